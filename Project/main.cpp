@@ -1,16 +1,260 @@
 #include <iostream>
+#include <memory>
 #include "Fractures.hpp"
 #include "Utils.hpp"
+#include "Ensemble.hpp"
+#include "Cache.hpp"
+#include "OutOfCore.hpp"
+#include "Multiprocess.hpp"
+#include "Flow.hpp"
+#include "Server.hpp"
+#include "Checkpoint.hpp"
+#include "Fuzz.hpp"
+#include "LocalTraces.hpp"
+#include "ParaviewExport.hpp"
+#include "Predicates.hpp"
 
 using namespace FractureLibrary;
 using namespace std;
 
-int main()
+int runEnsembleMode(int argc, char** argv)
 {
+    EnsembleParameters parameters;
+
+    for (int a = 2; a < argc; a++)
+    {
+        string arg = argv[a];
+        bool hasValue = a + 1 < argc;
+
+        if (arg == "--realizations" && hasValue)
+        {
+            parameters.NumberRealizations = stoul(argv[++a]);
+        }
+        else if (arg == "--threads" && hasValue)
+        {
+            parameters.NumberThreads = stoul(argv[++a]);
+        }
+        else if (arg == "--seed" && hasValue)
+        {
+            parameters.Seed = stoull(argv[++a]);
+        }
+        else if (arg == "--fractures" && hasValue)
+        {
+            parameters.Network.NumberFractures = stoul(argv[++a]);
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            parameters.WriteOutputs = true;
+            parameters.OutputFolder = argv[++a];
+        }
+        else if (!arg.empty() && arg[0] != '-')
+        {
+            parameters.InputFiles.push_back(arg);
+        }
+        else
+        {
+            cerr << "Unknown ensemble option: " << arg << endl;
+            return 1;
+        }
+    }
+
+    EnsembleStatistics statistics;
+    bool success = runEnsemble(parameters, statistics);
+    printEnsembleStatistics(statistics, cout);
+
+    return success ? 0 : 1;
+}
+
+int runOutOfCoreMode(int argc, char** argv)
+{
+    if (argc < 5)
+    {
+        cerr << "Usage: " << argv[0] << " --out-of-core <input> <traces> <results>"
+             << " [--memory <MB>] [--tiles <N>] [--workdir <dir>]" << endl;
+        return 1;
+    }
+
+    TilingParameters parameters;
+    for (int a = 5; a + 1 < argc; a += 2)
+    {
+        string arg = argv[a];
+        if (arg == "--memory")
+        {
+            parameters.MemoryBudget = stoull(argv[a + 1]) << 20;
+        }
+        else if (arg == "--tiles")
+        {
+            parameters.TilesPerAxis = stoul(argv[a + 1]);
+        }
+        else if (arg == "--workdir")
+        {
+            parameters.WorkDirectory = argv[a + 1];
+        }
+    }
+
+    TilingStatistics statistics;
+    if (!processOutOfCore(argv[2], argv[3], argv[4], parameters, statistics))
+    {
+        return 1;
+    }
+
+    cout << "# Fractures; Tiles; Duplicated; MaxTileFractures; Traces; EstimatedPeakBytes" << endl;
+    cout << statistics.NumberFractures << "; " << statistics.TilesPerAxis << "; "
+         << statistics.DuplicatedFractures << "; " << statistics.MaxTileFractures << "; "
+         << statistics.NumberTraces << "; " << statistics.EstimatedPeakBytes << endl;
+    return 0;
+}
+
+int runServerMode(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        cerr << "Usage: " << argv[0] << " --serve <input> <socket>" << endl;
+        return 1;
+    }
+
+    Fractures fractures;
+    if (!ImportFractures(argv[2], fractures))
+    {
+        cerr << "Error importing fractures from " << argv[2] << endl;
+        return 1;
+    }
+
+    ServerParameters parameters;
+    parameters.SocketPath = argv[3];
+    QueryServer server(fractures, parameters);
+    if (!server.start())
+    {
+        return 1;
+    }
+    cout << "Serving " << fractures.NumberFractures << " fractures and " << fractures.Traces.size()
+         << " traces on " << parameters.SocketPath << endl;
+
+    server.wait();
+    printServerStatistics(server.statistics(), cout);
+    return 0;
+}
+
+int runFuzzMode(int argc, char** argv)
+{
+    FuzzParameters parameters;
+    parameters.NumberCases = 0;
+    parameters.DurationSeconds = 60.0;
+
+    for (int a = 2; a < argc; a++)
+    {
+        string arg = argv[a];
+        bool hasValue = a + 1 < argc;
+
+        if (arg == "--cases" && hasValue)
+        {
+            parameters.NumberCases = stoull(argv[++a]);
+            parameters.DurationSeconds = 0.0;
+        }
+        else if (arg == "--seconds" && hasValue)
+        {
+            parameters.DurationSeconds = stod(argv[++a]);
+        }
+        else if (arg == "--seed" && hasValue)
+        {
+            parameters.Seed = stoull(argv[++a]);
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            parameters.OutputFolder = argv[++a];
+        }
+        else
+        {
+            cerr << "Unknown fuzz option: " << arg << endl;
+            return 1;
+        }
+    }
+
+    FuzzStatistics statistics;
+    bool agreed = runFuzz(parameters, defaultFuzzPaths(), statistics);
+    printFuzzStatistics(statistics, cout);
+    return agreed ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && string(argv[1]) == "--ensemble")
+    {
+        return runEnsembleMode(argc, argv);
+    }
+
+    if (argc > 1 && string(argv[1]) == "--out-of-core")
+    {
+        return runOutOfCoreMode(argc, argv);
+    }
+
+    if (argc > 1 && string(argv[1]) == "--fuzz")
+    {
+        return runFuzzMode(argc, argv);
+    }
+
+    if (argc > 1 && string(argv[1]) == "--serve")
+    {
+        return runServerMode(argc, argv);
+    }
+
+    if (argc > 2 && string(argv[1]) == "--clear-cache")
+    {
+        IntersectionCache cache(argv[2]);
+        cout << "Removed " << cache.invalidate() << " cache entries" << endl;
+        return 0;
+    }
+
+    string cacheDirectory;
+    string checkpointDirectory;
+    unsigned int numProcesses = 0;
+    int flowAxis = -1;
+    string localFormat;
+    string paraviewFolder;
+    bool exactNarrowPhase = false;
+    for (int a = 1; a + 1 < argc; a += 2)
+    {
+        string arg = argv[a];
+        if (arg == "--cache")
+        {
+            cacheDirectory = argv[a + 1];
+        }
+        else if (arg == "--checkpoint")
+        {
+            checkpointDirectory = argv[a + 1];
+        }
+        else if (arg == "--processes")
+        {
+            numProcesses = stoul(argv[a + 1]);
+        }
+        else if (arg == "--flow")
+        {
+            flowAxis = stoi(argv[a + 1]);
+        }
+        else if (arg == "--local")
+        {
+            localFormat = argv[a + 1];
+        }
+        else if (arg == "--paraview")
+        {
+            paraviewFolder = argv[a + 1];
+        }
+        else if (arg == "--narrow")
+        {
+            exactNarrowPhase = string(argv[a + 1]) == "exact";
+        }
+    }
+
     string filepath = "DFN/";
     vector<string> filenames = {"FR3_data.txt", "FR10_data.txt", "FR50_data.txt",
                                 "FR82_data.txt", "FR200_data.txt", "FR362_data.txt"};
 
+    unique_ptr<IntersectionCache> cache;
+    if (!cacheDirectory.empty())
+    {
+        cache = make_unique<IntersectionCache>(cacheDirectory);
+    }
+
     for (const auto& filename : filenames)
     {
         Fractures fractures;
@@ -22,7 +266,36 @@ int main()
         }
 
         map<int, vector<int>> file_intersections;
-        checkIntersections(fractures, file_intersections);
+        if (cache != nullptr)
+        {
+            cache->checkIntersections(fractures, file_intersections);
+        }
+        else if (!checkpointDirectory.empty())
+        {
+            CheckpointParameters parameters;
+            parameters.Path = checkpointDirectory + "/" + filename + ".dfnckpt";
+            CheckpointStatistics statistics;
+            if (!checkIntersectionsCheckpointed(fractures, file_intersections, parameters, statistics))
+            {
+                cerr << "Intersections of " << filename << " did not complete" << endl;
+                return 1;
+            }
+        }
+        else if (numProcesses > 0)
+        {
+            DecompositionParameters parameters;
+            parameters.NumberWorkers = numProcesses;
+            DecompositionStatistics statistics;
+            checkIntersectionsMultiprocess(fractures, file_intersections, parameters, statistics);
+        }
+        else if (exactNarrowPhase)
+        {
+            checkIntersectionsExact(fractures, file_intersections);
+        }
+        else
+        {
+            checkIntersections(fractures, file_intersections);
+        }
 
         string outputTraces = filename + "_traces.txt";
         writeTraces(fractures, outputTraces);
@@ -30,9 +303,47 @@ int main()
         string outputResults = filename + "_results.txt";
         writeResults(fractures, outputResults);
 
+        if (!localFormat.empty())
+        {
+            vector<LocalFracture> local;
+            computeLocalTraces(fractures, local);
+            if (localFormat == "binary")
+            {
+                writeLocalTracesBinary(local, filename + "_local.bin");
+            }
+            else
+            {
+                writeLocalTraces(local, filename + "_local.txt");
+            }
+        }
+
+        if (!paraviewFolder.empty())
+        {
+            ShardParameters parameters;
+            parameters.Folder = paraviewFolder;
+            parameters.Name = filename.substr(0, filename.find('_'));
+            ShardStatistics statistics;
+            exportNetworkParaview(fractures, file_intersections, parameters, statistics);
+        }
+
+        if (flowAxis >= 0)
+        {
+            FlowParameters parameters;
+            parameters.Axis = flowAxis;
+            FlowSolution solution;
+            solveFlow(fractures, parameters, solution);
+            cout << "Flow through " << filename << endl;
+            printFlowSolution(solution, cout);
+        }
+
         fractures.clear();
     }
 
+    if (cache != nullptr)
+    {
+        printCacheStatistics(cache->statistics(), cache->usage(), cout);
+    }
+
     return 0;
 
 }
@@ -0,0 +1,48 @@
+#include <iostream>
+#include "Batch.hpp"
+
+using namespace FractureLibrary;
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    BatchParameters parameters;
+    vector<string> inputs;
+
+    for (int a = 1; a < argc; a++)
+    {
+        string arg = argv[a];
+        bool hasValue = a + 1 < argc;
+
+        if (arg == "--threads" && hasValue)
+        {
+            parameters.NumberThreads = stoul(argv[++a]);
+        }
+        else if (arg == "--in-flight" && hasValue)
+        {
+            parameters.MaxFilesInFlight = stoul(argv[++a]);
+        }
+        else if (arg == "--output" && hasValue)
+        {
+            parameters.OutputFolder = argv[++a];
+        }
+        else
+        {
+            inputs.push_back(arg);
+        }
+    }
+
+    vector<string> files = expandInputs(inputs);
+    if (files.empty())
+    {
+        cerr << "Usage: " << argv[0] << " [--threads N] [--in-flight N] [--output <dir>]"
+             << " <file | directory | glob | @list>..." << endl;
+        return 1;
+    }
+
+    BatchStatistics statistics;
+    bool success = runBatch(files, parameters, statistics);
+    printBatchStatistics(statistics, cout);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,1365 @@
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include "Fractures.hpp"
+#include "Utils.hpp"
+#include "Generator.hpp"
+#include "Incremental.hpp"
+#include "Cache.hpp"
+#include "OutOfCore.hpp"
+#include "Multiprocess.hpp"
+#include "Batch.hpp"
+#include "ParallelImport.hpp"
+#include "Predicates.hpp"
+#include "Prefilter.hpp"
+#include "RayQueries.hpp"
+#include "Flow.hpp"
+#include "Statistics.hpp"
+#include "LazyTraces.hpp"
+#include "TraceSink.hpp"
+#include "TraceStore.hpp"
+#include "Server.hpp"
+#include "Checkpoint.hpp"
+#include "TraceSort.hpp"
+#include "Allocations.hpp"
+#include "LocalTraces.hpp"
+#include "ParaviewExport.hpp"
+#include "Regression.hpp"
+#include "FilterCascade.hpp"
+#include "TraceCrossings.hpp"
+#include <filesystem>
+#include <numeric>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifndef DFN_BUILD_TYPE
+#define DFN_BUILD_TYPE ""
+#endif
+
+using namespace FractureLibrary;
+using namespace std;
+
+struct BenchmarkOptions
+{
+    unsigned int Size = 1000;
+    unsigned int Repetitions = 3;
+    unsigned long long Seed = 1;
+};
+
+double timeIt(const function<void()>& work, unsigned int repetitions)
+{
+    double best = numeric_limits<double>::max();
+    for (unsigned int r = 0; r < max(1u, repetitions); r++)
+    {
+        auto start = chrono::steady_clock::now();
+        work();
+        auto end = chrono::steady_clock::now();
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+void report(const string& benchmark, const string& variant, double seconds,
+            double throughput, const string& unit)
+{
+    cout << benchmark << "; " << variant << "; " << seconds << "; "
+         << throughput << "; " << unit << endl;
+}
+
+double peakResidentMegabytes()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+Fractures syntheticNetwork(const BenchmarkOptions& options)
+{
+    NetworkParameters parameters;
+    parameters.NumberFractures = options.Size;
+    parameters.MinRadius = 0.02;
+    parameters.MaxRadius = 0.1;
+
+    Fractures fractures;
+    mt19937_64 generator(options.Seed);
+    generateFractures(fractures, parameters, generator);
+    return fractures;
+}
+
+// ***************************************************************************
+
+void benchIncremental(const BenchmarkOptions& options)
+{
+    const unsigned int updates = 10;
+    Fractures network = syntheticNetwork(options);
+
+    double full = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+    }, options.Repetitions);
+    report("incremental", "full_recompute", full, 1.0 / full, "networks/s");
+
+    Fractures base = network;
+    base.FracturesId.resize(options.Size - updates);
+    base.FracturesVertices.resize(options.Size - updates);
+    base.NumberFractures = base.FracturesId.size();
+    map<int, vector<int>> baseIntersections;
+    checkIntersections(base, baseIntersections);
+
+    double add = timeIt([&]()
+    {
+        Fractures fractures = base;
+        map<int, vector<int>> intersections = baseIntersections;
+        IncrementalDFN dfn(fractures, intersections);
+        vector<int> newTraces;
+        for (unsigned int k = options.Size - updates; k < options.Size; k++)
+        {
+            dfn.addFracture(network.FracturesId[k], network.FracturesVertices[k], newTraces);
+        }
+    }, options.Repetitions);
+    report("incremental", "add_" + to_string(updates), add, updates / add, "updates/s");
+
+    double remove = timeIt([&]()
+    {
+        Fractures fractures = base;
+        map<int, vector<int>> intersections = baseIntersections;
+        IncrementalDFN dfn(fractures, intersections);
+        for (unsigned int k = 0; k < updates; k++)
+        {
+            dfn.removeFracture(k * 7);
+        }
+    }, options.Repetitions);
+    report("incremental", "remove_" + to_string(updates), remove, updates / remove, "updates/s");
+
+    report("incremental", "speedup_add_vs_full", full / add, full / add, "x");
+}
+
+// ***************************************************************************
+
+void benchCache(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    IntersectionCache cache("bench_cache");
+    cache.invalidate();
+
+    double miss = timeIt([&]()
+    {
+        cache.invalidate();
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        cache.checkIntersections(fractures, intersections);
+    }, options.Repetitions);
+    report("cache", "miss", miss, 1.0 / miss, "networks/s");
+
+    double hit = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        cache.checkIntersections(fractures, intersections);
+    }, options.Repetitions);
+    report("cache", "hit", hit, 1.0 / hit, "networks/s");
+
+    cache.invalidate();
+}
+
+// ***************************************************************************
+
+void benchOutOfCore(const BenchmarkOptions& options)
+{
+    string input = "bench_ooc_input.txt";
+    writeFractures(syntheticNetwork(options), input);
+
+    for (size_t budget : {size_t(1) << 20, size_t(64) << 20})
+    {
+        TilingParameters parameters;
+        parameters.MemoryBudget = budget;
+        TilingStatistics statistics;
+
+        double seconds = timeIt([&]()
+        {
+            processOutOfCore(input, "bench_ooc_traces.txt", "bench_ooc_results.txt",
+                             parameters, statistics);
+        }, options.Repetitions);
+
+        string variant = "budget_" + to_string(budget >> 20) + "MB_tiles_" + to_string(statistics.TilesPerAxis);
+        report("out_of_core", variant, seconds, options.Size / seconds, "fractures/s");
+        report("out_of_core", variant + "_estimated_peak", seconds,
+               statistics.EstimatedPeakBytes / 1048576.0, "MB");
+    }
+    report("out_of_core", "process_peak_rss", 0.0, peakResidentMegabytes(), "MB");
+
+    remove(input.c_str());
+    remove("bench_ooc_traces.txt");
+    remove("bench_ooc_results.txt");
+}
+
+// ***************************************************************************
+
+void benchMultiprocess(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    const double pairs = 0.5 * options.Size * (options.Size - 1.0);
+
+    double serial = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+    }, options.Repetitions);
+    report("multiprocess", "serial", serial, pairs / serial, "pairs/s");
+
+    for (unsigned int workers : {1u, 2u, 4u})
+    {
+        double seconds = timeIt([&]()
+        {
+            Fractures fractures = network;
+            map<int, vector<int>> intersections;
+            DecompositionParameters parameters;
+            parameters.NumberWorkers = workers;
+            DecompositionStatistics statistics;
+            checkIntersectionsMultiprocess(fractures, intersections, parameters, statistics);
+        }, options.Repetitions);
+        report("multiprocess", "workers_" + to_string(workers), seconds, pairs / seconds, "pairs/s");
+    }
+}
+
+// ***************************************************************************
+
+void benchBatch(const BenchmarkOptions& options)
+{
+    // a directory of many small networks, one per input size unit
+    const string input = "bench_batch_input/";
+    const string output = "bench_batch_output/";
+    filesystem::create_directories(input);
+    filesystem::create_directories(output);
+
+    NetworkParameters parameters;
+    parameters.NumberFractures = 30;
+    mt19937_64 generator(options.Seed);
+    Fractures fractures;
+    for (unsigned int f = 0; f < options.Size; f++)
+    {
+        generateFractures(fractures, parameters, generator);
+        writeFractures(fractures, input + "FR_" + to_string(f) + "_data.txt");
+    }
+    vector<string> files = expandInputs({input});
+
+    for (unsigned int threads : {1u, 2u, 4u})
+    {
+        BatchParameters batch;
+        batch.NumberThreads = threads;
+        batch.OutputFolder = output;
+        BatchStatistics statistics;
+
+        double seconds = timeIt([&]()
+        {
+            runBatch(files, batch, statistics);
+        }, options.Repetitions);
+        report("batch", "threads_" + to_string(threads), seconds, files.size() / seconds, "files/s");
+    }
+
+    filesystem::remove_all(input);
+    filesystem::remove_all(output);
+}
+
+// ***************************************************************************
+
+void benchParallelImport(const BenchmarkOptions& options)
+{
+    // one large file: size x 100 fractures
+    BenchmarkOptions large = options;
+    large.Size = options.Size * 100;
+    const string input = "bench_import_input.txt";
+    writeFractures(syntheticNetwork(large), input);
+    const double megabytes = filesystem::file_size(input) / 1048576.0;
+
+    double serial = timeIt([&]()
+    {
+        Fractures fractures;
+        ImportFractures(input, fractures);
+    }, options.Repetitions);
+    report("parallel_import", "serial", serial, megabytes / serial, "MB/s");
+
+    for (unsigned int threads : {1u, 2u, 4u, 8u, 32u})
+    {
+        double seconds = timeIt([&]()
+        {
+            Fractures fractures;
+            ImportFracturesParallel(input, fractures, threads);
+        }, options.Repetitions);
+        report("parallel_import", "threads_" + to_string(threads), seconds, megabytes / seconds, "MB/s");
+    }
+
+    remove(input.c_str());
+}
+
+// ***************************************************************************
+
+void benchPredicates(const BenchmarkOptions& options)
+{
+    // tolerance narrow phase against the filtered exact one on the bundled networks
+    const vector<string> files = {"DFN/FR3_data.txt", "DFN/FR10_data.txt", "DFN/FR50_data.txt",
+                                  "DFN/FR82_data.txt", "DFN/FR200_data.txt", "DFN/FR362_data.txt"};
+
+    for (const string& file : files)
+    {
+        Fractures fractures;
+        if (!ImportFractures(file, fractures))
+        {
+            continue;
+        }
+        const vector<Matrix3Xd>& vertices = fractures.FracturesVertices;
+        const double pairs = 0.5 * vertices.size() * (vertices.size() - 1.0);
+        const string name = filesystem::path(file).stem().string();
+
+        vector<char> tolerance;
+        double toleranceSeconds = timeIt([&]()
+        {
+            tolerance.clear();
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                for (size_t j = i + 1; j < vertices.size(); j++)
+                {
+                    tolerance.push_back(fracturesIntersect(vertices[i], vertices[j]));
+                }
+            }
+        }, options.Repetitions);
+
+        vector<char> exact;
+        double exactSeconds = timeIt([&]()
+        {
+            exact.clear();
+            resetPredicateStatistics();
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                for (size_t j = i + 1; j < vertices.size(); j++)
+                {
+                    exact.push_back(fracturesIntersectExact(vertices[i], vertices[j]));
+                }
+            }
+        }, options.Repetitions);
+
+        size_t disagreements = 0;
+        for (size_t k = 0; k < exact.size(); k++)
+        {
+            disagreements += exact[k] != tolerance[k];
+        }
+
+        report("predicates", name + "_tolerance", toleranceSeconds, pairs / toleranceSeconds, "pairs/s");
+        report("predicates", name + "_exact", exactSeconds, pairs / exactSeconds, "pairs/s");
+        report("predicates", name + "_fallback_rate", exactSeconds,
+               100.0 * predicateStatistics().fallbackRate(), "%");
+        report("predicates", name + "_intersecting_tolerance", 0.0,
+               count(tolerance.begin(), tolerance.end(), 1), "pairs");
+        report("predicates", name + "_intersecting_exact", 0.0, count(exact.begin(), exact.end(), 1), "pairs");
+        report("predicates", name + "_disagreements", 0.0, disagreements, "pairs");
+    }
+}
+
+// ***************************************************************************
+
+void benchPrefilter(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    const double pairs = 0.5 * options.Size * (options.Size - 1.0);
+
+    double serial = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+    }, options.Repetitions);
+    report("prefilter", "none", serial, pairs / serial, "pairs/s");
+
+    const vector<pair<string, PrefilterPrecision>> precisions =
+    {
+        {"float", PrefilterPrecision::Float},
+        {"quantized16", PrefilterPrecision::Quantized16}
+    };
+    for (const auto& precision : precisions)
+    {
+        for (bool planes : {false, true})
+        {
+            PrefilterParameters parameters;
+            parameters.Precision = precision.second;
+            parameters.UsePlanes = planes;
+            PrefilterStatistics statistics;
+
+            double seconds = timeIt([&]()
+            {
+                Fractures fractures = network;
+                map<int, vector<int>> intersections;
+                checkIntersectionsPrefiltered(fractures, intersections, parameters, statistics);
+            }, options.Repetitions);
+
+            string variant = precision.first + (planes ? "_box_plane" : "_box");
+            report("prefilter", variant, seconds, pairs / seconds, "pairs/s");
+            report("prefilter", variant + "_rejected", seconds, 100.0 * statistics.rejectionRate(), "%");
+            report("prefilter", variant + "_rejected_by_plane", seconds,
+                   100.0 * statistics.RejectedByPlane / max(1.0, double(statistics.TestedPairs)), "%");
+        }
+    }
+}
+
+// ***************************************************************************
+
+void benchRays(const BenchmarkOptions& options)
+{
+    BenchmarkOptions large = options;
+    large.Size = options.Size * 100;
+    Fractures network = syntheticNetwork(large);
+
+    auto start = chrono::steady_clock::now();
+    FractureBVH bvh(network);
+    double build = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    report("rays", "build_bvh", build, large.Size / build, "fractures/s");
+
+    // particle plumes: groups of nearby rays with similar directions
+    mt19937_64 generator(options.Seed);
+    uniform_real_distribution<double> position(0.0, 1.0);
+    normal_distribution<double> direction(0.0, 1.0);
+    vector<Ray> rays(100 * options.Size);
+    Vector3d origin;
+    Vector3d heading;
+    for (size_t r = 0; r < rays.size(); r++)
+    {
+        if (r % FractureBVH::PacketSize == 0)
+        {
+            origin = Vector3d(position(generator), position(generator), position(generator));
+            heading = Vector3d(direction(generator), direction(generator), direction(generator)).normalized();
+        }
+        Vector3d jitter(direction(generator), direction(generator), direction(generator));
+        rays[r].Origin = origin + 0.001 * jitter;
+        rays[r].Direction = heading + 0.01 * jitter;
+    }
+
+    double single = timeIt([&]()
+    {
+        RayHit hit;
+        for (const Ray& ray : rays)
+        {
+            bvh.firstHit(ray, hit);
+        }
+    }, options.Repetitions);
+    report("rays", "first_hit", single, rays.size() / single, "rays/s");
+
+    double occlusion = timeIt([&]()
+    {
+        for (const Ray& ray : rays)
+        {
+            bvh.occluded(ray.Origin, ray.Origin + 0.1 * ray.Direction);
+        }
+    }, options.Repetitions);
+    report("rays", "occluded", occlusion, rays.size() / occlusion, "rays/s");
+
+    vector<RayHit> hits(rays.size());
+    double packets = timeIt([&]()
+    {
+        bvh.firstHits(rays.data(), rays.size(), hits.data());
+    }, options.Repetitions);
+    report("rays", "packets", packets, rays.size() / packets, "rays/s");
+
+    for (unsigned int threads : {1u, 2u, 4u})
+    {
+        double seconds = timeIt([&]()
+        {
+            castRays(bvh, rays, hits, threads);
+        }, options.Repetitions);
+        report("rays", "threads_" + to_string(threads), seconds, rays.size() / seconds, "rays/s");
+    }
+}
+
+// ***************************************************************************
+
+Fractures latticeNetwork(unsigned int side, mt19937_64& generator)
+{
+    // squares on a cubic lattice, one trace to each lattice neighbour; only
+    // the flow stage is measured, so the traces are placed directly
+    uniform_real_distribution<double> length(0.3, 0.6);
+    Fractures fractures;
+    fractures.NumberFractures = side * side * side;
+    fractures.FracturesId.reserve(fractures.NumberFractures);
+    fractures.FracturesVertices.reserve(fractures.NumberFractures);
+
+    auto index = [side](unsigned int i, unsigned int j, unsigned int k)
+    {
+        return (i * side + j) * side + k;
+    };
+
+    for (unsigned int i = 0; i < side; i++)
+    {
+        for (unsigned int j = 0; j < side; j++)
+        {
+            for (unsigned int k = 0; k < side; k++)
+            {
+                int normal = (i + j + k) % 3;
+                int u = (normal + 1) % 3;
+                int v = (normal + 2) % 3;
+                Matrix3Xd square = Vector3d(i, j, k).replicate(1, 4);
+                square(u, 0) -= 0.6; square(v, 0) -= 0.6;
+                square(u, 1) += 0.6; square(v, 1) -= 0.6;
+                square(u, 2) += 0.6; square(v, 2) += 0.6;
+                square(u, 3) -= 0.6; square(v, 3) += 0.6;
+                fractures.FracturesId.push_back(index(i, j, k));
+                fractures.FracturesVertices.push_back(square);
+
+                const unsigned int next[3][3] = {{i + 1, j, k}, {i, j + 1, k}, {i, j, k + 1}};
+                for (const auto& neighbour : next)
+                {
+                    if (neighbour[0] >= side || neighbour[1] >= side || neighbour[2] >= side)
+                    {
+                        continue;
+                    }
+                    Point middle(0.5 * (i + neighbour[0]), 0.5 * (j + neighbour[1]), 0.5 * (k + neighbour[2]));
+                    Point end(middle.x, middle.y, middle.z + length(generator));
+                    fractures.Traces.push_back(Trace(fractures.Traces.size(), index(i, j, k),
+                                                     index(neighbour[0], neighbour[1], neighbour[2]),
+                                                     middle, end, false, false));
+                }
+            }
+        }
+    }
+    return fractures;
+}
+
+// ***************************************************************************
+
+void benchFlow(const BenchmarkOptions& options)
+{
+    mt19937_64 generator(options.Seed);
+    for (unsigned int size = options.Size; size <= 1000000; size *= 10)
+    {
+        unsigned int side = max(2u, (unsigned int)round(cbrt(double(size))));
+        Fractures network = latticeNetwork(side, generator);
+        const string variant = to_string(network.FracturesVertices.size());
+
+        for (unsigned int threads : {1u, 4u})
+        {
+            FlowParameters parameters;
+            parameters.NumberThreads = threads;
+            parameters.SolverTolerance = 1e-8;
+            FlowSolution solution;
+            solveFlow(network, parameters, solution);
+
+            string name = variant + "_threads_" + to_string(threads);
+            report("flow", name + "_assembly", solution.AssemblySeconds,
+                   solution.NumberPipes / solution.AssemblySeconds, "pipes/s");
+            report("flow", name + "_solve", solution.SolveSeconds, solution.Iterations, "iterations");
+        }
+    }
+}
+
+// ***************************************************************************
+
+void benchTraceStatistics(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    const double pairs = 0.5 * options.Size * (options.Size - 1.0);
+
+    double stored = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        TraceStatistics statistics;
+        summarizeTraces(fractures, statistics);
+    }, options.Repetitions);
+    report("trace_statistics", "stored_traces", stored, pairs / stored, "pairs/s");
+
+    // same box prefilter as the streamed path, so the difference is the sink
+    double prefiltered = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        PrefilterParameters parameters;
+        parameters.UsePlanes = false;
+        PrefilterStatistics filtered;
+        checkIntersectionsPrefiltered(fractures, intersections, parameters, filtered);
+        TraceStatistics statistics;
+        summarizeTraces(fractures, statistics);
+    }, options.Repetitions);
+    report("trace_statistics", "stored_traces_prefiltered", prefiltered, pairs / prefiltered, "pairs/s");
+
+    for (unsigned int threads : {1u, 2u, 4u})
+    {
+        double seconds = timeIt([&]()
+        {
+            TraceStatistics statistics;
+            collectTraceStatistics(network, statistics, threads);
+        }, options.Repetitions);
+        report("trace_statistics", "streamed_threads_" + to_string(threads), seconds, pairs / seconds, "pairs/s");
+    }
+}
+
+// ***************************************************************************
+
+void benchLazy(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    const double pairs = 0.5 * options.Size * (options.Size - 1.0);
+
+    double full = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+    }, options.Repetitions);
+    report("lazy", "full_traces", full, pairs / full, "pairs/s");
+
+    double adjacency = timeIt([&]()
+    {
+        LazyTraceNetwork lazy(network);
+        map<int, vector<int>> intersections;
+        lazy.adjacency(intersections);
+    }, options.Repetitions);
+    report("lazy", "adjacency_only", adjacency, pairs / adjacency, "pairs/s");
+
+    double materialized = timeIt([&]()
+    {
+        LazyTraceNetwork lazy(network);
+        vector<Trace> traces;
+        lazy.materialize(traces);
+    }, options.Repetitions);
+    report("lazy", "adjacency_then_all_traces", materialized, pairs / materialized, "pairs/s");
+
+    // region of interest: one eighth of the unit domain
+    LazyParameters parameters;
+    parameters.UseRegion = true;
+    parameters.Region = BoundingBox(Vector3d::Zero(), Vector3d::Constant(0.5));
+    double region = timeIt([&]()
+    {
+        LazyTraceNetwork lazy(network, parameters);
+        map<int, vector<int>> intersections;
+        lazy.adjacency(intersections);
+    }, options.Repetitions);
+    report("lazy", "region_eighth", region, pairs / region, "pairs/s");
+}
+
+// ***************************************************************************
+
+void benchSinks(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    const double pairs = 0.5 * options.Size * (options.Size - 1.0);
+
+    double stored = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        writeTraces(fractures, "bench_sink_traces.txt");
+    }, options.Repetitions);
+    report("sinks", "stored_then_written", stored, pairs / stored, "pairs/s");
+
+    double collected = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        CollectingSink sink(fractures, intersections);
+        streamTraces(network, sink);
+    }, options.Repetitions);
+    report("sinks", "collecting", collected, pairs / collected, "pairs/s");
+
+    double text = timeIt([&]()
+    {
+        TextTraceWriter sink("bench_sink_traces.txt");
+        streamTraces(network, sink);
+    }, options.Repetitions);
+    report("sinks", "text_writer", text, pairs / text, "pairs/s");
+
+    double binary = timeIt([&]()
+    {
+        BinaryTraceWriter sink("bench_sink_traces.bin");
+        streamTraces(network, sink);
+    }, options.Repetitions);
+    report("sinks", "binary_writer", binary, pairs / binary, "pairs/s");
+
+    double statistics = timeIt([&]()
+    {
+        StatisticsSink sink(network);
+        streamTraces(network, sink);
+    }, options.Repetitions);
+    report("sinks", "statistics", statistics, pairs / statistics, "pairs/s");
+
+    remove("bench_sink_traces.txt");
+    remove("bench_sink_traces.bin");
+}
+
+// ***************************************************************************
+
+void benchTraceStore(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    vector<Trace> traces;
+    CallbackSink collect([&traces](const vector<Trace>& block)
+    {
+        traces.insert(traces.end(), block.begin(), block.end());
+    });
+    streamTraces(network, collect);
+    if (traces.empty())
+    {
+        return;
+    }
+    report("trace_store", "vector_of_trace", 0.0, double(sizeof(Trace)), "bytes/trace");
+
+    const vector<pair<string, TracePrecision>> precisions =
+    {
+        {"double", TracePrecision::Double},
+        {"float", TracePrecision::Float},
+        {"line_parameter", TracePrecision::LineParameter}
+    };
+    for (const auto& precision : precisions)
+    {
+        TraceStore store(precision.second, false, &network);
+        store.reserve(traces.size());
+        double filling = timeIt([&]()
+        {
+            store.clear();
+            store.consume(traces);
+        }, options.Repetitions);
+
+        double total = 0.0;
+        double reading = timeIt([&]()
+        {
+            total = 0.0;
+            for (size_t k = 0; k < store.size(); k++)
+            {
+                total += store[k].length;
+            }
+        }, options.Repetitions);
+
+        report("trace_store", precision.first + "_bytes", 0.0,
+               double(store.memoryBytes()) / store.size(), "bytes/trace");
+        report("trace_store", precision.first + "_fill", filling, store.size() / filling, "traces/s");
+        report("trace_store", precision.first + "_view", reading, store.size() / reading, "traces/s");
+    }
+}
+
+// ***************************************************************************
+
+void benchServer(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    ServerParameters parameters;
+    parameters.SocketPath = "bench_server.sock";
+    QueryServer server(network, parameters);
+    if (!server.start())
+    {
+        return;
+    }
+
+    const unsigned int numberClients = 4;
+    const unsigned int requests = 200;
+    const unsigned int batch = 16;
+    auto start = chrono::steady_clock::now();
+    vector<thread> clients;
+    for (unsigned int c = 0; c < numberClients; c++)
+    {
+        clients.emplace_back([&, c]()
+        {
+            QueryClient client;
+            if (!client.connect(parameters.SocketPath))
+            {
+                return;
+            }
+            mt19937_64 generator(options.Seed + c);
+            uniform_int_distribution<unsigned int> pick(0, network.FracturesId.size() - 1);
+            vector<vector<unsigned int>> lists;
+            vector<vector<Trace>> traces;
+            for (unsigned int r = 0; r < requests; r++)
+            {
+                vector<unsigned int> ids;
+                vector<Matrix3Xd> polygons;
+                for (unsigned int b = 0; b < batch; b++)
+                {
+                    unsigned int k = pick(generator);
+                    ids.push_back(network.FracturesId[k]);
+                    polygons.push_back(network.FracturesVertices[k]);
+                }
+                if (r % 3 == 0)
+                {
+                    client.neighbors(ids, lists);
+                }
+                else if (r % 3 == 1)
+                {
+                    client.traces(ids, traces);
+                }
+                else
+                {
+                    client.wouldIntersect(polygons, lists);
+                }
+            }
+        });
+    }
+    for (thread& client : clients)
+    {
+        client.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    server.stop();
+
+    ServerStatistics statistics = server.statistics();
+    report("server", "mixed_queries", seconds, statistics.Queries / seconds, "queries/s");
+    report("server", "latency_p50", statistics.Latency50, 1.0 / max(statistics.Latency50, 1e-12), "requests/s");
+    report("server", "latency_p90", statistics.Latency90, 1.0 / max(statistics.Latency90, 1e-12), "requests/s");
+    report("server", "latency_p99", statistics.Latency99, 1.0 / max(statistics.Latency99, 1e-12), "requests/s");
+}
+
+// ***************************************************************************
+
+void benchCheckpoint(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    double plain = timeIt([&]()
+    {
+        Fractures fractures = network;
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+    }, options.Repetitions);
+    report("checkpoint", "none", plain, network.FracturesId.size() / plain, "rows/s");
+
+    for (double interval : {1.0, 0.1, 0.0})
+    {
+        CheckpointParameters parameters;
+        parameters.Path = "bench.dfnckpt";
+        parameters.IntervalSeconds = interval;
+        CheckpointStatistics statistics;
+        double seconds = timeIt([&]()
+        {
+            Fractures fractures = network;
+            map<int, vector<int>> intersections;
+            checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics);
+        }, options.Repetitions);
+
+        string variant = "interval_" + to_string(interval).substr(0, 3);
+        report("checkpoint", variant, seconds, network.FracturesId.size() / seconds, "rows/s");
+        report("checkpoint", variant + "_checkpoints", statistics.StallSeconds,
+               double(statistics.Checkpoints), "checkpoints");
+        report("checkpoint", variant + "_overhead", seconds - plain, 100.0 * (seconds - plain) / plain, "%");
+    }
+
+    // an interrupted run and its resumption
+    CheckpointParameters parameters;
+    parameters.Path = "bench.dfnckpt";
+    parameters.IntervalSeconds = 0.1;
+    parameters.StopAfterRows = network.FracturesId.size() / 2;
+    CheckpointStatistics statistics;
+    Fractures first = network;
+    map<int, vector<int>> intersections;
+    checkIntersectionsCheckpointed(first, intersections, parameters, statistics);
+    parameters.StopAfterRows = 0;
+    double resumed = timeIt([&]()
+    {
+        Fractures second = network;
+        map<int, vector<int>> resumedIntersections;
+        checkIntersectionsCheckpointed(second, resumedIntersections, parameters, statistics);
+    }, 1);
+    report("checkpoint", "resume_second_half", resumed, network.FracturesId.size() / resumed, "rows/s");
+}
+
+// ***************************************************************************
+
+void benchTraceSort(const BenchmarkOptions& options)
+{
+    // per fracture lists as writeResults builds them, with a few large fractures
+    mt19937_64 generator(options.Seed);
+    uniform_real_distribution<double> length(0.0, 1.0);
+    const size_t numberTraces = size_t(options.Size) * 1000;
+    vector<vector<Trace>> lists(options.Size);
+    vector<Trace> all;
+    all.reserve(numberTraces);
+    for (size_t k = 0; k < numberTraces; k++)
+    {
+        double l = length(generator);
+        Trace trace(k, 0, 1, Point(0, 0, 0), Point(l, 0, 0), false, false);
+        all.push_back(trace);
+        size_t fracture = k % 10 == 0 ? k % 4 : k % options.Size;
+        lists[fracture].push_back(trace);
+    }
+
+    auto segmentsOf = [](vector<vector<Trace>>& copies)
+    {
+        vector<vector<Trace>*> segments;
+        for (auto& list : copies)
+        {
+            segments.push_back(&list);
+        }
+        return segments;
+    };
+
+    vector<vector<Trace>> copies;
+    double comparator = timeIt([&]()
+    {
+        copies = lists;
+        for (auto& list : copies)
+        {
+            sortTracesByLength(list);
+        }
+    }, options.Repetitions);
+    report("trace_sort", "segments_std_sort", comparator, numberTraces / comparator, "traces/s");
+
+    double serial = timeIt([&]()
+    {
+        copies = lists;
+        sortTraceSegments(segmentsOf(copies), 1);
+    }, options.Repetitions);
+    report("trace_sort", "segments_radix_1_thread", serial, numberTraces / serial, "traces/s");
+
+    double parallel = timeIt([&]()
+    {
+        copies = lists;
+        sortTraceSegments(segmentsOf(copies), 0);
+    }, options.Repetitions);
+    report("trace_sort", "segments_radix_parallel", parallel, numberTraces / parallel, "traces/s");
+
+    // global ranking of every trace
+    vector<Trace> ranked;
+    double global = timeIt([&]()
+    {
+        ranked = all;
+        sortTracesByLength(ranked);
+    }, options.Repetitions);
+    report("trace_sort", "global_std_sort", global, numberTraces / global, "traces/s");
+
+    vector<uint32_t> order;
+    double globalRadix = timeIt([&]()
+    {
+        radixOrderByLength(all, order);
+    }, options.Repetitions);
+    report("trace_sort", "global_radix_order", globalRadix, numberTraces / globalRadix, "traces/s");
+}
+
+// ***************************************************************************
+
+void benchAllocations(const BenchmarkOptions& options)
+{
+    if (!allocationTrackingEnabled())
+    {
+        report("allocations", "disabled", 0.0, 0.0, "configure with -DDFN_TRACK_ALLOCATIONS=ON");
+        return;
+    }
+
+    const string input = "bench_allocations.txt";
+    writeFractures(syntheticNetwork(options), input);
+    resetPhaseReports();
+
+    Fractures fractures;
+    ImportFractures(input, fractures);
+    map<int, vector<int>> intersections;
+    checkIntersections(fractures, intersections);
+    writeTraces(fractures, input + "_traces.txt");
+    writeResults(fractures, input + "_results.txt");
+
+    for (const PhaseReport& phase : phaseReports())
+    {
+        report("allocations", phase.Name + "_count", phase.Seconds, double(phase.Allocations), "allocations");
+        report("allocations", phase.Name + "_bytes", phase.Seconds, double(phase.Bytes), "bytes");
+        report("allocations", phase.Name + "_peak_live", phase.Seconds, double(phase.PeakLiveBytes), "bytes");
+        report("allocations", phase.Name + "_peak_resident", phase.Seconds,
+               double(phase.PeakResidentBytes), "bytes");
+    }
+
+    filesystem::remove(input);
+    filesystem::remove(input + "_traces.txt");
+    filesystem::remove(input + "_results.txt");
+}
+
+// ***************************************************************************
+
+void benchLocalTraces(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    map<int, vector<int>> intersections;
+    checkIntersections(network, intersections);
+    const double numberFractures = network.FracturesId.size();
+
+    vector<LocalFracture> local;
+    double serial = timeIt([&]()
+    {
+        computeLocalTraces(network, local, 1);
+    }, options.Repetitions);
+    report("local_traces", "compute_1_thread", serial, numberFractures / serial, "fractures/s");
+
+    double parallel = timeIt([&]()
+    {
+        computeLocalTraces(network, local);
+    }, options.Repetitions);
+    report("local_traces", "compute_all_threads", parallel, numberFractures / parallel, "fractures/s");
+
+    size_t bytes = 0;
+    double text = timeIt([&]()
+    {
+        ostringstream out;
+        writeLocalTraces(out, local);
+        bytes = out.str().size();
+    }, options.Repetitions);
+    report("local_traces", "write_text", text, bytes / text / 1e6, "MB/s");
+
+    double binary = timeIt([&]()
+    {
+        ostringstream out(ios::binary);
+        writeLocalTracesBinary(out, local);
+        bytes = out.str().size();
+    }, options.Repetitions);
+    report("local_traces", "write_binary", binary, bytes / binary / 1e6, "MB/s");
+}
+
+// ***************************************************************************
+
+void benchParaview(const BenchmarkOptions& options)
+{
+    Fractures network = syntheticNetwork(options);
+    map<int, vector<int>> intersections;
+    checkIntersections(network, intersections);
+    const string folder = "bench_paraview";
+    filesystem::create_directories(folder);
+
+    // the fractures through the monolithic ascii UCD export
+    MatrixXd points(3, 0);
+    vector<vector<unsigned int>> polygons;
+    for (const Matrix3Xd& vertices : network.FracturesVertices)
+    {
+        Index first = points.cols();
+        points.conservativeResize(3, first + vertices.cols());
+        points.rightCols(vertices.cols()) = vertices;
+        polygons.emplace_back(vertices.cols());
+        iota(polygons.back().begin(), polygons.back().end(), (unsigned int)first);
+    }
+    Gedim::UCDUtilities exporter;
+    double ucd = timeIt([&]()
+    {
+        exporter.ExportPolygons(folder + "/fractures.inp", points, polygons);
+    }, options.Repetitions);
+    const double numberCells = network.FracturesId.size() + network.Traces.size();
+    report("paraview", "ucd_fractures_only", ucd, network.FracturesId.size() / ucd, "cells/s");
+
+    for (unsigned int shards : {1u, 0u})
+    {
+        ShardParameters parameters;
+        parameters.Folder = folder;
+        parameters.NumberShards = shards;
+        ShardStatistics statistics;
+        double sharded = timeIt([&]()
+        {
+            exportNetworkParaview(network, intersections, parameters, statistics);
+        }, options.Repetitions);
+        report("paraview", "vtu_raw_" + to_string(statistics.Shards / 2) + "_shards", sharded,
+               numberCells / sharded, "cells/s");
+    }
+
+    filesystem::remove_all(folder);
+}
+
+// ***************************************************************************
+
+void benchFilterCascade(const BenchmarkOptions& options)
+{
+    // isotropic, then fractures squashed to horizontal and to vertical planes
+    const vector<pair<string, int>> orientations = {{"isotropic", -1}, {"horizontal", 2}, {"vertical", 0}};
+    const double pairs = 0.5 * options.Size * (options.Size - 1.0);
+    for (const auto& orientation : orientations)
+    {
+        Fractures network = syntheticNetwork(options);
+        if (orientation.second >= 0)
+        {
+            const int axis = orientation.second;
+            for (Matrix3Xd& vertices : network.FracturesVertices)
+            {
+                double centroid = vertices.row(axis).mean();
+                vertices.row(axis) = (vertices.row(axis).array() - centroid) * 0.02 + centroid;
+            }
+        }
+
+        double reference = timeIt([&]()
+        {
+            Fractures fractures = network;
+            map<int, vector<int>> intersections;
+            checkIntersections(fractures, intersections);
+        }, options.Repetitions);
+        report("filter_cascade", orientation.first + "_reference", reference, pairs / reference, "pairs/s");
+
+        for (bool adaptive : {false, true})
+        {
+            CascadeParameters parameters;
+            parameters.Adaptive = adaptive;
+            CascadeStatistics statistics;
+            double seconds = timeIt([&]()
+            {
+                Fractures fractures = network;
+                map<int, vector<int>> intersections;
+                checkIntersectionsCascade(fractures, intersections, parameters, statistics);
+            }, options.Repetitions);
+
+            vector<string> names(statistics.Filters.size());
+            for (const CascadeFilterStatistics& filter : statistics.Filters)
+            {
+                if (filter.Position >= 0)
+                {
+                    names[filter.Position] = cascadeFilterName(filter.Filter);
+                }
+            }
+            string order;
+            for (const string& name : names)
+            {
+                order += name.empty() || order.empty() ? name : "," + name;
+            }
+            report("filter_cascade", orientation.first + (adaptive ? "_adaptive[" + order + "]" : "_short_circuit"),
+                   seconds, pairs / seconds, "pairs/s");
+        }
+    }
+}
+
+// ***************************************************************************
+
+void benchTraceCrossings(const BenchmarkOptions& options)
+{
+    // one dense fracture: long chords cross almost every other trace, short
+    // segments only a few, where the sweep pays off
+    mt19937_64 generator(options.Seed);
+    uniform_real_distribution<double> coordinate(0.0, 1.0);
+    for (unsigned int numberTraces : {100u, 400u, 1600u})
+    {
+        for (const auto& shape : vector<pair<string, double>>{{"chords", 1.0}, {"short", 0.05}})
+        {
+            vector<LocalTrace> traces(numberTraces);
+            for (LocalTrace& trace : traces)
+            {
+                Vector2d target(coordinate(generator), coordinate(generator));
+                trace.P1 = Vector2d(coordinate(generator), coordinate(generator));
+                trace.P2 = trace.P1 + shape.second * (target - trace.P1);
+            }
+
+            vector<TraceCrossing> crossings;
+            const string variant = shape.first + "_" + to_string(numberTraces);
+            double brute = timeIt([&]()
+            {
+                traceCrossingsBruteForce(traces, crossings);
+            }, options.Repetitions);
+            report("trace_crossings", variant + "_brute_force", brute, numberTraces / brute, "traces/s");
+
+            double sweep = timeIt([&]()
+            {
+                traceCrossingsSweep(traces, crossings);
+            }, options.Repetitions);
+            report("trace_crossings", variant + "_sweep", sweep, numberTraces / sweep, "traces/s");
+            report("trace_crossings", variant + "_crossings", sweep, crossings.size(), "crossings");
+        }
+    }
+
+    Fractures network = syntheticNetwork(options);
+    map<int, vector<int>> intersections;
+    checkIntersections(network, intersections);
+    vector<LocalFracture> local;
+    computeLocalTraces(network, local);
+    const double numberFractures = local.size();
+
+    TraceCrossings crossings;
+    double serial = timeIt([&]()
+    {
+        computeTraceCrossings(local, crossings, 1);
+    }, options.Repetitions);
+    report("trace_crossings", "network_1_thread", serial, numberFractures / serial, "fractures/s");
+
+    double parallel = timeIt([&]()
+    {
+        computeTraceCrossings(local, crossings);
+    }, options.Repetitions);
+    report("trace_crossings", "network_all_threads", parallel, numberFractures / parallel, "fractures/s");
+    report("trace_crossings", "network_crossings", parallel, crossings.size(), "crossings");
+}
+
+// ***************************************************************************
+
+// fixed workloads of the regression suite: two reference networks and two
+// seeded synthetic ones
+vector<RegressionMeasurement> runRegressionWorkloads(unsigned int repetitions)
+{
+    vector<pair<string, function<Fractures()>>> workloads =
+    {
+        {"FR82", []() { Fractures fractures; ImportFractures("DFN/FR82_data.txt", fractures); return fractures; }},
+        {"FR362", []() { Fractures fractures; ImportFractures("DFN/FR362_data.txt", fractures); return fractures; }}
+    };
+    for (unsigned int size : {500u, 1000u})
+    {
+        BenchmarkOptions options;
+        options.Size = size;
+        options.Seed = size;
+        workloads.emplace_back("synthetic_" + to_string(size), [options]() { return syntheticNetwork(options); });
+    }
+
+    vector<RegressionMeasurement> measured;
+    for (const auto& workload : workloads)
+    {
+        Fractures network = workload.second();
+        if (network.FracturesId.empty())
+        {
+            cerr << "Workload " << workload.first << " has no fractures, it is not measured" << endl;
+            continue;
+        }
+
+        resetPeakResident();
+        size_t numberTraces = 0;
+        auto intersect = [&]()
+        {
+            Fractures fractures = network;
+            map<int, vector<int>> intersections;
+            checkIntersections(fractures, intersections);
+            numberTraces = fractures.Traces.size();
+        };
+        // short workloads get more repetitions, so that noise does not fail them
+        double first = timeIt(intersect, 1);
+        unsigned int runs = max<unsigned int>(repetitions, min(50.0, 0.5 / max(first, 1e-6)));
+        double seconds = min(first, timeIt(intersect, runs));
+
+        const double n = network.FracturesId.size();
+        RegressionMeasurement measurement;
+        measurement.Workload = workload.first;
+        measurement.PairsPerSecond = n * (n - 1) / 2 / seconds;
+        measurement.TracesPerSecond = numberTraces / seconds;
+        measurement.PeakMegabytes = peakResidentSinceReset();
+        measured.push_back(measurement);
+        report("regression", workload.first, seconds, measurement.PairsPerSecond, "pairs/s");
+    }
+    return measured;
+}
+
+// ***************************************************************************
+
+// returned when the baseline comes from another build type or host, ctest
+// reports the test as skipped
+const int regressionSkipped = 77;
+
+string regressionBuildType()
+{
+    string buildType = DFN_BUILD_TYPE;
+    return buildType.empty() ? "None" : buildType;
+}
+
+string regressionHost()
+{
+    char name[256] = {};
+    return gethostname(name, sizeof(name) - 1) == 0 ? string(name) : string("unknown");
+}
+
+// ***************************************************************************
+
+int runRegression(const string& baselinePath, double tolerance, bool update, unsigned int repetitions)
+{
+    RegressionBaseline baseline;
+    if (!update)
+    {
+        if (!readRegressionBaseline(baselinePath, baseline))
+        {
+            return 1;
+        }
+        if (!sameEnvironment(baseline, regressionBuildType(), regressionHost(), cerr))
+        {
+            cerr << "Skipping the comparison, rerun with --update-baseline to measure a baseline here" << endl;
+            return regressionSkipped;
+        }
+    }
+
+    vector<RegressionMeasurement> measured = runRegressionWorkloads(repetitions);
+    if (update)
+    {
+        baseline.Tolerance = tolerance >= 0.0 ? tolerance : baseline.Tolerance;
+        baseline.BuildType = regressionBuildType();
+        baseline.Host = regressionHost();
+        baseline.Workloads = measured;
+        return writeRegressionBaseline(baselinePath, baseline) ? 0 : 1;
+    }
+
+    bool passed = compareToBaseline(baseline, measured, tolerance >= 0.0 ? tolerance : baseline.Tolerance, cout);
+    if (!passed)
+    {
+        cerr << "Performance regressed against " << baselinePath << endl;
+    }
+    return passed ? 0 : 1;
+}
+
+// ***************************************************************************
+
+int main(int argc, char** argv)
+{
+    const vector<pair<string, function<void(const BenchmarkOptions&)>>> benchmarks =
+    {
+        {"incremental", benchIncremental},
+        {"cache", benchCache},
+        {"out_of_core", benchOutOfCore},
+        {"multiprocess", benchMultiprocess},
+        {"batch", benchBatch},
+        {"parallel_import", benchParallelImport},
+        {"predicates", benchPredicates},
+        {"prefilter", benchPrefilter},
+        {"rays", benchRays},
+        {"flow", benchFlow},
+        {"trace_statistics", benchTraceStatistics},
+        {"lazy", benchLazy},
+        {"sinks", benchSinks},
+        {"trace_store", benchTraceStore},
+        {"server", benchServer},
+        {"checkpoint", benchCheckpoint},
+        {"trace_sort", benchTraceSort},
+        {"allocations", benchAllocations},
+        {"local_traces", benchLocalTraces},
+        {"paraview", benchParaview},
+        {"filter_cascade", benchFilterCascade},
+        {"trace_crossings", benchTraceCrossings}
+    };
+
+    BenchmarkOptions options;
+    vector<string> selected;
+    string baselinePath;
+    double tolerance = -1.0;
+    bool updateBaseline = false;
+    for (int a = 1; a < argc; a++)
+    {
+        string arg = argv[a];
+        if (arg == "--size" && a + 1 < argc)
+        {
+            options.Size = stoul(argv[++a]);
+        }
+        else if (arg == "--repetitions" && a + 1 < argc)
+        {
+            options.Repetitions = stoul(argv[++a]);
+        }
+        else if (arg == "--seed" && a + 1 < argc)
+        {
+            options.Seed = stoull(argv[++a]);
+        }
+        else if (arg == "--regression" && a + 1 < argc)
+        {
+            baselinePath = argv[++a];
+        }
+        else if (arg == "--tolerance" && a + 1 < argc)
+        {
+            tolerance = stod(argv[++a]);
+        }
+        else if (arg == "--update-baseline")
+        {
+            updateBaseline = true;
+        }
+        else
+        {
+            selected.push_back(arg);
+        }
+    }
+
+    cout << "# Benchmark; Variant; Seconds; Throughput; Unit" << endl;
+    if (!baselinePath.empty())
+    {
+        return runRegression(baselinePath, tolerance, updateBaseline, options.Repetitions);
+    }
+
+    for (const auto& benchmark : benchmarks)
+    {
+        if (selected.empty() || find(selected.begin(), selected.end(), benchmark.first) != selected.end())
+        {
+            benchmark.second(options);
+        }
+    }
+
+    return 0;
+}
@@ -1,5 +1,29 @@
 #include <gtest/gtest.h>
 #include "src_test/DFN_Test.hpp"
+#include "src_test/Ensemble_Test.hpp"
+#include "src_test/Incremental_Test.hpp"
+#include "src_test/Cache_Test.hpp"
+#include "src_test/OutOfCore_Test.hpp"
+#include "src_test/Multiprocess_Test.hpp"
+#include "src_test/Batch_Test.hpp"
+#include "src_test/ParallelImport_Test.hpp"
+#include "src_test/Predicates_Test.hpp"
+#include "src_test/Prefilter_Test.hpp"
+#include "src_test/RayQueries_Test.hpp"
+#include "src_test/Flow_Test.hpp"
+#include "src_test/LazyTraces_Test.hpp"
+#include "src_test/TraceSink_Test.hpp"
+#include "src_test/TraceStore_Test.hpp"
+#include "src_test/Server_Test.hpp"
+#include "src_test/Checkpoint_Test.hpp"
+#include "src_test/Fuzz_Test.hpp"
+#include "src_test/TraceSort_Test.hpp"
+#include "src_test/Allocations_Test.hpp"
+#include "src_test/LocalTraces_Test.hpp"
+#include "src_test/ParaviewExport_Test.hpp"
+#include "src_test/Regression_Test.hpp"
+#include "src_test/FilterCascade_Test.hpp"
+#include "src_test/TraceCrossings_Test.hpp"
 #include "UCD_test.hpp"
 
 int main(int argc, char **argv)
@@ -0,0 +1,289 @@
+#include "Allocations.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define DFN_HAS_RUSAGE
+#endif
+
+#if defined(__linux__)
+#define DFN_HAS_CLEAR_REFS
+#endif
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        atomic<uint64_t> allocations(0);
+        atomic<uint64_t> deallocations(0);
+        atomic<uint64_t> allocatedBytes(0);
+        atomic<uint64_t> liveBytes(0);
+        atomic<uint64_t> peakLiveBytes(0);
+        // the resident peak of the phases ended since the last reset, which
+        // a phase started inside another one has cleared
+        atomic<uint64_t> endedResident(0);
+
+        struct PhaseRegistry
+        {
+            mutex Mutex;
+            vector<string> Order;
+            map<string, PhaseReport> Reports;
+        };
+
+        PhaseRegistry& registry()
+        {
+            static PhaseRegistry phases;
+            return phases;
+        }
+
+        void raisePeak(uint64_t live)
+        {
+            uint64_t peak = peakLiveBytes.load(memory_order_relaxed);
+            while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, memory_order_relaxed))
+            {
+            }
+        }
+
+        uint64_t residentSinceReset()
+        {
+#ifdef DFN_HAS_CLEAR_REFS
+            ifstream status("/proc/self/status");
+            string line;
+            while (getline(status, line))
+            {
+                if (line.compare(0, 6, "VmHWM:") == 0)
+                {
+                    return stoull(line.substr(6)) * 1024;
+                }
+            }
+#endif
+            return peakResidentBytes();
+        }
+    }
+
+// ***************************************************************************
+
+    AllocationCounters allocationCounters()
+    {
+        AllocationCounters counters;
+        counters.Allocations = allocations.load(memory_order_relaxed);
+        counters.Deallocations = deallocations.load(memory_order_relaxed);
+        counters.Bytes = allocatedBytes.load(memory_order_relaxed);
+        counters.LiveBytes = liveBytes.load(memory_order_relaxed);
+        counters.PeakLiveBytes = peakLiveBytes.load(memory_order_relaxed);
+        return counters;
+    }
+
+// ***************************************************************************
+
+    uint64_t peakResidentBytes()
+    {
+#ifdef DFN_HAS_RUSAGE
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss;
+#else
+        return uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#else
+        return 0;
+#endif
+    }
+
+// ***************************************************************************
+
+    void resetPeakResident()
+    {
+#ifdef DFN_HAS_CLEAR_REFS
+        ofstream clear("/proc/self/clear_refs");
+        clear << "5";
+#endif
+    }
+
+// ***************************************************************************
+
+    double peakResidentSinceReset()
+    {
+        return residentSinceReset() / (1024.0 * 1024.0);
+    }
+
+// ***************************************************************************
+
+    AllocationPhase::AllocationPhase(const char* name)
+        : Name(name), SavedPeak(0), SavedResident(0)
+    {
+        if (!allocationTrackingEnabled())
+        {
+            return;
+        }
+
+        // the peak restarts from the live heap, the outer value comes back at the end
+        Before = allocationCounters();
+        SavedPeak = peakLiveBytes.exchange(Before.LiveBytes, memory_order_relaxed);
+        SavedResident = max(endedResident.exchange(0, memory_order_relaxed), residentSinceReset());
+        resetPeakResident();
+        Start = chrono::steady_clock::now();
+    }
+
+// ***************************************************************************
+
+    AllocationPhase::~AllocationPhase()
+    {
+        if (!allocationTrackingEnabled())
+        {
+            return;
+        }
+
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - Start).count();
+        AllocationCounters after = allocationCounters();
+        raisePeak(SavedPeak);
+        uint64_t resident = max(endedResident.load(memory_order_relaxed), residentSinceReset());
+        endedResident.store(max(SavedResident, resident), memory_order_relaxed);
+
+        PhaseRegistry& phases = registry();
+        lock_guard<mutex> lock(phases.Mutex);
+        auto found = phases.Reports.find(Name);
+        if (found == phases.Reports.end())
+        {
+            phases.Order.push_back(Name);
+            found = phases.Reports.emplace(Name, PhaseReport()).first;
+            found->second.Name = Name;
+        }
+
+        PhaseReport& report = found->second;
+        report.Runs++;
+        report.Seconds += seconds;
+        report.Allocations += after.Allocations - Before.Allocations;
+        report.Bytes += after.Bytes - Before.Bytes;
+        report.PeakLiveBytes = max(report.PeakLiveBytes, after.PeakLiveBytes - Before.LiveBytes);
+        report.PeakResidentBytes = max(report.PeakResidentBytes, resident);
+    }
+
+// ***************************************************************************
+
+    vector<PhaseReport> phaseReports()
+    {
+        PhaseRegistry& phases = registry();
+        lock_guard<mutex> lock(phases.Mutex);
+        vector<PhaseReport> reports;
+        for (const string& name : phases.Order)
+        {
+            reports.push_back(phases.Reports[name]);
+        }
+        return reports;
+    }
+
+// ***************************************************************************
+
+    void resetPhaseReports()
+    {
+        PhaseRegistry& phases = registry();
+        lock_guard<mutex> lock(phases.Mutex);
+        phases.Order.clear();
+        phases.Reports.clear();
+    }
+
+// ***************************************************************************
+
+    void printPhaseReports(const vector<PhaseReport>& reports, ostream& out)
+    {
+        out << "# Phase; Runs; Seconds; Allocations; Bytes; PeakLiveBytes; PeakResidentBytes" << endl;
+        for (const PhaseReport& report : reports)
+        {
+            out << report.Name << "; " << report.Runs << "; " << report.Seconds << "; " << report.Allocations
+                << "; " << report.Bytes << "; " << report.PeakLiveBytes << "; " << report.PeakResidentBytes << endl;
+        }
+    }
+
+}
+
+#ifdef DFN_TRACK_ALLOCATIONS
+
+// Every block carries its size in a header in front of it, as wide as the
+// alignment asked for so that the block stays aligned.
+namespace
+{
+    const size_t headerSize = alignof(max_align_t);
+
+    void* trackedAllocate(size_t size, size_t alignment)
+    {
+        size_t header = max(headerSize, alignment);
+        size_t total = (size + header + alignment - 1) / alignment * alignment;
+        void* block = alignment > headerSize ? aligned_alloc(alignment, total) : malloc(size + header);
+        if (block == nullptr)
+        {
+            return nullptr;
+        }
+
+        char* user = static_cast<char*>(block) + header;
+        reinterpret_cast<size_t*>(user)[-1] = size;
+        FractureLibrary::allocations.fetch_add(1, memory_order_relaxed);
+        FractureLibrary::allocatedBytes.fetch_add(size, memory_order_relaxed);
+        uint64_t live = FractureLibrary::liveBytes.fetch_add(size, memory_order_relaxed) + size;
+        FractureLibrary::raisePeak(live);
+        return user;
+    }
+
+    void trackedRelease(void* pointer, size_t alignment)
+    {
+        if (pointer == nullptr)
+        {
+            return;
+        }
+
+        size_t header = max(headerSize, alignment);
+        size_t size = reinterpret_cast<size_t*>(pointer)[-1];
+        FractureLibrary::deallocations.fetch_add(1, memory_order_relaxed);
+        FractureLibrary::liveBytes.fetch_sub(size, memory_order_relaxed);
+        free(static_cast<char*>(pointer) - header);
+    }
+
+    void* allocateOrThrow(size_t size, size_t alignment)
+    {
+        void* pointer = trackedAllocate(size, alignment);
+        while (pointer == nullptr)
+        {
+            new_handler handler = get_new_handler();
+            if (handler == nullptr)
+            {
+                throw bad_alloc();
+            }
+            handler();
+            pointer = trackedAllocate(size, alignment);
+        }
+        return pointer;
+    }
+}
+
+void* operator new(size_t size) { return allocateOrThrow(size, 1); }
+void* operator new[](size_t size) { return allocateOrThrow(size, 1); }
+void* operator new(size_t size, const nothrow_t&) noexcept { return trackedAllocate(size, 1); }
+void* operator new[](size_t size, const nothrow_t&) noexcept { return trackedAllocate(size, 1); }
+void* operator new(size_t size, align_val_t alignment) { return allocateOrThrow(size, size_t(alignment)); }
+void* operator new[](size_t size, align_val_t alignment) { return allocateOrThrow(size, size_t(alignment)); }
+
+void operator delete(void* pointer) noexcept { trackedRelease(pointer, 1); }
+void operator delete[](void* pointer) noexcept { trackedRelease(pointer, 1); }
+void operator delete(void* pointer, size_t) noexcept { trackedRelease(pointer, 1); }
+void operator delete[](void* pointer, size_t) noexcept { trackedRelease(pointer, 1); }
+void operator delete(void* pointer, const nothrow_t&) noexcept { trackedRelease(pointer, 1); }
+void operator delete[](void* pointer, const nothrow_t&) noexcept { trackedRelease(pointer, 1); }
+void operator delete(void* pointer, align_val_t alignment) noexcept { trackedRelease(pointer, size_t(alignment)); }
+void operator delete[](void* pointer, align_val_t alignment) noexcept { trackedRelease(pointer, size_t(alignment)); }
+void operator delete(void* pointer, size_t, align_val_t alignment) noexcept
+{
+    trackedRelease(pointer, size_t(alignment));
+}
+void operator delete[](void* pointer, size_t, align_val_t alignment) noexcept
+{
+    trackedRelease(pointer, size_t(alignment));
+}
+
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+   // Counted by the replacement operator new of Allocations.cpp, built only
+   // with the DFN_TRACK_ALLOCATIONS CMake option; zero otherwise.
+   struct AllocationCounters
+   {
+       uint64_t Allocations;
+       uint64_t Deallocations;
+       uint64_t Bytes;
+       uint64_t LiveBytes;
+       uint64_t PeakLiveBytes;
+
+       AllocationCounters() : Allocations(0), Deallocations(0), Bytes(0), LiveBytes(0), PeakLiveBytes(0) {}
+   };
+
+   constexpr bool allocationTrackingEnabled()
+   {
+#ifdef DFN_TRACK_ALLOCATIONS
+       return true;
+#else
+       return false;
+#endif
+   }
+
+   AllocationCounters allocationCounters();
+
+   // process resident high-water mark
+   uint64_t peakResidentBytes();
+
+   // High water mark of the resident memory since the last reset. Linux
+   // clears it through /proc/self/clear_refs, elsewhere the reset does
+   // nothing and the peak of the whole process is returned.
+   void resetPeakResident();
+
+   double peakResidentSinceReset();
+
+   // sums over every run of a phase of the same name
+   struct PhaseReport
+   {
+       string Name;
+       uint64_t Runs;
+       double Seconds;
+       uint64_t Allocations;
+       uint64_t Bytes;
+       // largest growth of the live heap inside one run
+       uint64_t PeakLiveBytes;
+       // largest resident high-water mark inside one run
+       uint64_t PeakResidentBytes;
+
+       PhaseReport() : Runs(0), Seconds(0.0), Allocations(0), Bytes(0), PeakLiveBytes(0), PeakResidentBytes(0) {}
+   };
+
+   // Marks a pipeline phase for the scope of the object. Records nothing
+   // unless allocation tracking is built in.
+   class AllocationPhase
+   {
+       public:
+           explicit AllocationPhase(const char* name);
+           ~AllocationPhase();
+
+           AllocationPhase(const AllocationPhase&) = delete;
+           AllocationPhase& operator=(const AllocationPhase&) = delete;
+
+       private:
+           const char* Name;
+           chrono::steady_clock::time_point Start;
+           AllocationCounters Before;
+           uint64_t SavedPeak;
+           uint64_t SavedResident;
+   };
+
+   // in the order the phases first ran
+   vector<PhaseReport> phaseReports();
+
+   void resetPhaseReports();
+
+   void printPhaseReports(const vector<PhaseReport>& reports, ostream& out);
+
+}
@@ -0,0 +1,284 @@
+#include "Batch.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        struct BatchItem
+        {
+            string Input;
+            string Name;
+            Fractures Network;
+            map<int, vector<int>> Intersections;
+        };
+
+        double secondsSince(const chrono::steady_clock::time_point& start)
+        {
+            return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+    }
+
+// ***************************************************************************
+
+    bool matchWildcard(const string& pattern, const string& name)
+    {
+        size_t p = 0, n = 0;
+        size_t star = string::npos, resume = 0;
+
+        while (n < name.size())
+        {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n]))
+            {
+                p++;
+                n++;
+            }
+            else if (p < pattern.size() && pattern[p] == '*')
+            {
+                star = p++;
+                resume = n;
+            }
+            else if (star != string::npos)
+            {
+                p = star + 1;
+                n = ++resume;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        while (p < pattern.size() && pattern[p] == '*')
+        {
+            p++;
+        }
+        return p == pattern.size();
+    }
+
+// ***************************************************************************
+
+    vector<string> expandInputs(const vector<string>& arguments)
+    {
+        vector<string> files;
+        error_code error;
+
+        for (const auto& argument : arguments)
+        {
+            if (!argument.empty() && argument[0] == '@')
+            {
+                // a list file, one input per line
+                ifstream list(argument.substr(1));
+                if (!list)
+                {
+                    cerr << "File open failed: " << argument.substr(1) << endl;
+                    continue;
+                }
+
+                vector<string> listed;
+                string line;
+                while (getline(list, line))
+                {
+                    if (!line.empty() && line[0] != '#')
+                    {
+                        listed.push_back(line);
+                    }
+                }
+                vector<string> expanded = expandInputs(listed);
+                files.insert(files.end(), expanded.begin(), expanded.end());
+                continue;
+            }
+
+            filesystem::path path(argument);
+            string name = path.filename().string();
+            bool wildcard = name.find_first_of("*?") != string::npos;
+
+            if (!wildcard && filesystem::is_directory(path, error))
+            {
+                vector<string> found;
+                for (const auto& entry : filesystem::directory_iterator(path, error))
+                {
+                    if (entry.is_regular_file(error) && entry.path().extension() == ".txt")
+                    {
+                        found.push_back(entry.path().string());
+                    }
+                }
+                sort(found.begin(), found.end());
+                files.insert(files.end(), found.begin(), found.end());
+            }
+            else if (wildcard)
+            {
+                filesystem::path folder = path.parent_path().empty() ? filesystem::path(".") : path.parent_path();
+                vector<string> found;
+                for (const auto& entry : filesystem::directory_iterator(folder, error))
+                {
+                    if (entry.is_regular_file(error) && matchWildcard(name, entry.path().filename().string()))
+                    {
+                        found.push_back((path.parent_path() / entry.path().filename()).string());
+                    }
+                }
+                sort(found.begin(), found.end());
+                files.insert(files.end(), found.begin(), found.end());
+            }
+            else
+            {
+                files.push_back(argument);
+            }
+        }
+
+        return files;
+    }
+
+// ***************************************************************************
+
+    bool runBatch(const vector<string>& files,
+                  const BatchParameters& parameters,
+                  BatchStatistics& statistics)
+    {
+        statistics = BatchStatistics();
+
+        ThreadPool pool(parameters.NumberThreads);
+        // backpressure: a file only enters the pipeline when one has left it
+        const unsigned int inFlight = parameters.MaxFilesInFlight > 0 ? parameters.MaxFilesInFlight
+                                                                       : 2 * pool.size();
+        Semaphore slots(inFlight);
+
+        mutex statisticsMutex;
+        atomic<size_t> failed(0);
+
+        auto start = chrono::steady_clock::now();
+
+        // a malformed file throws from the parser; it fails alone and the
+        // batch goes on
+        auto fail = [&](const BatchItem& item, const string& message)
+        {
+            cerr << "Error processing " << item.Input << ": " << message << endl;
+            failed++;
+            slots.release();
+        };
+
+        // inputs with the same name in different folders would write the
+        // same output files
+        map<string, string> outputs;
+
+        for (const auto& input : files)
+        {
+            slots.acquire();
+
+            auto item = make_shared<BatchItem>();
+            item->Input = input;
+            item->Name = filesystem::path(input).filename().string();
+
+            auto claimed = outputs.emplace(item->Name, input);
+            if (!claimed.second)
+            {
+                fail(*item, "same output name as " + claimed.first->second);
+                continue;
+            }
+
+            // import -> intersect -> write, each stage resubmits the next one so
+            // that different stages of consecutive files overlap on the pool
+            pool.submit([&, item]()
+            {
+                try
+                {
+                    auto begin = chrono::steady_clock::now();
+                    error_code error;
+                    size_t bytes = filesystem::file_size(item->Input, error);
+                    bool imported = ImportFractures(item->Input, item->Network);
+                    double seconds = secondsSince(begin);
+                    {
+                        lock_guard<mutex> lock(statisticsMutex);
+                        statistics.ImportSeconds += seconds;
+                        statistics.InputBytes += error ? 0 : bytes;
+                    }
+
+                    if (!imported)
+                    {
+                        fail(*item, "import failed");
+                        return;
+                    }
+                }
+                catch (const exception& exception)
+                {
+                    fail(*item, exception.what());
+                    return;
+                }
+
+                pool.submit([&, item]()
+                {
+                    try
+                    {
+                        auto begin = chrono::steady_clock::now();
+                        checkIntersections(item->Network, item->Intersections);
+                        double seconds = secondsSince(begin);
+                        lock_guard<mutex> lock(statisticsMutex);
+                        statistics.IntersectSeconds += seconds;
+                    }
+                    catch (const exception& exception)
+                    {
+                        fail(*item, exception.what());
+                        return;
+                    }
+
+                    pool.submit([&, item]()
+                    {
+                        try
+                        {
+                            auto begin = chrono::steady_clock::now();
+                            filesystem::path folder(parameters.OutputFolder);
+                            writeTraces(item->Network, (folder / (item->Name + "_traces.txt")).string());
+                            writeResults(item->Network, (folder / (item->Name + "_results.txt")).string());
+                            double seconds = secondsSince(begin);
+                            lock_guard<mutex> lock(statisticsMutex);
+                            statistics.WriteSeconds += seconds;
+                            statistics.NumberFiles++;
+                            statistics.NumberFractures += item->Network.FracturesId.size();
+                            statistics.NumberTraces += item->Network.Traces.size();
+                        }
+                        catch (const exception& exception)
+                        {
+                            fail(*item, exception.what());
+                            return;
+                        }
+                        slots.release();
+                    });
+                });
+            });
+        }
+
+        pool.wait();
+
+        statistics.FailedFiles = failed;
+        statistics.ElapsedSeconds = secondsSince(start);
+
+        return statistics.FailedFiles == 0;
+    }
+
+// ***************************************************************************
+
+    void printBatchStatistics(const BatchStatistics& statistics,
+                              ostream& out)
+    {
+        double elapsed = statistics.ElapsedSeconds > 0 ? statistics.ElapsedSeconds : 1.0;
+
+        out << "# Files; Failed; Fractures; Traces; Seconds" << endl;
+        out << statistics.NumberFiles << "; " << statistics.FailedFiles << "; "
+            << statistics.NumberFractures << "; " << statistics.NumberTraces << "; "
+            << statistics.ElapsedSeconds << endl;
+        out << "# FilesPerSecond; FracturesPerSecond; MegabytesPerSecond" << endl;
+        out << statistics.NumberFiles / elapsed << "; " << statistics.NumberFractures / elapsed << "; "
+            << statistics.InputBytes / 1048576.0 / elapsed << endl;
+        out << "# ImportSeconds; IntersectSeconds; WriteSeconds" << endl;
+        out << statistics.ImportSeconds << "; " << statistics.IntersectSeconds << "; "
+            << statistics.WriteSeconds << endl;
+    }
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   struct BatchParameters
+   {
+       unsigned int NumberThreads;
+       unsigned int MaxFilesInFlight;
+       string OutputFolder;
+
+       BatchParameters() : NumberThreads(0), MaxFilesInFlight(0), OutputFolder("./") {}
+   };
+
+   struct BatchStatistics
+   {
+       size_t NumberFiles;
+       size_t FailedFiles;
+       size_t NumberFractures;
+       size_t NumberTraces;
+       size_t InputBytes;
+       double ImportSeconds;
+       double IntersectSeconds;
+       double WriteSeconds;
+       double ElapsedSeconds;
+
+       BatchStatistics()
+           : NumberFiles(0), FailedFiles(0), NumberFractures(0), NumberTraces(0), InputBytes(0),
+             ImportSeconds(0), IntersectSeconds(0), WriteSeconds(0), ElapsedSeconds(0) {}
+   };
+
+   bool matchWildcard(const string& pattern, const string& name);
+
+   vector<string> expandInputs(const vector<string>& arguments);
+
+   bool runBatch(const vector<string>& files,
+                 const BatchParameters& parameters,
+                 BatchStatistics& statistics);
+
+   void printBatchStatistics(const BatchStatistics& statistics,
+                             ostream& out);
+
+}
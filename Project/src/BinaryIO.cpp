@@ -0,0 +1,183 @@
+#include "BinaryIO.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        // bytes of one trace record and one neighbour
+        const uint64_t traceRecordSize = 3 * sizeof(int32_t) + 6 * sizeof(double) + 2 * sizeof(uint8_t) + sizeof(double);
+        const uint64_t neighbourRecordSize = sizeof(int32_t);
+
+        // when the stream cannot tell its size, only this many records are
+        // reserved up front
+        const uint64_t unknownSizeReserve = 1 << 16;
+    }
+
+// ***************************************************************************
+
+    bool countFits(istream& in, uint64_t count, uint64_t recordSize, uint64_t& reserve)
+    {
+        reserve = min(count, unknownSizeReserve);
+        streampos position = in.tellg();
+        if (position == streampos(-1))
+        {
+            in.clear();
+            return true;
+        }
+        in.seekg(0, ios::end);
+        streampos end = in.tellg();
+        in.seekg(position);
+        if (end == streampos(-1) || !in)
+        {
+            in.clear();
+            in.seekg(position);
+            return true;
+        }
+        reserve = count;
+        return count <= uint64_t(end - position) / recordSize;
+    }
+
+// ***************************************************************************
+
+    void writeTraceBinary(ostream& out, const Trace& trace)
+    {
+        writeBinary<int32_t>(out, trace.traceId);
+        writeBinary<int32_t>(out, trace.fractureId1);
+        writeBinary<int32_t>(out, trace.fractureId2);
+        writeBinary(out, trace.p1.x);
+        writeBinary(out, trace.p1.y);
+        writeBinary(out, trace.p1.z);
+        writeBinary(out, trace.p2.x);
+        writeBinary(out, trace.p2.y);
+        writeBinary(out, trace.p2.z);
+        writeBinary<uint8_t>(out, trace.Tips1);
+        writeBinary<uint8_t>(out, trace.Tips2);
+        writeBinary(out, trace.length);
+    }
+
+// ***************************************************************************
+
+    bool readTraceBinary(istream& in, Trace& trace)
+    {
+        int32_t id, f1, f2;
+        uint8_t tips1, tips2;
+
+        bool ok = readBinary(in, id) && readBinary(in, f1) && readBinary(in, f2) &&
+                  readBinary(in, trace.p1.x) && readBinary(in, trace.p1.y) && readBinary(in, trace.p1.z) &&
+                  readBinary(in, trace.p2.x) && readBinary(in, trace.p2.y) && readBinary(in, trace.p2.z) &&
+                  readBinary(in, tips1) && readBinary(in, tips2) && readBinary(in, trace.length);
+
+        trace.traceId = id;
+        trace.fractureId1 = f1;
+        trace.fractureId2 = f2;
+        trace.Tips1 = tips1 != 0;
+        trace.Tips2 = tips2 != 0;
+
+        return ok;
+    }
+
+// ***************************************************************************
+
+    void writeTracesBinary(ostream& out, const vector<Trace>& traces)
+    {
+        writeBinary<uint64_t>(out, traces.size());
+        for (const auto& trace : traces)
+        {
+            writeTraceBinary(out, trace);
+        }
+    }
+
+// ***************************************************************************
+
+    bool readTracesBinary(istream& in, vector<Trace>& traces)
+    {
+        uint64_t numTraces;
+        if (!readBinary(in, numTraces))
+        {
+            return false;
+        }
+
+        uint64_t reserve;
+        if (!countFits(in, numTraces, traceRecordSize, reserve))
+        {
+            return false;
+        }
+
+        traces.clear();
+        traces.reserve(reserve);
+        Trace trace(0, 0, 0, Point(), Point(), false, false);
+        for (uint64_t t = 0; t < numTraces; t++)
+        {
+            if (!readTraceBinary(in, trace))
+            {
+                return false;
+            }
+            traces.push_back(trace);
+        }
+
+        return true;
+    }
+
+// ***************************************************************************
+
+    void writeIntersectionsBinary(ostream& out, const map<int, vector<int>>& intersections)
+    {
+        writeBinary<uint64_t>(out, intersections.size());
+        for (const auto& entry : intersections)
+        {
+            writeBinary<int32_t>(out, entry.first);
+            writeBinary<uint64_t>(out, entry.second.size());
+            for (int neighbour : entry.second)
+            {
+                writeBinary<int32_t>(out, neighbour);
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    bool readIntersectionsBinary(istream& in, map<int, vector<int>>& intersections)
+    {
+        uint64_t numEntries;
+        if (!readBinary(in, numEntries))
+        {
+            return false;
+        }
+
+        intersections.clear();
+        for (uint64_t e = 0; e < numEntries; e++)
+        {
+            int32_t id;
+            uint64_t numNeighbours;
+            if (!readBinary(in, id) || !readBinary(in, numNeighbours))
+            {
+                return false;
+            }
+
+            uint64_t reserve;
+            if (!countFits(in, numNeighbours, neighbourRecordSize, reserve))
+            {
+                return false;
+            }
+
+            vector<int>& neighbours = intersections[id];
+            neighbours.clear();
+            neighbours.reserve(reserve);
+            for (uint64_t k = 0; k < numNeighbours; k++)
+            {
+                int32_t neighbour;
+                if (!readBinary(in, neighbour))
+                {
+                    return false;
+                }
+                neighbours.push_back(neighbour);
+            }
+        }
+
+        return true;
+    }
+
+}
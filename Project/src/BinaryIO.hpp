@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   template <typename T>
+   void writeBinary(ostream& out, const T& value)
+   {
+       out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+   }
+
+   template <typename T>
+   bool readBinary(istream& in, T& value)
+   {
+       return bool(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+   }
+
+   // A count read from a corrupt file must not drive the allocation: false
+   // when count records do not fit in what is left of the stream. reserve
+   // is what may be allocated up front, bounded when the stream cannot tell
+   // its size.
+   bool countFits(istream& in, uint64_t count, uint64_t recordSize, uint64_t& reserve);
+
+   void writeTraceBinary(ostream& out, const Trace& trace);
+
+   bool readTraceBinary(istream& in, Trace& trace);
+
+   void writeTracesBinary(ostream& out, const vector<Trace>& traces);
+
+   bool readTracesBinary(istream& in, vector<Trace>& traces);
+
+   void writeIntersectionsBinary(ostream& out, const map<int, vector<int>>& intersections);
+
+   bool readIntersectionsBinary(istream& in, map<int, vector<int>>& intersections);
+
+}
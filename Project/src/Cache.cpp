@@ -0,0 +1,253 @@
+#include "Cache.hpp"
+#include "BinaryIO.hpp"
+#include "Utils.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+
+#ifndef DFN_VERSION
+#define DFN_VERSION "unknown"
+#endif
+
+namespace FractureLibrary
+{
+
+    // DFN_VERSION carries the commit when the tree is a git checkout; bump
+    // the format number whenever the intersection results may change, for
+    // builds without it
+    const string codeVersion = string(DFN_VERSION) + "/cache-2";
+
+    static const char cacheMagic[4] = {'D', 'F', 'N', 'C'};
+    static const string cacheExtension = ".dfncache";
+
+// ***************************************************************************
+
+    unsigned long long hashFractures(const Fractures& fractures)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](const void* data, size_t size)
+        {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for (size_t b = 0; b < size; b++)
+            {
+                hash ^= bytes[b];
+                hash *= 1099511628211ULL;
+            }
+        };
+
+        mix(codeVersion.data(), codeVersion.size());
+        mix(&epsilon, sizeof(epsilon));
+
+        uint64_t numberFractures = fractures.NumberFractures;
+        uint64_t size = fractures.FracturesId.size();
+        mix(&numberFractures, sizeof(numberFractures));
+        mix(&size, sizeof(size));
+
+        for (size_t i = 0; i < fractures.FracturesId.size(); i++)
+        {
+            uint32_t id = fractures.FracturesId[i];
+            uint64_t cols = fractures.FracturesVertices[i].cols();
+            mix(&id, sizeof(id));
+            mix(&cols, sizeof(cols));
+            mix(fractures.FracturesVertices[i].data(), sizeof(double) * 3 * cols);
+        }
+
+        return hash;
+    }
+
+// ***************************************************************************
+
+    IntersectionCache::IntersectionCache(const string& directory)
+        : Directory(directory)
+    {
+        error_code error;
+        filesystem::create_directories(Directory, error);
+        if (error)
+        {
+            cerr << "Failed to create cache directory: " << Directory << endl;
+        }
+    }
+
+// ***************************************************************************
+
+    string IntersectionCache::entryPath(unsigned long long key) const
+    {
+        ostringstream name;
+        name << hex << setw(16) << setfill('0') << key << cacheExtension;
+        return (filesystem::path(Directory) / name.str()).string();
+    }
+
+// ***************************************************************************
+
+    bool IntersectionCache::checkIntersections(Fractures& fractures,
+                                               map<int, vector<int>>& intersections)
+    {
+        auto start = chrono::steady_clock::now();
+        unsigned long long key = hashFractures(fractures);
+        bool hit = load(key, fractures, intersections);
+        auto lookup = chrono::steady_clock::now();
+        Statistics.LookupSeconds += chrono::duration<double>(lookup - start).count();
+
+        if (hit)
+        {
+            Statistics.Hits++;
+            return true;
+        }
+
+        Statistics.Misses++;
+        fractures.Traces.clear();
+        intersections.clear();
+        FractureLibrary::checkIntersections(fractures, intersections);
+        Statistics.ComputeSeconds += chrono::duration<double>(chrono::steady_clock::now() - lookup).count();
+
+        store(key, fractures, intersections);
+        return false;
+    }
+
+// ***************************************************************************
+
+    bool IntersectionCache::load(unsigned long long key,
+                                 Fractures& fractures,
+                                 map<int, vector<int>>& intersections)
+    {
+        string path = entryPath(key);
+        ifstream file(path, ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        char magic[4];
+        uint64_t storedKey, numberFractures;
+        uint32_t versionSize;
+        if (!file.read(magic, 4) || memcmp(magic, cacheMagic, 4) != 0 ||
+            !readBinary(file, versionSize) || versionSize != codeVersion.size())
+        {
+            Statistics.Errors++;
+            return false;
+        }
+
+        string version(versionSize, '\0');
+        if (!file.read(&version[0], versionSize) || version != codeVersion ||
+            !readBinary(file, storedKey) || storedKey != key ||
+            !readBinary(file, numberFractures) || numberFractures != fractures.FracturesId.size())
+        {
+            Statistics.Errors++;
+            return false;
+        }
+
+        vector<Trace> traces;
+        map<int, vector<int>> adjacency;
+        if (!readTracesBinary(file, traces) || !readIntersectionsBinary(file, adjacency))
+        {
+            cerr << "Corrupted cache entry: " << path << endl;
+            Statistics.Errors++;
+            return false;
+        }
+
+        Statistics.BytesRead += file.tellg();
+        fractures.Traces = move(traces);
+        intersections = move(adjacency);
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool IntersectionCache::store(unsigned long long key,
+                                  const Fractures& fractures,
+                                  const map<int, vector<int>>& intersections)
+    {
+        string path = entryPath(key);
+        // write aside and rename, so that concurrent readers never see a partial entry
+        string temporary = path + ".tmp" + to_string(chrono::steady_clock::now().time_since_epoch().count());
+
+        {
+            ofstream file(temporary, ios::binary);
+            if (!file)
+            {
+                cerr << "Failed to open cache entry for writing: " << temporary << endl;
+                Statistics.Errors++;
+                return false;
+            }
+
+            file.write(cacheMagic, 4);
+            writeBinary<uint32_t>(file, codeVersion.size());
+            file.write(codeVersion.data(), codeVersion.size());
+            writeBinary<uint64_t>(file, key);
+            writeBinary<uint64_t>(file, fractures.FracturesId.size());
+            writeTracesBinary(file, fractures.Traces);
+            writeIntersectionsBinary(file, intersections);
+
+            if (!file)
+            {
+                Statistics.Errors++;
+                return false;
+            }
+            Statistics.BytesWritten += file.tellp();
+        }
+
+        error_code error;
+        filesystem::rename(temporary, path, error);
+        if (error)
+        {
+            filesystem::remove(temporary, error);
+            Statistics.Errors++;
+            return false;
+        }
+
+        Statistics.Stores++;
+        return true;
+    }
+
+// ***************************************************************************
+
+    unsigned long long IntersectionCache::invalidate()
+    {
+        unsigned long long removed = 0;
+        error_code error;
+        for (const auto& entry : filesystem::directory_iterator(Directory, error))
+        {
+            if (entry.path().extension() == cacheExtension && filesystem::remove(entry.path(), error))
+            {
+                removed++;
+            }
+        }
+        return removed;
+    }
+
+// ***************************************************************************
+
+    CacheUsage IntersectionCache::usage() const
+    {
+        CacheUsage usage = {0, 0};
+        error_code error;
+        for (const auto& entry : filesystem::directory_iterator(Directory, error))
+        {
+            if (entry.path().extension() == cacheExtension)
+            {
+                usage.Entries++;
+                usage.Bytes += entry.file_size(error);
+            }
+        }
+        return usage;
+    }
+
+// ***************************************************************************
+
+    void printCacheStatistics(const CacheStatistics& statistics,
+                              const CacheUsage& usage,
+                              ostream& out)
+    {
+        out << "# Hits; Misses; Stores; Errors" << endl;
+        out << statistics.Hits << "; " << statistics.Misses << "; "
+            << statistics.Stores << "; " << statistics.Errors << endl;
+        out << "# BytesRead; BytesWritten; LookupSeconds; ComputeSeconds" << endl;
+        out << statistics.BytesRead << "; " << statistics.BytesWritten << "; "
+            << statistics.LookupSeconds << "; " << statistics.ComputeSeconds << endl;
+        out << "# Entries; Bytes" << endl;
+        out << usage.Entries << "; " << usage.Bytes << endl;
+    }
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   extern const string codeVersion;
+
+   unsigned long long hashFractures(const Fractures& fractures);
+
+   struct CacheStatistics
+   {
+       unsigned long long Hits;
+       unsigned long long Misses;
+       unsigned long long Stores;
+       unsigned long long Errors;
+       unsigned long long BytesRead;
+       unsigned long long BytesWritten;
+       double LookupSeconds;
+       double ComputeSeconds;
+
+       CacheStatistics()
+           : Hits(0), Misses(0), Stores(0), Errors(0), BytesRead(0), BytesWritten(0),
+             LookupSeconds(0), ComputeSeconds(0) {}
+   };
+
+   struct CacheUsage
+   {
+       unsigned long long Entries;
+       unsigned long long Bytes;
+   };
+
+   class IntersectionCache
+   {
+       public:
+           explicit IntersectionCache(const string& directory);
+
+           bool checkIntersections(Fractures& fractures,
+                                   map<int, vector<int>>& intersections);
+
+           bool load(unsigned long long key,
+                     Fractures& fractures,
+                     map<int, vector<int>>& intersections);
+
+           bool store(unsigned long long key,
+                      const Fractures& fractures,
+                      const map<int, vector<int>>& intersections);
+
+           unsigned long long invalidate();
+
+           CacheUsage usage() const;
+
+           string entryPath(unsigned long long key) const;
+
+           const CacheStatistics& statistics() const { return Statistics; }
+
+       private:
+           string Directory;
+           CacheStatistics Statistics;
+   };
+
+   void printCacheStatistics(const CacheStatistics& statistics,
+                             const CacheUsage& usage,
+                             ostream& out);
+
+}
@@ -0,0 +1,353 @@
+#include "Checkpoint.hpp"
+#include "BinaryIO.hpp"
+#include "Cache.hpp"
+#include "ThreadPool.hpp"
+#include "TraceSink.hpp"
+#include "Utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        const char checkpointMagic[4] = {'D', 'F', 'N', 'K'};
+        const uint32_t segmentMagic = 0x32474553;
+
+        // an accepted pair whose trace could not be built, after Position
+        // traces of the checkpoint
+        struct UntracedPair
+        {
+            uint64_t Position;
+            int32_t FractureId1;
+            int32_t FractureId2;
+        };
+
+        // what happened between two checkpoints; the accepted pairs are
+        // those of the traces and the untraced ones
+        struct Segment
+        {
+            uint64_t NextRow;
+            int32_t TraceId;
+            vector<UntracedPair> Untraced;
+            vector<Trace> Traces;
+
+            Segment() : NextRow(0), TraceId(0) {}
+        };
+
+        // collects as checkIntersections does and keeps the untraced pairs
+        // of the next segment; a block holds the traces of the pairs accepted
+        // since the last one, in the same order
+        class CheckpointSink : public CollectingSink
+        {
+            public:
+                CheckpointSink(Fractures& fractures, map<int, vector<int>>& intersections, Segment& pending,
+                               size_t firstTrace)
+                    : CollectingSink(fractures, intersections), DFN(fractures), Pending(pending),
+                      FirstTrace(firstTrace) {}
+
+                void intersecting(int fractureId1, int fractureId2) override
+                {
+                    CollectingSink::intersecting(fractureId1, fractureId2);
+                    Accepted.emplace_back(fractureId1, fractureId2);
+                }
+
+                void consume(const vector<Trace>& block) override
+                {
+                    size_t t = 0;
+                    for (const auto& accepted : Accepted)
+                    {
+                        if (t < block.size() && block[t].fractureId1 == accepted.first &&
+                            block[t].fractureId2 == accepted.second)
+                        {
+                            t++;
+                            continue;
+                        }
+                        Pending.Untraced.push_back({DFN.Traces.size() + t - FirstTrace, accepted.first, accepted.second});
+                    }
+                    Accepted.clear();
+                    CollectingSink::consume(block);
+                }
+
+                // the pairs left over had no trace
+                void settle()
+                {
+                    consume({});
+                }
+
+            private:
+                Fractures& DFN;
+                Segment& Pending;
+                size_t FirstTrace;
+                vector<pair<int, int>> Accepted;
+        };
+
+        uint64_t checksum(const string& bytes)
+        {
+            uint64_t hash = 14695981039346656037ULL;
+            for (unsigned char byte : bytes)
+            {
+                hash ^= byte;
+                hash *= 1099511628211ULL;
+            }
+            return hash;
+        }
+
+        string encode(const Segment& segment)
+        {
+            ostringstream out(ios::binary);
+            writeBinary<uint64_t>(out, segment.NextRow);
+            writeBinary<int32_t>(out, segment.TraceId);
+            writeBinary<uint64_t>(out, segment.Untraced.size());
+            for (const UntracedPair& untraced : segment.Untraced)
+            {
+                writeBinary<uint64_t>(out, untraced.Position);
+                writeBinary<int32_t>(out, untraced.FractureId1);
+                writeBinary<int32_t>(out, untraced.FractureId2);
+            }
+            writeTracesBinary(out, segment.Traces);
+            return out.str();
+        }
+
+        bool decode(const string& bytes, Segment& segment)
+        {
+            istringstream in(bytes, ios::binary);
+            uint64_t numberPairs = 0;
+            if (!readBinary(in, segment.NextRow) || !readBinary(in, segment.TraceId) ||
+                !readBinary(in, numberPairs) || numberPairs > bytes.size())
+            {
+                return false;
+            }
+            segment.Untraced.resize(numberPairs);
+            for (UntracedPair& untraced : segment.Untraced)
+            {
+                if (!readBinary(in, untraced.Position) || !readBinary(in, untraced.FractureId1) ||
+                    !readBinary(in, untraced.FractureId2))
+                {
+                    return false;
+                }
+            }
+            return readTracesBinary(in, segment.Traces);
+        }
+
+        // replays the whole segments of the file into state; returns the
+        // length of the valid prefix, zero when the file cannot be used
+        uint64_t readCheckpoint(const string& path, uint64_t hash, Segment& state)
+        {
+            ifstream file(path, ios::binary);
+            char magic[4];
+            uint64_t stored = 0;
+            if (!file.read(magic, 4) || memcmp(magic, checkpointMagic, 4) != 0 ||
+                !readBinary(file, stored))
+            {
+                return 0;
+            }
+            if (stored != hash)
+            {
+                cerr << "Checkpoint " << path << " belongs to another network, starting over" << endl;
+                return 0;
+            }
+
+            uint64_t valid = file.tellg();
+            while (true)
+            {
+                uint32_t marker = 0;
+                uint64_t bytes = 0;
+                uint64_t sum = 0;
+                if (!readBinary(file, marker) || marker != segmentMagic ||
+                    !readBinary(file, bytes) || !readBinary(file, sum))
+                {
+                    break;
+                }
+
+                string payload(bytes, '\0');
+                Segment segment;
+                if (!file.read(&payload[0], bytes) || checksum(payload) != sum || !decode(payload, segment))
+                {
+                    break;
+                }
+
+                state.NextRow = segment.NextRow;
+                state.TraceId = segment.TraceId;
+                state.Untraced.insert(state.Untraced.end(), segment.Untraced.begin(), segment.Untraced.end());
+                state.Traces.insert(state.Traces.end(), segment.Traces.begin(), segment.Traces.end());
+                valid = file.tellg();
+            }
+            return valid;
+        }
+
+        bool appendSegment(const string& path, const Segment& segment, uint64_t& bytesWritten)
+        {
+            string payload = encode(segment);
+            ofstream file(path, ios::binary | ios::app);
+            writeBinary<uint32_t>(file, segmentMagic);
+            writeBinary<uint64_t>(file, payload.size());
+            writeBinary<uint64_t>(file, checksum(payload));
+            file.write(payload.data(), payload.size());
+            file.flush();
+            if (!file)
+            {
+                cerr << "Failed to write checkpoint " << path << endl;
+                return false;
+            }
+            bytesWritten += sizeof(uint32_t) + 2 * sizeof(uint64_t) + payload.size();
+            return true;
+        }
+    }
+
+// ***************************************************************************
+
+    bool checkIntersectionsCheckpointed(Fractures& fractures,
+                                        map<int, vector<int>>& intersections,
+                                        const CheckpointParameters& parameters,
+                                        CheckpointStatistics& statistics)
+    {
+        auto start = chrono::steady_clock::now();
+        statistics = CheckpointStatistics();
+        const uint64_t hash = hashFractures(fractures);
+
+        Segment resumed;
+        uint64_t valid = readCheckpoint(parameters.Path, hash, resumed);
+        if (valid == 0)
+        {
+            ofstream file(parameters.Path, ios::binary | ios::trunc);
+            file.write(checkpointMagic, 4);
+            writeBinary<uint64_t>(file, hash);
+            if (!file)
+            {
+                cerr << "Failed to create checkpoint " << parameters.Path << endl;
+                return false;
+            }
+        }
+        else
+        {
+            // drop a segment torn by the interruption, later ones are appended
+            error_code error;
+            filesystem::resize_file(parameters.Path, valid, error);
+        }
+
+        // the accepted pairs in their order: each untraced one before the
+        // trace at its position
+        PairKernelState state;
+        const unordered_set<int> repeatedIds = repeatedFractureIds(fractures);
+        auto accept = [&](int id1, int id2)
+        {
+            intersections[id1].push_back(id2);
+            intersections[id2].push_back(id1);
+            if (repeatedIds.count(id1) > 0 || repeatedIds.count(id2) > 0)
+            {
+                state.PairFound.insert(FracturePair(id1, id2, fractures.NumberFractures));
+            }
+        };
+        size_t untraced = 0;
+        for (size_t t = 0; t <= resumed.Traces.size(); t++)
+        {
+            for (; untraced < resumed.Untraced.size() && resumed.Untraced[untraced].Position <= t; untraced++)
+            {
+                accept(resumed.Untraced[untraced].FractureId1, resumed.Untraced[untraced].FractureId2);
+            }
+            if (t < resumed.Traces.size())
+            {
+                accept(resumed.Traces[t].fractureId1, resumed.Traces[t].fractureId2);
+            }
+        }
+        for (; untraced < resumed.Untraced.size(); untraced++)
+        {
+            accept(resumed.Untraced[untraced].FractureId1, resumed.Untraced[untraced].FractureId2);
+        }
+        const size_t firstTrace = fractures.Traces.size();
+        fractures.Traces.insert(fractures.Traces.end(), resumed.Traces.begin(), resumed.Traces.end());
+        statistics.ResumedRow = resumed.NextRow;
+        statistics.ResumedTraces = resumed.Traces.size();
+        state.NextRow = resumed.NextRow;
+        state.TraceId = resumed.TraceId;
+
+        // at most one segment is being written; a due checkpoint waits for it
+        ThreadPool writer(1);
+        atomic<bool> busy(false);
+        atomic<bool> failed(false);
+        uint64_t bytesWritten = 0;
+        double writeSeconds = 0.0;
+        Segment pending;
+        size_t handedTraces = fractures.Traces.size();
+        size_t handedRow = resumed.NextRow;
+        auto lastCheckpoint = chrono::steady_clock::now();
+        CheckpointSink sink(fractures, intersections, pending, firstTrace);
+
+        auto handOver = [&](size_t nextRow)
+        {
+            auto begin = chrono::steady_clock::now();
+            auto segment = make_shared<Segment>();
+            segment->NextRow = nextRow;
+            segment->TraceId = state.TraceId;
+            sink.settle();
+            segment->Untraced.swap(pending.Untraced);
+            segment->Traces.assign(fractures.Traces.begin() + handedTraces, fractures.Traces.end());
+            handedTraces = fractures.Traces.size();
+            handedRow = nextRow;
+
+            busy = true;
+            writer.submit([&, segment]()
+            {
+                auto writing = chrono::steady_clock::now();
+                if (!appendSegment(parameters.Path, *segment, bytesWritten))
+                {
+                    failed = true;
+                }
+                writeSeconds += chrono::duration<double>(chrono::steady_clock::now() - writing).count();
+                busy = false;
+            });
+            statistics.Checkpoints++;
+            lastCheckpoint = chrono::steady_clock::now();
+            statistics.StallSeconds += chrono::duration<double>(lastCheckpoint - begin).count();
+        };
+
+        PairKernel kernel;
+        size_t rows = 0;
+        kernel.RowDone = [&](size_t i)
+        {
+            rows++;
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - lastCheckpoint).count();
+            if (!busy && elapsed >= parameters.IntervalSeconds)
+            {
+                handOver(i + 1);
+            }
+            return parameters.StopAfterRows == 0 || rows < parameters.StopAfterRows;
+        };
+        bool done = runPairKernel(fractures, sink, kernel, state);
+
+        if (state.NextRow != handedRow && (!done || !parameters.RemoveOnSuccess))
+        {
+            handOver(state.NextRow);
+        }
+        writer.wait();
+
+        statistics.NextRow = state.NextRow;
+        statistics.BytesWritten = bytesWritten;
+        statistics.WriteSeconds = writeSeconds;
+        if (done && parameters.RemoveOnSuccess)
+        {
+            error_code error;
+            filesystem::remove(parameters.Path, error);
+        }
+        statistics.TotalSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return done && !failed;
+    }
+
+// ***************************************************************************
+
+    void printCheckpointStatistics(const CheckpointStatistics& statistics, ostream& out)
+    {
+        out << "# ResumedRow; ResumedTraces; NextRow; Checkpoints; BytesWritten; StallSeconds; WriteSeconds; TotalSeconds"
+            << endl;
+        out << statistics.ResumedRow << "; " << statistics.ResumedTraces << "; " << statistics.NextRow << "; "
+            << statistics.Checkpoints << "; " << statistics.BytesWritten << "; " << statistics.StallSeconds << "; "
+            << statistics.WriteSeconds << "; " << statistics.TotalSeconds << endl;
+    }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   struct CheckpointParameters
+   {
+       string Path;
+       // least time between two checkpoints; zero writes one after every row
+       double IntervalSeconds;
+       // stop after this many rows of the pair loop, as a preempted job would
+       size_t StopAfterRows;
+       bool RemoveOnSuccess;
+
+       CheckpointParameters() : IntervalSeconds(60.0), StopAfterRows(0), RemoveOnSuccess(true) {}
+   };
+
+   struct CheckpointStatistics
+   {
+       size_t ResumedRow;
+       size_t ResumedTraces;
+       size_t NextRow;
+       unsigned long long Checkpoints;
+       unsigned long long BytesWritten;
+       // time the pair loop spent handing checkpoints over, and the time the
+       // writer spent in the background
+       double StallSeconds;
+       double WriteSeconds;
+       double TotalSeconds;
+
+       CheckpointStatistics()
+           : ResumedRow(0), ResumedTraces(0), NextRow(0), Checkpoints(0), BytesWritten(0),
+             StallSeconds(0.0), WriteSeconds(0.0), TotalSeconds(0.0) {}
+   };
+
+   // checkIntersections with periodic checkpoints of the row frontier, the
+   // accepted pairs, the traces and the trace id counter. The checkpoint is an
+   // append only file of checksummed segments, written by a background thread;
+   // a later call with the same fractures resumes from its last whole segment.
+   // Returns true once every row is done.
+   bool checkIntersectionsCheckpointed(Fractures& fractures,
+                                       map<int, vector<int>>& intersections,
+                                       const CheckpointParameters& parameters,
+                                       CheckpointStatistics& statistics);
+
+   void printCheckpointStatistics(const CheckpointStatistics& statistics, ostream& out);
+
+}
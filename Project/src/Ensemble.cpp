@@ -0,0 +1,181 @@
+#include "Ensemble.hpp"
+#include "Utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    void EnsembleStatistics::merge(const EnsembleStatistics& other)
+    {
+        NumberRealizations += other.NumberRealizations;
+        FailedRealizations += other.FailedRealizations;
+        TracesPerRealization.merge(other.TracesPerRealization);
+        TraceLength.merge(other.TraceLength);
+        TraceLengthHistogram.merge(other.TraceLengthHistogram);
+        TraceEnds += other.TraceEnds;
+        PassingEnds += other.PassingEnds;
+        LargestClusterFraction.merge(other.LargestClusterFraction);
+        IsolatedFraction.merge(other.IsolatedFraction);
+    }
+
+// ***************************************************************************
+
+    double EnsembleStatistics::passingFraction() const
+    {
+        return TraceEnds > 0 ? double(PassingEnds) / TraceEnds : 0.0;
+    }
+
+// ***************************************************************************
+
+    double EnsembleStatistics::realizationsPerSecond() const
+    {
+        return ElapsedSeconds > 0 ? NumberRealizations / ElapsedSeconds : 0.0;
+    }
+
+// ***************************************************************************
+
+    bool runEnsemble(const EnsembleParameters& parameters,
+                     EnsembleStatistics& statistics)
+    {
+        unsigned int numThreads = parameters.NumberThreads;
+        if (numThreads == 0)
+        {
+            numThreads = max(1u, thread::hardware_concurrency());
+        }
+        numThreads = min(numThreads, max(1u, parameters.NumberRealizations));
+
+        atomic<unsigned int> nextRealization(0);
+        vector<EnsembleStatistics> workerStatistics(numThreads);
+
+        auto worker = [&](unsigned int w)
+        {
+            // buffers owned by the worker and reused for all its realizations
+            Fractures fractures;
+            map<int, vector<int>> intersections;
+            EnsembleStatistics& local = workerStatistics[w];
+            local.TraceLengthHistogram = Histogram(0.0, parameters.MaxTraceLength,
+                                                   parameters.HistogramBins);
+
+            unsigned int r;
+            while ((r = nextRealization++) < parameters.NumberRealizations)
+            {
+                intersections.clear();
+
+                if (parameters.InputFiles.empty())
+                {
+                    seed_seq seed{parameters.Seed, (unsigned long long)r};
+                    mt19937_64 generator(seed);
+                    generateFractures(fractures, parameters.Network, generator);
+                }
+                else
+                {
+                    fractures.clear();
+                    const string& filename = parameters.InputFiles[r % parameters.InputFiles.size()];
+                    if (!ImportFractures(filename, fractures))
+                    {
+                        local.FailedRealizations++;
+                        continue;
+                    }
+                }
+
+                checkIntersections(fractures, intersections);
+
+                local.NumberRealizations++;
+                local.TracesPerRealization.add(fractures.Traces.size());
+                for (const auto& trace : fractures.Traces)
+                {
+                    local.TraceLength.add(trace.length);
+                    local.TraceLengthHistogram.add(trace.length);
+                    local.TraceEnds += 2;
+                    local.PassingEnds += (trace.Tips1 ? 0 : 1) + (trace.Tips2 ? 0 : 1);
+                }
+
+                if (!fractures.FracturesId.empty())
+                {
+                    ClusterSummary clusters = summarizeClusters(labelClusters(fractures, intersections));
+                    double n = fractures.FracturesId.size();
+                    local.LargestClusterFraction.add(clusters.LargestCluster / n);
+                    local.IsolatedFraction.add(clusters.IsolatedFractures / n);
+                }
+
+                if (parameters.WriteOutputs)
+                {
+                    string prefix = parameters.OutputFolder + "realization_" + to_string(r);
+                    writeTraces(fractures, prefix + "_traces.txt");
+                    writeResults(fractures, prefix + "_results.txt");
+                }
+            }
+        };
+
+        auto start = chrono::steady_clock::now();
+
+        vector<thread> threads;
+        threads.reserve(numThreads);
+        for (unsigned int w = 0; w < numThreads; w++)
+        {
+            threads.emplace_back(worker, w);
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+
+        auto end = chrono::steady_clock::now();
+
+        statistics = EnsembleStatistics();
+        statistics.TraceLengthHistogram = Histogram(0.0, parameters.MaxTraceLength,
+                                                    parameters.HistogramBins);
+        for (const auto& local : workerStatistics)
+        {
+            statistics.merge(local);
+        }
+        statistics.ElapsedSeconds = chrono::duration<double>(end - start).count();
+
+        return statistics.FailedRealizations == 0;
+    }
+
+// ***************************************************************************
+
+    void printEnsembleStatistics(const EnsembleStatistics& statistics,
+                                 ostream& out)
+    {
+        out << "# Realizations; Failed; Seconds; RealizationsPerSecond" << endl;
+        out << statistics.NumberRealizations << "; " << statistics.FailedRealizations << "; "
+            << statistics.ElapsedSeconds << "; " << statistics.realizationsPerSecond() << endl;
+
+        out << "# TracesPerRealization Mean; StdDev; Min; Max" << endl;
+        out << statistics.TracesPerRealization.Mean << "; "
+            << sqrt(statistics.TracesPerRealization.variance()) << "; "
+            << statistics.TracesPerRealization.Min << "; "
+            << statistics.TracesPerRealization.Max << endl;
+
+        out << "# TraceLength Mean; StdDev; Min; Max" << endl;
+        out << statistics.TraceLength.Mean << "; "
+            << sqrt(statistics.TraceLength.variance()) << "; "
+            << statistics.TraceLength.Min << "; "
+            << statistics.TraceLength.Max << endl;
+
+        out << "# PassingFraction" << endl;
+        out << statistics.passingFraction() << endl;
+
+        out << "# LargestClusterFraction Mean; IsolatedFraction Mean" << endl;
+        out << statistics.LargestClusterFraction.Mean << "; "
+            << statistics.IsolatedFraction.Mean << endl;
+
+        const Histogram& histogram = statistics.TraceLengthHistogram;
+        out << "# TraceLength Histogram: Lower; Upper; Count" << endl;
+        double width = histogram.Bins.empty() ? 0.0 : (histogram.Upper - histogram.Lower) / histogram.Bins.size();
+        for (size_t b = 0; b < histogram.Bins.size(); b++)
+        {
+            out << histogram.Lower + b * width << "; " << histogram.Lower + (b + 1) * width
+                << "; " << histogram.Bins[b] << endl;
+        }
+        out << "# Overflow" << endl;
+        out << histogram.Overflow << endl;
+    }
+
+}
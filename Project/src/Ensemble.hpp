@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+#include "Generator.hpp"
+#include "Statistics.hpp"
+
+namespace FractureLibrary
+{
+
+   struct EnsembleParameters
+   {
+       unsigned int NumberRealizations;
+       unsigned int NumberThreads;
+       unsigned long long Seed;
+       NetworkParameters Network;
+       vector<string> InputFiles;
+       bool WriteOutputs;
+       string OutputFolder;
+       double MaxTraceLength;
+       unsigned int HistogramBins;
+
+       EnsembleParameters()
+           : NumberRealizations(100), NumberThreads(0), Seed(0), WriteOutputs(false),
+             OutputFolder("./"), MaxTraceLength(4.0), HistogramBins(40) {}
+   };
+
+   struct EnsembleStatistics
+   {
+       unsigned int NumberRealizations;
+       unsigned int FailedRealizations;
+       RunningMoments TracesPerRealization;
+       RunningMoments TraceLength;
+       Histogram TraceLengthHistogram;
+       unsigned long long TraceEnds;
+       unsigned long long PassingEnds;
+       RunningMoments LargestClusterFraction;
+       RunningMoments IsolatedFraction;
+       double ElapsedSeconds;
+
+       EnsembleStatistics()
+           : NumberRealizations(0), FailedRealizations(0), TraceEnds(0), PassingEnds(0),
+             ElapsedSeconds(0) {}
+
+       void merge(const EnsembleStatistics& other);
+
+       double passingFraction() const;
+
+       double realizationsPerSecond() const;
+   };
+
+   bool runEnsemble(const EnsembleParameters& parameters,
+                    EnsembleStatistics& statistics);
+
+   void printEnsembleStatistics(const EnsembleStatistics& statistics,
+                                ostream& out);
+
+}
@@ -0,0 +1,188 @@
+#include "FilterCascade.hpp"
+#include "Allocations.hpp"
+#include "TraceSink.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        const CascadeFilter allFilters[] =
+        {
+            CascadeFilter::ProjectionXY,
+            CascadeFilter::ProjectionYZ,
+            CascadeFilter::ProjectionZX,
+            CascadeFilter::Separation
+        };
+    }
+
+// ***************************************************************************
+
+    string cascadeFilterName(CascadeFilter filter)
+    {
+        switch (filter)
+        {
+            case CascadeFilter::ProjectionXY: return "projection_xy";
+            case CascadeFilter::ProjectionYZ: return "projection_yz";
+            case CascadeFilter::ProjectionZX: return "projection_zx";
+            case CascadeFilter::Separation: return "separation";
+        }
+        return "unknown";
+    }
+
+// ***************************************************************************
+
+    double CascadeStatistics::rejectionRate() const
+    {
+        return Pairs > 0 ? double(Rejected) / Pairs : 0.0;
+    }
+
+// ***************************************************************************
+
+    bool cascadeRejects(CascadeFilter filter, const Matrix3Xd& P, const Matrix3Xd& Q)
+    {
+        switch (filter)
+        {
+            case CascadeFilter::ProjectionXY:
+                return !intersection2D(projectsOnPlane(P, "XY"), projectsOnPlane(Q, "XY"));
+            case CascadeFilter::ProjectionYZ:
+                return !intersection2D(projectsOnPlane(P, "YZ"), projectsOnPlane(Q, "YZ"));
+            case CascadeFilter::ProjectionZX:
+                return !intersection2D(projectsOnPlane(P, "ZX"), projectsOnPlane(Q, "ZX"));
+            case CascadeFilter::Separation:
+                return checkSeparation(P, Q);
+        }
+        return false;
+    }
+
+// ***************************************************************************
+
+    FilterCascade::FilterCascade(const CascadeParameters& parameters)
+        : Parameters(parameters)
+    {
+        for (CascadeFilter filter : allFilters)
+        {
+            CascadeFilterStatistics filterStatistics;
+            filterStatistics.Filter = filter;
+            filterStatistics.Position = Order.size();
+            Statistics.Filters.push_back(filterStatistics);
+            Order.push_back(filter);
+        }
+    }
+
+// ***************************************************************************
+
+    bool FilterCascade::intersects(const Matrix3Xd& P, const Matrix3Xd& Q)
+    {
+        Statistics.Pairs++;
+
+        // the sample runs every filter, each on its own clock
+        if (Parameters.Adaptive && Statistics.Pairs <= Parameters.SamplePairs)
+        {
+            bool rejected = false;
+            for (CascadeFilterStatistics& filter : Statistics.Filters)
+            {
+                auto start = chrono::steady_clock::now();
+                bool rejects = cascadeRejects(filter.Filter, P, Q);
+                filter.SampledSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                filter.SampledPairs++;
+                filter.Evaluated++;
+                if (rejects)
+                {
+                    filter.SampledRejections++;
+                    filter.Rejected++;
+                    rejected = true;
+                }
+            }
+
+            if (Statistics.Pairs == Parameters.SamplePairs)
+            {
+                reorder();
+            }
+            Statistics.Rejected += rejected;
+            return !rejected;
+        }
+
+        for (CascadeFilter filter : Order)
+        {
+            CascadeFilterStatistics& filterStatistics = Statistics.Filters[size_t(filter)];
+            filterStatistics.Evaluated++;
+            if (cascadeRejects(filter, P, Q))
+            {
+                filterStatistics.Rejected++;
+                Statistics.Rejected++;
+                return false;
+            }
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    void FilterCascade::reorder()
+    {
+        // expected cost of a filter per rejected pair; cheap and selective first
+        auto rank = [](const CascadeFilterStatistics& filter)
+        {
+            return filter.SampledRejections > 0 ? filter.SampledSeconds / filter.SampledRejections
+                                                : numeric_limits<double>::infinity();
+        };
+
+        vector<CascadeFilterStatistics*> ranked;
+        for (CascadeFilterStatistics& filter : Statistics.Filters)
+        {
+            ranked.push_back(&filter);
+        }
+        stable_sort(ranked.begin(), ranked.end(), [&rank](const CascadeFilterStatistics* a,
+                                                          const CascadeFilterStatistics* b)
+                    {
+                        return rank(*a) < rank(*b);
+                    });
+
+        Order.clear();
+        for (CascadeFilterStatistics* filter : ranked)
+        {
+            filter->Position = Order.size();
+            Order.push_back(filter->Filter);
+        }
+    }
+
+// ***************************************************************************
+
+    void checkIntersectionsCascade(Fractures& fractures, map<int, vector<int>>& intersections,
+                                   const CascadeParameters& parameters,
+                                   CascadeStatistics& statistics)
+    {
+        AllocationPhase phase("intersect");
+        FilterCascade cascade(parameters);
+        CollectingSink sink(fractures, intersections);
+        PairKernel kernel;
+        kernel.Intersect = [&cascade](const Matrix3Xd& P, const Matrix3Xd& Q)
+        {
+            return cascade.intersects(P, Q);
+        };
+        PairKernelState state;
+        runPairKernel(fractures, sink, kernel, state);
+
+        statistics = cascade.statistics();
+    }
+
+// ***************************************************************************
+
+    void printCascadeStatistics(const CascadeStatistics& statistics, ostream& out)
+    {
+        out << "# Pairs; Rejected; RejectionRate" << endl;
+        out << statistics.Pairs << "; " << statistics.Rejected << "; " << statistics.rejectionRate() << endl;
+        out << "# Filter; Position; SampledPairs; SampledRejections; SampledSeconds; Evaluated; Rejected" << endl;
+        for (const CascadeFilterStatistics& filter : statistics.Filters)
+        {
+            out << cascadeFilterName(filter.Filter) << "; " << filter.Position << "; " << filter.SampledPairs << "; "
+                << filter.SampledRejections << "; " << filter.SampledSeconds << "; " << filter.Evaluated << "; "
+                << filter.Rejected << endl;
+        }
+    }
+
+}
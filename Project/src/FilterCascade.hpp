@@ -0,0 +1,96 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   // the rejection tests of fracturesIntersect
+   enum class CascadeFilter
+   {
+       ProjectionXY,
+       ProjectionYZ,
+       ProjectionZX,
+       Separation
+   };
+
+   string cascadeFilterName(CascadeFilter filter);
+
+   struct CascadeParameters
+   {
+       // pairs on which every filter runs, to measure its cost and rejection rate
+       unsigned long long SamplePairs;
+       // false keeps the order of fracturesIntersect
+       bool Adaptive;
+
+       CascadeParameters() : SamplePairs(4096), Adaptive(true) {}
+   };
+
+   struct CascadeFilterStatistics
+   {
+       CascadeFilter Filter;
+       unsigned long long SampledPairs;
+       unsigned long long SampledRejections;
+       double SampledSeconds;
+       unsigned long long Evaluated;
+       unsigned long long Rejected;
+       // place in the cascade after the sample
+       int Position;
+
+       CascadeFilterStatistics()
+           : Filter(CascadeFilter::ProjectionXY), SampledPairs(0), SampledRejections(0), SampledSeconds(0.0),
+             Evaluated(0), Rejected(0), Position(-1) {}
+   };
+
+   struct CascadeStatistics
+   {
+       unsigned long long Pairs;
+       unsigned long long Rejected;
+       // in the order of CascadeFilter
+       vector<CascadeFilterStatistics> Filters;
+
+       CascadeStatistics() : Pairs(0), Rejected(0) {}
+
+       double rejectionRate() const;
+   };
+
+   // fracturesIntersect with its tests in a measured order: they run one at
+   // a time up to the first rejection. After the sample the tests are sorted
+   // by measured cost over rejection rate, the cheapest rejection first; a
+   // test that rejected nothing in the sample goes last. A pair intersects
+   // when no test rejects it, so the answer never depends on the order.
+   class FilterCascade
+   {
+       public:
+           explicit FilterCascade(const CascadeParameters& parameters = CascadeParameters());
+
+           bool intersects(const Matrix3Xd& P, const Matrix3Xd& Q);
+
+           const vector<CascadeFilter>& order() const { return Order; }
+
+           const CascadeStatistics& statistics() const { return Statistics; }
+
+       private:
+           CascadeParameters Parameters;
+           CascadeStatistics Statistics;
+           vector<CascadeFilter> Order;
+
+           void reorder();
+   };
+
+   // true when the filter proves that P and Q do not intersect
+   bool cascadeRejects(CascadeFilter filter, const Matrix3Xd& P, const Matrix3Xd& Q);
+
+   // checkIntersections with the cascade as the narrow phase; same traces
+   // in the same order
+   void checkIntersectionsCascade(Fractures& fractures, map<int, vector<int>>& intersections,
+                                  const CascadeParameters& parameters,
+                                  CascadeStatistics& statistics);
+
+   void printCascadeStatistics(const CascadeStatistics& statistics, ostream& out);
+
+}
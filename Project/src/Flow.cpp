@@ -0,0 +1,259 @@
+#include "Flow.hpp"
+#include "SpatialIndex.hpp"
+#include "ThreadPool.hpp"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        struct Pipe
+        {
+            unsigned int I;
+            unsigned int J;
+            double Conductance;
+        };
+
+        Vector3d toVector(const Point& point)
+        {
+            return Vector3d(point.x, point.y, point.z);
+        }
+    }
+
+// ***************************************************************************
+
+    bool solveFlow(const Fractures& fractures, const FlowParameters& parameters,
+                   FlowSolution& solution)
+    {
+        auto start = chrono::steady_clock::now();
+        const size_t n = fractures.FracturesVertices.size();
+        const int axis = parameters.Axis;
+        const double transmissivity = pow(parameters.Aperture, 3) / (12.0 * parameters.Viscosity);
+        const unsigned int numThreads = resolveThreads(parameters.NumberThreads);
+
+        solution = FlowSolution();
+        solution.Pressure.assign(n, numeric_limits<double>::quiet_NaN());
+        if (n == 0 || axis < 0 || axis > 2)
+        {
+            cerr << "Flow needs fractures and an axis among 0, 1, 2" << endl;
+            return false;
+        }
+
+        unordered_map<unsigned int, unsigned int> position;
+        position.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            position[fractures.FracturesId[i]] = i;
+        }
+
+        vector<Vector3d> centroids(n);
+        vector<BoundingBox> boxes(n);
+        BoundingBox domain;
+        parallelFor(0, n, numThreads, [&](size_t first, size_t last, unsigned int)
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                centroids[i] = fractures.FracturesVertices[i].rowwise().mean();
+                boxes[i] = computeBoundingBox(fractures.FracturesVertices[i]);
+            }
+        });
+        for (const BoundingBox& box : boxes)
+        {
+            domain.expand(box);
+        }
+        const double extent = domain.Max(axis) - domain.Min(axis);
+        const double tolerance = parameters.FaceTolerance * max(extent, 1.0);
+
+        // one pipe per trace: width = trace length, length = centroid to
+        // trace midpoint on both sides
+        const vector<Trace>& traces = fractures.Traces;
+        vector<Pipe> pipes(traces.size(), Pipe{0, 0, 0.0});
+        parallelFor(0, traces.size(), numThreads, [&](size_t first, size_t last, unsigned int)
+        {
+            for (size_t t = first; t < last; t++)
+            {
+                auto i = position.find(traces[t].fractureId1);
+                auto j = position.find(traces[t].fractureId2);
+                if (i == position.end() || j == position.end() || i->second == j->second)
+                {
+                    continue;
+                }
+                Vector3d middle = 0.5 * (toVector(traces[t].p1) + toVector(traces[t].p2));
+                double distance = (centroids[i->second] - middle).norm() + (centroids[j->second] - middle).norm();
+                if (!(traces[t].length > 0.0) || !(distance > 0.0) || !isfinite(distance))
+                {
+                    continue;
+                }
+                pipes[t] = Pipe{i->second, j->second, transmissivity * traces[t].length / distance};
+            }
+        });
+
+        // boundary pipes from the centroid to the face, width ~ fracture size
+        vector<double> inlet(n, 0.0);
+        vector<double> outlet(n, 0.0);
+        parallelFor(0, n, numThreads, [&](size_t first, size_t last, unsigned int)
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                double width = (boxes[i].Max - boxes[i].Min).norm();
+                if (boxes[i].Min(axis) <= domain.Min(axis) + tolerance)
+                {
+                    inlet[i] = transmissivity * width / max(centroids[i](axis) - domain.Min(axis), tolerance);
+                }
+                if (boxes[i].Max(axis) >= domain.Max(axis) - tolerance)
+                {
+                    outlet[i] = transmissivity * width / max(domain.Max(axis) - centroids[i](axis), tolerance);
+                }
+            }
+        });
+
+        // unknowns only for fractures connected to a face, so the system is SPD
+        vector<vector<unsigned int>> neighbours(n);
+        for (const Pipe& pipe : pipes)
+        {
+            if (pipe.Conductance > 0.0)
+            {
+                neighbours[pipe.I].push_back(pipe.J);
+                neighbours[pipe.J].push_back(pipe.I);
+            }
+        }
+        vector<int> unknown(n, -1);
+        vector<unsigned int> queue;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (inlet[i] > 0.0 || outlet[i] > 0.0)
+            {
+                unknown[i] = 0;
+                queue.push_back(i);
+            }
+        }
+        for (size_t q = 0; q < queue.size(); q++)
+        {
+            for (unsigned int j : neighbours[queue[q]])
+            {
+                if (unknown[j] < 0)
+                {
+                    unknown[j] = 0;
+                    queue.push_back(j);
+                }
+            }
+        }
+        int numberUnknowns = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (unknown[i] >= 0)
+            {
+                unknown[i] = numberUnknowns++;
+            }
+        }
+        solution.NumberUnknowns = numberUnknowns;
+
+        // thread local triplets, summed by setFromTriplets
+        using Triplet = Eigen::Triplet<double>;
+        vector<vector<Triplet>> local(numThreads);
+        VectorXd rhs = VectorXd::Zero(numberUnknowns);
+        parallelFor(0, pipes.size(), numThreads, [&](size_t first, size_t last, unsigned int thread)
+        {
+            vector<Triplet>& triplets = local[thread];
+            for (size_t p = first; p < last; p++)
+            {
+                const Pipe& pipe = pipes[p];
+                if (pipe.Conductance <= 0.0 || unknown[pipe.I] < 0)
+                {
+                    continue;
+                }
+                int a = unknown[pipe.I];
+                int b = unknown[pipe.J];
+                triplets.emplace_back(a, a, pipe.Conductance);
+                triplets.emplace_back(b, b, pipe.Conductance);
+                triplets.emplace_back(a, b, -pipe.Conductance);
+                triplets.emplace_back(b, a, -pipe.Conductance);
+            }
+        });
+        parallelFor(0, n, numThreads, [&](size_t first, size_t last, unsigned int thread)
+        {
+            for (size_t i = first; i < last; i++)
+            {
+                if (unknown[i] >= 0 && inlet[i] + outlet[i] > 0.0)
+                {
+                    local[thread].emplace_back(unknown[i], unknown[i], inlet[i] + outlet[i]);
+                    rhs(unknown[i]) = inlet[i] * parameters.InletPressure + outlet[i] * parameters.OutletPressure;
+                }
+            }
+        });
+
+        vector<Triplet> triplets;
+        size_t total = 0;
+        for (const auto& part : local)
+        {
+            total += part.size();
+        }
+        triplets.reserve(total);
+        for (auto& part : local)
+        {
+            triplets.insert(triplets.end(), part.begin(), part.end());
+            vector<Triplet>().swap(part);
+        }
+
+        SparseMatrix<double> system(numberUnknowns, numberUnknowns);
+        system.setFromTriplets(triplets.begin(), triplets.end());
+        for (const Pipe& pipe : pipes)
+        {
+            solution.NumberPipes += pipe.Conductance > 0.0;
+        }
+        auto assembled = chrono::steady_clock::now();
+        solution.AssemblySeconds = chrono::duration<double>(assembled - start).count();
+
+        ConjugateGradient<SparseMatrix<double>, Lower | Upper> solver;
+        solver.setTolerance(parameters.SolverTolerance);
+        if (parameters.MaxIterations > 0)
+        {
+            solver.setMaxIterations(parameters.MaxIterations);
+        }
+        solver.compute(system);
+        VectorXd pressure = VectorXd::Constant(numberUnknowns,
+                                               0.5 * (parameters.InletPressure + parameters.OutletPressure));
+        if (numberUnknowns > 0)
+        {
+            pressure = solver.solveWithGuess(rhs, pressure);
+            solution.Iterations = solver.iterations();
+            solution.Error = solver.error();
+            solution.Converged = solver.info() == Success;
+        }
+        solution.SolveSeconds = chrono::duration<double>(chrono::steady_clock::now() - assembled).count();
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (unknown[i] < 0)
+            {
+                continue;
+            }
+            double p = pressure(unknown[i]);
+            solution.Pressure[i] = p;
+            solution.Inflow += inlet[i] * (parameters.InletPressure - p);
+            solution.Outflow += outlet[i] * (p - parameters.OutletPressure);
+        }
+
+        return solution.Converged || numberUnknowns == 0;
+    }
+
+// ***************************************************************************
+
+    void printFlowSolution(const FlowSolution& solution, ostream& out)
+    {
+        out << "Unknowns: " << solution.NumberUnknowns << endl;
+        out << "Pipes: " << solution.NumberPipes << endl;
+        out << "Inflow: " << solution.Inflow << endl;
+        out << "Outflow: " << solution.Outflow << endl;
+        out << "Iterations: " << solution.Iterations
+            << (solution.Converged ? "" : " (not converged)") << endl;
+        out << "Relative residual: " << solution.Error << endl;
+        out << "Assembly time: " << solution.AssemblySeconds << " s" << endl;
+        out << "Solve time: " << solution.SolveSeconds << " s" << endl;
+    }
+
+}
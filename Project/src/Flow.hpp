@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   // cubic law pipe network: one pressure per fracture, one pipe per trace,
+   // fixed pressures on the two domain faces normal to Axis
+   struct FlowParameters
+   {
+       double Aperture;
+       double Viscosity;
+       int Axis;
+       double InletPressure;
+       double OutletPressure;
+       double FaceTolerance;
+       unsigned int NumberThreads;
+       double SolverTolerance;
+       int MaxIterations;
+
+       FlowParameters()
+           : Aperture(1e-4), Viscosity(1e-3), Axis(0), InletPressure(1.0), OutletPressure(0.0),
+             FaceTolerance(1e-6), NumberThreads(0), SolverTolerance(1e-10), MaxIterations(0) {}
+   };
+
+   struct FlowSolution
+   {
+       // NaN for fractures not connected to either face
+       vector<double> Pressure;
+       unsigned int NumberUnknowns;
+       unsigned int NumberPipes;
+       double Inflow;
+       double Outflow;
+       bool Converged;
+       int Iterations;
+       double Error;
+       double AssemblySeconds;
+       double SolveSeconds;
+
+       FlowSolution()
+           : NumberUnknowns(0), NumberPipes(0), Inflow(0), Outflow(0), Converged(false),
+             Iterations(0), Error(0), AssemblySeconds(0), SolveSeconds(0) {}
+   };
+
+   bool solveFlow(const Fractures& fractures, const FlowParameters& parameters,
+                  FlowSolution& solution);
+
+   void printFlowSolution(const FlowSolution& solution, ostream& out);
+
+}
@@ -0,0 +1,556 @@
+#include "Fuzz.hpp"
+#include "Checkpoint.hpp"
+#include "FilterCascade.hpp"
+#include "Incremental.hpp"
+#include "LazyTraces.hpp"
+#include "Multiprocess.hpp"
+#include "OutOfCore.hpp"
+#include "Predicates.hpp"
+#include "Prefilter.hpp"
+#include "Statistics.hpp"
+#include "TraceSink.hpp"
+#include "Utils.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        // the reference and the paths report failed traces of parallel
+        // pairs on cerr, which the coplanar cases produce by design
+        class MuteErrors
+        {
+            public:
+                MuteErrors() : Saved(cerr.rdbuf(Discard.rdbuf())) {}
+                ~MuteErrors() { cerr.rdbuf(Saved); }
+
+            private:
+                ostringstream Discard;
+                streambuf* Saved;
+        };
+
+        Fractures pairNetwork(const Matrix3Xd& P, const Matrix3Xd& Q)
+        {
+            Fractures fractures;
+            fractures.NumberFractures = 2;
+            fractures.FracturesId = {0, 1};
+            fractures.FracturesVertices = {P, Q};
+            return fractures;
+        }
+
+        bool sameTraces(const vector<Trace>& a, const vector<Trace>& b)
+        {
+            if (a.size() != b.size())
+            {
+                return false;
+            }
+            for (size_t t = 0; t < a.size(); t++)
+            {
+                if (a[t].traceId != b[t].traceId || a[t].fractureId1 != b[t].fractureId1 ||
+                    a[t].fractureId2 != b[t].fractureId2 || a[t].Tips1 != b[t].Tips1 ||
+                    a[t].Tips2 != b[t].Tips2 ||
+                    a[t].p1.x != b[t].p1.x || a[t].p1.y != b[t].p1.y || a[t].p1.z != b[t].p1.z ||
+                    a[t].p2.x != b[t].p2.x || a[t].p2.y != b[t].p2.y || a[t].p2.z != b[t].p2.z)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        FuzzPath prefilterPath(const string& name, PrefilterPrecision precision)
+        {
+            return {name, [precision](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+            {
+                Fractures fractures = pairNetwork(P, Q);
+                map<int, vector<int>> intersections;
+                PrefilterParameters parameters;
+                parameters.Precision = precision;
+                parameters.UsePlanes = false;
+                PrefilterStatistics statistics;
+                checkIntersectionsPrefiltered(fractures, intersections, parameters, statistics);
+                return sameTraces(fractures.Traces, reference);
+            }};
+        }
+
+        // the plane test is only conservative with respect to the exact predicate
+        FuzzPath planePath(const string& name, PrefilterPrecision precision)
+        {
+            return {name, [precision](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>&)
+            {
+                Fractures fractures = pairNetwork(P, Q);
+                PrefilterParameters parameters;
+                parameters.Precision = precision;
+                ConservativePrefilter prefilter(fractures, parameters);
+                return prefilter.mayIntersect(0, 1) || !fracturesIntersectExact(P, Q);
+            }};
+        }
+
+        string readFile(const string& filename)
+        {
+            ifstream file(filename);
+            ostringstream content;
+            content << file.rdbuf();
+            return content.str();
+        }
+
+        // rounds every coordinate to the given number of significant digits
+        Matrix3Xd roundDigits(const Matrix3Xd& vertices, int digits)
+        {
+            Matrix3Xd rounded = vertices;
+            char buffer[64];
+            for (Index k = 0; k < rounded.size(); k++)
+            {
+                snprintf(buffer, sizeof(buffer), "%.*e", digits - 1, rounded.data()[k]);
+                rounded.data()[k] = strtod(buffer, nullptr);
+            }
+            return rounded;
+        }
+
+        Matrix3Xd withoutColumn(const Matrix3Xd& vertices, Index column)
+        {
+            Matrix3Xd reduced(3, vertices.cols() - 1);
+            for (Index c = 0, k = 0; c < vertices.cols(); c++)
+            {
+                if (c != column)
+                {
+                    reduced.col(k++) = vertices.col(c);
+                }
+            }
+            return reduced;
+        }
+
+        Matrix3Xd polygon(const Vector3d& center, const Vector3d& normal, double radius, double aspect,
+                          unsigned int numVertices, mt19937_64& generator)
+        {
+            uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+            Vector3d n = normal.normalized();
+            Vector3d u = n.unitOrthogonal();
+            Vector3d v = n.cross(u);
+            double theta0 = angle(generator);
+            Vector3d a = cos(theta0) * u + sin(theta0) * v;
+            Vector3d b = n.cross(a);
+
+            Matrix3Xd vertices(3, numVertices);
+            for (unsigned int k = 0; k < numVertices; k++)
+            {
+                double theta = 2.0 * M_PI * k / numVertices;
+                vertices.col(k) = center + radius * (cos(theta) * a + aspect * sin(theta) * b);
+            }
+            return vertices;
+        }
+
+        Vector3d randomDirection(mt19937_64& generator)
+        {
+            normal_distribution<double> gaussian(0.0, 1.0);
+            Vector3d direction;
+            do
+            {
+                direction = Vector3d(gaussian(generator), gaussian(generator), gaussian(generator));
+            }
+            while (direction.norm() < 1e-12);
+            return direction.normalized();
+        }
+
+        Vector3d planeNormal(const Matrix3Xd& vertices)
+        {
+            return (vertices.col(1) - vertices.col(0)).cross(vertices.col(2) - vertices.col(0)).normalized();
+        }
+    }
+
+// ***************************************************************************
+
+    string fuzzCaseName(FuzzCase fuzzCase)
+    {
+        switch (fuzzCase)
+        {
+            case FuzzCase::Random: return "random";
+            case FuzzCase::NearParallel: return "near_parallel";
+            case FuzzCase::TouchingEdge: return "touching_edge";
+            case FuzzCase::Coplanar: return "coplanar";
+            case FuzzCase::Sliver: return "sliver";
+        }
+        return "unknown";
+    }
+
+// ***************************************************************************
+
+    vector<FuzzPath> defaultFuzzPaths()
+    {
+        vector<FuzzPath> paths;
+        paths.push_back(prefilterPath("prefilter_float", PrefilterPrecision::Float));
+        paths.push_back(prefilterPath("prefilter_quantized", PrefilterPrecision::Quantized16));
+        paths.push_back(planePath("prefilter_planes_float", PrefilterPrecision::Float));
+        paths.push_back(planePath("prefilter_planes_quantized", PrefilterPrecision::Quantized16));
+
+        paths.push_back({"lazy", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            Fractures fractures = pairNetwork(P, Q);
+            LazyTraceNetwork network(fractures);
+            vector<Trace> traces;
+            network.materialize(traces);
+            return sameTraces(traces, reference);
+        }});
+
+        paths.push_back({"stream", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            Fractures fractures = pairNetwork(P, Q);
+            vector<Trace> traces;
+            CallbackSink sink([&traces](const vector<Trace>& block)
+            {
+                traces.insert(traces.end(), block.begin(), block.end());
+            });
+            streamTraces(fractures, sink);
+            return sameTraces(traces, reference);
+        }});
+
+        paths.push_back({"incremental", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            Fractures fractures = pairNetwork(P, Q);
+            fractures.NumberFractures = 1;
+            fractures.FracturesId.pop_back();
+            fractures.FracturesVertices.pop_back();
+            map<int, vector<int>> intersections;
+            IncrementalDFN network(fractures, intersections);
+            vector<int> added;
+            network.addFracture(1, Q, added);
+            return sameTraces(fractures.Traces, reference);
+        }});
+
+        paths.push_back({"cascade", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            Fractures fractures = pairNetwork(P, Q);
+            map<int, vector<int>> intersections;
+            CascadeParameters parameters;
+            CascadeStatistics statistics;
+            checkIntersectionsCascade(fractures, intersections, parameters, statistics);
+            return sameTraces(fractures.Traces, reference);
+        }});
+
+        // the slabs of two workers, so that the pair usually straddles the cut
+        paths.push_back({"multiprocess", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            Fractures fractures = pairNetwork(P, Q);
+            map<int, vector<int>> intersections;
+            DecompositionParameters parameters;
+            DecompositionStatistics statistics;
+            return checkIntersectionsMultiprocess(fractures, intersections, parameters, statistics) &&
+                   sameTraces(fractures.Traces, reference);
+        }});
+
+        // three tiles per axis: the pair is usually in several tiles and
+        // must be owned by exactly one of them
+        paths.push_back({"out_of_core", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            Fractures fractures = pairNetwork(P, Q);
+            fractures.Traces = reference;
+            if (!writeFractures(fractures, "fuzz_tiled_input.txt"))
+            {
+                return false;
+            }
+            writeTraces(fractures, "fuzz_memory_traces.txt");
+            TilingParameters parameters;
+            parameters.TilesPerAxis = 3;
+            TilingStatistics statistics;
+            bool agrees = processOutOfCore("fuzz_tiled_input.txt", "fuzz_tiled_traces.txt", "fuzz_tiled_results.txt",
+                                           parameters, statistics) &&
+                          readFile("fuzz_tiled_traces.txt") == readFile("fuzz_memory_traces.txt");
+            for (const char* file : {"fuzz_tiled_input.txt", "fuzz_memory_traces.txt", "fuzz_tiled_traces.txt",
+                                     "fuzz_tiled_results.txt"})
+            {
+                remove(file);
+            }
+            return agrees;
+        }});
+
+        paths.push_back({"trace_statistics", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            Fractures fractures = pairNetwork(P, Q);
+            TraceStatistics collected;
+            collectTraceStatistics(fractures, collected, 1);
+            fractures.Traces = reference;
+            TraceStatistics summarized;
+            summarizeTraces(fractures, summarized);
+            return collected.NumberTraces == summarized.NumberTraces &&
+                   collected.TraceEnds == summarized.TraceEnds &&
+                   collected.PassingEnds == summarized.PassingEnds &&
+                   collected.TotalLength == summarized.TotalLength &&
+                   collected.TracesPerFracture == summarized.TracesPerFracture;
+        }});
+
+        // stopped after the first row, then resumed from the checkpoint
+        paths.push_back({"checkpoint_resume", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)
+        {
+            CheckpointParameters parameters;
+            parameters.Path = "fuzz_checkpoint.dfnckpt";
+            parameters.IntervalSeconds = 0.0;
+            parameters.StopAfterRows = 1;
+            remove(parameters.Path.c_str());
+
+            Fractures fractures = pairNetwork(P, Q);
+            map<int, vector<int>> intersections;
+            CheckpointStatistics statistics;
+            bool done = checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics);
+            fractures = pairNetwork(P, Q);
+            intersections.clear();
+            done = checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics) && !done;
+            remove(parameters.Path.c_str());
+            return done && statistics.ResumedRow == 1 && sameTraces(fractures.Traces, reference);
+        }});
+
+        // the exact predicate must not depend on the order of its inputs nor on
+        // the orientation of a polygon; rotating the vertices moves the apex of
+        // the fan, which legitimately changes a polygon that is not quite planar
+        paths.push_back({"exact_symmetry", [](const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>&)
+        {
+            bool forward = fracturesIntersectExact(P, Q);
+            Matrix3Xd reversed(3, Q.cols());
+            reversed << Q.col(0), Q.rightCols(Q.cols() - 1).rowwise().reverse();
+            return fracturesIntersectExact(Q, P) == forward &&
+                   fracturesIntersectExact(P, reversed) == forward;
+        }});
+
+        return paths;
+    }
+
+// ***************************************************************************
+
+    void generateFuzzPair(FuzzCase fuzzCase, mt19937_64& generator, Matrix3Xd& P, Matrix3Xd& Q)
+    {
+        uniform_real_distribution<double> unit(0.0, 1.0);
+        uniform_real_distribution<double> radius(0.1, 0.5);
+        uniform_int_distribution<unsigned int> vertices(3, 8);
+        auto logUniform = [&](double lowExponent, double highExponent)
+        {
+            return pow(10.0, lowExponent + (highExponent - lowExponent) * unit(generator));
+        };
+
+        Vector3d center(unit(generator), unit(generator), unit(generator));
+        Vector3d normal = randomDirection(generator);
+        double r = radius(generator);
+        P = polygon(center, normal, r, 1.0, vertices(generator), generator);
+        normal = planeNormal(P);
+
+        switch (fuzzCase)
+        {
+            case FuzzCase::Random:
+            {
+                Vector3d offset = 0.6 * unit(generator) * randomDirection(generator);
+                Q = polygon(center + offset, randomDirection(generator), radius(generator), 1.0,
+                            vertices(generator), generator);
+                break;
+            }
+            case FuzzCase::NearParallel:
+            {
+                // a tiny tilt and a tiny lift off the plane of P
+                Vector3d axis = normal.cross(randomDirection(generator)).normalized();
+                Vector3d tilted = AngleAxisd(logUniform(-12, -3), axis) * normal;
+                Vector3d slide = (Matrix3d::Identity() - normal * normal.transpose()) * randomDirection(generator);
+                double lift = (unit(generator) < 0.5 ? -1.0 : 1.0) * logUniform(-12, -2);
+                Q = polygon(center + 0.5 * r * slide + lift * normal, tilted, radius(generator), 1.0,
+                            vertices(generator), generator);
+                break;
+            }
+            case FuzzCase::TouchingEdge:
+            {
+                // Q hangs off an edge or a vertex of P at any angle, coplanar included
+                uniform_int_distribution<Index> edge(0, P.cols() - 1);
+                Index k = edge(generator);
+                Vector3d a = P.col(k);
+                Vector3d b = P.col((k + 1) % P.cols());
+                Vector3d outward = (b - a).cross(normal).normalized();
+                double phi = M_PI * unit(generator);
+                if (unit(generator) < 0.25)
+                {
+                    phi = unit(generator) < 0.5 ? 0.0 : M_PI;
+                }
+                Vector3d w = r * (cos(phi) * outward + sin(phi) * normal);
+                if (unit(generator) < 0.5)
+                {
+                    Q.resize(3, 4);
+                    Q << a, b, b + w, a + w;
+                }
+                else
+                {
+                    Vector3d side = (b - a).normalized() * r * (unit(generator) - 0.5);
+                    Q.resize(3, 3);
+                    Q << a, a + w + side, a + w - side;
+                }
+                break;
+            }
+            case FuzzCase::Coplanar:
+            {
+                Vector3d slide = (Matrix3d::Identity() - normal * normal.transpose()) * randomDirection(generator);
+                double lift = unit(generator) < 0.5 ? 0.0 : logUniform(-15, -9);
+                Q = polygon(center + 1.5 * r * unit(generator) * slide + lift * normal, normal,
+                            radius(generator), 1.0, vertices(generator), generator);
+                break;
+            }
+            case FuzzCase::Sliver:
+            {
+                double aspect = logUniform(-9, -4);
+                Vector3d offset = 0.5 * r * unit(generator) * randomDirection(generator);
+                Q = polygon(center + offset, randomDirection(generator), radius(generator), aspect,
+                            vertices(generator), generator);
+                if (unit(generator) < 0.5)
+                {
+                    swap(P, Q);
+                }
+                break;
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    vector<Trace> referencePairTraces(const Matrix3Xd& P, const Matrix3Xd& Q)
+    {
+        Fractures fractures = pairNetwork(P, Q);
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        return fractures.Traces;
+    }
+
+// ***************************************************************************
+
+    void shrinkDisagreement(const FuzzPath& path, Matrix3Xd& P, Matrix3Xd& Q)
+    {
+        auto disagrees = [&path](const Matrix3Xd& a, const Matrix3Xd& b)
+        {
+            return !path.Agrees(a, b, referencePairTraces(a, b));
+        };
+
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (Matrix3Xd* vertices : {&P, &Q})
+            {
+                for (Index c = 0; vertices->cols() > 3 && c < vertices->cols(); c++)
+                {
+                    Matrix3Xd saved = *vertices;
+                    *vertices = withoutColumn(saved, c);
+                    if (disagrees(P, Q))
+                    {
+                        changed = true;
+                        c--;
+                    }
+                    else
+                    {
+                        *vertices = saved;
+                    }
+                }
+            }
+        }
+
+        // fewest digits that still disagree, for a readable reproducer
+        for (int digits = 1; digits < 17; digits++)
+        {
+            Matrix3Xd roundedP = roundDigits(P, digits);
+            Matrix3Xd roundedQ = roundDigits(Q, digits);
+            if (disagrees(roundedP, roundedQ))
+            {
+                P = roundedP;
+                Q = roundedQ;
+                break;
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    bool runFuzz(const FuzzParameters& parameters, const vector<FuzzPath>& paths, FuzzStatistics& statistics)
+    {
+        MuteErrors mute;
+        auto start = chrono::steady_clock::now();
+        mt19937_64 generator(parameters.Seed);
+
+        statistics = FuzzStatistics();
+        statistics.CasesOf.assign(parameters.Cases.size(), 0);
+        statistics.DisagreementsOf.assign(paths.size(), 0);
+        for (const FuzzPath& path : paths)
+        {
+            statistics.PathNames.push_back(path.Name);
+        }
+        if (!parameters.OutputFolder.empty())
+        {
+            filesystem::create_directories(parameters.OutputFolder);
+        }
+
+        Matrix3Xd P, Q;
+        for (unsigned long long c = 0; !parameters.Cases.empty(); c++)
+        {
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (parameters.DurationSeconds > 0.0 ? elapsed >= parameters.DurationSeconds : c >= parameters.NumberCases)
+            {
+                break;
+            }
+
+            size_t kind = c % parameters.Cases.size();
+            generateFuzzPair(parameters.Cases[kind], generator, P, Q);
+            vector<Trace> reference = referencePairTraces(P, Q);
+            statistics.Cases++;
+            statistics.CasesOf[kind]++;
+            statistics.ReferenceIntersections += !reference.empty();
+
+            for (size_t p = 0; p < paths.size(); p++)
+            {
+                if (paths[p].Agrees(P, Q, reference))
+                {
+                    continue;
+                }
+
+                statistics.Disagreements++;
+                statistics.DisagreementsOf[p]++;
+                if (statistics.Reproducers.size() >= parameters.MaxReproducers)
+                {
+                    continue;
+                }
+
+                FuzzDisagreement found;
+                found.Path = paths[p].Name;
+                found.Case = parameters.Cases[kind];
+                found.CaseIndex = c;
+                found.OriginalVertices = P.cols() + Q.cols();
+                found.P = P;
+                found.Q = Q;
+                shrinkDisagreement(paths[p], found.P, found.Q);
+                if (!parameters.OutputFolder.empty())
+                {
+                    writeFractures(pairNetwork(found.P, found.Q), parameters.OutputFolder + "/fuzz_" +
+                                   found.Path + "_" + to_string(c) + ".txt");
+                }
+                statistics.Reproducers.push_back(found);
+            }
+        }
+
+        statistics.Seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return statistics.Disagreements == 0;
+    }
+
+// ***************************************************************************
+
+    void printFuzzStatistics(const FuzzStatistics& statistics, ostream& out)
+    {
+        out << "# Cases; ReferenceIntersections; Disagreements; Seconds" << endl;
+        out << statistics.Cases << "; " << statistics.ReferenceIntersections << "; "
+            << statistics.Disagreements << "; " << statistics.Seconds << endl;
+
+        out << "# Path; Disagreements" << endl;
+        for (size_t p = 0; p < statistics.PathNames.size(); p++)
+        {
+            out << statistics.PathNames[p] << "; " << statistics.DisagreementsOf[p] << endl;
+        }
+
+        out << "# Path; Case; Index; OriginalVertices; Vertices" << endl;
+        for (const FuzzDisagreement& found : statistics.Reproducers)
+        {
+            out << found.Path << "; " << fuzzCaseName(found.Case) << "; " << found.CaseIndex << "; "
+                << found.OriginalVertices << "; " << found.P.cols() + found.Q.cols() << endl;
+        }
+    }
+
+}
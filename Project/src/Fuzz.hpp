@@ -0,0 +1,93 @@
+#pragma once
+
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   enum class FuzzCase
+   {
+       Random,
+       NearParallel,
+       TouchingEdge,
+       Coplanar,
+       Sliver
+   };
+
+   string fuzzCaseName(FuzzCase fuzzCase);
+
+   // A path agrees on (P, Q) when it gives what the reference gives; the
+   // reference traces of the pair are those of checkIntersections.
+   struct FuzzPath
+   {
+       string Name;
+       function<bool(const Matrix3Xd& P, const Matrix3Xd& Q, const vector<Trace>& reference)> Agrees;
+   };
+
+   // The pair paths checked against checkIntersections: the prefilters, the
+   // filter cascade, the lazy, streamed and incremental networks, the
+   // multiprocess and out of core decompositions, the trace statistics and a
+   // checkpointed run resumed after its first row. The exact predicates are
+   // only checked for symmetry.
+   vector<FuzzPath> defaultFuzzPaths();
+
+   struct FuzzParameters
+   {
+       unsigned long long Seed;
+       // stop after this many pairs, or after DurationSeconds when it is positive
+       unsigned long long NumberCases;
+       double DurationSeconds;
+       vector<FuzzCase> Cases;
+       size_t MaxReproducers;
+       // folder for the reproducers, in the ImportFractures format; empty to skip
+       string OutputFolder;
+
+       FuzzParameters()
+           : Seed(1), NumberCases(1000), DurationSeconds(0.0),
+             Cases({FuzzCase::Random, FuzzCase::NearParallel, FuzzCase::TouchingEdge,
+                    FuzzCase::Coplanar, FuzzCase::Sliver}),
+             MaxReproducers(10) {}
+   };
+
+   struct FuzzDisagreement
+   {
+       string Path;
+       FuzzCase Case;
+       unsigned long long CaseIndex;
+       // shrunk pair that still shows the disagreement
+       Matrix3Xd P;
+       Matrix3Xd Q;
+       size_t OriginalVertices;
+   };
+
+   struct FuzzStatistics
+   {
+       unsigned long long Cases;
+       unsigned long long ReferenceIntersections;
+       unsigned long long Disagreements;
+       vector<unsigned long long> CasesOf;
+       vector<unsigned long long> DisagreementsOf;
+       vector<string> PathNames;
+       vector<FuzzDisagreement> Reproducers;
+       double Seconds;
+
+       FuzzStatistics() : Cases(0), ReferenceIntersections(0), Disagreements(0), Seconds(0.0) {}
+   };
+
+   void generateFuzzPair(FuzzCase fuzzCase, mt19937_64& generator, Matrix3Xd& P, Matrix3Xd& Q);
+
+   vector<Trace> referencePairTraces(const Matrix3Xd& P, const Matrix3Xd& Q);
+
+   // drops vertices and coordinate digits while the path still disagrees
+   void shrinkDisagreement(const FuzzPath& path, Matrix3Xd& P, Matrix3Xd& Q);
+
+   // true when no path disagrees with the reference
+   bool runFuzz(const FuzzParameters& parameters, const vector<FuzzPath>& paths, FuzzStatistics& statistics);
+
+   void printFuzzStatistics(const FuzzStatistics& statistics, ostream& out);
+
+}
@@ -0,0 +1,57 @@
+#include "Generator.hpp"
+#include <cmath>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    void generateFractures(Fractures& fractures,
+                           const NetworkParameters& parameters,
+                           mt19937_64& generator)
+    {
+        uniform_real_distribution<double> position(0.0, parameters.DomainSize);
+        uniform_real_distribution<double> radius(parameters.MinRadius, parameters.MaxRadius);
+        uniform_real_distribution<double> angle(0.0, 2.0 * M_PI);
+        normal_distribution<double> gaussian(0.0, 1.0);
+
+        const unsigned int n = parameters.NumberFractures;
+        const unsigned int numVertices = parameters.NumberVertices;
+
+        // resize instead of clear so that the vertex matrices of a previous
+        // network with the same shape are reused without new allocations
+        fractures.NumberFractures = n;
+        fractures.FracturesId.resize(n);
+        fractures.FracturesVertices.resize(n);
+        fractures.Traces.clear();
+
+        for (unsigned int f = 0; f < n; f++)
+        {
+            Vector3d center(position(generator), position(generator), position(generator));
+
+            Vector3d normal(gaussian(generator), gaussian(generator), gaussian(generator));
+            while (normal.norm() < 1e-12)
+            {
+                normal = Vector3d(gaussian(generator), gaussian(generator), gaussian(generator));
+            }
+            normal.normalize();
+
+            Vector3d u = normal.unitOrthogonal();
+            Vector3d v = normal.cross(u);
+
+            double r = radius(generator);
+            double theta0 = angle(generator);
+
+            Matrix3Xd& vertices = fractures.FracturesVertices[f];
+            vertices.resize(3, numVertices);
+            for (unsigned int k = 0; k < numVertices; k++)
+            {
+                double theta = theta0 + 2.0 * M_PI * k / numVertices;
+                vertices.col(k) = center + r * (cos(theta) * u + sin(theta) * v);
+            }
+
+            fractures.FracturesId[f] = f;
+        }
+    }
+
+}
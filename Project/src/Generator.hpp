@@ -0,0 +1,26 @@
+#pragma once
+
+#include <random>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   struct NetworkParameters
+   {
+       unsigned int NumberFractures;
+       unsigned int NumberVertices;
+       double DomainSize;
+       double MinRadius;
+       double MaxRadius;
+
+       NetworkParameters()
+           : NumberFractures(50), NumberVertices(4), DomainSize(1.0),
+             MinRadius(0.05), MaxRadius(0.3) {}
+   };
+
+   void generateFractures(Fractures& fractures,
+                          const NetworkParameters& parameters,
+                          mt19937_64& generator);
+
+}
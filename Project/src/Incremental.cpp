@@ -0,0 +1,181 @@
+#include "Incremental.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    IncrementalDFN::IncrementalDFN(Fractures& fractures,
+                                   map<int, vector<int>>& intersections,
+                                   double cellSize)
+        : DFN(fractures), Intersections(intersections), NextTraceId(0), TestedPairs(0)
+    {
+        Boxes = computeBoundingBoxes(DFN);
+        Grid = SpatialGrid(cellSize > 0.0 ? cellSize : suggestCellSize(Boxes));
+
+        for (size_t i = 0; i < DFN.FracturesId.size(); i++)
+        {
+            Position[DFN.FracturesId[i]] = i;
+            Grid.insert(DFN.FracturesId[i], Boxes[i]);
+        }
+
+        for (const auto& trace : DFN.Traces)
+        {
+            NextTraceId = max(NextTraceId, trace.traceId + 1);
+        }
+    }
+
+// ***************************************************************************
+
+    bool IncrementalDFN::addFracture(unsigned int id,
+                                     const Matrix3Xd& vertices,
+                                     vector<int>& newTraces)
+    {
+        newTraces.clear();
+
+        if (Position.count(id) != 0)
+        {
+            cerr << "Fracture " << id << " is already in the network" << endl;
+            return false;
+        }
+
+        BoundingBox box = computeBoundingBox(vertices);
+        BoundingBox searchBox = box;
+        searchBox.inflate(epsilon);
+
+        vector<unsigned int> candidates;
+        Grid.query(searchBox, candidates);
+
+        // visit the candidates in network order, as a full recomputation would
+        vector<size_t> positions;
+        positions.reserve(candidates.size());
+        for (unsigned int candidate : candidates)
+        {
+            size_t j = Position[candidate];
+            if (searchBox.overlaps(Boxes[j]))
+            {
+                positions.push_back(j);
+            }
+        }
+        sort(positions.begin(), positions.end());
+
+        for (size_t j : positions)
+        {
+            int id1 = DFN.FracturesId[j];
+            int id2 = id;
+            const Matrix3Xd& P = DFN.FracturesVertices[j];
+
+            TestedPairs++;
+            if (!fracturesIntersect(P, vertices))
+            {
+                continue;
+            }
+
+            Intersections[id1].push_back(id2);
+            Intersections[id2].push_back(id1);
+
+            try
+            {
+                DFN.Traces.push_back(calculateTrace(P, vertices, id1, id2, NextTraceId));
+                newTraces.push_back(DFN.Traces.back().traceId);
+            }
+            catch (const exception& e)
+            {
+                cerr << "Error calculating trace between fractures "
+                     << id1 << " and " << id2 << ": " << e.what() << endl;
+            }
+        }
+
+        Position[id] = DFN.FracturesId.size();
+        DFN.FracturesId.push_back(id);
+        DFN.FracturesVertices.push_back(vertices);
+        DFN.NumberFractures = DFN.FracturesId.size();
+        Boxes.push_back(box);
+        Grid.insert(id, box);
+
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool IncrementalDFN::removeFracture(unsigned int id)
+    {
+        auto it = Position.find(id);
+        if (it == Position.end())
+        {
+            cerr << "Fracture " << id << " is not in the network" << endl;
+            return false;
+        }
+
+        size_t i = it->second;
+        Grid.remove(id, Boxes[i]);
+
+        const int removed = id;
+        auto adjacency = Intersections.find(removed);
+        if (adjacency != Intersections.end())
+        {
+            for (int neighbour : adjacency->second)
+            {
+                vector<int>& list = Intersections[neighbour];
+                list.erase(remove(list.begin(), list.end(), removed), list.end());
+                if (list.empty())
+                {
+                    Intersections.erase(neighbour);
+                }
+            }
+            Intersections.erase(adjacency);
+        }
+
+        DFN.Traces.erase(remove_if(DFN.Traces.begin(), DFN.Traces.end(),
+                                   [removed](const Trace& trace)
+                                   {
+                                       return trace.fractureId1 == removed ||
+                                              trace.fractureId2 == removed;
+                                   }),
+                         DFN.Traces.end());
+
+        DFN.FracturesId.erase(DFN.FracturesId.begin() + i);
+        DFN.FracturesVertices.erase(DFN.FracturesVertices.begin() + i);
+        DFN.NumberFractures = DFN.FracturesId.size();
+        Boxes.erase(Boxes.begin() + i);
+
+        Position.erase(it);
+        for (size_t j = i; j < DFN.FracturesId.size(); j++)
+        {
+            Position[DFN.FracturesId[j]] = j;
+        }
+
+        return true;
+    }
+
+// ***************************************************************************
+
+    map<int, int> IncrementalDFN::compactTraceIds()
+    {
+        // canonical order is the one of checkIntersections: by the network
+        // position of the first fracture, then of the second one
+        stable_sort(DFN.Traces.begin(), DFN.Traces.end(),
+                    [this](const Trace& a, const Trace& b)
+                    {
+                        size_t a1 = Position[a.fractureId1], b1 = Position[b.fractureId1];
+                        if (a1 != b1)
+                        {
+                            return a1 < b1;
+                        }
+                        return Position[a.fractureId2] < Position[b.fractureId2];
+                    });
+
+        map<int, int> renumbering;
+        NextTraceId = 0;
+        for (auto& trace : DFN.Traces)
+        {
+            renumbering[trace.traceId] = NextTraceId;
+            trace.traceId = NextTraceId++;
+        }
+
+        return renumbering;
+    }
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "Fractures.hpp"
+#include "SpatialIndex.hpp"
+
+namespace FractureLibrary
+{
+
+   class IncrementalDFN
+   {
+       public:
+           IncrementalDFN(Fractures& fractures,
+                          map<int, vector<int>>& intersections,
+                          double cellSize = 0.0);
+
+           bool addFracture(unsigned int id,
+                            const Matrix3Xd& vertices,
+                            vector<int>& newTraces);
+
+           bool removeFracture(unsigned int id);
+
+           map<int, int> compactTraceIds();
+
+           int nextTraceId() const { return NextTraceId; }
+
+           size_t testedPairs() const { return TestedPairs; }
+
+       private:
+           Fractures& DFN;
+           map<int, vector<int>>& Intersections;
+           vector<BoundingBox> Boxes;
+           unordered_map<unsigned int, size_t> Position;
+           SpatialGrid Grid;
+           int NextTraceId;
+           size_t TestedPairs;
+   };
+
+}
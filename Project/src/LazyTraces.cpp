@@ -0,0 +1,153 @@
+#include "LazyTraces.hpp"
+#include "Prefilter.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    LazyTraceNetwork::LazyTraceNetwork(const Fractures& fractures, const LazyParameters& parameters)
+        : DFN(fractures), Selected(0), Evaluated(0)
+    {
+        const vector<unsigned int>& ids = fractures.FracturesId;
+        const vector<Matrix3Xd>& vertices = fractures.FracturesVertices;
+        const size_t n = vertices.size();
+
+        for (size_t i = 0; i < n; i++)
+        {
+            Position.emplace(ids[i], i);
+        }
+
+        // the prefilter and the rows only see the fractures of the region,
+        // so that a small region costs in proportion to its own size
+        Fractures region;
+        vector<unsigned int> original;
+        const Fractures* scope = &fractures;
+        if (parameters.UseRegion)
+        {
+            BoundingBox box = parameters.Region;
+            box.inflate(epsilon);
+            for (size_t i = 0; i < n; i++)
+            {
+                if (computeBoundingBox(vertices[i]).overlaps(box))
+                {
+                    original.push_back(i);
+                    region.FracturesId.push_back(ids[i]);
+                    region.FracturesVertices.push_back(vertices[i]);
+                }
+            }
+            region.NumberFractures = original.size();
+            scope = &region;
+        }
+        const size_t k = scope->FracturesVertices.size();
+        Selected = k;
+        auto index = [&](size_t r)
+        {
+            return parameters.UseRegion ? original[r] : r;
+        };
+
+        // adjacency only: the same pairs checkIntersections accepts, no traces
+        PrefilterParameters filter;
+        filter.UsePlanes = false;
+        ConservativePrefilter prefilter(*scope, filter);
+        vector<char> survivors;
+        for (size_t a = 0; a < k; a++)
+        {
+            prefilter.candidates(a, survivors);
+            for (size_t b = a + 1; b < k; b++)
+            {
+                if (survivors[b] && scope->FracturesId[a] != scope->FracturesId[b] &&
+                    fracturesIntersect(scope->FracturesVertices[a], scope->FracturesVertices[b]))
+                {
+                    Pairs.emplace_back(index(a), index(b));
+                }
+            }
+        }
+
+        Cache.resize(Pairs.size());
+        Done.assign(Pairs.size(), 0);
+    }
+
+// ***************************************************************************
+
+    void LazyTraceNetwork::adjacency(map<int, vector<int>>& intersections) const
+    {
+        const vector<unsigned int>& ids = DFN.FracturesId;
+        for (const auto& pair : Pairs)
+        {
+            intersections[ids[pair.first]].push_back(ids[pair.second]);
+            intersections[ids[pair.second]].push_back(ids[pair.first]);
+        }
+    }
+
+// ***************************************************************************
+
+    const Trace* LazyTraceNetwork::trace(size_t pair)
+    {
+        if (pair >= Pairs.size())
+        {
+            return nullptr;
+        }
+
+        if (!Done[pair])
+        {
+            Done[pair] = 1;
+            Evaluated++;
+
+            unsigned int i = Pairs[pair].first;
+            unsigned int j = Pairs[pair].second;
+            int traceId = pair;
+            try
+            {
+                Cache[pair] = calculateTrace(DFN.FracturesVertices[i], DFN.FracturesVertices[j],
+                                             DFN.FracturesId[i], DFN.FracturesId[j], traceId);
+                Cache[pair]->traceId = pair;
+            }
+            catch (const exception&)
+            {
+                Cache[pair].reset();
+            }
+        }
+
+        return Cache[pair] ? &*Cache[pair] : nullptr;
+    }
+
+// ***************************************************************************
+
+    const Trace* LazyTraceNetwork::trace(int fractureId1, int fractureId2)
+    {
+        auto first = Position.find(fractureId1);
+        auto second = Position.find(fractureId2);
+        if (first == Position.end() || second == Position.end())
+        {
+            return nullptr;
+        }
+
+        pair<unsigned int, unsigned int> key = minmax(first->second, second->second);
+        auto it = lower_bound(Pairs.begin(), Pairs.end(), key);
+        if (it == Pairs.end() || *it != key)
+        {
+            return nullptr;
+        }
+        return trace(it - Pairs.begin());
+    }
+
+// ***************************************************************************
+
+    void LazyTraceNetwork::materialize(vector<Trace>& traces)
+    {
+        traces.clear();
+        for (size_t p = 0; p < Pairs.size(); p++)
+        {
+            const Trace* computed = trace(p);
+            if (computed != nullptr)
+            {
+                traces.push_back(*computed);
+                traces.back().traceId = traces.size() - 1;
+            }
+        }
+    }
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include "Fractures.hpp"
+#include "SpatialIndex.hpp"
+
+namespace FractureLibrary
+{
+
+   struct LazyParameters
+   {
+       // only fractures whose box overlaps Region take part
+       bool UseRegion;
+       BoundingBox Region;
+
+       LazyParameters() : UseRegion(false) {}
+   };
+
+   // Intersecting pairs are found up front; each trace is computed on first
+   // access and then cached. Not safe for concurrent access.
+   class LazyTraceNetwork
+   {
+       public:
+           LazyTraceNetwork(const Fractures& fractures,
+                            const LazyParameters& parameters = LazyParameters());
+
+           size_t numberPairs() const { return Pairs.size(); }
+
+           size_t numberSelected() const { return Selected; }
+
+           size_t evaluatedTraces() const { return Evaluated; }
+
+           // same layout as checkIntersections
+           void adjacency(map<int, vector<int>>& intersections) const;
+
+           // traceId is the pair index; nullptr if the trace cannot be built
+           const Trace* trace(size_t pair);
+
+           const Trace* trace(int fractureId1, int fractureId2);
+
+           // every trace, numbered like checkIntersections numbers them
+           void materialize(vector<Trace>& traces);
+
+       private:
+           const Fractures& DFN;
+           vector<pair<unsigned int, unsigned int>> Pairs;
+           vector<optional<Trace>> Cache;
+           vector<char> Done;
+           unordered_map<int, unsigned int> Position;
+           size_t Selected;
+           size_t Evaluated;
+   };
+
+}
@@ -0,0 +1,299 @@
+#include "LocalTraces.hpp"
+#include "BinaryIO.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <unordered_map>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        const char localMagic[4] = {'D', 'F', 'N', 'L'};
+
+        void writeVector(ostream& out, const Vector3d& v)
+        {
+            out << v.x() << "; " << v.y() << "; " << v.z() << endl;
+        }
+    }
+
+// ***************************************************************************
+
+    LocalFrame fractureFrame(const Matrix3Xd& vertices)
+    {
+        LocalFrame frame;
+        if (vertices.cols() == 0)
+        {
+            return frame;
+        }
+        frame.Origin = vertices.col(0);
+        if (vertices.cols() < 3)
+        {
+            return frame;
+        }
+
+        // the first vertex away from the origin gives the edge, the first
+        // one off its line the plane: a vertex may lie on an edge
+        Index second = 1;
+        while (second < vertices.cols() && vertices.col(second) == vertices.col(0))
+        {
+            second++;
+        }
+        if (second == vertices.cols())
+        {
+            return frame;
+        }
+        Vector3d edge = vertices.col(second) - vertices.col(0);
+        Vector3d normal = Vector3d::Zero();
+        for (Index k = second + 1; k < vertices.cols() && normal.norm() < epsilon * edge.norm(); k++)
+        {
+            normal = edge.cross(vertices.col(k) - vertices.col(0));
+        }
+        if (normal.norm() < epsilon * edge.norm())
+        {
+            // every vertex on one line, the global axes are as good as any
+            return frame;
+        }
+
+        frame.Normal = normal.normalized();
+        frame.U = edge.normalized();
+        frame.V = frame.Normal.cross(frame.U);
+        return frame;
+    }
+
+// ***************************************************************************
+
+    void computeLocalTraces(const Fractures& fractures, vector<LocalFracture>& local,
+                            unsigned int numThreads)
+    {
+        const size_t numberFractures = fractures.FracturesId.size();
+        local.assign(numberFractures, LocalFracture());
+
+        unordered_map<unsigned int, size_t> indexOf;
+        indexOf.reserve(numberFractures);
+        for (size_t i = 0; i < numberFractures; i++)
+        {
+            indexOf.emplace(fractures.FracturesId[i], i);
+        }
+
+        // trace k of fracture i is tracesOf[i][k], the side is in the sign
+        vector<vector<long long>> tracesOf(numberFractures);
+        for (size_t t = 0; t < fractures.Traces.size(); t++)
+        {
+            const Trace& trace = fractures.Traces[t];
+            auto first = indexOf.find(trace.fractureId1);
+            auto second = indexOf.find(trace.fractureId2);
+            if (first != indexOf.end())
+            {
+                tracesOf[first->second].push_back((long long)t);
+            }
+            if (second != indexOf.end())
+            {
+                tracesOf[second->second].push_back(-(long long)t - 1);
+            }
+        }
+
+        parallelFor(0, numberFractures, numThreads, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                LocalFracture& fracture = local[i];
+                const Matrix3Xd& vertices = fractures.FracturesVertices[i];
+                fracture.Id = fractures.FracturesId[i];
+                fracture.Frame = fractureFrame(vertices);
+
+                const LocalFrame& frame = fracture.Frame;
+                Matrix3Xd offsets = vertices.colwise() - frame.Origin;
+                fracture.Vertices.resize(2, vertices.cols());
+                fracture.Vertices.row(0) = frame.U.transpose() * offsets;
+                fracture.Vertices.row(1) = frame.V.transpose() * offsets;
+
+                fracture.Traces.resize(tracesOf[i].size());
+                for (size_t k = 0; k < tracesOf[i].size(); k++)
+                {
+                    long long entry = tracesOf[i][k];
+                    bool firstSide = entry >= 0;
+                    const Trace& trace = fractures.Traces[firstSide ? entry : -entry - 1];
+                    LocalTrace& projected = fracture.Traces[k];
+                    projected.TraceId = trace.traceId;
+                    projected.Tips = firstSide ? trace.Tips1 : trace.Tips2;
+                    projected.P1 = frame.toLocal(Vector3d(trace.p1.x, trace.p1.y, trace.p1.z));
+                    projected.P2 = frame.toLocal(Vector3d(trace.p2.x, trace.p2.y, trace.p2.z));
+                }
+            }
+        });
+    }
+
+// ***************************************************************************
+
+    void writeLocalTraces(ostream& out, const vector<LocalFracture>& local)
+    {
+        out << scientific << setprecision(16);
+        out << "# Number of Fractures" << endl;
+        out << local.size() << endl;
+
+        for (const LocalFracture& fracture : local)
+        {
+            out << "# FractureId; NumVertices; NumTraces" << endl;
+            out << fracture.Id << "; " << fracture.Vertices.cols() << "; " << fracture.Traces.size() << endl;
+            out << "# Origin; U; V" << endl;
+            writeVector(out, fracture.Frame.Origin);
+            writeVector(out, fracture.Frame.U);
+            writeVector(out, fracture.Frame.V);
+            out << "# Vertices" << endl;
+            for (int r = 0; r < 2; r++)
+            {
+                for (int c = 0; c < fracture.Vertices.cols(); c++)
+                {
+                    out << (c == 0 ? "" : "; ") << fracture.Vertices(r, c);
+                }
+                out << endl;
+            }
+            if (!fracture.Traces.empty())
+            {
+                out << "# TraceId; Tips; U1; V1; U2; V2" << endl;
+            }
+            for (const LocalTrace& trace : fracture.Traces)
+            {
+                out << trace.TraceId << "; " << (trace.Tips ? "true" : "false") << "; "
+                    << trace.P1.x() << "; " << trace.P1.y() << "; "
+                    << trace.P2.x() << "; " << trace.P2.y() << endl;
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    bool writeLocalTraces(const vector<LocalFracture>& local, const string& filename)
+    {
+        ofstream outFile(filename);
+        if (!outFile)
+        {
+            cerr << "Failed to open file for writing: " << filename << endl;
+            return false;
+        }
+        writeLocalTraces(outFile, local);
+        return bool(outFile);
+    }
+
+// ***************************************************************************
+
+    void writeLocalTracesBinary(ostream& out, const vector<LocalFracture>& local)
+    {
+        out.write(localMagic, 4);
+        writeBinary<uint64_t>(out, local.size());
+        for (const LocalFracture& fracture : local)
+        {
+            writeBinary<uint32_t>(out, fracture.Id);
+            writeBinary<uint32_t>(out, fracture.Vertices.cols());
+            writeBinary<uint32_t>(out, fracture.Traces.size());
+            for (const Vector3d* v : {&fracture.Frame.Origin, &fracture.Frame.U, &fracture.Frame.V})
+            {
+                out.write(reinterpret_cast<const char*>(v->data()), 3 * sizeof(double));
+            }
+            out.write(reinterpret_cast<const char*>(fracture.Vertices.data()),
+                      fracture.Vertices.size() * sizeof(double));
+            for (const LocalTrace& trace : fracture.Traces)
+            {
+                writeBinary<int32_t>(out, trace.TraceId);
+                writeBinary<uint8_t>(out, trace.Tips);
+                writeBinary<double>(out, trace.P1.x());
+                writeBinary<double>(out, trace.P1.y());
+                writeBinary<double>(out, trace.P2.x());
+                writeBinary<double>(out, trace.P2.y());
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    bool readLocalTracesBinary(istream& in, vector<LocalFracture>& local)
+    {
+        char magic[4];
+        uint64_t numberFractures = 0;
+        if (!in.read(magic, 4) || memcmp(magic, localMagic, 4) != 0 || !readBinary(in, numberFractures))
+        {
+            return false;
+        }
+
+        local.clear();
+        for (uint64_t i = 0; i < numberFractures; i++)
+        {
+            LocalFracture fracture;
+            uint32_t numberVertices = 0, numberTraces = 0;
+            if (!readBinary(in, fracture.Id) || !readBinary(in, numberVertices) || !readBinary(in, numberTraces))
+            {
+                return false;
+            }
+            for (Vector3d* v : {&fracture.Frame.Origin, &fracture.Frame.U, &fracture.Frame.V})
+            {
+                if (!in.read(reinterpret_cast<char*>(v->data()), 3 * sizeof(double)))
+                {
+                    return false;
+                }
+            }
+            fracture.Frame.Normal = fracture.Frame.U.cross(fracture.Frame.V);
+
+            // the counts are checked against the stream before allocating
+            uint64_t reserve = 0;
+            if (!countFits(in, numberVertices, 2 * sizeof(double), reserve))
+            {
+                return false;
+            }
+            vector<double> coordinates;
+            coordinates.reserve(2 * reserve);
+            for (uint32_t v = 0; v < 2 * numberVertices; v++)
+            {
+                double value = 0.0;
+                if (!readBinary(in, value))
+                {
+                    return false;
+                }
+                coordinates.push_back(value);
+            }
+            fracture.Vertices = Map<const Matrix2Xd>(coordinates.data(), 2, numberVertices);
+
+            if (!countFits(in, numberTraces, sizeof(int32_t) + sizeof(uint8_t) + 4 * sizeof(double), reserve))
+            {
+                return false;
+            }
+            fracture.Traces.reserve(reserve);
+            for (uint32_t t = 0; t < numberTraces; t++)
+            {
+                LocalTrace trace;
+                int32_t traceId = 0;
+                uint8_t tips = 0;
+                if (!readBinary(in, traceId) || !readBinary(in, tips) ||
+                    !readBinary(in, trace.P1.x()) || !readBinary(in, trace.P1.y()) ||
+                    !readBinary(in, trace.P2.x()) || !readBinary(in, trace.P2.y()))
+                {
+                    return false;
+                }
+                trace.TraceId = traceId;
+                trace.Tips = tips != 0;
+                fracture.Traces.push_back(trace);
+            }
+            local.push_back(move(fracture));
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool writeLocalTracesBinary(const vector<LocalFracture>& local, const string& filename)
+    {
+        ofstream outFile(filename, ios::binary);
+        if (!outFile)
+        {
+            cerr << "Failed to open file for writing: " << filename << endl;
+            return false;
+        }
+        writeLocalTracesBinary(outFile, local);
+        return bool(outFile);
+    }
+
+}
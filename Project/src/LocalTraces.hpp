@@ -0,0 +1,75 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   // Orthonormal frame of a fracture plane: Origin is the first vertex, U
+   // runs along the first edge and Normal is the plane normal of the first
+   // three vertices, as in intersectPlanes. A point X maps to
+   // (U.(X - Origin), V.(X - Origin)).
+   struct LocalFrame
+   {
+       Vector3d Origin;
+       Vector3d U;
+       Vector3d V;
+       Vector3d Normal;
+
+       LocalFrame()
+           : Origin(Vector3d::Zero()), U(Vector3d::UnitX()), V(Vector3d::UnitY()), Normal(Vector3d::UnitZ()) {}
+
+       Vector2d toLocal(const Vector3d& point) const
+       {
+           Vector3d d = point - Origin;
+           return Vector2d(U.dot(d), V.dot(d));
+       }
+
+       Vector3d toGlobal(const Vector2d& point) const
+       {
+           return Origin + point.x() * U + point.y() * V;
+       }
+   };
+
+   LocalFrame fractureFrame(const Matrix3Xd& vertices);
+
+   struct LocalTrace
+   {
+       int TraceId;
+       bool Tips;
+       Vector2d P1;
+       Vector2d P2;
+
+       LocalTrace() : TraceId(-1), Tips(false), P1(Vector2d::Zero()), P2(Vector2d::Zero()) {}
+   };
+
+   struct LocalFracture
+   {
+       unsigned int Id;
+       LocalFrame Frame;
+       Matrix2Xd Vertices;
+       // in the order of fractures.Traces; endpoints are the orthogonal
+       // projections of the 3D ones, which need not lie on this plane
+       vector<LocalTrace> Traces;
+
+       LocalFracture() : Id(0) {}
+   };
+
+   // one entry per fracture, in the order of fractures.FracturesId
+   void computeLocalTraces(const Fractures& fractures, vector<LocalFracture>& local,
+                           unsigned int numThreads = 0);
+
+   void writeLocalTraces(ostream& out, const vector<LocalFracture>& local);
+
+   bool writeLocalTraces(const vector<LocalFracture>& local, const string& filename);
+
+   void writeLocalTracesBinary(ostream& out, const vector<LocalFracture>& local);
+
+   bool readLocalTracesBinary(istream& in, vector<LocalFracture>& local);
+
+   bool writeLocalTracesBinary(const vector<LocalFracture>& local, const string& filename);
+
+}
@@ -0,0 +1,328 @@
+#include "Multiprocess.hpp"
+#include "SpatialIndex.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define DFN_HAS_FORK
+#endif
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        struct PairRecord
+        {
+            uint32_t I;
+            uint32_t J;
+            uint8_t HasTrace;
+            uint8_t Tips1;
+            uint8_t Tips2;
+            double P1[3];
+            double P2[3];
+        };
+
+        // layout of the shared region of a worker: header followed by the records
+        struct WorkerHeader
+        {
+            uint64_t Count;
+            uint32_t Overflow;
+            uint32_t Done;
+        };
+
+        struct Slabs
+        {
+            int Axis;
+            vector<double> Bounds;
+
+            size_t slabOf(double coordinate) const
+            {
+                size_t s = upper_bound(Bounds.begin() + 1, Bounds.end() - 1, coordinate) - (Bounds.begin() + 1);
+                return s;
+            }
+        };
+
+        // pairs owned by the slab: the lower end of the overlap of the two boxes
+        // along the decomposition axis falls inside it
+        size_t processSlab(const Fractures& fractures,
+                           const vector<BoundingBox>& boxes,
+                           const vector<unsigned int>& members,
+                           const Slabs& slabs,
+                           size_t slab,
+                           PairRecord* records,
+                           size_t capacity,
+                           bool& overflow)
+        {
+            const int axis = slabs.Axis;
+            size_t count = 0;
+            overflow = false;
+
+            for (size_t a = 0; a < members.size(); a++)
+            {
+                for (size_t b = a + 1; b < members.size(); b++)
+                {
+                    unsigned int i = members[a];
+                    unsigned int j = members[b];
+                    if (boxes[j].Min(axis) > boxes[i].Max(axis))
+                    {
+                        break;
+                    }
+
+                    if (!boxes[i].overlaps(boxes[j]) ||
+                        slabs.slabOf(max(boxes[i].Min(axis), boxes[j].Min(axis))) != slab)
+                    {
+                        continue;
+                    }
+
+                    if (i > j)
+                    {
+                        swap(i, j);
+                    }
+
+                    if (fractures.FracturesId[i] == fractures.FracturesId[j] ||
+                        !fracturesIntersect(fractures.FracturesVertices[i], fractures.FracturesVertices[j]))
+                    {
+                        continue;
+                    }
+
+                    if (count == capacity)
+                    {
+                        overflow = true;
+                        return count;
+                    }
+
+                    PairRecord& record = records[count++];
+                    record.I = i;
+                    record.J = j;
+                    record.HasTrace = 0;
+                    try
+                    {
+                        int traceId = 0;
+                        Trace trace = calculateTrace(fractures.FracturesVertices[i], fractures.FracturesVertices[j],
+                                                     fractures.FracturesId[i], fractures.FracturesId[j], traceId);
+                        record.HasTrace = 1;
+                        record.Tips1 = trace.Tips1;
+                        record.Tips2 = trace.Tips2;
+                        record.P1[0] = trace.p1.x;
+                        record.P1[1] = trace.p1.y;
+                        record.P1[2] = trace.p1.z;
+                        record.P2[0] = trace.p2.x;
+                        record.P2[1] = trace.p2.y;
+                        record.P2[2] = trace.p2.z;
+                    }
+                    catch (const exception& e)
+                    {
+                        cerr << "Error calculating trace between fractures "
+                             << fractures.FracturesId[i] << " and " << fractures.FracturesId[j]
+                             << ": " << e.what() << endl;
+                    }
+                }
+            }
+
+            return count;
+        }
+    }
+
+// ***************************************************************************
+
+    bool checkIntersectionsMultiprocess(Fractures& fractures,
+                                        map<int, vector<int>>& intersections,
+                                        const DecompositionParameters& parameters,
+                                        DecompositionStatistics& statistics)
+    {
+        const size_t n = fractures.FracturesId.size();
+        const unsigned int numWorkers = max(1u, parameters.NumberWorkers);
+
+        statistics = DecompositionStatistics();
+        statistics.NumberWorkers = numWorkers;
+
+        vector<BoundingBox> boxes = computeBoundingBoxes(fractures);
+        BoundingBox domain;
+        for (auto& box : boxes)
+        {
+            box.inflate(epsilon);
+            domain.expand(box);
+        }
+        if (n == 0)
+        {
+            return true;
+        }
+
+        // slabs along the longest side, with equal numbers of fracture centres
+        Slabs slabs;
+        (domain.Max - domain.Min).maxCoeff(&slabs.Axis);
+        statistics.Axis = slabs.Axis;
+
+        vector<double> centres(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            centres[i] = 0.5 * (boxes[i].Min(slabs.Axis) + boxes[i].Max(slabs.Axis));
+        }
+        sort(centres.begin(), centres.end());
+
+        slabs.Bounds.push_back(domain.Min(slabs.Axis));
+        for (unsigned int w = 1; w < numWorkers; w++)
+        {
+            slabs.Bounds.push_back(centres[w * n / numWorkers]);
+        }
+        slabs.Bounds.push_back(domain.Max(slabs.Axis));
+
+        // each worker gets its slab plus the halo of fractures reaching into it
+        vector<vector<unsigned int>> members(numWorkers);
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t first = slabs.slabOf(boxes[i].Min(slabs.Axis));
+            size_t last = slabs.slabOf(boxes[i].Max(slabs.Axis));
+            for (size_t s = first; s <= last; s++)
+            {
+                members[s].push_back(i);
+            }
+        }
+
+        statistics.SlabFractures.resize(numWorkers);
+        statistics.HaloFractures.resize(numWorkers);
+        statistics.WorkerPairs.resize(numWorkers);
+        for (unsigned int w = 0; w < numWorkers; w++)
+        {
+            sort(members[w].begin(), members[w].end(), [&](unsigned int a, unsigned int b)
+                 {
+                     return boxes[a].Min(slabs.Axis) < boxes[b].Min(slabs.Axis);
+                 });
+
+            for (unsigned int i : members[w])
+            {
+                if (slabs.slabOf(0.5 * (boxes[i].Min(slabs.Axis) + boxes[i].Max(slabs.Axis))) == w)
+                {
+                    statistics.SlabFractures[w]++;
+                }
+                else
+                {
+                    statistics.HaloFractures[w]++;
+                }
+            }
+        }
+
+        vector<vector<PairRecord>> results(numWorkers);
+        vector<bool> collected(numWorkers, false);
+
+#ifdef DFN_HAS_FORK
+        vector<size_t> capacity(numWorkers);
+        vector<void*> regions(numWorkers, MAP_FAILED);
+        vector<size_t> regionBytes(numWorkers);
+        vector<pid_t> pids(numWorkers, -1);
+
+        for (unsigned int w = 0; w < numWorkers; w++)
+        {
+            capacity[w] = parameters.MaxRecordsPerWorker > 0 ? parameters.MaxRecordsPerWorker
+                                                              : 64 * members[w].size() + 1024;
+            regionBytes[w] = sizeof(WorkerHeader) + capacity[w] * sizeof(PairRecord);
+            regions[w] = mmap(nullptr, regionBytes[w], PROT_READ | PROT_WRITE,
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+            if (regions[w] == MAP_FAILED)
+            {
+                continue;
+            }
+
+            WorkerHeader* header = static_cast<WorkerHeader*>(regions[w]);
+            header->Count = 0;
+            header->Overflow = 0;
+            header->Done = 0;
+
+            cout.flush();
+            cerr.flush();
+            pids[w] = fork();
+            if (pids[w] == 0)
+            {
+                PairRecord* records = reinterpret_cast<PairRecord*>(header + 1);
+                bool overflow;
+                header->Count = processSlab(fractures, boxes, members[w], slabs, w,
+                                            records, capacity[w], overflow);
+                header->Overflow = overflow;
+                header->Done = 1;
+                _exit(0);
+            }
+        }
+
+        for (unsigned int w = 0; w < numWorkers; w++)
+        {
+            if (pids[w] > 0)
+            {
+                int status = 0;
+                waitpid(pids[w], &status, 0);
+
+                const WorkerHeader* header = static_cast<const WorkerHeader*>(regions[w]);
+                if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && header->Done && !header->Overflow)
+                {
+                    const PairRecord* records = reinterpret_cast<const PairRecord*>(header + 1);
+                    results[w].assign(records, records + header->Count);
+                    collected[w] = true;
+                }
+            }
+
+            if (regions[w] != MAP_FAILED)
+            {
+                munmap(regions[w], regionBytes[w]);
+            }
+        }
+#endif
+
+        for (unsigned int w = 0; w < numWorkers; w++)
+        {
+            if (collected[w])
+            {
+                continue;
+            }
+
+            // the worker could not run or ran out of space: redo its slab here
+            statistics.InProcessSlabs++;
+
+            size_t size = 1024;
+            bool overflow = true;
+            while (overflow)
+            {
+                results[w].resize(size);
+                size_t count = processSlab(fractures, boxes, members[w], slabs, w,
+                                           results[w].data(), size, overflow);
+                results[w].resize(count);
+                size *= 4;
+            }
+        }
+
+        // merge in (first, second) network order, the order of checkIntersections
+        vector<PairRecord> merged;
+        for (unsigned int w = 0; w < numWorkers; w++)
+        {
+            statistics.WorkerPairs[w] = results[w].size();
+            merged.insert(merged.end(), results[w].begin(), results[w].end());
+        }
+        sort(merged.begin(), merged.end(), [](const PairRecord& a, const PairRecord& b)
+             {
+                 return a.I != b.I ? a.I < b.I : a.J < b.J;
+             });
+
+        int traceId = 0;
+        for (const auto& record : merged)
+        {
+            int id1 = fractures.FracturesId[record.I];
+            int id2 = fractures.FracturesId[record.J];
+            intersections[id1].push_back(id2);
+            intersections[id2].push_back(id1);
+
+            if (record.HasTrace)
+            {
+                fractures.Traces.emplace_back(traceId++, id1, id2,
+                                              Point(record.P1[0], record.P1[1], record.P1[2]),
+                                              Point(record.P2[0], record.P2[1], record.P2[2]),
+                                              record.Tips1, record.Tips2);
+            }
+        }
+
+        return true;
+    }
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   struct DecompositionParameters
+   {
+       unsigned int NumberWorkers;
+       size_t MaxRecordsPerWorker;
+
+       DecompositionParameters() : NumberWorkers(2), MaxRecordsPerWorker(0) {}
+   };
+
+   struct DecompositionStatistics
+   {
+       unsigned int NumberWorkers;
+       int Axis;
+       vector<size_t> SlabFractures;
+       vector<size_t> HaloFractures;
+       vector<size_t> WorkerPairs;
+       unsigned int InProcessSlabs;
+
+       DecompositionStatistics() : NumberWorkers(0), Axis(0), InProcessSlabs(0) {}
+   };
+
+   bool checkIntersectionsMultiprocess(Fractures& fractures,
+                                       map<int, vector<int>>& intersections,
+                                       const DecompositionParameters& parameters,
+                                       DecompositionStatistics& statistics);
+
+}
@@ -0,0 +1,588 @@
+#include "OutOfCore.hpp"
+#include "BinaryIO.hpp"
+#include "SpatialIndex.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        // append-only binary files fed through bounded in-memory buffers
+        class SpillFiles
+        {
+            public:
+                SpillFiles(const string& prefix, size_t count, size_t flushBytes)
+                    : Prefix(prefix), Buffers(count), FlushBytes(flushBytes), Failed(false) {}
+
+                string path(size_t b) const { return Prefix + to_string(b) + ".bin"; }
+
+                size_t size() const { return Buffers.size(); }
+
+                template <typename T>
+                void put(size_t b, const T& value)
+                {
+                    Buffers[b].append(reinterpret_cast<const char*>(&value), sizeof(T));
+                }
+
+                void put(size_t b, const void* data, size_t bytes)
+                {
+                    Buffers[b].append(static_cast<const char*>(data), bytes);
+                }
+
+                void commit(size_t b)
+                {
+                    if (Buffers[b].size() >= FlushBytes)
+                    {
+                        flush(b);
+                    }
+                }
+
+                void flush(size_t b)
+                {
+                    if (Buffers[b].empty())
+                    {
+                        return;
+                    }
+
+                    ofstream file(path(b), ios::binary | ios::app);
+                    file.write(Buffers[b].data(), Buffers[b].size());
+                    Failed = Failed || !file;
+                    Buffers[b].clear();
+                }
+
+                void flushAll()
+                {
+                    for (size_t b = 0; b < Buffers.size(); b++)
+                    {
+                        flush(b);
+                    }
+                }
+
+                void removeAll()
+                {
+                    for (size_t b = 0; b < Buffers.size(); b++)
+                    {
+                        remove(path(b).c_str());
+                    }
+                }
+
+                bool failed() const { return Failed; }
+
+            private:
+                string Prefix;
+                vector<string> Buffers;
+                size_t FlushBytes;
+                bool Failed;
+        };
+
+        struct TileFracture
+        {
+            uint64_t Index;
+            unsigned int Id;
+            Matrix3Xd Vertices;
+            BoundingBox Box;
+            // in the outer block of a tile processed in blocks
+            bool Outer;
+        };
+
+        double residentBytes(const TileFracture& fracture)
+        {
+            return sizeof(TileFracture) + sizeof(double) * fracture.Vertices.size() + 32.0;
+        }
+
+        // the next fractures of a tile bucket, until they take capacity bytes;
+        // false once the bucket is exhausted
+        bool readTileBlock(ifstream& file, double capacity, bool outer, vector<TileFracture>& block)
+        {
+            double bytes = 0.0;
+            TileFracture fracture;
+            fracture.Outer = outer;
+            uint32_t cols;
+            size_t first = block.size();
+            while (bytes < capacity && readBinary(file, fracture.Index) && readBinary(file, fracture.Id) &&
+                   readBinary(file, cols))
+            {
+                fracture.Vertices.resize(3, cols);
+                file.read(reinterpret_cast<char*>(fracture.Vertices.data()), sizeof(double) * 3 * cols);
+                fracture.Box = computeBoundingBox(fracture.Vertices);
+                fracture.Box.inflate(epsilon);
+                block.push_back(fracture);
+                bytes += residentBytes(fracture);
+            }
+            return block.size() > first;
+        }
+
+        struct PairTrace
+        {
+            uint64_t I;
+            uint64_t J;
+            Trace T;
+        };
+
+        struct ResultRecord
+        {
+            uint64_t Index;
+            uint32_t FractureId;
+            int32_t TraceId;
+            uint8_t Tips;
+            double Length;
+        };
+
+        struct TileGrid
+        {
+            Vector3d Origin;
+            Vector3d Size;
+            int Count;
+
+            Array3i tileOf(const Vector3d& point) const
+            {
+                Array3i t = ((point - Origin).array() / Size.array()).floor().cast<int>();
+                return t.max(0).min(Count - 1);
+            }
+
+            size_t linear(const Array3i& t) const
+            {
+                return (size_t(t(0)) * Count + t(1)) * Count + t(2);
+            }
+        };
+    }
+
+// ***************************************************************************
+
+    FractureReader::FractureReader(const string& filename)
+        : File(filename), Failed(false), Declared(0)
+    {
+        string line;
+        if (!File || !nextLine(line))
+        {
+            cerr << "File open failed: " << filename << endl;
+            Failed = true;
+            return;
+        }
+
+        Declared = stoul(line);
+    }
+
+// ***************************************************************************
+
+    bool FractureReader::nextLine(string& line)
+    {
+        while (getline(File, line))
+        {
+            if (!line.empty() && line[0] == '#')
+            {
+                continue;
+            }
+            return true;
+        }
+        return false;
+    }
+
+// ***************************************************************************
+
+    bool FractureReader::next(unsigned int& id, Matrix3Xd& vertices)
+    {
+        string line;
+        if (Failed || !nextLine(line))
+        {
+            return false;
+        }
+
+        istringstream converter(line);
+        int numVertices;
+        char delimiter;
+        converter >> id >> delimiter >> numVertices;
+        if (converter.fail() || delimiter != ';')
+        {
+            cerr << "Error reading fracture header." << endl;
+            Failed = true;
+            return false;
+        }
+
+        vertices.resize(3, numVertices);
+        for (int i = 0; i < 3; i++)
+        {
+            if (!nextLine(line))
+            {
+                cerr << "Unexpected end of file while reading vertices." << endl;
+                Failed = true;
+                return false;
+            }
+
+            istringstream vertexStream(line);
+            string value;
+            for (int j = 0; j < numVertices; j++)
+            {
+                if (!getline(vertexStream, value, ';'))
+                {
+                    cerr << "Error reading vertex line." << endl;
+                    Failed = true;
+                    return false;
+                }
+                vertices(i, j) = stod(value);
+            }
+        }
+
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool processOutOfCore(const string& inputFile,
+                          const string& tracesFile,
+                          const string& resultsFile,
+                          const TilingParameters& parameters,
+                          TilingStatistics& statistics)
+    {
+        statistics = TilingStatistics();
+
+        // first pass: domain extent and fracture size, nothing is kept
+        BoundingBox domain;
+        double extentSum = 0.0;
+        size_t numberFractures = 0;
+        {
+            FractureReader reader(inputFile);
+            unsigned int id;
+            Matrix3Xd vertices;
+            while (reader.next(id, vertices))
+            {
+                BoundingBox box = computeBoundingBox(vertices);
+                domain.expand(box);
+                extentSum += (box.Max - box.Min).maxCoeff();
+                numberFractures++;
+            }
+            if (!reader.good())
+            {
+                return false;
+            }
+        }
+
+        if (numberFractures == 0)
+        {
+            cerr << "There is no fractures" << endl;
+            return false;
+        }
+
+        statistics.NumberFractures = numberFractures;
+        domain.inflate(epsilon);
+
+        // a tile holds its fractures and the pair sweep data, keep it within half the budget
+        const double meanVertices = 4.0;
+        const double bytesPerFracture = sizeof(TileFracture) + 24.0 * meanVertices + 32.0;
+        int tiles = parameters.TilesPerAxis;
+        if (tiles <= 0)
+        {
+            double needed = numberFractures * bytesPerFracture / (0.5 * parameters.MemoryBudget);
+            tiles = max(1, int(ceil(cbrt(needed))));
+        }
+        tiles = min(tiles, 32);
+        statistics.TilesPerAxis = tiles;
+
+        TileGrid grid;
+        grid.Origin = domain.Min;
+        grid.Count = tiles;
+        grid.Size = ((domain.Max - domain.Min) / tiles).cwiseMax(Vector3d::Constant(epsilon));
+
+        const size_t numberTiles = size_t(tiles) * tiles * tiles;
+        const size_t numberPartitions = numberTiles;
+        const size_t partitionSize = (numberFractures + numberPartitions - 1) / numberPartitions;
+        const size_t flushBytes = max<size_t>(4096, parameters.MemoryBudget / (8 * numberTiles));
+
+        string prefix = parameters.WorkDirectory + "/dfn_ooc_" +
+                        to_string(chrono::steady_clock::now().time_since_epoch().count());
+        SpillFiles buckets(prefix + "_tile_", numberTiles, flushBytes);
+        SpillFiles pairs(prefix + "_pairs_", numberPartitions, flushBytes);
+        SpillFiles records(prefix + "_results_", numberPartitions, flushBytes);
+        string tracesBody = prefix + "_traces.txt";
+
+        auto cleanup = [&]()
+        {
+            buckets.removeAll();
+            pairs.removeAll();
+            records.removeAll();
+            remove(tracesBody.c_str());
+        };
+
+        // second pass: stream every fracture into the buckets of the tiles it touches
+        {
+            FractureReader reader(inputFile);
+            unsigned int id;
+            Matrix3Xd vertices;
+            uint64_t index = 0;
+            while (reader.next(id, vertices))
+            {
+                BoundingBox box = computeBoundingBox(vertices);
+                box.inflate(epsilon);
+                Array3i lo = grid.tileOf(box.Min);
+                Array3i hi = grid.tileOf(box.Max);
+
+                size_t copies = 0;
+                for (int a = lo(0); a <= hi(0); a++)
+                {
+                    for (int b = lo(1); b <= hi(1); b++)
+                    {
+                        for (int c = lo(2); c <= hi(2); c++)
+                        {
+                            size_t tile = grid.linear(Array3i(a, b, c));
+                            buckets.put(tile, index);
+                            buckets.put<uint32_t>(tile, id);
+                            buckets.put<uint32_t>(tile, vertices.cols());
+                            buckets.put(tile, vertices.data(), sizeof(double) * vertices.size());
+                            buckets.commit(tile);
+                            copies++;
+                        }
+                    }
+                }
+                statistics.DuplicatedFractures += copies - 1;
+                index++;
+            }
+            buckets.flushAll();
+        }
+
+        // process the tiles one at a time; a pair belongs to the tile holding the
+        // lower corner of the overlap of the two boxes, so it is found exactly once.
+        // A tile over its share of the budget is joined block by block: every
+        // outer block with itself, then with each later block streamed past it.
+        const double blockBytes = 0.25 * parameters.MemoryBudget;
+        vector<TileFracture> tile;
+        auto sweep = [&](size_t t, bool joined)
+        {
+            sort(tile.begin(), tile.end(), [](const TileFracture& a, const TileFracture& b)
+                 {
+                     return a.Box.Min.x() < b.Box.Min.x();
+                 });
+
+            for (size_t a = 0; a < tile.size(); a++)
+            {
+                for (size_t b = a + 1; b < tile.size() && tile[b].Box.Min.x() <= tile[a].Box.Max.x(); b++)
+                {
+                    if ((joined && tile[a].Outer == tile[b].Outer) ||
+                        !tile[a].Box.overlaps(tile[b].Box) || tile[a].Id == tile[b].Id)
+                    {
+                        continue;
+                    }
+
+                    Vector3d corner = tile[a].Box.Min.cwiseMax(tile[b].Box.Min);
+                    if (grid.linear(grid.tileOf(corner)) != t)
+                    {
+                        continue;
+                    }
+
+                    const TileFracture& first = tile[a].Index < tile[b].Index ? tile[a] : tile[b];
+                    const TileFracture& second = tile[a].Index < tile[b].Index ? tile[b] : tile[a];
+
+                    if (!fracturesIntersect(first.Vertices, second.Vertices))
+                    {
+                        continue;
+                    }
+
+                    try
+                    {
+                        int traceId = 0;
+                        Trace trace = calculateTrace(first.Vertices, second.Vertices,
+                                                     first.Id, second.Id, traceId);
+
+                        size_t partition = first.Index / partitionSize;
+                        pairs.put(partition, first.Index);
+                        pairs.put(partition, second.Index);
+                        string encoded;
+                        {
+                            ostringstream out;
+                            writeTraceBinary(out, trace);
+                            encoded = out.str();
+                        }
+                        pairs.put(partition, encoded.data(), encoded.size());
+                        pairs.commit(partition);
+                    }
+                    catch (const exception& e)
+                    {
+                        cerr << "Error calculating trace between fractures "
+                             << first.Id << " and " << second.Id << ": " << e.what() << endl;
+                    }
+                }
+            }
+        };
+
+        for (size_t t = 0; t < numberTiles; t++)
+        {
+            ifstream outer(buckets.path(t), ios::binary);
+            size_t tileFractures = 0;
+            size_t blocks = 0;
+            tile.clear();
+            while (readTileBlock(outer, blockBytes, true, tile))
+            {
+                const size_t outerFractures = tile.size();
+                tileFractures += outerFractures;
+                blocks++;
+                statistics.MaxResidentFractures = max(statistics.MaxResidentFractures, outerFractures);
+                sweep(t, false);
+
+                // the blocks after the outer one, from a second reader
+                streampos next = outer.tellg();
+                if (next != streampos(-1) && outer.peek() != char_traits<char>::eof())
+                {
+                    ifstream inner(buckets.path(t), ios::binary);
+                    inner.seekg(next);
+                    while (readTileBlock(inner, blockBytes, false, tile))
+                    {
+                        statistics.MaxResidentFractures = max(statistics.MaxResidentFractures, tile.size());
+                        sweep(t, true);
+                        tile.erase(remove_if(tile.begin(), tile.end(), [](const TileFracture& fracture)
+                                             {
+                                                 return !fracture.Outer;
+                                             }), tile.end());
+                    }
+                }
+                tile.clear();
+            }
+            outer.close();
+            remove(buckets.path(t).c_str());
+            statistics.MaxTileFractures = max(statistics.MaxTileFractures, tileFractures);
+            statistics.SplitTiles += blocks > 1;
+        }
+        pairs.flushAll();
+
+        // number the traces in (first, second) network order, as checkIntersections does
+        int traceId = 0;
+        {
+            ofstream body(tracesBody);
+            vector<PairTrace> partition;
+            for (size_t p = 0; p < numberPartitions; p++)
+            {
+                partition.clear();
+                ifstream file(pairs.path(p), ios::binary);
+                PairTrace record = {0, 0, Trace(0, 0, 0, Point(), Point(), false, false)};
+                while (readBinary(file, record.I) && readBinary(file, record.J) &&
+                       readTraceBinary(file, record.T))
+                {
+                    partition.push_back(record);
+                }
+                file.close();
+                remove(pairs.path(p).c_str());
+                statistics.MaxPartitionRecords = max(statistics.MaxPartitionRecords, partition.size());
+
+                sort(partition.begin(), partition.end(), [](const PairTrace& a, const PairTrace& b)
+                     {
+                         return a.I != b.I ? a.I < b.I : a.J < b.J;
+                     });
+
+                for (auto& entry : partition)
+                {
+                    entry.T.traceId = traceId++;
+                    writeTraceLine(body, entry.T);
+
+                    ResultRecord first = {entry.I, uint32_t(entry.T.fractureId1), entry.T.traceId,
+                                          uint8_t(entry.T.Tips1), entry.T.length};
+                    ResultRecord second = {entry.J, uint32_t(entry.T.fractureId2), entry.T.traceId,
+                                           uint8_t(entry.T.Tips2), entry.T.length};
+                    records.put(entry.I / partitionSize, first);
+                    records.commit(entry.I / partitionSize);
+                    records.put(entry.J / partitionSize, second);
+                    records.commit(entry.J / partitionSize);
+                }
+            }
+            records.flushAll();
+        }
+        statistics.NumberTraces = traceId;
+
+        {
+            ofstream outFile(tracesFile);
+            if (!outFile)
+            {
+                cerr << "Failed to open file for writing: " << tracesFile << endl;
+                cleanup();
+                return false;
+            }
+
+            outFile << "# Number of Traces" << endl;
+            outFile << traceId << endl;
+            outFile << "# TraceId; FractureId1; FractureId2; X1; Y1; Z1; X2; Y2; Z2" << endl;
+            ifstream body(tracesBody);
+            if (traceId > 0)
+            {
+                outFile << body.rdbuf();
+            }
+        }
+
+        {
+            ofstream outFile(resultsFile);
+            if (!outFile)
+            {
+                cerr << "Failed to open file for writing: " << resultsFile << endl;
+                cleanup();
+                return false;
+            }
+
+            vector<ResultRecord> partition;
+            for (size_t p = 0; p < numberPartitions; p++)
+            {
+                partition.clear();
+                ifstream file(records.path(p), ios::binary);
+                ResultRecord record;
+                while (readBinary(file, record))
+                {
+                    partition.push_back(record);
+                }
+                file.close();
+                remove(records.path(p).c_str());
+                statistics.MaxPartitionRecords = max(statistics.MaxPartitionRecords, partition.size());
+
+                // passing traces first, then by decreasing length as in writeResults
+                stable_sort(partition.begin(), partition.end(), [](const ResultRecord& a, const ResultRecord& b)
+                            {
+                                if (a.Index != b.Index)
+                                {
+                                    return a.Index < b.Index;
+                                }
+                                if (a.Tips != b.Tips)
+                                {
+                                    return a.Tips < b.Tips;
+                                }
+                                return a.Length > b.Length;
+                            });
+
+                for (size_t begin = 0; begin < partition.size();)
+                {
+                    size_t end = begin;
+                    while (end < partition.size() && partition[end].Index == partition[begin].Index)
+                    {
+                        end++;
+                    }
+
+                    outFile << "# FractureId; NumTraces" << endl;
+                    outFile << partition[begin].FractureId << "; " << end - begin << endl;
+                    outFile << "# TraceId; Tips; Length" << endl;
+                    for (size_t r = begin; r < end; r++)
+                    {
+                        outFile << partition[r].TraceId << "; " << (partition[r].Tips ? "true" : "false")
+                                << "; " << partition[r].Length << endl;
+                    }
+
+                    begin = end;
+                }
+            }
+        }
+
+        bool failed = buckets.failed() || pairs.failed() || records.failed();
+        cleanup();
+
+        statistics.EstimatedPeakBytes = size_t(statistics.MaxResidentFractures * bytesPerFracture) +
+                                        3 * numberTiles * flushBytes +
+                                        statistics.MaxPartitionRecords * sizeof(PairTrace);
+
+        if (failed)
+        {
+            cerr << "Error writing the spill files in " << parameters.WorkDirectory << endl;
+            return false;
+        }
+
+        return true;
+    }
+
+}
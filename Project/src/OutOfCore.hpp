@@ -0,0 +1,65 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   class FractureReader
+   {
+       public:
+           explicit FractureReader(const string& filename);
+
+           bool good() const { return !Failed; }
+
+           size_t declaredFractures() const { return Declared; }
+
+           bool next(unsigned int& id, Matrix3Xd& vertices);
+
+       private:
+           ifstream File;
+           bool Failed;
+           size_t Declared;
+
+           bool nextLine(string& line);
+   };
+
+   struct TilingParameters
+   {
+       size_t MemoryBudget;
+       unsigned int TilesPerAxis;
+       string WorkDirectory;
+
+       TilingParameters()
+           : MemoryBudget(size_t(256) << 20), TilesPerAxis(0), WorkDirectory(".") {}
+   };
+
+   struct TilingStatistics
+   {
+       size_t NumberFractures;
+       unsigned int TilesPerAxis;
+       size_t DuplicatedFractures;
+       size_t MaxTileFractures;
+       // a tile over its share of the budget is read in blocks; at most two
+       // of them are in memory
+       size_t SplitTiles;
+       size_t MaxResidentFractures;
+       size_t MaxPartitionRecords;
+       size_t NumberTraces;
+       size_t EstimatedPeakBytes;
+
+       TilingStatistics()
+           : NumberFractures(0), TilesPerAxis(0), DuplicatedFractures(0), MaxTileFractures(0), SplitTiles(0),
+             MaxResidentFractures(0), MaxPartitionRecords(0), NumberTraces(0), EstimatedPeakBytes(0) {}
+   };
+
+   bool processOutOfCore(const string& inputFile,
+                         const string& tracesFile,
+                         const string& resultsFile,
+                         const TilingParameters& parameters,
+                         TilingStatistics& statistics);
+
+}
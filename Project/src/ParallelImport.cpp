@@ -0,0 +1,319 @@
+#include "ParallelImport.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define DFN_HAS_MMAP
+#endif
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        const char fractureMarker[] = "# FractureId";
+        const size_t fractureMarkerSize = sizeof(fractureMarker) - 1;
+
+        // read-only view of the whole file, memory mapped when possible
+        class MappedFile
+        {
+            public:
+                explicit MappedFile(const string& filename) : Data(nullptr), Size(0), Mapped(false)
+                {
+#ifdef DFN_HAS_MMAP
+                    int fd = open(filename.c_str(), O_RDONLY);
+                    if (fd >= 0)
+                    {
+                        struct stat info;
+                        if (fstat(fd, &info) == 0 && info.st_size > 0)
+                        {
+                            void* address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                            if (address != MAP_FAILED)
+                            {
+                                Data = static_cast<const char*>(address);
+                                Size = info.st_size;
+                                Mapped = true;
+                            }
+                        }
+                        close(fd);
+                        if (Mapped)
+                        {
+                            return;
+                        }
+                    }
+#endif
+                    ifstream file(filename, ios::binary);
+                    if (file)
+                    {
+                        ostringstream content;
+                        content << file.rdbuf();
+                        Buffer = content.str();
+                        Data = Buffer.data();
+                        Size = Buffer.size();
+                    }
+                }
+
+                ~MappedFile()
+                {
+#ifdef DFN_HAS_MMAP
+                    if (Mapped)
+                    {
+                        munmap(const_cast<char*>(Data), Size);
+                    }
+#endif
+                }
+
+                const char* Data;
+                size_t Size;
+
+            private:
+                bool Mapped;
+                string Buffer;
+        };
+
+        struct Cursor
+        {
+            const char* Position;
+            const char* End;
+
+            bool nextLine(const char*& begin, const char*& end)
+            {
+                while (Position < End)
+                {
+                    begin = Position;
+                    const char* newline = static_cast<const char*>(memchr(Position, '\n', End - Position));
+                    end = newline != nullptr ? newline : End;
+                    Position = newline != nullptr ? newline + 1 : End;
+
+                    if (end > begin && *(end - 1) == '\r')
+                    {
+                        end--;
+                    }
+                    if (end > begin && *begin == '#')
+                    {
+                        continue;
+                    }
+                    return true;
+                }
+                return false;
+            }
+        };
+
+        bool isMarker(const char* position, const char* end)
+        {
+            return size_t(end - position) >= fractureMarkerSize &&
+                   memcmp(position, fractureMarker, fractureMarkerSize) == 0;
+        }
+
+        const char* nextMarker(const char* position, const char* begin, const char* end)
+        {
+            // move to the start of a line, then look for the next marker line
+            while (position < end && position > begin && *(position - 1) != '\n')
+            {
+                position++;
+            }
+            while (position < end)
+            {
+                if (isMarker(position, end))
+                {
+                    return position;
+                }
+                const char* newline = static_cast<const char*>(memchr(position, '\n', end - position));
+                position = newline != nullptr ? newline + 1 : end;
+            }
+            return end;
+        }
+
+        // same conversion as stod on the text between two separators
+        bool parseDouble(const char* begin, const char* end, double& value)
+        {
+            char buffer[128];
+            size_t length = min<size_t>(end - begin, sizeof(buffer) - 1);
+            memcpy(buffer, begin, length);
+            buffer[length] = '\0';
+
+            char* parsed;
+            value = strtod(buffer, &parsed);
+            return parsed != buffer;
+        }
+
+        bool parseHeader(const char* begin, const char* end, unsigned int& id, int& numVertices)
+        {
+            istringstream converter(string(begin, end));
+            char delimiter;
+            converter >> id >> delimiter >> numVertices;
+            return !converter.fail() && delimiter == ';';
+        }
+
+        // reads the count fractures of the chunk and nothing else; false
+        // also when the chunk holds more, a fracture without its marker
+        bool parseChunk(const char* begin, const char* end, Fractures& fractures, size_t slot, size_t count)
+        {
+            Cursor cursor = {begin, end};
+            const char* lineBegin;
+            const char* lineEnd;
+
+            for (size_t f = 0; f < count; f++, slot++)
+            {
+                unsigned int id;
+                int numVertices;
+                if (!cursor.nextLine(lineBegin, lineEnd) || !parseHeader(lineBegin, lineEnd, id, numVertices))
+                {
+                    return false;
+                }
+
+                fractures.FracturesId[slot] = id;
+                Matrix3Xd& vertices = fractures.FracturesVertices[slot];
+                vertices.resize(3, numVertices);
+
+                for (int i = 0; i < 3; i++)
+                {
+                    if (!cursor.nextLine(lineBegin, lineEnd))
+                    {
+                        return false;
+                    }
+
+                    const char* value = lineBegin;
+                    for (int j = 0; j < numVertices; j++)
+                    {
+                        if (value >= lineEnd)
+                        {
+                            return false;
+                        }
+
+                        const char* separator = static_cast<const char*>(memchr(value, ';', lineEnd - value));
+                        const char* valueEnd = separator != nullptr ? separator : lineEnd;
+                        if (!parseDouble(value, valueEnd, vertices(i, j)))
+                        {
+                            return false;
+                        }
+                        value = valueEnd + 1;
+                    }
+                }
+            }
+
+            return !cursor.nextLine(lineBegin, lineEnd);
+        }
+    }
+
+// ***************************************************************************
+
+    bool ImportFracturesParallel(const string& filename,
+                                 Fractures& fractures,
+                                 unsigned int numThreads)
+    {
+        MappedFile file(filename);
+        if (file.Data == nullptr)
+        {
+            cerr << "File open failed: " << filename << endl;
+            return false;
+        }
+
+        const char* begin = file.Data;
+        const char* end = file.Data + file.Size;
+
+        Cursor cursor = {begin, end};
+        const char* lineBegin;
+        const char* lineEnd;
+        if (!cursor.nextLine(lineBegin, lineEnd))
+        {
+            cerr << "There is no fractures" << endl;
+            return false;
+        }
+
+        fractures.NumberFractures = stoi(string(lineBegin, lineEnd));
+        if (fractures.NumberFractures == 0)
+        {
+            cerr << "There is no fractures" << endl;
+            return false;
+        }
+
+        const char* body = nextMarker(cursor.Position, begin, end);
+        if (body == end)
+        {
+            // no header comments to split at: fall back to the serial reader
+            fractures.clear();
+            return ImportFractures(filename, fractures);
+        }
+
+        // split at marker lines, then count the fractures of every chunk
+        numThreads = resolveThreads(numThreads);
+        const size_t numChunks = 4 * size_t(numThreads);
+        vector<const char*> bounds = {body};
+        for (size_t c = 1; c < numChunks; c++)
+        {
+            const char* candidate = body + (end - body) * c / numChunks;
+            const char* bound = nextMarker(max(candidate, bounds.back() + 1), begin, end);
+            if (bound < end)
+            {
+                bounds.push_back(bound);
+            }
+        }
+        bounds.push_back(end);
+        const size_t chunks = bounds.size() - 1;
+
+        vector<size_t> counts(chunks, 0);
+        parallelFor(0, chunks, numThreads, [&](size_t first, size_t last, unsigned int)
+        {
+            for (size_t c = first; c < last; c++)
+            {
+                const char* position = bounds[c];
+                while (position < bounds[c + 1])
+                {
+                    if (isMarker(position, bounds[c + 1]))
+                    {
+                        counts[c]++;
+                    }
+                    const char* newline = static_cast<const char*>(memchr(position, '\n', bounds[c + 1] - position));
+                    position = newline != nullptr ? newline + 1 : bounds[c + 1];
+                }
+            }
+        });
+
+        vector<size_t> offsets(chunks + 1, 0);
+        for (size_t c = 0; c < chunks; c++)
+        {
+            offsets[c + 1] = offsets[c] + counts[c];
+        }
+
+        // the markers are only comments; when they do not split the file
+        // into whole fractures the serial reader decides, and reports
+        // what is wrong with it
+        if (offsets.back() != size_t(fractures.NumberFractures))
+        {
+            fractures.clear();
+            return ImportFractures(filename, fractures);
+        }
+
+        fractures.FracturesId.assign(offsets.back(), 0);
+        fractures.FracturesVertices.assign(offsets.back(), Matrix3Xd());
+        fractures.Traces.clear();
+
+        atomic<bool> failed(false);
+        parallelFor(0, chunks, numThreads, [&](size_t first, size_t last, unsigned int)
+        {
+            for (size_t c = first; c < last && !failed; c++)
+            {
+                if (!parseChunk(bounds[c], bounds[c + 1], fractures, offsets[c], counts[c]))
+                {
+                    failed = true;
+                }
+            }
+        });
+
+        if (failed)
+        {
+            fractures.clear();
+            return ImportFractures(filename, fractures);
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   bool ImportFracturesParallel(const string& filename,
+                                Fractures& fractures,
+                                unsigned int numThreads = 0);
+
+}
@@ -0,0 +1,418 @@
+#include "ParaviewExport.hpp"
+#include "SpatialIndex.hpp"
+#include "Statistics.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <unordered_map>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        const unsigned char vtkLine = 3;
+        const unsigned char vtkPolygon = 7;
+
+        const char* byteOrder()
+        {
+            const uint16_t probe = 1;
+            return *reinterpret_cast<const unsigned char*>(&probe) == 1 ? "LittleEndian" : "BigEndian";
+        }
+
+        // 21 bits of x spread to every third bit
+        uint64_t spreadBits(uint64_t x)
+        {
+            x &= 0x1fffff;
+            x = (x | x << 32) & 0x1f00000000ffffULL;
+            x = (x | x << 16) & 0x1f0000ff0000ffULL;
+            x = (x | x << 8) & 0x100f00f00f00f00fULL;
+            x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+            x = (x | x << 2) & 0x1249249249249249ULL;
+            return x;
+        }
+
+        uint64_t mortonKey(const Vector3d& point, const BoundingBox& box)
+        {
+            const double cells = double((1 << 21) - 1);
+            uint64_t key = 0;
+            for (int d = 0; d < 3; d++)
+            {
+                double extent = box.Max(d) - box.Min(d);
+                double scaled = extent > 0.0 ? (point(d) - box.Min(d)) / extent : 0.0;
+                key |= spreadBits(uint64_t(min(max(scaled, 0.0), 1.0) * cells)) << d;
+            }
+            return key;
+        }
+
+        // appended arrays are recorded while the header is written and
+        // follow it in the same order
+        struct Appended
+        {
+            vector<pair<const char*, uint64_t>> Blocks;
+            uint64_t Offset = 0;
+        };
+
+        template <typename T>
+        void writeArray(ostream& out, const char* type, const string& name, unsigned int components,
+                        const vector<T>& values, VtkEncoding encoding, Appended& appended)
+        {
+            out << "        <DataArray type=\"" << type << "\" Name=\"" << name
+                << "\" NumberOfComponents=\"" << components << "\"";
+            if (encoding == VtkEncoding::Raw)
+            {
+                out << " format=\"appended\" offset=\"" << appended.Offset << "\"/>\n";
+                uint64_t bytes = values.size() * sizeof(T);
+                appended.Blocks.emplace_back(reinterpret_cast<const char*>(values.data()), bytes);
+                appended.Offset += sizeof(uint64_t) + bytes;
+                return;
+            }
+
+            out << " format=\"ascii\">\n";
+            for (size_t k = 0; k < values.size(); k++)
+            {
+                out << (k % 12 == 0 ? "          " : " ") << +values[k];
+                if (k % 12 == 11 || k + 1 == values.size())
+                {
+                    out << "\n";
+                }
+            }
+            out << "        </DataArray>\n";
+        }
+
+        // one piece of the cells in order[first, last); returns its size in
+        // bytes, zero when the file cannot be written
+        uint64_t writeShard(const string& path, const MatrixXd& points,
+                            const vector<vector<unsigned int>>& cells,
+                            const vector<Gedim::UCDProperty<double>>& cellProperties,
+                            const vector<uint32_t>& order, size_t first, size_t last,
+                            VtkEncoding encoding, size_t& numberPoints)
+        {
+            // points are renumbered in the order the cells of the shard use them
+            unordered_map<unsigned int, int64_t> localOf;
+            vector<double> coordinates;
+            vector<int64_t> connectivity;
+            vector<int64_t> offsets;
+            vector<uint8_t> types;
+            vector<vector<double>> properties(cellProperties.size());
+            offsets.reserve(last - first);
+            types.reserve(last - first);
+            for (size_t k = first; k < last; k++)
+            {
+                const vector<unsigned int>& cell = cells[order[k]];
+                for (unsigned int point : cell)
+                {
+                    auto inserted = localOf.emplace(point, int64_t(localOf.size()));
+                    if (inserted.second)
+                    {
+                        coordinates.insert(coordinates.end(), points.col(point).data(), points.col(point).data() + 3);
+                    }
+                    connectivity.push_back(inserted.first->second);
+                }
+                offsets.push_back(connectivity.size());
+                types.push_back(cell.size() == 2 ? vtkLine : vtkPolygon);
+
+                for (size_t p = 0; p < cellProperties.size(); p++)
+                {
+                    const Gedim::UCDProperty<double>& property = cellProperties[p];
+                    const double* values = property.Data + size_t(order[k]) * property.NumComponents;
+                    properties[p].insert(properties[p].end(), values, values + property.NumComponents);
+                }
+            }
+            numberPoints = localOf.size();
+
+            ofstream out(path, ios::binary);
+            if (!out)
+            {
+                cerr << "Failed to open file for writing: " << path << endl;
+                return 0;
+            }
+            out << setprecision(17);
+            out << "<?xml version=\"1.0\"?>\n"
+                << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << byteOrder()
+                << "\" header_type=\"UInt64\">\n"
+                << "  <UnstructuredGrid>\n"
+                << "    <Piece NumberOfPoints=\"" << numberPoints << "\" NumberOfCells=\"" << last - first << "\">\n";
+
+            Appended appended;
+            out << "      <Points>\n";
+            writeArray(out, "Float64", "Points", 3, coordinates, encoding, appended);
+            out << "      </Points>\n      <Cells>\n";
+            writeArray(out, "Int64", "connectivity", 1, connectivity, encoding, appended);
+            writeArray(out, "Int64", "offsets", 1, offsets, encoding, appended);
+            writeArray(out, "UInt8", "types", 1, types, encoding, appended);
+            out << "      </Cells>\n      <CellData>\n";
+            for (size_t p = 0; p < cellProperties.size(); p++)
+            {
+                writeArray(out, "Float64", cellProperties[p].Label, cellProperties[p].NumComponents,
+                           properties[p], encoding, appended);
+            }
+            out << "      </CellData>\n    </Piece>\n  </UnstructuredGrid>\n";
+
+            if (encoding == VtkEncoding::Raw)
+            {
+                out << "  <AppendedData encoding=\"raw\">\n_";
+                for (const auto& block : appended.Blocks)
+                {
+                    uint64_t bytes = block.second;
+                    out.write(reinterpret_cast<const char*>(&bytes), sizeof(uint64_t));
+                    out.write(block.first, bytes);
+                }
+                out << "\n  </AppendedData>\n";
+            }
+            out << "</VTKFile>\n";
+
+            uint64_t bytes = out.tellp();
+            return out ? bytes : 0;
+        }
+
+        bool writeParallelHeader(const string& path, const string& name, unsigned int shards,
+                                 const vector<Gedim::UCDProperty<double>>& cellProperties)
+        {
+            ofstream out(path);
+            if (!out)
+            {
+                cerr << "Failed to open file for writing: " << path << endl;
+                return false;
+            }
+            out << "<?xml version=\"1.0\"?>\n"
+                << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\"" << byteOrder()
+                << "\" header_type=\"UInt64\">\n"
+                << "  <PUnstructuredGrid GhostLevel=\"0\">\n"
+                << "    <PPoints>\n"
+                << "      <PDataArray type=\"Float64\" Name=\"Points\" NumberOfComponents=\"3\"/>\n"
+                << "    </PPoints>\n"
+                << "    <PCellData>\n";
+            for (const Gedim::UCDProperty<double>& property : cellProperties)
+            {
+                out << "      <PDataArray type=\"Float64\" Name=\"" << property.Label
+                    << "\" NumberOfComponents=\"" << property.NumComponents << "\"/>\n";
+            }
+            out << "    </PCellData>\n";
+            for (unsigned int s = 0; s < shards; s++)
+            {
+                out << "    <Piece Source=\"" << name << "_" << s << ".vtu\"/>\n";
+            }
+            out << "  </PUnstructuredGrid>\n</VTKFile>\n";
+            return bool(out);
+        }
+
+        void accumulate(ShardStatistics& total, const ShardStatistics& part)
+        {
+            total.Shards += part.Shards;
+            total.Cells += part.Cells;
+            total.Points += part.Points;
+            total.Bytes += part.Bytes;
+            total.Seconds += part.Seconds;
+        }
+    }
+
+// ***************************************************************************
+
+    bool exportShardedCells(const MatrixXd& points,
+                            const vector<vector<unsigned int>>& cells,
+                            const vector<Gedim::UCDProperty<double>>& cellProperties,
+                            const ShardParameters& parameters,
+                            ShardStatistics& statistics)
+    {
+        auto start = chrono::steady_clock::now();
+        statistics = ShardStatistics();
+
+        for (const Gedim::UCDProperty<double>& property : cellProperties)
+        {
+            if (property.Size != cells.size() || (property.Data == nullptr && !cells.empty()))
+            {
+                cerr << "Property " << property.Label << " has " << property.Size << " values for "
+                     << cells.size() << " cells" << endl;
+                return false;
+            }
+        }
+
+        vector<uint64_t> keys(cells.size());
+        BoundingBox box;
+        vector<Vector3d> centroids(cells.size(), Vector3d::Zero());
+        for (size_t c = 0; c < cells.size(); c++)
+        {
+            for (unsigned int point : cells[c])
+            {
+                if (point >= points.cols())
+                {
+                    cerr << "Cell " << c << " refers to point " << point << " of " << points.cols() << endl;
+                    return false;
+                }
+                centroids[c] += points.col(point);
+            }
+            centroids[c] /= max<size_t>(1, cells[c].size());
+            box.expand(centroids[c]);
+        }
+        for (size_t c = 0; c < cells.size(); c++)
+        {
+            keys[c] = mortonKey(centroids[c], box);
+        }
+
+        vector<uint32_t> order(cells.size());
+        iota(order.begin(), order.end(), 0);
+        sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b)
+             {
+                 return keys[a] < keys[b] || (keys[a] == keys[b] && a < b);
+             });
+
+        error_code error;
+        filesystem::create_directories(parameters.Folder, error);
+
+        const unsigned int shards = min<size_t>(resolveThreads(parameters.NumberShards),
+                                                max<size_t>(1, cells.size()));
+        vector<uint64_t> bytes(shards, 0);
+        vector<size_t> numberPoints(shards, 0);
+        const string base = parameters.Folder + "/" + parameters.Name;
+        parallelFor(0, shards, shards, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t s = begin; s < end; s++)
+            {
+                size_t first = cells.size() * s / shards;
+                size_t last = cells.size() * (s + 1) / shards;
+                bytes[s] = writeShard(base + "_" + to_string(s) + ".vtu", points, cells, cellProperties,
+                                      order, first, last, parameters.Encoding, numberPoints[s]);
+            }
+        });
+
+        bool written = writeParallelHeader(base + ".pvtu", parameters.Name, shards, cellProperties);
+        statistics.Shards = shards;
+        statistics.Cells = cells.size();
+        for (unsigned int s = 0; s < shards; s++)
+        {
+            written = written && bytes[s] > 0;
+            statistics.Points += numberPoints[s];
+            statistics.Bytes += bytes[s];
+        }
+        statistics.Seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return written;
+    }
+
+// ***************************************************************************
+
+    bool writeParaviewCollection(const string& filename, const vector<string>& parts)
+    {
+        ofstream out(filename);
+        if (!out)
+        {
+            cerr << "Failed to open file for writing: " << filename << endl;
+            return false;
+        }
+        out << "<?xml version=\"1.0\"?>\n"
+            << "<VTKFile type=\"Collection\" version=\"1.0\" byte_order=\"" << byteOrder() << "\">\n"
+            << "  <Collection>\n";
+        for (size_t p = 0; p < parts.size(); p++)
+        {
+            out << "    <DataSet timestep=\"0\" group=\"\" part=\"" << p << "\" file=\"" << parts[p] << "\"/>\n";
+        }
+        out << "  </Collection>\n</VTKFile>\n";
+        return bool(out);
+    }
+
+// ***************************************************************************
+
+    bool exportNetworkParaview(const Fractures& fractures,
+                               const map<int, vector<int>>& intersections,
+                               const ShardParameters& parameters,
+                               ShardStatistics& statistics)
+    {
+        statistics = ShardStatistics();
+        const size_t numberFractures = fractures.FracturesId.size();
+        const size_t numberTraces = fractures.Traces.size();
+
+        // fractures, one polygon each
+        Index numberVertices = 0;
+        for (const Matrix3Xd& vertices : fractures.FracturesVertices)
+        {
+            numberVertices += vertices.cols();
+        }
+        MatrixXd points(3, numberVertices);
+        vector<vector<unsigned int>> polygons(numberFractures);
+        Index next = 0;
+        for (size_t i = 0; i < numberFractures; i++)
+        {
+            const Matrix3Xd& vertices = fractures.FracturesVertices[i];
+            points.middleCols(next, vertices.cols()) = vertices;
+            polygons[i].resize(vertices.cols());
+            iota(polygons[i].begin(), polygons[i].end(), (unsigned int)next);
+            next += vertices.cols();
+        }
+
+        unordered_map<int, size_t> indexOf;
+        for (size_t i = 0; i < numberFractures; i++)
+        {
+            indexOf[fractures.FracturesId[i]] = i;
+        }
+        vector<unsigned int> labels = labelClusters(fractures, intersections);
+        vector<double> fractureId(numberFractures), clusterId(numberFractures), tracesOf(numberFractures, 0.0);
+        for (size_t i = 0; i < numberFractures; i++)
+        {
+            fractureId[i] = fractures.FracturesId[i];
+            clusterId[i] = labels[i];
+        }
+
+        // traces, one segment each
+        MatrixXd endpoints(3, 2 * numberTraces);
+        vector<vector<unsigned int>> segments(numberTraces);
+        vector<double> traceId(numberTraces), fractureId1(numberTraces), fractureId2(numberTraces);
+        vector<double> tips(2 * numberTraces), length(numberTraces);
+        for (size_t t = 0; t < numberTraces; t++)
+        {
+            const Trace& trace = fractures.Traces[t];
+            endpoints.col(2 * t) << trace.p1.x, trace.p1.y, trace.p1.z;
+            endpoints.col(2 * t + 1) << trace.p2.x, trace.p2.y, trace.p2.z;
+            segments[t] = {(unsigned int)(2 * t), (unsigned int)(2 * t + 1)};
+            traceId[t] = trace.traceId;
+            fractureId1[t] = trace.fractureId1;
+            fractureId2[t] = trace.fractureId2;
+            tips[2 * t] = trace.Tips1;
+            tips[2 * t + 1] = trace.Tips2;
+            length[t] = trace.length;
+            for (int id : {trace.fractureId1, trace.fractureId2})
+            {
+                auto it = indexOf.find(id);
+                if (it != indexOf.end())
+                {
+                    tracesOf[it->second] += 1.0;
+                }
+            }
+        }
+
+        auto property = [](const string& label, const vector<double>& values, unsigned int components)
+        {
+            return Gedim::UCDProperty<double>{label, "-", (unsigned int)(values.size() / components), components,
+                                              values.data()};
+        };
+
+        ShardParameters part = parameters;
+        ShardStatistics partStatistics;
+        part.Name = parameters.Name + "_fractures";
+        bool written = exportShardedCells(points, polygons,
+                                          {property("FractureId", fractureId, 1),
+                                           property("ClusterId", clusterId, 1),
+                                           property("NumberTraces", tracesOf, 1)},
+                                          part, partStatistics);
+        accumulate(statistics, partStatistics);
+
+        part.Name = parameters.Name + "_traces";
+        written = exportShardedCells(endpoints, segments,
+                                     {property("TraceId", traceId, 1),
+                                      property("FractureId1", fractureId1, 1),
+                                      property("FractureId2", fractureId2, 1),
+                                      property("Tips", tips, 2),
+                                      property("Length", length, 1)},
+                                     part, partStatistics) && written;
+        accumulate(statistics, partStatistics);
+
+        return writeParaviewCollection(parameters.Folder + "/" + parameters.Name + ".pvd",
+                                       {parameters.Name + "_fractures.pvtu", parameters.Name + "_traces.pvtu"})
+               && written;
+    }
+
+}
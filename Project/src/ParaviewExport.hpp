@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+#include "UCDUtilities.hpp"
+
+namespace FractureLibrary
+{
+
+   enum class VtkEncoding
+   {
+       Ascii,
+       // appended raw binary, the fastest for ParaView to load
+       Raw
+   };
+
+   struct ShardParameters
+   {
+       string Folder;
+       string Name;
+       // one shard per thread; zero uses every hardware thread
+       unsigned int NumberShards;
+       VtkEncoding Encoding;
+
+       ShardParameters() : Folder("."), Name("network"), NumberShards(0), Encoding(VtkEncoding::Raw) {}
+   };
+
+   struct ShardStatistics
+   {
+       unsigned int Shards;
+       size_t Cells;
+       size_t Points;
+       unsigned long long Bytes;
+       double Seconds;
+
+       ShardStatistics() : Shards(0), Cells(0), Points(0), Bytes(0), Seconds(0.0) {}
+   };
+
+   // Writes cells (segments with two points, polygons otherwise) as
+   // Folder/Name_<k>.vtu shards plus Folder/Name.pvtu. Cells are ordered
+   // along a Morton curve of their centroids and cut into shards of equal
+   // size, so every shard covers a compact region; the shards are written
+   // from their own thread. Cell properties follow UCDUtilities: Size
+   // cells of NumComponents values each.
+   bool exportShardedCells(const MatrixXd& points,
+                           const vector<vector<unsigned int>>& cells,
+                           const vector<Gedim::UCDProperty<double>>& cellProperties,
+                           const ShardParameters& parameters,
+                           ShardStatistics& statistics);
+
+   // a .pvd collection of the given .pvtu files, one part each, relative to
+   // the folder of the collection
+   bool writeParaviewCollection(const string& filename, const vector<string>& parts);
+
+   // Name_fractures.pvtu with FractureId, ClusterId and NumberTraces,
+   // Name_traces.pvtu with TraceId, FractureId1, FractureId2, Tips and
+   // Length, and Name.pvd collecting them
+   bool exportNetworkParaview(const Fractures& fractures,
+                              const map<int, vector<int>>& intersections,
+                              const ShardParameters& parameters,
+                              ShardStatistics& statistics);
+
+}
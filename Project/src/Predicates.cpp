@@ -0,0 +1,665 @@
+#include "Predicates.hpp"
+#include "Allocations.hpp"
+#include "SpatialIndex.hpp"
+#include "TraceSink.hpp"
+#include <cmath>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        thread_local PredicateStatistics counters;
+
+        // Shewchuk's first error bounds, machine epsilon 2^-53
+        const double machineEpsilon = ldexp(1.0, -53);
+        const double orient2dBound = (3.0 + 16.0 * machineEpsilon) * machineEpsilon;
+        const double orient3dBound = (7.0 + 56.0 * machineEpsilon) * machineEpsilon;
+
+        // crossing points are compared through terms of degree two, three
+        // and five; the bounds are loose multiples of their rounding error
+        const double determinantBound = 4.0 * machineEpsilon;
+        const double crossingBound = 16.0 * machineEpsilon;
+        const double crossingsBound = 32.0 * machineEpsilon;
+
+        // nonoverlapping expansion, components in increasing magnitude
+        using Expansion = vector<double>;
+
+        void twoSum(double a, double b, double& x, double& y)
+        {
+            x = a + b;
+            double bVirtual = x - a;
+            double aVirtual = x - bVirtual;
+            y = (a - aVirtual) + (b - bVirtual);
+        }
+
+        void twoProduct(double a, double b, double& x, double& y)
+        {
+            x = a * b;
+            y = fma(a, b, -x);
+        }
+
+        void fastTwoSum(double a, double b, double& x, double& y)
+        {
+            x = a + b;
+            y = b - (x - a);
+        }
+
+        // e + b in place, without zero components
+        void grow(Expansion& e, double b)
+        {
+            size_t count = 0;
+            double q = b;
+            for (double component : e)
+            {
+                double sum;
+                double error;
+                twoSum(q, component, sum, error);
+                q = sum;
+                if (error != 0.0)
+                {
+                    e[count++] = error;
+                }
+            }
+            e.resize(count);
+            if (q != 0.0 || e.empty())
+            {
+                e.push_back(q);
+            }
+        }
+
+        Expansion add(Expansion e, const Expansion& f)
+        {
+            for (double component : f)
+            {
+                grow(e, component);
+            }
+            return e;
+        }
+
+        Expansion difference(double a, double b)
+        {
+            Expansion e = {a};
+            grow(e, -b);
+            return e;
+        }
+
+        // Shewchuk's scale-expansion with zero elimination
+        Expansion scale(const Expansion& e, double b)
+        {
+            Expansion h;
+            h.reserve(2 * e.size());
+            double q;
+            double error;
+            twoProduct(e[0], b, q, error);
+            if (error != 0.0)
+            {
+                h.push_back(error);
+            }
+            for (size_t i = 1; i < e.size(); i++)
+            {
+                double high;
+                double low;
+                double sum;
+                twoProduct(e[i], b, high, low);
+                twoSum(q, low, sum, error);
+                if (error != 0.0)
+                {
+                    h.push_back(error);
+                }
+                fastTwoSum(high, sum, q, error);
+                if (error != 0.0)
+                {
+                    h.push_back(error);
+                }
+            }
+            if (q != 0.0 || h.empty())
+            {
+                h.push_back(q);
+            }
+            return h;
+        }
+
+        Expansion multiply(const Expansion& e, const Expansion& f)
+        {
+            const Expansion& longer = e.size() >= f.size() ? e : f;
+            const Expansion& shorter = e.size() >= f.size() ? f : e;
+            Expansion product = scale(longer, shorter[0]);
+            for (size_t i = 1; i < shorter.size(); i++)
+            {
+                product = add(move(product), scale(longer, shorter[i]));
+            }
+            return product;
+        }
+
+        Expansion negate(Expansion e)
+        {
+            for (double& component : e)
+            {
+                component = -component;
+            }
+            return e;
+        }
+
+        int sign(const Expansion& e)
+        {
+            double top = e.back();
+            return (top > 0.0) - (top < 0.0);
+        }
+
+        int sign(double value)
+        {
+            return (value > 0.0) - (value < 0.0);
+        }
+
+        int orient2dExact(double ax, double ay, double bx, double by, double cx, double cy)
+        {
+            Expansion left = multiply(difference(ax, cx), difference(by, cy));
+            Expansion right = multiply(difference(ay, cy), difference(bx, cx));
+            return sign(add(left, negate(right)));
+        }
+
+        int orient3dExact(const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d)
+        {
+            Expansion adx = difference(a.x(), d.x());
+            Expansion ady = difference(a.y(), d.y());
+            Expansion adz = difference(a.z(), d.z());
+            Expansion bdx = difference(b.x(), d.x());
+            Expansion bdy = difference(b.y(), d.y());
+            Expansion bdz = difference(b.z(), d.z());
+            Expansion cdx = difference(c.x(), d.x());
+            Expansion cdy = difference(c.y(), d.y());
+            Expansion cdz = difference(c.z(), d.z());
+
+            Expansion bc = add(multiply(bdx, cdy), negate(multiply(cdx, bdy)));
+            Expansion ca = add(multiply(cdx, ady), negate(multiply(adx, cdy)));
+            Expansion ab = add(multiply(adx, bdy), negate(multiply(bdx, ady)));
+
+            Expansion determinant = add(add(multiply(adz, bc), multiply(bdz, ca)), multiply(cdz, ab));
+            return sign(determinant);
+        }
+
+        // the lines a0 a1 and b0 b1 meet at a0 + Along / Determinant (a1 - a0);
+        // the permanents bound the rounding error of the two values
+        struct LineCrossing
+        {
+            Vector2d Origin;
+            Vector2d Direction;
+            double Determinant;
+            double DeterminantPermanent;
+            double Along;
+            double AlongPermanent;
+        };
+
+        LineCrossing lineCrossing(const Vector2d& a0, const Vector2d& a1, const Vector2d& b0, const Vector2d& b1)
+        {
+            LineCrossing crossing;
+            crossing.Origin = a0;
+            crossing.Direction = a1 - a0;
+            Vector2d other = b1 - b0;
+            Vector2d offset = a0 - b0;
+            double left = crossing.Direction.x() * other.y();
+            double right = crossing.Direction.y() * other.x();
+            crossing.Determinant = left - right;
+            crossing.DeterminantPermanent = fabs(left) + fabs(right);
+            left = other.x() * offset.y();
+            right = other.y() * offset.x();
+            crossing.Along = left - right;
+            crossing.AlongPermanent = fabs(left) + fabs(right);
+            return crossing;
+        }
+
+        bool certain(const LineCrossing& crossing)
+        {
+            return fabs(crossing.Determinant) > determinantBound * crossing.DeterminantPermanent;
+        }
+
+        struct ExactLineCrossing
+        {
+            Vector2d Origin;
+            Expansion Direction[2];
+            Expansion Determinant;
+            Expansion Along;
+        };
+
+        ExactLineCrossing exactLineCrossing(const Vector2d& a0, const Vector2d& a1,
+                                            const Vector2d& b0, const Vector2d& b1)
+        {
+            ExactLineCrossing crossing;
+            crossing.Origin = a0;
+            crossing.Direction[0] = difference(a1.x(), a0.x());
+            crossing.Direction[1] = difference(a1.y(), a0.y());
+            Expansion otherX = difference(b1.x(), b0.x());
+            Expansion otherY = difference(b1.y(), b0.y());
+            crossing.Determinant = add(multiply(crossing.Direction[0], otherY),
+                                       negate(multiply(crossing.Direction[1], otherX)));
+            crossing.Along = add(multiply(otherX, difference(a0.y(), b0.y())),
+                                 negate(multiply(otherY, difference(a0.x(), b0.x()))));
+            return crossing;
+        }
+
+        // coplanar triangles: exact separating edge test in the projection
+        // that drops the dominant axis of the normal
+        bool coplanarTrianglesIntersect(const Vector3d* t1, const Vector3d* t2)
+        {
+            Vector3d normal = (t1[1] - t1[0]).cross(t1[2] - t1[0]).cwiseAbs();
+            int drop = 0;
+            normal.maxCoeff(&drop);
+            int u = (drop + 1) % 3;
+            int v = (drop + 2) % 3;
+
+            auto separates = [u, v](const Vector3d* a, const Vector3d* b)
+            {
+                int orientation = orient2d(a[0](u), a[0](v), a[1](u), a[1](v), a[2](u), a[2](v));
+                if (orientation == 0)
+                {
+                    return false;
+                }
+                for (int e = 0; e < 3; e++)
+                {
+                    const Vector3d& from = a[e];
+                    const Vector3d& to = a[(e + 1) % 3];
+                    bool outside = true;
+                    for (int k = 0; k < 3 && outside; k++)
+                    {
+                        int side = orient2d(from(u), from(v), to(u), to(v), b[k](u), b[k](v));
+                        outside = side * orientation < 0;
+                    }
+                    if (outside)
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            return !separates(t1, t2) && !separates(t2, t1);
+        }
+
+        bool checkMinMax(const Vector3d& p1, const Vector3d& q1, const Vector3d& r1,
+                         const Vector3d& p2, const Vector3d& q2, const Vector3d& r2)
+        {
+            if (orient3d(q2, p2, p1, q1) > 0)
+            {
+                return false;
+            }
+            if (orient3d(r2, p2, r1, p1) > 0)
+            {
+                return false;
+            }
+            return true;
+        }
+
+        bool triangleAgainstPlane(const Vector3d& p1, const Vector3d& q1, const Vector3d& r1,
+                                  const Vector3d& p2, const Vector3d& q2, const Vector3d& r2,
+                                  int dp2, int dq2, int dr2, bool& coplanar)
+        {
+            if (dp2 > 0)
+            {
+                if (dq2 > 0)
+                {
+                    return checkMinMax(p1, r1, q1, r2, p2, q2);
+                }
+                if (dr2 > 0)
+                {
+                    return checkMinMax(p1, r1, q1, q2, r2, p2);
+                }
+                return checkMinMax(p1, q1, r1, p2, q2, r2);
+            }
+            if (dp2 < 0)
+            {
+                if (dq2 < 0)
+                {
+                    return checkMinMax(p1, q1, r1, r2, p2, q2);
+                }
+                if (dr2 < 0)
+                {
+                    return checkMinMax(p1, q1, r1, q2, r2, p2);
+                }
+                return checkMinMax(p1, r1, q1, p2, q2, r2);
+            }
+            if (dq2 < 0)
+            {
+                if (dr2 >= 0)
+                {
+                    return checkMinMax(p1, r1, q1, q2, r2, p2);
+                }
+                return checkMinMax(p1, q1, r1, p2, q2, r2);
+            }
+            if (dq2 > 0)
+            {
+                if (dr2 > 0)
+                {
+                    return checkMinMax(p1, r1, q1, p2, q2, r2);
+                }
+                return checkMinMax(p1, q1, r1, q2, r2, p2);
+            }
+            if (dr2 > 0)
+            {
+                return checkMinMax(p1, q1, r1, r2, p2, q2);
+            }
+            if (dr2 < 0)
+            {
+                return checkMinMax(p1, r1, q1, r2, p2, q2);
+            }
+            coplanar = true;
+            return false;
+        }
+    }
+
+// ***************************************************************************
+
+    double PredicateStatistics::fallbackRate() const
+    {
+        unsigned long long calls = Orient2dCalls + Orient3dCalls;
+        return calls > 0 ? double(Orient2dFallbacks + Orient3dFallbacks) / calls : 0.0;
+    }
+
+// ***************************************************************************
+
+    PredicateStatistics predicateStatistics()
+    {
+        return counters;
+    }
+
+// ***************************************************************************
+
+    void resetPredicateStatistics()
+    {
+        counters = PredicateStatistics();
+    }
+
+// ***************************************************************************
+
+    int orient2d(double ax, double ay, double bx, double by, double cx, double cy)
+    {
+        counters.Orient2dCalls++;
+
+        double left = (ax - cx) * (by - cy);
+        double right = (ay - cy) * (bx - cx);
+        double determinant = left - right;
+
+        // opposite signs (or a zero term) cannot cancel
+        if ((left > 0.0 && right <= 0.0) || (left < 0.0 && right >= 0.0) || left == 0.0)
+        {
+            return sign(determinant);
+        }
+
+        double bound = orient2dBound * (fabs(left) + fabs(right));
+        if (determinant >= bound || -determinant >= bound)
+        {
+            return sign(determinant);
+        }
+
+        counters.Orient2dFallbacks++;
+        return orient2dExact(ax, ay, bx, by, cx, cy);
+    }
+
+// ***************************************************************************
+
+    int compareCrossing(const Vector2d& a0, const Vector2d& a1, const Vector2d& b0, const Vector2d& b1,
+                        const Vector2d& c)
+    {
+        // sign of (a0 - c) Determinant + Along (a1 - a0), times that of Determinant
+        LineCrossing crossing = lineCrossing(a0, a1, b0, b1);
+        if (certain(crossing))
+        {
+            int k = 0;
+            for (; k < 2; k++)
+            {
+                double offset = crossing.Origin(k) - c(k);
+                double value = offset * crossing.Determinant + crossing.Along * crossing.Direction(k);
+                double permanent = fabs(offset) * crossing.DeterminantPermanent
+                                   + crossing.AlongPermanent * fabs(crossing.Direction(k));
+                if (fabs(value) > crossingBound * permanent)
+                {
+                    return sign(value) * sign(crossing.Determinant);
+                }
+                if (permanent != 0.0)
+                {
+                    break;
+                }
+            }
+            if (k == 2)
+            {
+                return 0;
+            }
+        }
+
+        ExactLineCrossing exact = exactLineCrossing(a0, a1, b0, b1);
+        for (int k = 0; k < 2; k++)
+        {
+            Expansion value = add(multiply(difference(exact.Origin(k), c(k)), exact.Determinant),
+                                  multiply(exact.Along, exact.Direction[k]));
+            if (sign(value) != 0)
+            {
+                return sign(value) * sign(exact.Determinant);
+            }
+        }
+        return 0;
+    }
+
+// ***************************************************************************
+
+    int compareCrossings(const Vector2d& a0, const Vector2d& a1, const Vector2d& b0, const Vector2d& b1,
+                         const Vector2d& c0, const Vector2d& c1, const Vector2d& d0, const Vector2d& d1)
+    {
+        // with D, D' the determinants: sign of (a0 - c0) D D' + Along (a1 - a0) D'
+        // - Along' (c1 - c0) D, times those of D and D'
+        LineCrossing first = lineCrossing(a0, a1, b0, b1);
+        LineCrossing second = lineCrossing(c0, c1, d0, d1);
+        if (certain(first) && certain(second))
+        {
+            int k = 0;
+            for (; k < 2; k++)
+            {
+                double offset = first.Origin(k) - second.Origin(k);
+                double value = offset * first.Determinant * second.Determinant
+                               + first.Along * first.Direction(k) * second.Determinant
+                               - second.Along * second.Direction(k) * first.Determinant;
+                double permanent = fabs(offset) * first.DeterminantPermanent * second.DeterminantPermanent
+                                   + first.AlongPermanent * fabs(first.Direction(k)) * second.DeterminantPermanent
+                                   + second.AlongPermanent * fabs(second.Direction(k)) * first.DeterminantPermanent;
+                if (fabs(value) > crossingsBound * permanent)
+                {
+                    return sign(value) * sign(first.Determinant) * sign(second.Determinant);
+                }
+                if (permanent != 0.0)
+                {
+                    break;
+                }
+            }
+            if (k == 2)
+            {
+                return 0;
+            }
+        }
+
+        ExactLineCrossing exactFirst = exactLineCrossing(a0, a1, b0, b1);
+        ExactLineCrossing exactSecond = exactLineCrossing(c0, c1, d0, d1);
+        Expansion determinants = multiply(exactFirst.Determinant, exactSecond.Determinant);
+        for (int k = 0; k < 2; k++)
+        {
+            Expansion value = multiply(difference(exactFirst.Origin(k), exactSecond.Origin(k)), determinants);
+            value = add(value, multiply(multiply(exactFirst.Along, exactFirst.Direction[k]), exactSecond.Determinant));
+            value = add(value, negate(multiply(multiply(exactSecond.Along, exactSecond.Direction[k]),
+                                               exactFirst.Determinant)));
+            if (sign(value) != 0)
+            {
+                return sign(value) * sign(determinants);
+            }
+        }
+        return 0;
+    }
+
+// ***************************************************************************
+
+    int orient3d(const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d)
+    {
+        counters.Orient3dCalls++;
+
+        Vector3d ad = a - d;
+        Vector3d bd = b - d;
+        Vector3d cd = c - d;
+
+        double bdxcdy = bd.x() * cd.y();
+        double cdxbdy = cd.x() * bd.y();
+        double cdxady = cd.x() * ad.y();
+        double adxcdy = ad.x() * cd.y();
+        double adxbdy = ad.x() * bd.y();
+        double bdxady = bd.x() * ad.y();
+
+        double determinant = ad.z() * (bdxcdy - cdxbdy)
+                             + bd.z() * (cdxady - adxcdy)
+                             + cd.z() * (adxbdy - bdxady);
+        double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * fabs(ad.z())
+                           + (fabs(cdxady) + fabs(adxcdy)) * fabs(bd.z())
+                           + (fabs(adxbdy) + fabs(bdxady)) * fabs(cd.z());
+
+        double bound = orient3dBound * permanent;
+        if (determinant > bound || -determinant > bound)
+        {
+            return sign(determinant);
+        }
+
+        counters.Orient3dFallbacks++;
+        return orient3dExact(a, b, c, d);
+    }
+
+// ***************************************************************************
+
+    bool trianglesIntersectExact(const Vector3d& p1, const Vector3d& q1, const Vector3d& r1,
+                                 const Vector3d& p2, const Vector3d& q2, const Vector3d& r2)
+    {
+        // Guigue-Devillers test, every decision is an exact orientation sign
+        int dp1 = orient3d(p1, p2, q2, r2);
+        int dq1 = orient3d(q1, p2, q2, r2);
+        int dr1 = orient3d(r1, p2, q2, r2);
+        if (dp1 * dq1 > 0 && dp1 * dr1 > 0)
+        {
+            return false;
+        }
+
+        int dp2 = orient3d(p2, q1, r1, p1);
+        int dq2 = orient3d(q2, q1, r1, p1);
+        int dr2 = orient3d(r2, q1, r1, p1);
+        if (dp2 * dq2 > 0 && dp2 * dr2 > 0)
+        {
+            return false;
+        }
+
+        bool coplanar = false;
+        bool result;
+        if (dp1 > 0)
+        {
+            if (dq1 > 0)
+            {
+                result = triangleAgainstPlane(r1, p1, q1, p2, r2, q2, dp2, dr2, dq2, coplanar);
+            }
+            else if (dr1 > 0)
+            {
+                result = triangleAgainstPlane(q1, r1, p1, p2, r2, q2, dp2, dr2, dq2, coplanar);
+            }
+            else
+            {
+                result = triangleAgainstPlane(p1, q1, r1, p2, q2, r2, dp2, dq2, dr2, coplanar);
+            }
+        }
+        else if (dp1 < 0)
+        {
+            if (dq1 < 0)
+            {
+                result = triangleAgainstPlane(r1, p1, q1, p2, q2, r2, dp2, dq2, dr2, coplanar);
+            }
+            else if (dr1 < 0)
+            {
+                result = triangleAgainstPlane(q1, r1, p1, p2, q2, r2, dp2, dq2, dr2, coplanar);
+            }
+            else
+            {
+                result = triangleAgainstPlane(p1, q1, r1, p2, r2, q2, dp2, dr2, dq2, coplanar);
+            }
+        }
+        else if (dq1 < 0)
+        {
+            if (dr1 >= 0)
+            {
+                result = triangleAgainstPlane(q1, r1, p1, p2, r2, q2, dp2, dr2, dq2, coplanar);
+            }
+            else
+            {
+                result = triangleAgainstPlane(p1, q1, r1, p2, q2, r2, dp2, dq2, dr2, coplanar);
+            }
+        }
+        else if (dq1 > 0)
+        {
+            if (dr1 > 0)
+            {
+                result = triangleAgainstPlane(p1, q1, r1, p2, r2, q2, dp2, dr2, dq2, coplanar);
+            }
+            else
+            {
+                result = triangleAgainstPlane(q1, r1, p1, p2, q2, r2, dp2, dq2, dr2, coplanar);
+            }
+        }
+        else if (dr1 > 0)
+        {
+            result = triangleAgainstPlane(r1, p1, q1, p2, q2, r2, dp2, dq2, dr2, coplanar);
+        }
+        else if (dr1 < 0)
+        {
+            result = triangleAgainstPlane(r1, p1, q1, p2, r2, q2, dp2, dr2, dq2, coplanar);
+        }
+        else
+        {
+            coplanar = true;
+            result = false;
+        }
+
+        if (coplanar)
+        {
+            const Vector3d first[3] = {p1, q1, r1};
+            const Vector3d second[3] = {p2, q2, r2};
+            return coplanarTrianglesIntersect(first, second);
+        }
+        return result;
+    }
+
+// ***************************************************************************
+
+    bool fracturesIntersectExact(const Matrix3Xd& P, const Matrix3Xd& Q)
+    {
+        // coordinate comparisons are exact, so disjoint boxes are a safe early exit
+        if (!computeBoundingBox(P).overlaps(computeBoundingBox(Q)))
+        {
+            return false;
+        }
+
+        // both polygons as triangle fans around their first vertex
+        for (Index i = 1; i + 1 < P.cols(); i++)
+        {
+            for (Index j = 1; j + 1 < Q.cols(); j++)
+            {
+                if (trianglesIntersectExact(P.col(0), P.col(i), P.col(i + 1),
+                                            Q.col(0), Q.col(j), Q.col(j + 1)))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+// ***************************************************************************
+
+    void checkIntersectionsExact(Fractures& fractures, map<int, vector<int>>& intersections)
+    {
+        AllocationPhase phase("intersect");
+        CollectingSink sink(fractures, intersections);
+        PairKernel kernel;
+        kernel.Intersect = fracturesIntersectExact;
+        PairKernelState state;
+        runPairKernel(fractures, sink, kernel, state);
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   // counters of the calling thread
+   struct PredicateStatistics
+   {
+       unsigned long long Orient2dCalls;
+       unsigned long long Orient2dFallbacks;
+       unsigned long long Orient3dCalls;
+       unsigned long long Orient3dFallbacks;
+
+       PredicateStatistics()
+           : Orient2dCalls(0), Orient2dFallbacks(0), Orient3dCalls(0), Orient3dFallbacks(0) {}
+
+       double fallbackRate() const;
+   };
+
+   PredicateStatistics predicateStatistics();
+
+   void resetPredicateStatistics();
+
+   // sign of the determinant: +1 if a, b, c are counterclockwise
+   int orient2d(double ax, double ay, double bx, double by, double cx, double cy);
+
+   // Lexicographic order, exact, of the point where the lines a0 a1 and
+   // b0 b1 meet against the point c: -1, 0 or +1. The lines must not be
+   // parallel.
+   int compareCrossing(const Vector2d& a0, const Vector2d& a1, const Vector2d& b0, const Vector2d& b1,
+                       const Vector2d& c);
+
+   // the same between the meeting points of a0 a1, b0 b1 and of c0 c1, d0 d1
+   int compareCrossings(const Vector2d& a0, const Vector2d& a1, const Vector2d& b0, const Vector2d& b1,
+                        const Vector2d& c0, const Vector2d& c1, const Vector2d& d0, const Vector2d& d1);
+
+   // sign of (a - d) . ((b - d) x (c - d))
+   int orient3d(const Vector3d& a, const Vector3d& b, const Vector3d& c, const Vector3d& d);
+
+   bool trianglesIntersectExact(const Vector3d& p1, const Vector3d& q1, const Vector3d& r1,
+                                const Vector3d& p2, const Vector3d& q2, const Vector3d& r2);
+
+   bool fracturesIntersectExact(const Matrix3Xd& P, const Matrix3Xd& Q);
+
+   // checkIntersections with fracturesIntersectExact as the narrow phase
+   void checkIntersectionsExact(Fractures& fractures, map<int, vector<int>>& intersections);
+
+}
@@ -0,0 +1,307 @@
+#include "Prefilter.hpp"
+#include "SpatialIndex.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        const double latticeSteps = 65534.0;
+
+        float roundDown(double value)
+        {
+            float rounded = float(value);
+            return double(rounded) > value ? nextafterf(rounded, -INFINITY) : rounded;
+        }
+
+        float roundUp(double value)
+        {
+            float rounded = float(value);
+            return double(rounded) < value ? nextafterf(rounded, INFINITY) : rounded;
+        }
+
+        uint16_t quantize(double value)
+        {
+            return uint16_t(min(max(value, 0.0), 65535.0));
+        }
+
+        Vector3d polygonNormal(const Matrix3Xd& vertices)
+        {
+            Vector3d normal = Vector3d::Zero();
+            for (Index v = 1; v + 1 < vertices.cols(); v++)
+            {
+                normal += (vertices.col(v) - vertices.col(0)).cross(vertices.col(v + 1) - vertices.col(0));
+            }
+            double norm = normal.norm();
+            return norm > 0.0 ? Vector3d(normal / norm) : normal;
+        }
+    }
+
+// ***************************************************************************
+
+    double PrefilterStatistics::rejectionRate() const
+    {
+        return TestedPairs > 0 ? double(RejectedByBox + RejectedByPlane) / TestedPairs : 0.0;
+    }
+
+// ***************************************************************************
+
+    ConservativePrefilter::ConservativePrefilter(const Fractures& fractures,
+                                                 const PrefilterParameters& parameters)
+        : Parameters(parameters), Size(fractures.FracturesVertices.size())
+    {
+        vector<BoundingBox> boxes = computeBoundingBoxes(fractures);
+        BoundingBox domain;
+        for (BoundingBox& box : boxes)
+        {
+            box.inflate(epsilon);
+            domain.expand(box);
+        }
+
+        // frame of the packed data: world coordinates or the 16 bit lattice
+        Vector3d origin = Vector3d::Zero();
+        Vector3d scale = Vector3d::Ones();
+        bool quantized = Parameters.Precision == PrefilterPrecision::Quantized16;
+        if (quantized && Size > 0)
+        {
+            origin = domain.Min;
+            for (int a = 0; a < 3; a++)
+            {
+                double extent = domain.Max(a) - domain.Min(a);
+                scale(a) = extent > 0.0 ? extent / latticeSteps : 1.0;
+            }
+        }
+
+        for (int a = 0; a < 3; a++)
+        {
+            Normal[a].resize(Size);
+            if (quantized)
+            {
+                MinQuantized[a].resize(Size);
+                MaxQuantized[a].resize(Size);
+            }
+            else
+            {
+                MinFloat[a].resize(Size);
+                MaxFloat[a].resize(Size);
+            }
+        }
+        SlabMin.resize(Size);
+        SlabMax.resize(Size);
+
+        for (size_t k = 0; k < Size; k++)
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                if (quantized)
+                {
+                    MinQuantized[a][k] = quantize(floor((boxes[k].Min(a) - origin(a)) / scale(a)) - 1.0);
+                    MaxQuantized[a][k] = quantize(ceil((boxes[k].Max(a) - origin(a)) / scale(a)) + 1.0);
+                }
+                else
+                {
+                    MinFloat[a][k] = roundDown(boxes[k].Min(a));
+                    MaxFloat[a][k] = roundUp(boxes[k].Max(a));
+                }
+            }
+
+            // the stored float normal is the test direction, so the slab is
+            // measured along exactly that direction and then widened
+            const Matrix3Xd& vertices = fractures.FracturesVertices[k];
+            Vector3d normal = polygonNormal(vertices);
+            if (normal.isZero())
+            {
+                for (int a = 0; a < 3; a++)
+                {
+                    Normal[a][k] = 0.0f;
+                }
+                SlabMin[k] = -INFINITY;
+                SlabMax[k] = INFINITY;
+                continue;
+            }
+
+            Vector3d direction;
+            for (int a = 0; a < 3; a++)
+            {
+                Normal[a][k] = float(normal(a) * scale(a));
+                direction(a) = Normal[a][k];
+            }
+
+            double lower = numeric_limits<double>::max();
+            double upper = -numeric_limits<double>::max();
+            double magnitude = 0.0;
+            for (Index v = 0; v < vertices.cols(); v++)
+            {
+                Vector3d position = (vertices.col(v) - origin).cwiseQuotient(scale);
+                double distance = direction.dot(position);
+                lower = min(lower, distance);
+                upper = max(upper, distance);
+                magnitude = max(magnitude, direction.cwiseAbs().dot(position.cwiseAbs()));
+            }
+            double margin = 1e-12 * magnitude + DBL_MIN;
+            SlabMin[k] = roundDown(lower - margin);
+            SlabMax[k] = roundUp(upper + margin);
+        }
+    }
+
+// ***************************************************************************
+
+    void ConservativePrefilter::box(size_t j, float* lower, float* upper) const
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            if (Parameters.Precision == PrefilterPrecision::Quantized16)
+            {
+                lower[a] = MinQuantized[a][j];
+                upper[a] = MaxQuantized[a][j];
+            }
+            else
+            {
+                lower[a] = MinFloat[a][j];
+                upper[a] = MaxFloat[a][j];
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    bool ConservativePrefilter::boxesOverlap(size_t i, size_t j) const
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            bool overlap = Parameters.Precision == PrefilterPrecision::Quantized16
+                           ? MinQuantized[a][i] <= MaxQuantized[a][j] && MinQuantized[a][j] <= MaxQuantized[a][i]
+                           : MinFloat[a][i] <= MaxFloat[a][j] && MinFloat[a][j] <= MaxFloat[a][i];
+            if (!overlap)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool ConservativePrefilter::boxOutsideSlab(size_t plane, size_t j) const
+    {
+        float lower[3];
+        float upper[3];
+        box(j, lower, upper);
+
+        // float rounding of the three term dot products stays below 1.5 FLT_EPSILON * magnitude
+        float low = 0.0f;
+        float high = 0.0f;
+        float magnitude = 0.0f;
+        for (int a = 0; a < 3; a++)
+        {
+            float n = Normal[a][plane];
+            low += n * (n >= 0.0f ? lower[a] : upper[a]);
+            high += n * (n >= 0.0f ? upper[a] : lower[a]);
+            magnitude += fabsf(n) * max(fabsf(lower[a]), fabsf(upper[a]));
+        }
+        float margin = 4.0f * FLT_EPSILON * magnitude;
+
+        return low - margin > SlabMax[plane] || high + margin < SlabMin[plane];
+    }
+
+// ***************************************************************************
+
+    bool ConservativePrefilter::mayIntersect(size_t i, size_t j)
+    {
+        Statistics.TestedPairs++;
+        if (!boxesOverlap(i, j))
+        {
+            Statistics.RejectedByBox++;
+            return false;
+        }
+        if (Parameters.UsePlanes && (boxOutsideSlab(i, j) || boxOutsideSlab(j, i)))
+        {
+            Statistics.RejectedByPlane++;
+            return false;
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    void ConservativePrefilter::candidates(size_t i, vector<char>& survivors)
+    {
+        survivors.assign(Size, 0);
+        if (i + 1 >= Size)
+        {
+            return;
+        }
+
+        // branch free box stage over the packed arrays
+        if (Parameters.Precision == PrefilterPrecision::Quantized16)
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                const uint16_t lower = MinQuantized[a][i];
+                const uint16_t upper = MaxQuantized[a][i];
+                const uint16_t* minimum = MinQuantized[a].data();
+                const uint16_t* maximum = MaxQuantized[a].data();
+                for (size_t j = i + 1; j < Size; j++)
+                {
+                    survivors[j] = (a == 0 || survivors[j]) & (lower <= maximum[j]) & (minimum[j] <= upper);
+                }
+            }
+        }
+        else
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                const float lower = MinFloat[a][i];
+                const float upper = MaxFloat[a][i];
+                const float* minimum = MinFloat[a].data();
+                const float* maximum = MaxFloat[a].data();
+                for (size_t j = i + 1; j < Size; j++)
+                {
+                    survivors[j] = (a == 0 || survivors[j]) & (lower <= maximum[j]) & (minimum[j] <= upper);
+                }
+            }
+        }
+
+        Statistics.TestedPairs += Size - i - 1;
+        for (size_t j = i + 1; j < Size; j++)
+        {
+            if (!survivors[j])
+            {
+                Statistics.RejectedByBox++;
+            }
+            else if (Parameters.UsePlanes && (boxOutsideSlab(i, j) || boxOutsideSlab(j, i)))
+            {
+                survivors[j] = 0;
+                Statistics.RejectedByPlane++;
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void checkIntersectionsPrefiltered(Fractures& fractures, map<int, vector<int>>& intersections,
+                                       const PrefilterParameters& parameters,
+                                       PrefilterStatistics& statistics)
+    {
+        ConservativePrefilter prefilter(fractures, parameters);
+        vector<char> survivors;
+        size_t row = prefilter.size();
+
+        checkIntersections(fractures, intersections, [&](size_t i, size_t j)
+        {
+            if (i != row)
+            {
+                prefilter.candidates(i, survivors);
+                row = i;
+            }
+            return survivors[j] != 0;
+        });
+
+        statistics = prefilter.statistics();
+    }
+
+}
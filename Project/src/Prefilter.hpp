@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <map>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   enum class PrefilterPrecision
+   {
+       Float,
+       Quantized16
+   };
+
+   struct PrefilterParameters
+   {
+       PrefilterPrecision Precision;
+       bool UsePlanes;
+
+       PrefilterParameters() : Precision(PrefilterPrecision::Float), UsePlanes(true) {}
+   };
+
+   struct PrefilterStatistics
+   {
+       unsigned long long TestedPairs;
+       unsigned long long RejectedByBox;
+       unsigned long long RejectedByPlane;
+
+       PrefilterStatistics() : TestedPairs(0), RejectedByBox(0), RejectedByPlane(0) {}
+
+       double rejectionRate() const;
+   };
+
+   // Coarse reject test on reduced precision copies of the fracture bounds.
+   // Every bound is rounded outward, so a rejected pair never intersects.
+   class ConservativePrefilter
+   {
+       public:
+           ConservativePrefilter(const Fractures& fractures,
+                                 const PrefilterParameters& parameters = PrefilterParameters());
+
+           size_t size() const { return Size; }
+
+           bool mayIntersect(size_t i, size_t j);
+
+           // survivors[j] for every j > i, one pass over the packed arrays
+           void candidates(size_t i, vector<char>& survivors);
+
+           const PrefilterStatistics& statistics() const { return Statistics; }
+
+       private:
+           PrefilterParameters Parameters;
+           PrefilterStatistics Statistics;
+           size_t Size;
+
+           // Float: world coordinates; Quantized16: lattice of the domain box
+           vector<float> MinFloat[3];
+           vector<float> MaxFloat[3];
+           vector<uint16_t> MinQuantized[3];
+           vector<uint16_t> MaxQuantized[3];
+
+           // plane normal in the same frame as the boxes, and the slab of the fracture
+           vector<float> Normal[3];
+           vector<float> SlabMin;
+           vector<float> SlabMax;
+
+           void box(size_t j, float* lower, float* upper) const;
+
+           bool boxesOverlap(size_t i, size_t j) const;
+
+           bool boxOutsideSlab(size_t plane, size_t j) const;
+   };
+
+   void checkIntersectionsPrefiltered(Fractures& fractures, map<int, vector<int>>& intersections,
+                                      const PrefilterParameters& parameters,
+                                      PrefilterStatistics& statistics);
+
+}
@@ -0,0 +1,410 @@
+#include "RayQueries.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        // slab test; returns the entry distance through near
+        bool rayHitsBox(const BoundingBox& box, const Vector3d& origin, const Vector3d& inverse,
+                        double maxDistance, double& near)
+        {
+            double entry = 0.0;
+            double exit = maxDistance;
+            for (int a = 0; a < 3; a++)
+            {
+                double t1 = (box.Min(a) - origin(a)) * inverse(a);
+                double t2 = (box.Max(a) - origin(a)) * inverse(a);
+                if (t1 > t2)
+                {
+                    swap(t1, t2);
+                }
+                // NaN from 0 * inf (origin on a slab face, parallel ray) keeps the bounds
+                entry = t1 > entry ? t1 : entry;
+                exit = t2 < exit ? t2 : exit;
+                if (entry > exit)
+                {
+                    return false;
+                }
+            }
+            near = entry;
+            return true;
+        }
+
+        // Moller-Trumbore, both faces
+        bool rayHitsTriangle(const Vector3d& origin, const Vector3d& direction,
+                             const Vector3d& a, const Vector3d& b, const Vector3d& c, double& t)
+        {
+            Vector3d edge1 = b - a;
+            Vector3d edge2 = c - a;
+            Vector3d p = direction.cross(edge2);
+            double determinant = edge1.dot(p);
+            if (determinant == 0.0)
+            {
+                return false;
+            }
+            double inverse = 1.0 / determinant;
+            Vector3d s = origin - a;
+            double u = s.dot(p) * inverse;
+            if (u < 0.0 || u > 1.0)
+            {
+                return false;
+            }
+            Vector3d q = s.cross(edge1);
+            double v = direction.dot(q) * inverse;
+            if (v < 0.0 || u + v > 1.0)
+            {
+                return false;
+            }
+            t = edge2.dot(q) * inverse;
+            return t >= 0.0;
+        }
+    }
+
+// ***************************************************************************
+
+    FractureBVH::FractureBVH(const Fractures& fractures, unsigned int leafSize)
+        : Vertices(fractures.FracturesVertices), Ids(fractures.FracturesId)
+    {
+        const size_t n = Vertices.size();
+        leafSize = max(leafSize, 1u);
+        vector<BoundingBox> boxes = computeBoundingBoxes(fractures);
+        vector<Vector3d> centers(n);
+        for (size_t k = 0; k < n; k++)
+        {
+            centers[k] = 0.5 * (boxes[k].Min + boxes[k].Max);
+        }
+
+        Order.resize(n);
+        for (unsigned int k = 0; k < n; k++)
+        {
+            Order[k] = k;
+        }
+        if (n == 0)
+        {
+            return;
+        }
+
+        // depth first layout: the left child always follows its parent
+        struct Task
+        {
+            unsigned int Node;
+            unsigned int First;
+            unsigned int Count;
+        };
+        Nodes.reserve(2 * n / leafSize + 1);
+        Nodes.push_back(Node());
+        vector<Task> stack = {{0, 0, unsigned(n)}};
+        while (!stack.empty())
+        {
+            Task task = stack.back();
+            stack.pop_back();
+
+            BoundingBox box;
+            BoundingBox centerBox;
+            for (unsigned int k = task.First; k < task.First + task.Count; k++)
+            {
+                box.expand(boxes[Order[k]]);
+                centerBox.expand(centers[Order[k]]);
+            }
+            Nodes[task.Node].Box = box;
+
+            Vector3d extent = centerBox.Max - centerBox.Min;
+            int axis = 0;
+            extent.maxCoeff(&axis);
+            if (task.Count <= leafSize || extent(axis) <= 0.0)
+            {
+                Nodes[task.Node].First = task.First;
+                Nodes[task.Node].Count = task.Count;
+                Nodes[task.Node].Right = 0;
+                Nodes[task.Node].Axis = 0;
+                continue;
+            }
+
+            unsigned int half = task.Count / 2;
+            auto begin = Order.begin() + task.First;
+            nth_element(begin, begin + half, begin + task.Count, [&centers, axis](unsigned int a, unsigned int b)
+            {
+                return centers[a](axis) < centers[b](axis);
+            });
+
+            unsigned int left = Nodes.size();
+            Nodes.push_back(Node());
+            unsigned int right = Nodes.size();
+            Nodes.push_back(Node());
+            Nodes[task.Node].First = left;
+            Nodes[task.Node].Count = 0;
+            Nodes[task.Node].Right = right;
+            Nodes[task.Node].Axis = axis;
+            stack.push_back({right, task.First + half, task.Count - half});
+            stack.push_back({left, task.First, half});
+        }
+    }
+
+// ***************************************************************************
+
+    bool FractureBVH::intersectFracture(unsigned int index, const Ray& ray, double maxDistance,
+                                        RayHit& hit) const
+    {
+        const Matrix3Xd& polygon = Vertices[index];
+        for (Index v = 1; v + 1 < polygon.cols(); v++)
+        {
+            double t;
+            if (rayHitsTriangle(ray.Origin, ray.Direction, polygon.col(0), polygon.col(v),
+                                polygon.col(v + 1), t) && t <= maxDistance)
+            {
+                hit.FractureId = Ids[index];
+                hit.Index = index;
+                hit.Distance = t;
+                hit.Point = ray.Origin + t * ray.Direction;
+                return true;
+            }
+        }
+        return false;
+    }
+
+// ***************************************************************************
+
+    bool FractureBVH::firstHit(const Ray& ray, RayHit& hit) const
+    {
+        hit = RayHit();
+        if (Nodes.empty())
+        {
+            return false;
+        }
+
+        Vector3d inverse = ray.Direction.cwiseInverse();
+        double closest = ray.MaxDistance;
+        vector<unsigned int> stack = {0};
+        while (!stack.empty())
+        {
+            const Node& node = Nodes[stack.back()];
+            stack.pop_back();
+
+            double near;
+            if (!rayHitsBox(node.Box, ray.Origin, inverse, closest, near))
+            {
+                continue;
+            }
+
+            if (node.Count > 0)
+            {
+                for (unsigned int k = node.First; k < node.First + node.Count; k++)
+                {
+                    RayHit candidate;
+                    if (intersectFracture(Order[k], ray, closest, candidate) &&
+                        (!hit.hit() || candidate.Distance < hit.Distance ||
+                         (candidate.Distance == hit.Distance && candidate.Index < hit.Index)))
+                    {
+                        hit = candidate;
+                        closest = candidate.Distance;
+                    }
+                }
+                continue;
+            }
+
+            // visit the nearer child first
+            double nearLeft = 0.0;
+            double nearRight = 0.0;
+            bool left = rayHitsBox(Nodes[node.First].Box, ray.Origin, inverse, closest, nearLeft);
+            bool right = rayHitsBox(Nodes[node.Right].Box, ray.Origin, inverse, closest, nearRight);
+            if (left && right && nearLeft <= nearRight)
+            {
+                stack.push_back(node.Right);
+                stack.push_back(node.First);
+            }
+            else if (left && right)
+            {
+                stack.push_back(node.First);
+                stack.push_back(node.Right);
+            }
+            else if (left)
+            {
+                stack.push_back(node.First);
+            }
+            else if (right)
+            {
+                stack.push_back(node.Right);
+            }
+        }
+        return hit.hit();
+    }
+
+// ***************************************************************************
+
+    void FractureBVH::allHits(const Ray& ray, vector<RayHit>& hits) const
+    {
+        hits.clear();
+        if (Nodes.empty())
+        {
+            return;
+        }
+
+        Vector3d inverse = ray.Direction.cwiseInverse();
+        vector<unsigned int> stack = {0};
+        while (!stack.empty())
+        {
+            const Node& node = Nodes[stack.back()];
+            stack.pop_back();
+
+            double near;
+            if (!rayHitsBox(node.Box, ray.Origin, inverse, ray.MaxDistance, near))
+            {
+                continue;
+            }
+            if (node.Count == 0)
+            {
+                stack.push_back(node.Right);
+                stack.push_back(node.First);
+                continue;
+            }
+            for (unsigned int k = node.First; k < node.First + node.Count; k++)
+            {
+                RayHit hit;
+                if (intersectFracture(Order[k], ray, ray.MaxDistance, hit))
+                {
+                    hits.push_back(hit);
+                }
+            }
+        }
+
+        sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b)
+        {
+            return a.Distance < b.Distance || (a.Distance == b.Distance && a.Index < b.Index);
+        });
+    }
+
+// ***************************************************************************
+
+    bool FractureBVH::occluded(const Vector3d& a, const Vector3d& b) const
+    {
+        if (Nodes.empty())
+        {
+            return false;
+        }
+
+        Ray ray(a, b - a, 1.0);
+        Vector3d inverse = ray.Direction.cwiseInverse();
+        vector<unsigned int> stack = {0};
+        while (!stack.empty())
+        {
+            const Node& node = Nodes[stack.back()];
+            stack.pop_back();
+
+            double near;
+            if (!rayHitsBox(node.Box, ray.Origin, inverse, ray.MaxDistance, near))
+            {
+                continue;
+            }
+            if (node.Count == 0)
+            {
+                stack.push_back(node.Right);
+                stack.push_back(node.First);
+                continue;
+            }
+            for (unsigned int k = node.First; k < node.First + node.Count; k++)
+            {
+                RayHit hit;
+                if (intersectFracture(Order[k], ray, ray.MaxDistance, hit))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+// ***************************************************************************
+
+    void FractureBVH::firstHits(const Ray* rays, size_t numberRays, RayHit* hits) const
+    {
+        // packets of PacketSize rays share one traversal; a node is entered if
+        // any ray of the packet still reaches its box
+        for (size_t start = 0; start < numberRays; start += PacketSize)
+        {
+            const size_t count = min(PacketSize, numberRays - start);
+            Vector3d inverse[PacketSize];
+            double closest[PacketSize];
+            for (size_t r = 0; r < count; r++)
+            {
+                inverse[r] = rays[start + r].Direction.cwiseInverse();
+                closest[r] = rays[start + r].MaxDistance;
+                hits[start + r] = RayHit();
+            }
+            if (Nodes.empty())
+            {
+                continue;
+            }
+
+            vector<unsigned int> stack = {0};
+            while (!stack.empty())
+            {
+                const Node& node = Nodes[stack.back()];
+                stack.pop_back();
+
+                bool active[PacketSize];
+                int leader = -1;
+                for (size_t r = 0; r < count; r++)
+                {
+                    double near;
+                    active[r] = rayHitsBox(node.Box, rays[start + r].Origin, inverse[r], closest[r], near);
+                    if (active[r] && leader < 0)
+                    {
+                        leader = r;
+                    }
+                }
+                if (leader < 0)
+                {
+                    continue;
+                }
+
+                // children in the order the first active ray meets them
+                if (node.Count == 0)
+                {
+                    bool forward = rays[start + leader].Direction(node.Axis) >= 0.0;
+                    stack.push_back(forward ? node.Right : node.First);
+                    stack.push_back(forward ? node.First : node.Right);
+                    continue;
+                }
+
+                for (size_t r = 0; r < count; r++)
+                {
+                    if (!active[r])
+                    {
+                        continue;
+                    }
+                    RayHit& hit = hits[start + r];
+                    for (unsigned int k = node.First; k < node.First + node.Count; k++)
+                    {
+                        RayHit candidate;
+                        if (intersectFracture(Order[k], rays[start + r], closest[r], candidate) &&
+                            (!hit.hit() || candidate.Distance < hit.Distance ||
+                             (candidate.Distance == hit.Distance && candidate.Index < hit.Index)))
+                        {
+                            hit = candidate;
+                            closest[r] = candidate.Distance;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void castRays(const FractureBVH& bvh, const vector<Ray>& rays, vector<RayHit>& hits,
+                  unsigned int numThreads)
+    {
+        hits.resize(rays.size());
+        const size_t packets = (rays.size() + FractureBVH::PacketSize - 1) / FractureBVH::PacketSize;
+        parallelFor(0, packets, numThreads, [&](size_t first, size_t last, unsigned int)
+        {
+            size_t begin = first * FractureBVH::PacketSize;
+            size_t end = min(rays.size(), last * FractureBVH::PacketSize);
+            bvh.firstHits(rays.data() + begin, end - begin, hits.data() + begin);
+        });
+    }
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include "Fractures.hpp"
+#include "SpatialIndex.hpp"
+
+namespace FractureLibrary
+{
+
+   struct Ray
+   {
+       Vector3d Origin;
+       Vector3d Direction;
+       double MaxDistance;
+
+       Ray() : Origin(Vector3d::Zero()), Direction(Vector3d::UnitX()),
+               MaxDistance(numeric_limits<double>::infinity()) {}
+       Ray(const Vector3d& origin, const Vector3d& direction,
+           double maxDistance = numeric_limits<double>::infinity())
+           : Origin(origin), Direction(direction), MaxDistance(maxDistance) {}
+   };
+
+   // Distance is the ray parameter, in units of |Direction|
+   struct RayHit
+   {
+       int FractureId;
+       unsigned int Index;
+       double Distance;
+       Vector3d Point;
+
+       RayHit() : FractureId(-1), Index(0), Distance(numeric_limits<double>::infinity()),
+                  Point(Vector3d::Zero()) {}
+
+       bool hit() const { return FractureId >= 0; }
+   };
+
+   class FractureBVH
+   {
+       public:
+           explicit FractureBVH(const Fractures& fractures, unsigned int leafSize = 4);
+
+           size_t size() const { return Vertices.size(); }
+
+           size_t numberNodes() const { return Nodes.size(); }
+
+           bool firstHit(const Ray& ray, RayHit& hit) const;
+
+           // every crossing along the ray, sorted by distance
+           void allHits(const Ray& ray, vector<RayHit>& hits) const;
+
+           // true if the segment from a to b crosses any fracture
+           bool occluded(const Vector3d& a, const Vector3d& b) const;
+
+           // first hits of a group of rays traversing the tree together
+           void firstHits(const Ray* rays, size_t numberRays, RayHit* hits) const;
+
+           static constexpr size_t PacketSize = 8;
+
+       private:
+           struct Node
+           {
+               BoundingBox Box;
+               unsigned int First;
+               unsigned int Count;
+               unsigned int Right;
+               int Axis;
+           };
+
+           vector<Node> Nodes;
+           vector<unsigned int> Order;
+           vector<Matrix3Xd> Vertices;
+           vector<unsigned int> Ids;
+
+           bool intersectFracture(unsigned int index, const Ray& ray, double maxDistance,
+                                  RayHit& hit) const;
+   };
+
+   void castRays(const FractureBVH& bvh, const vector<Ray>& rays, vector<RayHit>& hits,
+                 unsigned int numThreads = 0);
+
+}
@@ -0,0 +1,342 @@
+#include "Regression.hpp"
+#include <cctype>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        // just enough JSON for the baseline: objects, arrays, strings and numbers
+        struct JsonValue
+        {
+            enum class Type { Null, Number, String, Array, Object } Kind = Type::Null;
+            double Number = 0.0;
+            string String;
+            vector<JsonValue> Array;
+            vector<pair<string, JsonValue>> Object;
+
+            const JsonValue* find(const string& key) const
+            {
+                for (const auto& member : Object)
+                {
+                    if (member.first == key)
+                    {
+                        return &member.second;
+                    }
+                }
+                return nullptr;
+            }
+        };
+
+        class JsonParser
+        {
+            public:
+                explicit JsonParser(const string& text) : Text(text), Position(0) {}
+
+                bool parse(JsonValue& value)
+                {
+                    if (!parseValue(value))
+                    {
+                        return false;
+                    }
+                    skipSpaces();
+                    return Position == Text.size();
+                }
+
+            private:
+                const string& Text;
+                size_t Position;
+
+                void skipSpaces()
+                {
+                    while (Position < Text.size() && isspace((unsigned char)Text[Position]))
+                    {
+                        Position++;
+                    }
+                }
+
+                bool consume(char c)
+                {
+                    skipSpaces();
+                    if (Position < Text.size() && Text[Position] == c)
+                    {
+                        Position++;
+                        return true;
+                    }
+                    return false;
+                }
+
+                bool parseString(string& out)
+                {
+                    if (!consume('"'))
+                    {
+                        return false;
+                    }
+                    out.clear();
+                    while (Position < Text.size() && Text[Position] != '"')
+                    {
+                        if (Text[Position] == '\\' && Position + 1 < Text.size())
+                        {
+                            Position++;
+                        }
+                        out += Text[Position++];
+                    }
+                    return Position++ < Text.size();
+                }
+
+                bool parseValue(JsonValue& value)
+                {
+                    skipSpaces();
+                    if (Position >= Text.size())
+                    {
+                        return false;
+                    }
+
+                    char c = Text[Position];
+                    if (c == '{')
+                    {
+                        Position++;
+                        value.Kind = JsonValue::Type::Object;
+                        if (consume('}'))
+                        {
+                            return true;
+                        }
+                        do
+                        {
+                            pair<string, JsonValue> member;
+                            if (!parseString(member.first) || !consume(':') || !parseValue(member.second))
+                            {
+                                return false;
+                            }
+                            value.Object.push_back(move(member));
+                        } while (consume(','));
+                        return consume('}');
+                    }
+                    if (c == '[')
+                    {
+                        Position++;
+                        value.Kind = JsonValue::Type::Array;
+                        if (consume(']'))
+                        {
+                            return true;
+                        }
+                        do
+                        {
+                            value.Array.emplace_back();
+                            if (!parseValue(value.Array.back()))
+                            {
+                                return false;
+                            }
+                        } while (consume(','));
+                        return consume(']');
+                    }
+                    if (c == '"')
+                    {
+                        value.Kind = JsonValue::Type::String;
+                        return parseString(value.String);
+                    }
+                    if (Text.compare(Position, 4, "null") == 0)
+                    {
+                        Position += 4;
+                        return true;
+                    }
+
+                    const char* begin = Text.c_str() + Position;
+                    char* end = nullptr;
+                    value.Number = strtod(begin, &end);
+                    if (end == begin)
+                    {
+                        return false;
+                    }
+                    value.Kind = JsonValue::Type::Number;
+                    Position += end - begin;
+                    return true;
+                }
+        };
+
+        double numberOf(const JsonValue& object, const string& key, double fallback)
+        {
+            const JsonValue* member = object.find(key);
+            return member != nullptr && member->Kind == JsonValue::Type::Number ? member->Number : fallback;
+        }
+
+        string stringOf(const JsonValue& object, const string& key, const string& fallback)
+        {
+            const JsonValue* member = object.find(key);
+            return member != nullptr && member->Kind == JsonValue::Type::String ? member->String : fallback;
+        }
+
+        // relative change of measured against expected, in percent
+        string change(double expected, double measured)
+        {
+            ostringstream out;
+            out << showpos << fixed << setprecision(1)
+                << (expected > 0.0 ? 100.0 * (measured - expected) / expected : 0.0) << "%";
+            return out.str();
+        }
+    }
+
+// ***************************************************************************
+
+    bool readRegressionBaseline(const string& filename, RegressionBaseline& baseline)
+    {
+        ifstream file(filename);
+        if (!file)
+        {
+            cerr << "Failed to open baseline " << filename << endl;
+            return false;
+        }
+        stringstream text;
+        text << file.rdbuf();
+
+        JsonValue root;
+        string content = text.str();
+        JsonParser parser(content);
+        const JsonValue* workloads = nullptr;
+        if (!parser.parse(root) || root.Kind != JsonValue::Type::Object ||
+            (workloads = root.find("workloads")) == nullptr || workloads->Kind != JsonValue::Type::Array)
+        {
+            cerr << "Malformed baseline " << filename << endl;
+            return false;
+        }
+
+        baseline = RegressionBaseline();
+        baseline.Tolerance = numberOf(root, "tolerance", baseline.Tolerance);
+        baseline.BuildType = stringOf(root, "build_type", "");
+        baseline.Host = stringOf(root, "host", "");
+        for (const JsonValue& entry : workloads->Array)
+        {
+            const JsonValue* name = entry.find("workload");
+            if (name == nullptr || name->Kind != JsonValue::Type::String)
+            {
+                cerr << "Baseline entry without a workload name in " << filename << endl;
+                return false;
+            }
+            RegressionMeasurement measurement;
+            measurement.Workload = name->String;
+            measurement.PairsPerSecond = numberOf(entry, "pairs_per_second", 0.0);
+            measurement.TracesPerSecond = numberOf(entry, "traces_per_second", 0.0);
+            measurement.PeakMegabytes = numberOf(entry, "peak_megabytes", 0.0);
+            baseline.Workloads.push_back(measurement);
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool writeRegressionBaseline(const string& filename, const RegressionBaseline& baseline)
+    {
+        ofstream file(filename);
+        if (!file)
+        {
+            cerr << "Failed to open file for writing: " << filename << endl;
+            return false;
+        }
+
+        file << setprecision(6);
+        file << "{" << endl;
+        file << "    \"tolerance\": " << baseline.Tolerance << "," << endl;
+        file << "    \"build_type\": \"" << baseline.BuildType << "\"," << endl;
+        file << "    \"host\": \"" << baseline.Host << "\"," << endl;
+        file << "    \"workloads\": [" << endl;
+        for (size_t w = 0; w < baseline.Workloads.size(); w++)
+        {
+            const RegressionMeasurement& measurement = baseline.Workloads[w];
+            file << "        {\"workload\": \"" << measurement.Workload << "\", "
+                 << "\"pairs_per_second\": " << measurement.PairsPerSecond << ", "
+                 << "\"traces_per_second\": " << measurement.TracesPerSecond << ", "
+                 << "\"peak_megabytes\": " << measurement.PeakMegabytes << "}"
+                 << (w + 1 < baseline.Workloads.size() ? "," : "") << endl;
+        }
+        file << "    ]" << endl;
+        file << "}" << endl;
+        return bool(file);
+    }
+
+// ***************************************************************************
+
+    bool sameEnvironment(const RegressionBaseline& baseline, const string& buildType,
+                         const string& host, ostream& out)
+    {
+        // a baseline without them predates the fields and matches nothing
+        bool same = true;
+        if (baseline.BuildType != buildType)
+        {
+            out << "Baseline build type \"" << baseline.BuildType << "\" differs from \"" << buildType << "\"" << endl;
+            same = false;
+        }
+        if (baseline.Host != host)
+        {
+            out << "Baseline host \"" << baseline.Host << "\" differs from \"" << host << "\"" << endl;
+            same = false;
+        }
+        return same;
+    }
+
+// ***************************************************************************
+
+    bool compareToBaseline(const RegressionBaseline& baseline,
+                           const vector<RegressionMeasurement>& measured,
+                           double tolerance, ostream& out)
+    {
+        bool passed = true;
+        out << "# Workload; Metric; Baseline; Measured; Change; Status" << endl;
+        for (const RegressionMeasurement& measurement : measured)
+        {
+            const RegressionMeasurement* expected = nullptr;
+            for (const RegressionMeasurement& entry : baseline.Workloads)
+            {
+                if (entry.Workload == measurement.Workload)
+                {
+                    expected = &entry;
+                }
+            }
+            if (expected == nullptr)
+            {
+                out << measurement.Workload << "; -; -; -; -; not in baseline" << endl;
+                continue;
+            }
+
+            // throughput may drop by the tolerance, the memory may grow by it
+            const tuple<const char*, double, double, bool> metrics[] =
+            {
+                {"pairs/s", expected->PairsPerSecond, measurement.PairsPerSecond, true},
+                {"traces/s", expected->TracesPerSecond, measurement.TracesPerSecond, true},
+                {"peak MB", expected->PeakMegabytes, measurement.PeakMegabytes, false}
+            };
+            for (const auto& metric : metrics)
+            {
+                double reference = get<1>(metric);
+                double value = get<2>(metric);
+                bool higherIsBetter = get<3>(metric);
+                bool regressed = reference > 0.0 &&
+                                 (higherIsBetter ? value < reference * (1.0 - tolerance)
+                                                 : value > reference * (1.0 + tolerance));
+                passed = passed && !regressed;
+                out << measurement.Workload << "; " << get<0>(metric) << "; " << reference << "; " << value
+                    << "; " << change(reference, value) << "; " << (regressed ? "REGRESSION" : "ok") << endl;
+            }
+        }
+
+        // a workload that did not run, e.g. a network that failed to load,
+        // would otherwise pass unchecked
+        for (const RegressionMeasurement& entry : baseline.Workloads)
+        {
+            bool found = false;
+            for (const RegressionMeasurement& measurement : measured)
+            {
+                found = found || measurement.Workload == entry.Workload;
+            }
+            if (!found)
+            {
+                passed = false;
+                out << entry.Workload << "; -; -; -; -; NOT MEASURED" << endl;
+            }
+        }
+        return passed;
+    }
+
+}
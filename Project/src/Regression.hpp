@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   struct RegressionMeasurement
+   {
+       string Workload;
+       double PairsPerSecond;
+       double TracesPerSecond;
+       double PeakMegabytes;
+
+       RegressionMeasurement() : PairsPerSecond(0.0), TracesPerSecond(0.0), PeakMegabytes(0.0) {}
+   };
+
+   struct RegressionBaseline
+   {
+       // allowed relative loss of throughput, and growth of the peak memory
+       double Tolerance;
+       // where the baseline was measured; absolute throughput only compares
+       // against a run of the same build type on the same host
+       string BuildType;
+       string Host;
+       vector<RegressionMeasurement> Workloads;
+
+       RegressionBaseline() : Tolerance(0.5) {}
+   };
+
+   // {"tolerance": t, "build_type": b, "host": h, "workloads": [{"workload": name, "pairs_per_second": x,
+   //  "traces_per_second": y, "peak_megabytes": z}, ...]}
+   bool readRegressionBaseline(const string& filename, RegressionBaseline& baseline);
+
+   bool writeRegressionBaseline(const string& filename, const RegressionBaseline& baseline);
+
+   // false, with the reason on out, when the baseline was measured with
+   // another build type or on another host
+   bool sameEnvironment(const RegressionBaseline& baseline, const string& buildType,
+                        const string& host, ostream& out);
+
+   // one line per metric of every measured workload; false when any of them
+   // is outside the tolerance or any baseline workload was not measured.
+   // Workloads missing from the baseline are listed but do not fail.
+   bool compareToBaseline(const RegressionBaseline& baseline,
+                          const vector<RegressionMeasurement>& measured,
+                          double tolerance, ostream& out);
+
+}
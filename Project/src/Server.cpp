@@ -0,0 +1,862 @@
+#include "Server.hpp"
+#include "Utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define DFN_HAS_SOCKETS
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        struct MessageHeader
+        {
+            uint32_t Code;
+            uint32_t Count;
+            uint64_t Bytes;
+        };
+
+        const size_t TraceRecordBytes = 3 * sizeof(uint32_t) + 1 + 6 * sizeof(double);
+
+        // latencies from 100 ns on, in bins 2^(1/8) wide, about 9%
+        const double LatencyFloor = 1e-7;
+        const double BinsPerDoubling = 8.0;
+        const size_t LatencyBins = 256;
+
+        // the payload is read in steps of this, so that a request that
+        // announces more than it sends does not allocate all of it
+        const size_t ReadStepBytes = size_t(1) << 20;
+
+        template <typename T>
+        void put(vector<char>& buffer, const T& value)
+        {
+            const char* bytes = reinterpret_cast<const char*>(&value);
+            buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+        }
+
+        template <typename T>
+        bool get(const vector<char>& buffer, size_t& offset, T& value)
+        {
+            if (offset + sizeof(T) > buffer.size())
+            {
+                return false;
+            }
+            memcpy(&value, buffer.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+        }
+
+        void putIds(vector<char>& buffer, const vector<unsigned int>& ids)
+        {
+            put(buffer, uint32_t(ids.size()));
+            for (unsigned int id : ids)
+            {
+                put(buffer, uint32_t(id));
+            }
+        }
+
+        bool getIds(const vector<char>& buffer, size_t& offset, vector<unsigned int>& ids)
+        {
+            uint32_t n = 0;
+            if (!get(buffer, offset, n) || offset + size_t(n) * sizeof(uint32_t) > buffer.size())
+            {
+                return false;
+            }
+            ids.resize(n);
+            for (uint32_t k = 0; k < n; k++)
+            {
+                uint32_t id = 0;
+                get(buffer, offset, id);
+                ids[k] = id;
+            }
+            return true;
+        }
+
+        // the largest payload a valid request of count queries can have;
+        // larger ones are refused without reading them
+        uint64_t maxRequestBytes(const ServerParameters& parameters, uint32_t opcode, uint32_t count)
+        {
+            uint64_t bytes = 0;
+            switch (QueryOpcode(opcode))
+            {
+                case QueryOpcode::Neighbors:
+                case QueryOpcode::Traces:
+                    bytes = uint64_t(count) * sizeof(uint32_t);
+                    break;
+                case QueryOpcode::Polygons:
+                    bytes = uint64_t(count) * (sizeof(uint32_t) + uint64_t(parameters.MaxVertices) * 3 * sizeof(double));
+                    break;
+                default:
+                    break;
+            }
+            return min(bytes, parameters.MaxRequestBytes);
+        }
+
+        size_t latencyBin(double seconds)
+        {
+            if (!(seconds > LatencyFloor))
+            {
+                return 0;
+            }
+            return min(LatencyBins - 1, size_t(log2(seconds / LatencyFloor) * BinsPerDoubling));
+        }
+
+        // the upper end of the bin of the request of that rank, never above
+        // the largest latency seen
+        double percentile(const vector<uint64_t>& counts, uint64_t requests, double maximum, double fraction)
+        {
+            if (requests == 0)
+            {
+                return 0.0;
+            }
+            uint64_t rank = max<uint64_t>(uint64_t(ceil(fraction * requests)), 1);
+            uint64_t seen = 0;
+            for (size_t bin = 0; bin < counts.size(); bin++)
+            {
+                seen += counts[bin];
+                if (seen >= rank)
+                {
+                    return min(maximum, LatencyFloor * exp2((bin + 1) / BinsPerDoubling));
+                }
+            }
+            return maximum;
+        }
+
+#ifdef DFN_HAS_SOCKETS
+        // with stopping set, gives up once it is raised instead of blocking
+        // on a client that sent part of a message
+        bool readFully(int connection, char* data, size_t bytes, const atomic<bool>* stopping = nullptr)
+        {
+            while (bytes > 0)
+            {
+                if (stopping != nullptr)
+                {
+                    pollfd waiting = {connection, POLLIN, 0};
+                    int ready = poll(&waiting, 1, 50);
+                    if (*stopping || (ready < 0 && errno != EINTR))
+                    {
+                        return false;
+                    }
+                    if (ready <= 0)
+                    {
+                        continue;
+                    }
+                }
+
+                ssize_t got = recv(connection, data, bytes, 0);
+                if (got <= 0)
+                {
+                    if (got < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                data += got;
+                bytes -= got;
+            }
+            return true;
+        }
+
+        bool writeFully(int connection, const char* data, size_t bytes)
+        {
+            while (bytes > 0)
+            {
+                ssize_t sent = send(connection, data, bytes, MSG_NOSIGNAL);
+                if (sent <= 0)
+                {
+                    if (sent < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    return false;
+                }
+                data += sent;
+                bytes -= sent;
+            }
+            return true;
+        }
+
+        bool sendMessage(int connection, uint32_t code, uint32_t count, const vector<char>& payload)
+        {
+            MessageHeader header = {code, count, payload.size()};
+            return writeFully(connection, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+                   writeFully(connection, payload.data(), payload.size());
+        }
+
+        bool fillAddress(const string& socketPath, sockaddr_un& address)
+        {
+            memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path))
+            {
+                cerr << "Invalid socket path " << socketPath << endl;
+                return false;
+            }
+            strcpy(address.sun_path, socketPath.c_str());
+            return true;
+        }
+#endif
+    }
+
+// ***************************************************************************
+
+    QueryServer::QueryServer(Fractures& fractures, const ServerParameters& parameters)
+        : DFN(fractures), Parameters(parameters), Listener(-1), Running(false), Stopping(false),
+          LatencyCounts(LatencyBins, 0)
+    {
+        if (fractures.Traces.empty())
+        {
+            checkIntersections(fractures, Intersections);
+        }
+        else
+        {
+            for (const Trace& trace : fractures.Traces)
+            {
+                Intersections[trace.fractureId1].push_back(trace.fractureId2);
+                Intersections[trace.fractureId2].push_back(trace.fractureId1);
+            }
+        }
+        for (auto& entry : Intersections)
+        {
+            sort(entry.second.begin(), entry.second.end());
+        }
+
+        for (size_t t = 0; t < fractures.Traces.size(); t++)
+        {
+            TracesOf[fractures.Traces[t].fractureId1].push_back(t);
+            TracesOf[fractures.Traces[t].fractureId2].push_back(t);
+        }
+
+        Boxes = computeBoundingBoxes(fractures);
+        Grid = SpatialGrid(suggestCellSize(Boxes));
+        for (size_t i = 0; i < Boxes.size(); i++)
+        {
+            Grid.insert(i, Boxes[i]);
+        }
+    }
+
+// ***************************************************************************
+
+    QueryServer::~QueryServer()
+    {
+        stop();
+    }
+
+// ***************************************************************************
+
+    void QueryServer::neighbors(unsigned int id, vector<unsigned int>& result) const
+    {
+        result.clear();
+        auto it = Intersections.find(id);
+        if (it != Intersections.end())
+        {
+            result.assign(it->second.begin(), it->second.end());
+        }
+    }
+
+// ***************************************************************************
+
+    void QueryServer::traces(unsigned int id, vector<const Trace*>& result) const
+    {
+        result.clear();
+        auto it = TracesOf.find(id);
+        if (it != TracesOf.end())
+        {
+            for (size_t t : it->second)
+            {
+                result.push_back(&DFN.Traces[t]);
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void QueryServer::wouldIntersect(const Matrix3Xd& polygon, vector<unsigned int>& result) const
+    {
+        result.clear();
+        if (polygon.cols() < 3)
+        {
+            return;
+        }
+
+        BoundingBox box = computeBoundingBox(polygon);
+        box.inflate(epsilon);
+
+        // a polygon covering most of the grid is cheaper to test against every box
+        Vector3d span = (box.Max - box.Min) / Grid.cellSize();
+        double cells = (span.array() + 1.0).prod();
+        vector<unsigned int> candidates;
+        if (cells > double(Boxes.size()))
+        {
+            for (size_t i = 0; i < Boxes.size(); i++)
+            {
+                candidates.push_back(i);
+            }
+        }
+        else
+        {
+            Grid.query(box, candidates);
+        }
+
+        for (unsigned int i : candidates)
+        {
+            if (Boxes[i].overlaps(box) && fracturesIntersect(DFN.FracturesVertices[i], polygon))
+            {
+                result.push_back(DFN.FracturesId[i]);
+            }
+        }
+        sort(result.begin(), result.end());
+    }
+
+// ***************************************************************************
+
+    bool QueryServer::answer(uint32_t opcode, const vector<char>& request, uint32_t count, vector<char>& response)
+    {
+        size_t offset = 0;
+        vector<unsigned int> ids;
+
+        switch (QueryOpcode(opcode))
+        {
+            case QueryOpcode::Neighbors:
+            case QueryOpcode::Traces:
+            {
+                if (request.size() != size_t(count) * sizeof(uint32_t))
+                {
+                    return false;
+                }
+                vector<const Trace*> found;
+                for (uint32_t q = 0; q < count; q++)
+                {
+                    uint32_t id = 0;
+                    get(request, offset, id);
+                    if (QueryOpcode(opcode) == QueryOpcode::Neighbors)
+                    {
+                        neighbors(id, ids);
+                        putIds(response, ids);
+                        continue;
+                    }
+
+                    traces(id, found);
+                    put(response, uint32_t(found.size()));
+                    for (const Trace* trace : found)
+                    {
+                        put(response, uint32_t(trace->traceId));
+                        put(response, uint32_t(trace->fractureId1));
+                        put(response, uint32_t(trace->fractureId2));
+                        put(response, uint8_t(trace->Tips1 | (trace->Tips2 << 1)));
+                        for (double value : {trace->p1.x, trace->p1.y, trace->p1.z,
+                                             trace->p2.x, trace->p2.y, trace->p2.z})
+                        {
+                            put(response, value);
+                        }
+                    }
+                }
+                return true;
+            }
+            case QueryOpcode::Polygons:
+            {
+                for (uint32_t q = 0; q < count; q++)
+                {
+                    uint32_t vertices = 0;
+                    if (!get(request, offset, vertices) || vertices < 3 || vertices > Parameters.MaxVertices ||
+                        offset + size_t(vertices) * 3 * sizeof(double) > request.size())
+                    {
+                        return false;
+                    }
+                    Matrix3Xd polygon(3, vertices);
+                    memcpy(polygon.data(), request.data() + offset, size_t(vertices) * 3 * sizeof(double));
+                    offset += size_t(vertices) * 3 * sizeof(double);
+
+                    wouldIntersect(polygon, ids);
+                    putIds(response, ids);
+                }
+                return offset == request.size();
+            }
+            case QueryOpcode::Statistics:
+            {
+                ServerStatistics current = statistics();
+                put(response, current.Clients);
+                put(response, current.Requests);
+                put(response, current.Queries);
+                put(response, current.Errors);
+                put(response, current.Latency50);
+                put(response, current.Latency90);
+                put(response, current.Latency99);
+                put(response, current.LatencyMax);
+                return true;
+            }
+            case QueryOpcode::Shutdown:
+            {
+                Stopping = true;
+                return true;
+            }
+        }
+        return false;
+    }
+
+// ***************************************************************************
+
+    void QueryServer::record(double seconds, uint32_t queries, bool error)
+    {
+        lock_guard<mutex> lock(StatisticsMutex);
+        Counters.Requests++;
+        Counters.Queries += queries;
+        Counters.Errors += error;
+        Counters.LatencyMax = max(Counters.LatencyMax, seconds);
+        LatencyCounts[latencyBin(seconds)]++;
+    }
+
+// ***************************************************************************
+
+    ServerStatistics QueryServer::statistics() const
+    {
+        lock_guard<mutex> lock(StatisticsMutex);
+        ServerStatistics result = Counters;
+        result.Latency50 = percentile(LatencyCounts, Counters.Requests, Counters.LatencyMax, 0.50);
+        result.Latency90 = percentile(LatencyCounts, Counters.Requests, Counters.LatencyMax, 0.90);
+        result.Latency99 = percentile(LatencyCounts, Counters.Requests, Counters.LatencyMax, 0.99);
+        return result;
+    }
+
+#ifdef DFN_HAS_SOCKETS
+
+// ***************************************************************************
+
+    bool QueryServer::start()
+    {
+        sockaddr_un address;
+        if (Running || !fillAddress(Parameters.SocketPath, address))
+        {
+            return false;
+        }
+
+        Listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (Listener < 0)
+        {
+            cerr << "Cannot create socket: " << strerror(errno) << endl;
+            return false;
+        }
+
+        unlink(Parameters.SocketPath.c_str());
+        if (bind(Listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(Listener, 64) != 0)
+        {
+            cerr << "Cannot listen on " << Parameters.SocketPath << ": " << strerror(errno) << endl;
+            ::close(Listener);
+            Listener = -1;
+            return false;
+        }
+
+        Stopping = false;
+        Running = true;
+        Acceptor = thread(&QueryServer::acceptLoop, this);
+        return true;
+    }
+
+// ***************************************************************************
+
+    void QueryServer::acceptLoop()
+    {
+        while (!Stopping)
+        {
+            joinFinishedClients();
+
+            pollfd waiting = {Listener, POLLIN, 0};
+            if (poll(&waiting, 1, 50) <= 0)
+            {
+                continue;
+            }
+
+            int connection = accept(Listener, nullptr, nullptr);
+            if (connection < 0)
+            {
+                continue;
+            }
+
+            {
+                lock_guard<mutex> lock(StatisticsMutex);
+                Counters.Clients++;
+            }
+            lock_guard<mutex> lock(ClientsMutex);
+            ClientThreads.emplace_back();
+            ClientThread& client = ClientThreads.back();
+            client.Worker = thread(&QueryServer::serveClient, this, connection, &client.Done);
+        }
+    }
+
+// ***************************************************************************
+
+    void QueryServer::joinFinishedClients()
+    {
+        lock_guard<mutex> lock(ClientsMutex);
+        for (auto it = ClientThreads.begin(); it != ClientThreads.end();)
+        {
+            if (it->Done)
+            {
+                it->Worker.join();
+                it = ClientThreads.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void QueryServer::serveClient(int connection, atomic<bool>* done)
+    {
+        vector<char> request;
+        vector<char> response;
+
+        while (!Stopping)
+        {
+            // wake up now and then to notice a shutdown
+            pollfd waiting = {connection, POLLIN, 0};
+            int ready = poll(&waiting, 1, 50);
+            if (ready == 0)
+            {
+                continue;
+            }
+
+            MessageHeader header;
+            if (ready < 0 || !readFully(connection, reinterpret_cast<char*>(&header), sizeof(header), &Stopping))
+            {
+                break;
+            }
+
+            bool valid = header.Count <= Parameters.MaxBatch &&
+                         header.Bytes <= maxRequestBytes(Parameters, header.Code, header.Count);
+            bool received = true;
+            request.clear();
+            while (valid && received && request.size() < header.Bytes)
+            {
+                size_t offset = request.size();
+                request.resize(offset + min<uint64_t>(header.Bytes - offset, ReadStepBytes));
+                received = readFully(connection, request.data() + offset, request.size() - offset, &Stopping);
+            }
+            if (!received)
+            {
+                break;
+            }
+
+            auto begin = chrono::steady_clock::now();
+            response.clear();
+            valid = valid && answer(header.Code, request, header.Count, response);
+            if (!valid)
+            {
+                response.clear();
+            }
+
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            record(seconds, valid ? header.Count : 0, !valid);
+            bool sent = sendMessage(connection, uint32_t(valid ? QueryStatus::Ok : QueryStatus::BadRequest),
+                                    valid ? header.Count : 0, response);
+
+            // after a malformed request the stream cannot be trusted any more
+            if (!sent || !valid)
+            {
+                break;
+            }
+        }
+
+        ::close(connection);
+        *done = true;
+    }
+
+// ***************************************************************************
+
+    void QueryServer::wait()
+    {
+        if (Acceptor.joinable())
+        {
+            Acceptor.join();
+        }
+        stop();
+    }
+
+// ***************************************************************************
+
+    void QueryServer::stop()
+    {
+        Stopping = true;
+        if (Acceptor.joinable())
+        {
+            Acceptor.join();
+        }
+
+        list<ClientThread> clients;
+        {
+            lock_guard<mutex> lock(ClientsMutex);
+            clients.swap(ClientThreads);
+        }
+        for (ClientThread& client : clients)
+        {
+            client.Worker.join();
+        }
+
+        if (Listener >= 0)
+        {
+            ::close(Listener);
+            Listener = -1;
+            unlink(Parameters.SocketPath.c_str());
+        }
+        Running = false;
+    }
+
+// ***************************************************************************
+
+    bool QueryClient::connect(const string& socketPath)
+    {
+        sockaddr_un address;
+        close();
+        if (!fillAddress(socketPath, address))
+        {
+            return false;
+        }
+
+        Connection = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (Connection < 0 ||
+            ::connect(Connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            cerr << "Cannot connect to " << socketPath << ": " << strerror(errno) << endl;
+            close();
+            return false;
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    void QueryClient::close()
+    {
+        if (Connection >= 0)
+        {
+            ::close(Connection);
+            Connection = -1;
+        }
+    }
+
+// ***************************************************************************
+
+    bool QueryClient::exchange(QueryOpcode opcode, uint32_t count, const vector<char>& payload,
+                               uint32_t& answerCount, vector<char>& answer)
+    {
+        MessageHeader header;
+        if (Connection < 0 || !sendMessage(Connection, uint32_t(opcode), count, payload) ||
+            !readFully(Connection, reinterpret_cast<char*>(&header), sizeof(header)))
+        {
+            return false;
+        }
+
+        answer.resize(header.Bytes);
+        if (!readFully(Connection, answer.data(), answer.size()))
+        {
+            return false;
+        }
+        answerCount = header.Count;
+        return header.Code == uint32_t(QueryStatus::Ok);
+    }
+
+#else
+
+// ***************************************************************************
+
+    bool QueryServer::start()
+    {
+        cerr << "The query server needs Unix domain sockets" << endl;
+        return false;
+    }
+
+    void QueryServer::acceptLoop() {}
+
+    void QueryServer::joinFinishedClients() {}
+
+    void QueryServer::serveClient(int, atomic<bool>*) {}
+
+    void QueryServer::wait() {}
+
+    void QueryServer::stop() {}
+
+    bool QueryClient::connect(const string&)
+    {
+        return false;
+    }
+
+    void QueryClient::close() {}
+
+    bool QueryClient::exchange(QueryOpcode, uint32_t, const vector<char>&, uint32_t&, vector<char>&)
+    {
+        return false;
+    }
+
+#endif
+
+// ***************************************************************************
+
+    QueryClient::~QueryClient()
+    {
+        close();
+    }
+
+// ***************************************************************************
+
+    bool QueryClient::neighbors(const vector<unsigned int>& ids, vector<vector<unsigned int>>& result)
+    {
+        vector<char> payload;
+        for (unsigned int id : ids)
+        {
+            put(payload, uint32_t(id));
+        }
+
+        uint32_t count = 0;
+        vector<char> answer;
+        if (!exchange(QueryOpcode::Neighbors, ids.size(), payload, count, answer) || count != ids.size())
+        {
+            return false;
+        }
+
+        size_t offset = 0;
+        result.assign(count, {});
+        for (uint32_t q = 0; q < count; q++)
+        {
+            if (!getIds(answer, offset, result[q]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool QueryClient::traces(const vector<unsigned int>& ids, vector<vector<Trace>>& result)
+    {
+        vector<char> payload;
+        for (unsigned int id : ids)
+        {
+            put(payload, uint32_t(id));
+        }
+
+        uint32_t count = 0;
+        vector<char> answer;
+        if (!exchange(QueryOpcode::Traces, ids.size(), payload, count, answer) || count != ids.size())
+        {
+            return false;
+        }
+
+        size_t offset = 0;
+        result.assign(count, {});
+        for (uint32_t q = 0; q < count; q++)
+        {
+            uint32_t n = 0;
+            if (!get(answer, offset, n) || offset + size_t(n) * TraceRecordBytes > answer.size())
+            {
+                return false;
+            }
+            for (uint32_t t = 0; t < n; t++)
+            {
+                uint32_t id = 0, id1 = 0, id2 = 0;
+                uint8_t tips = 0;
+                double p[6];
+                get(answer, offset, id);
+                get(answer, offset, id1);
+                get(answer, offset, id2);
+                get(answer, offset, tips);
+                for (double& value : p)
+                {
+                    get(answer, offset, value);
+                }
+                result[q].emplace_back(id, id1, id2, Point(p[0], p[1], p[2]), Point(p[3], p[4], p[5]),
+                                       tips & 1, (tips >> 1) & 1);
+            }
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool QueryClient::wouldIntersect(const vector<Matrix3Xd>& polygons, vector<vector<unsigned int>>& result)
+    {
+        vector<char> payload;
+        for (const Matrix3Xd& polygon : polygons)
+        {
+            put(payload, uint32_t(polygon.cols()));
+            const char* bytes = reinterpret_cast<const char*>(polygon.data());
+            payload.insert(payload.end(), bytes, bytes + polygon.size() * sizeof(double));
+        }
+
+        uint32_t count = 0;
+        vector<char> answer;
+        if (!exchange(QueryOpcode::Polygons, polygons.size(), payload, count, answer) ||
+            count != polygons.size())
+        {
+            return false;
+        }
+
+        size_t offset = 0;
+        result.assign(count, {});
+        for (uint32_t q = 0; q < count; q++)
+        {
+            if (!getIds(answer, offset, result[q]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    bool QueryClient::statistics(ServerStatistics& result)
+    {
+        uint32_t count = 0;
+        vector<char> answer;
+        if (!exchange(QueryOpcode::Statistics, 0, {}, count, answer))
+        {
+            return false;
+        }
+
+        size_t offset = 0;
+        return get(answer, offset, result.Clients) && get(answer, offset, result.Requests) &&
+               get(answer, offset, result.Queries) && get(answer, offset, result.Errors) &&
+               get(answer, offset, result.Latency50) && get(answer, offset, result.Latency90) &&
+               get(answer, offset, result.Latency99) && get(answer, offset, result.LatencyMax);
+    }
+
+// ***************************************************************************
+
+    bool QueryClient::shutdown()
+    {
+        uint32_t count = 0;
+        vector<char> answer;
+        return exchange(QueryOpcode::Shutdown, 0, {}, count, answer);
+    }
+
+// ***************************************************************************
+
+    void printServerStatistics(const ServerStatistics& statistics, ostream& out)
+    {
+        out << "# Clients; Requests; Queries; Errors; Latency50; Latency90; Latency99; LatencyMax" << endl;
+        out << statistics.Clients << "; " << statistics.Requests << "; " << statistics.Queries << "; "
+            << statistics.Errors << "; " << statistics.Latency50 << "; " << statistics.Latency90 << "; "
+            << statistics.Latency99 << "; " << statistics.LatencyMax << endl;
+    }
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Fractures.hpp"
+#include "SpatialIndex.hpp"
+
+namespace FractureLibrary
+{
+
+   // Binary protocol, native byte order. A request is
+   //   uint32 Opcode, uint32 Count, uint64 Bytes, Bytes of payload
+   // and every answer is
+   //   uint32 Status, uint32 Count, uint64 Bytes, Bytes of payload
+   // Neighbors and Traces carry Count fracture ids (uint32), Polygons carry
+   // Count polygons as uint32 NumberVertices followed by x, y, z doubles.
+   // The answer holds one list per query: uint32 n and n fracture ids, or n
+   // trace records (uint32 traceId, fractureId1, fractureId2, uint8 tips,
+   // p1 and p2 as six doubles).
+   enum class QueryOpcode : uint32_t
+   {
+       Neighbors = 1,
+       Traces = 2,
+       Polygons = 3,
+       Statistics = 4,
+       Shutdown = 5
+   };
+
+   enum class QueryStatus : uint32_t
+   {
+       Ok = 0,
+       BadRequest = 1
+   };
+
+   struct ServerParameters
+   {
+       string SocketPath;
+       // upper bound on the queries of one request and on polygon vertices
+       uint32_t MaxBatch;
+       uint32_t MaxVertices;
+       // upper bound on the payload of one request, below what the batch
+       // and vertex limits allow for polygons
+       uint64_t MaxRequestBytes;
+
+       ServerParameters() : MaxBatch(1 << 20), MaxVertices(1024), MaxRequestBytes(uint64_t(1) << 26) {}
+   };
+
+   struct ServerStatistics
+   {
+       uint64_t Clients;
+       uint64_t Requests;
+       uint64_t Queries;
+       uint64_t Errors;
+       // request latency in seconds, from the end of reading to the answer
+       // being ready; the percentiles are within 10% of the exact ones
+       double Latency50;
+       double Latency90;
+       double Latency99;
+       double LatencyMax;
+
+       ServerStatistics()
+           : Clients(0), Requests(0), Queries(0), Errors(0),
+             Latency50(0.0), Latency90(0.0), Latency99(0.0), LatencyMax(0.0) {}
+   };
+
+   // Loads the network once and answers queries of any number of clients,
+   // one thread per connection; the indices are read only after construction.
+   class QueryServer
+   {
+       public:
+           QueryServer(Fractures& fractures, const ServerParameters& parameters);
+           ~QueryServer();
+
+           QueryServer(const QueryServer&) = delete;
+           QueryServer& operator=(const QueryServer&) = delete;
+
+           // binds the socket and accepts in the background
+           bool start();
+
+           // blocks until a client asks for shutdown or stop is called
+           void wait();
+
+           void stop();
+
+           bool running() const { return Running; }
+
+           ServerStatistics statistics() const;
+
+           void neighbors(unsigned int id, vector<unsigned int>& result) const;
+
+           void traces(unsigned int id, vector<const Trace*>& result) const;
+
+           void wouldIntersect(const Matrix3Xd& polygon, vector<unsigned int>& result) const;
+
+       private:
+           struct ClientThread
+           {
+               thread Worker;
+               atomic<bool> Done;
+
+               ClientThread() : Done(false) {}
+           };
+
+           const Fractures& DFN;
+           ServerParameters Parameters;
+           map<int, vector<int>> Intersections;
+           unordered_map<unsigned int, vector<size_t>> TracesOf;
+           vector<BoundingBox> Boxes;
+           SpatialGrid Grid;
+
+           int Listener;
+           atomic<bool> Running;
+           atomic<bool> Stopping;
+           thread Acceptor;
+           mutex ClientsMutex;
+           // finished ones are joined as the next clients are accepted
+           list<ClientThread> ClientThreads;
+
+           mutable mutex StatisticsMutex;
+           ServerStatistics Counters;
+           // request counts on a logarithmic scale of latencies
+           vector<uint64_t> LatencyCounts;
+
+           void acceptLoop();
+
+           void joinFinishedClients();
+
+           void serveClient(int connection, atomic<bool>* done);
+
+           bool answer(uint32_t opcode, const vector<char>& request, uint32_t count, vector<char>& response);
+
+           void record(double seconds, uint32_t queries, bool error);
+   };
+
+   // Blocking client for a QueryServer on the same machine.
+   class QueryClient
+   {
+       public:
+           QueryClient() : Connection(-1) {}
+           ~QueryClient();
+
+           QueryClient(const QueryClient&) = delete;
+           QueryClient& operator=(const QueryClient&) = delete;
+
+           bool connect(const string& socketPath);
+
+           void close();
+
+           bool neighbors(const vector<unsigned int>& ids, vector<vector<unsigned int>>& result);
+
+           bool traces(const vector<unsigned int>& ids, vector<vector<Trace>>& result);
+
+           bool wouldIntersect(const vector<Matrix3Xd>& polygons, vector<vector<unsigned int>>& result);
+
+           bool statistics(ServerStatistics& result);
+
+           bool shutdown();
+
+       private:
+           int Connection;
+
+           bool exchange(QueryOpcode opcode, uint32_t count, const vector<char>& payload,
+                         uint32_t& answerCount, vector<char>& answer);
+   };
+
+   void printServerStatistics(const ServerStatistics& statistics, ostream& out);
+
+}
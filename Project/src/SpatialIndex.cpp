@@ -0,0 +1,140 @@
+#include "SpatialIndex.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    BoundingBox computeBoundingBox(const Matrix3Xd& vertices)
+    {
+        return BoundingBox(vertices.rowwise().minCoeff(), vertices.rowwise().maxCoeff());
+    }
+
+// ***************************************************************************
+
+    vector<BoundingBox> computeBoundingBoxes(const Fractures& fractures)
+    {
+        vector<BoundingBox> boxes;
+        boxes.reserve(fractures.FracturesVertices.size());
+        for (const auto& vertices : fractures.FracturesVertices)
+        {
+            boxes.push_back(computeBoundingBox(vertices));
+        }
+        return boxes;
+    }
+
+// ***************************************************************************
+
+    Array<long long, 3, 1> SpatialGrid::cellOf(const Vector3d& point) const
+    {
+        return (point.array() / CellSize).floor().cast<long long>();
+    }
+
+// ***************************************************************************
+
+    long long SpatialGrid::key(long long i, long long j, long long k)
+    {
+        // 21 bits per axis, enough for 10^6 cells along each direction
+        const long long mask = (1LL << 21) - 1;
+        return ((i & mask) << 42) | ((j & mask) << 21) | (k & mask);
+    }
+
+// ***************************************************************************
+
+    void SpatialGrid::insert(unsigned int item, const BoundingBox& box)
+    {
+        auto lo = cellOf(box.Min);
+        auto hi = cellOf(box.Max);
+
+        for (long long i = lo(0); i <= hi(0); i++)
+        {
+            for (long long j = lo(1); j <= hi(1); j++)
+            {
+                for (long long k = lo(2); k <= hi(2); k++)
+                {
+                    Cells[key(i, j, k)].push_back(item);
+                }
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void SpatialGrid::remove(unsigned int item, const BoundingBox& box)
+    {
+        auto lo = cellOf(box.Min);
+        auto hi = cellOf(box.Max);
+
+        for (long long i = lo(0); i <= hi(0); i++)
+        {
+            for (long long j = lo(1); j <= hi(1); j++)
+            {
+                for (long long k = lo(2); k <= hi(2); k++)
+                {
+                    auto it = Cells.find(key(i, j, k));
+                    if (it == Cells.end())
+                    {
+                        continue;
+                    }
+
+                    vector<unsigned int>& cell = it->second;
+                    cell.erase(std::remove(cell.begin(), cell.end(), item), cell.end());
+                    if (cell.empty())
+                    {
+                        Cells.erase(it);
+                    }
+                }
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void SpatialGrid::query(const BoundingBox& box, vector<unsigned int>& items) const
+    {
+        items.clear();
+
+        auto lo = cellOf(box.Min);
+        auto hi = cellOf(box.Max);
+
+        for (long long i = lo(0); i <= hi(0); i++)
+        {
+            for (long long j = lo(1); j <= hi(1); j++)
+            {
+                for (long long k = lo(2); k <= hi(2); k++)
+                {
+                    auto it = Cells.find(key(i, j, k));
+                    if (it != Cells.end())
+                    {
+                        items.insert(items.end(), it->second.begin(), it->second.end());
+                    }
+                }
+            }
+        }
+
+        sort(items.begin(), items.end());
+        items.erase(unique(items.begin(), items.end()), items.end());
+    }
+
+// ***************************************************************************
+
+    double suggestCellSize(const vector<BoundingBox>& boxes)
+    {
+        if (boxes.empty())
+        {
+            return 1.0;
+        }
+
+        double sum = 0.0;
+        for (const auto& box : boxes)
+        {
+            sum += (box.Max - box.Min).maxCoeff();
+        }
+
+        double size = sum / boxes.size();
+        return size > 0.0 ? size : 1.0;
+    }
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   struct BoundingBox
+   {
+       Vector3d Min;
+       Vector3d Max;
+
+       BoundingBox()
+           : Min(Vector3d::Constant(numeric_limits<double>::max())),
+             Max(Vector3d::Constant(-numeric_limits<double>::max())) {}
+       BoundingBox(const Vector3d& min, const Vector3d& max) : Min(min), Max(max) {}
+
+       bool empty() const { return (Min.array() > Max.array()).any(); }
+
+       void expand(const Vector3d& point)
+       {
+           Min = Min.cwiseMin(point);
+           Max = Max.cwiseMax(point);
+       }
+
+       void expand(const BoundingBox& box)
+       {
+           Min = Min.cwiseMin(box.Min);
+           Max = Max.cwiseMax(box.Max);
+       }
+
+       void inflate(double margin)
+       {
+           Min.array() -= margin;
+           Max.array() += margin;
+       }
+
+       bool overlaps(const BoundingBox& other) const
+       {
+           return (Min.array() <= other.Max.array()).all() &&
+                  (other.Min.array() <= Max.array()).all();
+       }
+   };
+
+   BoundingBox computeBoundingBox(const Matrix3Xd& vertices);
+
+   vector<BoundingBox> computeBoundingBoxes(const Fractures& fractures);
+
+   class SpatialGrid
+   {
+       public:
+           explicit SpatialGrid(double cellSize = 1.0) : CellSize(cellSize) {}
+
+           double cellSize() const { return CellSize; }
+
+           void insert(unsigned int item, const BoundingBox& box);
+
+           void remove(unsigned int item, const BoundingBox& box);
+
+           void query(const BoundingBox& box, vector<unsigned int>& items) const;
+
+           void clear() { Cells.clear(); }
+
+       private:
+           double CellSize;
+           unordered_map<long long, vector<unsigned int>> Cells;
+
+           Array<long long, 3, 1> cellOf(const Vector3d& point) const;
+
+           static long long key(long long i, long long j, long long k);
+   };
+
+   double suggestCellSize(const vector<BoundingBox>& boxes);
+
+}
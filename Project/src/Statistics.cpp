@@ -0,0 +1,436 @@
+#include "Statistics.hpp"
+#include "Prefilter.hpp"
+#include "SpatialIndex.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include <unordered_map>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    void RunningMoments::add(double value)
+    {
+        if (Count == 0)
+        {
+            Min = value;
+            Max = value;
+        }
+        else
+        {
+            Min = min(Min, value);
+            Max = max(Max, value);
+        }
+
+        Count++;
+        double delta = value - Mean;
+        Mean += delta / Count;
+        M2 += delta * (value - Mean);
+    }
+
+// ***************************************************************************
+
+    void RunningMoments::merge(const RunningMoments& other)
+    {
+        if (other.Count == 0)
+        {
+            return;
+        }
+
+        if (Count == 0)
+        {
+            *this = other;
+            return;
+        }
+
+        double total = double(Count) + double(other.Count);
+        double delta = other.Mean - Mean;
+        Mean += delta * other.Count / total;
+        M2 += other.M2 + delta * delta * double(Count) * double(other.Count) / total;
+        Count += other.Count;
+        Min = min(Min, other.Min);
+        Max = max(Max, other.Max);
+    }
+
+// ***************************************************************************
+
+    double RunningMoments::variance() const
+    {
+        return Count > 1 ? M2 / (Count - 1) : 0.0;
+    }
+
+// ***************************************************************************
+
+    void Histogram::add(double value)
+    {
+        if (value < Lower)
+        {
+            Underflow++;
+            return;
+        }
+
+        double width = (Upper - Lower) / Bins.size();
+        size_t bin = size_t((value - Lower) / width);
+
+        if (bin >= Bins.size())
+        {
+            // the upper bound belongs to the last bin
+            if (value <= Upper)
+            {
+                Bins.back()++;
+                return;
+            }
+            Overflow++;
+            return;
+        }
+
+        Bins[bin]++;
+    }
+
+// ***************************************************************************
+
+    void Histogram::merge(const Histogram& other)
+    {
+        if (Bins.empty())
+        {
+            *this = other;
+            return;
+        }
+
+        for (size_t i = 0; i < Bins.size() && i < other.Bins.size(); i++)
+        {
+            Bins[i] += other.Bins[i];
+        }
+        Underflow += other.Underflow;
+        Overflow += other.Overflow;
+    }
+
+// ***************************************************************************
+
+    LogHistogram::LogHistogram(double lower, double upper, unsigned int binsPerDecade)
+        : Lower(lower), BinsPerDecade(binsPerDecade), Underflow(0), Overflow(0)
+    {
+        Bins.assign(size_t(ceil(log10(upper / lower) * binsPerDecade)), 0);
+    }
+
+// ***************************************************************************
+
+    void LogHistogram::add(double value)
+    {
+        if (!(value >= Lower))
+        {
+            Underflow++;
+            return;
+        }
+
+        size_t bin = size_t(log10(value / Lower) * BinsPerDecade);
+        if (bin >= Bins.size())
+        {
+            Overflow++;
+            return;
+        }
+
+        Bins[bin]++;
+    }
+
+// ***************************************************************************
+
+    void LogHistogram::merge(const LogHistogram& other)
+    {
+        for (size_t i = 0; i < Bins.size() && i < other.Bins.size(); i++)
+        {
+            Bins[i] += other.Bins[i];
+        }
+        Underflow += other.Underflow;
+        Overflow += other.Overflow;
+    }
+
+// ***************************************************************************
+
+    double LogHistogram::binLower(size_t bin) const
+    {
+        return Lower * pow(10.0, double(bin) / BinsPerDecade);
+    }
+
+// ***************************************************************************
+
+    void TraceStatistics::add(const Trace& trace, size_t position1, size_t position2)
+    {
+        NumberTraces++;
+        TraceEnds += 2;
+        PassingEnds += (trace.Tips1 ? 0 : 1) + (trace.Tips2 ? 0 : 1);
+        Length.add(trace.length);
+        LengthHistogram.add(trace.length);
+        TotalLength += trace.length;
+
+        size_t needed = max(position1, position2) + 1;
+        if (TracesPerFracture.size() < needed)
+        {
+            TracesPerFracture.resize(needed, 0);
+        }
+        TracesPerFracture[position1]++;
+        TracesPerFracture[position2]++;
+    }
+
+// ***************************************************************************
+
+    void TraceStatistics::merge(const TraceStatistics& other)
+    {
+        NumberTraces += other.NumberTraces;
+        FailedTraces += other.FailedTraces;
+        TraceEnds += other.TraceEnds;
+        PassingEnds += other.PassingEnds;
+        Length.merge(other.Length);
+        LengthHistogram.merge(other.LengthHistogram);
+        TotalLength += other.TotalLength;
+
+        if (TracesPerFracture.size() < other.TracesPerFracture.size())
+        {
+            TracesPerFracture.resize(other.TracesPerFracture.size(), 0);
+        }
+        for (size_t i = 0; i < other.TracesPerFracture.size(); i++)
+        {
+            TracesPerFracture[i] += other.TracesPerFracture[i];
+        }
+    }
+
+// ***************************************************************************
+
+    double TraceStatistics::passingFraction() const
+    {
+        return TraceEnds > 0 ? double(PassingEnds) / TraceEnds : 0.0;
+    }
+
+// ***************************************************************************
+
+    double TraceStatistics::p21() const
+    {
+        return FractureArea > 0.0 ? TotalLength / FractureArea : 0.0;
+    }
+
+// ***************************************************************************
+
+    double TraceStatistics::p32() const
+    {
+        return DomainVolume > 0.0 ? FractureArea / DomainVolume : 0.0;
+    }
+
+// ***************************************************************************
+
+    void measureNetwork(const Fractures& fractures, TraceStatistics& statistics)
+    {
+        const vector<Matrix3Xd>& polygons = fractures.FracturesVertices;
+        BoundingBox domain;
+        statistics.FractureArea = 0.0;
+        for (const Matrix3Xd& vertices : polygons)
+        {
+            Vector3d normal = Vector3d::Zero();
+            for (Index v = 1; v + 1 < vertices.cols(); v++)
+            {
+                normal += (vertices.col(v) - vertices.col(0)).cross(vertices.col(v + 1) - vertices.col(0));
+            }
+            statistics.FractureArea += 0.5 * normal.norm();
+            domain.expand(computeBoundingBox(vertices));
+        }
+        statistics.DomainVolume = polygons.empty() ? 0.0 : (domain.Max - domain.Min).prod();
+        statistics.TracesPerFracture.assign(polygons.size(), 0);
+    }
+
+// ***************************************************************************
+
+    void collectTraceStatistics(const Fractures& fractures, TraceStatistics& statistics,
+                                unsigned int numThreads)
+    {
+        statistics = TraceStatistics();
+        measureNetwork(fractures, statistics);
+
+        const vector<unsigned int>& ids = fractures.FracturesId;
+        const vector<Matrix3Xd>& vertices = fractures.FracturesVertices;
+        const size_t n = vertices.size();
+        numThreads = resolveThreads(numThreads);
+
+        // the box stage keeps exactly the pairs checkIntersections accepts
+        PrefilterParameters filter;
+        filter.UsePlanes = false;
+        ConservativePrefilter prefilter(fractures, filter);
+
+        // rows are dealt round robin, the early rows hold most of the pairs;
+        // candidates() updates counters, so every thread filters with its own copy
+        vector<TraceStatistics> local(numThreads);
+        parallelFor(0, numThreads, numThreads, [&](size_t first, size_t last, unsigned int)
+        {
+            for (size_t thread = first; thread < last; thread++)
+            {
+                TraceStatistics& accumulator = local[thread];
+                ConservativePrefilter rows = prefilter;
+                vector<char> survivors;
+                int traceId = 0;
+
+                for (size_t i = thread; i < n; i += numThreads)
+                {
+                    rows.candidates(i, survivors);
+                    for (size_t j = i + 1; j < n; j++)
+                    {
+                        if (!survivors[j] || ids[i] == ids[j] || !fracturesIntersect(vertices[i], vertices[j]))
+                        {
+                            continue;
+                        }
+
+                        try
+                        {
+                            accumulator.add(calculateTrace(vertices[i], vertices[j], ids[i], ids[j], traceId), i, j);
+                        }
+                        catch (const exception&)
+                        {
+                            accumulator.FailedTraces++;
+                        }
+                    }
+                }
+            }
+        });
+
+        for (const TraceStatistics& part : local)
+        {
+            statistics.merge(part);
+        }
+    }
+
+// ***************************************************************************
+
+    void summarizeTraces(const Fractures& fractures, TraceStatistics& statistics)
+    {
+        statistics = TraceStatistics();
+        measureNetwork(fractures, statistics);
+
+        unordered_map<int, size_t> position;
+        for (size_t i = 0; i < fractures.FracturesId.size(); i++)
+        {
+            position[fractures.FracturesId[i]] = i;
+        }
+
+        for (const Trace& trace : fractures.Traces)
+        {
+            statistics.add(trace, position[trace.fractureId1], position[trace.fractureId2]);
+        }
+    }
+
+// ***************************************************************************
+
+    void printTraceStatistics(const TraceStatistics& statistics, ostream& out)
+    {
+        out << "# NumberTraces; FailedTraces; PassingFraction; P21; P32" << endl;
+        out << statistics.NumberTraces << "; " << statistics.FailedTraces << "; "
+            << statistics.passingFraction() << "; " << statistics.p21() << "; "
+            << statistics.p32() << endl;
+
+        out << "# TraceLength: Mean; StdDev; Min; Max" << endl;
+        out << statistics.Length.Mean << "; " << sqrt(statistics.Length.variance()) << "; "
+            << statistics.Length.Min << "; " << statistics.Length.Max << endl;
+
+        out << "# LogBinLower; Count" << endl;
+        for (size_t b = 0; b < statistics.LengthHistogram.Bins.size(); b++)
+        {
+            if (statistics.LengthHistogram.Bins[b] > 0)
+            {
+                out << statistics.LengthHistogram.binLower(b) << "; "
+                    << statistics.LengthHistogram.Bins[b] << endl;
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    vector<unsigned int> labelClusters(const Fractures& fractures,
+                                       const map<int, vector<int>>& intersections)
+    {
+        const size_t n = fractures.FracturesId.size();
+
+        unordered_map<int, unsigned int> position;
+        position.reserve(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            position[fractures.FracturesId[i]] = i;
+        }
+
+        vector<unsigned int> parent(n);
+        iota(parent.begin(), parent.end(), 0);
+
+        auto find = [&parent](unsigned int i)
+        {
+            while (parent[i] != i)
+            {
+                parent[i] = parent[parent[i]];
+                i = parent[i];
+            }
+            return i;
+        };
+
+        for (const auto& entry : intersections)
+        {
+            auto it = position.find(entry.first);
+            if (it == position.end())
+            {
+                continue;
+            }
+
+            for (int neighbour : entry.second)
+            {
+                auto jt = position.find(neighbour);
+                if (jt == position.end())
+                {
+                    continue;
+                }
+
+                unsigned int a = find(it->second);
+                unsigned int b = find(jt->second);
+                if (a != b)
+                {
+                    parent[max(a, b)] = min(a, b);
+                }
+            }
+        }
+
+        vector<unsigned int> labels(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            labels[i] = find(i);
+        }
+
+        return labels;
+    }
+
+// ***************************************************************************
+
+    ClusterSummary summarizeClusters(const vector<unsigned int>& labels)
+    {
+        ClusterSummary summary = {0, 0, 0};
+
+        vector<unsigned int> sizes(labels.size(), 0);
+        for (unsigned int label : labels)
+        {
+            sizes[label]++;
+        }
+
+        for (unsigned int size : sizes)
+        {
+            if (size == 0)
+            {
+                continue;
+            }
+
+            summary.NumberClusters++;
+            summary.LargestCluster = max(summary.LargestCluster, size);
+            if (size == 1)
+            {
+                summary.IsolatedFractures++;
+            }
+        }
+
+        return summary;
+    }
+
+}
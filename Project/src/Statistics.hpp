@@ -0,0 +1,119 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   struct RunningMoments
+   {
+       unsigned long long Count;
+       double Mean;
+       double M2;
+       double Min;
+       double Max;
+
+       RunningMoments() : Count(0), Mean(0), M2(0), Min(0), Max(0) {}
+
+       void add(double value);
+
+       void merge(const RunningMoments& other);
+
+       double variance() const;
+   };
+
+   struct Histogram
+   {
+       double Lower;
+       double Upper;
+       vector<unsigned long long> Bins;
+       unsigned long long Underflow;
+       unsigned long long Overflow;
+
+       Histogram() : Lower(0), Upper(1), Underflow(0), Overflow(0) {}
+       Histogram(double lower, double upper, unsigned int numberBins)
+           : Lower(lower), Upper(upper), Bins(numberBins, 0), Underflow(0), Overflow(0) {}
+
+       void add(double value);
+
+       void merge(const Histogram& other);
+   };
+
+   // logarithmic bins: BinsPerDecade equal bins in log10 from Lower upward
+   struct LogHistogram
+   {
+       double Lower;
+       unsigned int BinsPerDecade;
+       vector<unsigned long long> Bins;
+       unsigned long long Underflow;
+       unsigned long long Overflow;
+
+       LogHistogram() : LogHistogram(1e-6, 1e4, 10) {}
+       LogHistogram(double lower, double upper, unsigned int binsPerDecade);
+
+       void add(double value);
+
+       void merge(const LogHistogram& other);
+
+       double binLower(size_t bin) const;
+   };
+
+   // aggregates of the traces of one network; P21 is trace length per unit
+   // fracture area, P32 fracture area per unit volume of the bounding box
+   struct TraceStatistics
+   {
+       unsigned long long NumberTraces;
+       unsigned long long FailedTraces;
+       unsigned long long TraceEnds;
+       unsigned long long PassingEnds;
+       RunningMoments Length;
+       LogHistogram LengthHistogram;
+       double TotalLength;
+       vector<unsigned int> TracesPerFracture;
+       double FractureArea;
+       double DomainVolume;
+
+       TraceStatistics()
+           : NumberTraces(0), FailedTraces(0), TraceEnds(0), PassingEnds(0), TotalLength(0),
+             FractureArea(0), DomainVolume(0) {}
+
+       void add(const Trace& trace, size_t position1, size_t position2);
+
+       void merge(const TraceStatistics& other);
+
+       double passingFraction() const;
+
+       double p21() const;
+
+       double p32() const;
+   };
+
+   struct ClusterSummary
+   {
+       unsigned int NumberClusters;
+       unsigned int LargestCluster;
+       unsigned int IsolatedFractures;
+   };
+
+   vector<unsigned int> labelClusters(const Fractures& fractures,
+                                      const map<int, vector<int>>& intersections);
+
+   ClusterSummary summarizeClusters(const vector<unsigned int>& labels);
+
+   // fracture area, domain volume and zeroed per-fracture counts
+   void measureNetwork(const Fractures& fractures, TraceStatistics& statistics);
+
+   // runs the intersection kernel and reduces every trace on the fly,
+   // without filling fractures.Traces
+   void collectTraceStatistics(const Fractures& fractures, TraceStatistics& statistics,
+                               unsigned int numThreads = 0);
+
+   // the same aggregates from traces already stored in fractures.Traces
+   void summarizeTraces(const Fractures& fractures, TraceStatistics& statistics);
+
+   void printTraceStatistics(const TraceStatistics& statistics, ostream& out);
+
+}
@@ -0,0 +1,170 @@
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace FractureLibrary
+{
+
+    // timed waits keep the binaries loadable with libstdc++ runtimes older
+    // than GCC 12, where condition_variable::wait got a new symbol version
+    static const chrono::milliseconds waitSlice(100);
+
+// ***************************************************************************
+
+    unsigned int resolveThreads(unsigned int numThreads)
+    {
+        if (numThreads == 0)
+        {
+            numThreads = thread::hardware_concurrency();
+        }
+        return max(1u, numThreads);
+    }
+
+// ***************************************************************************
+
+    ThreadPool::ThreadPool(unsigned int numThreads)
+        : Pending(0), Stopping(false)
+    {
+        numThreads = resolveThreads(numThreads);
+        Workers.reserve(numThreads);
+        for (unsigned int t = 0; t < numThreads; t++)
+        {
+            Workers.emplace_back(&ThreadPool::run, this);
+        }
+    }
+
+// ***************************************************************************
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            lock_guard<mutex> lock(Mutex);
+            Stopping = true;
+        }
+        TaskAvailable.notify_all();
+        for (auto& worker : Workers)
+        {
+            worker.join();
+        }
+    }
+
+// ***************************************************************************
+
+    void ThreadPool::submit(function<void()> task)
+    {
+        {
+            lock_guard<mutex> lock(Mutex);
+            Tasks.push(move(task));
+            Pending++;
+        }
+        TaskAvailable.notify_one();
+    }
+
+// ***************************************************************************
+
+    void ThreadPool::wait()
+    {
+        unique_lock<mutex> lock(Mutex);
+        while (!AllDone.wait_for(lock, waitSlice, [this]() { return Pending == 0; }))
+        {
+        }
+    }
+
+// ***************************************************************************
+
+    void ThreadPool::run()
+    {
+        while (true)
+        {
+            function<void()> task;
+            {
+                unique_lock<mutex> lock(Mutex);
+                while (!TaskAvailable.wait_for(lock, waitSlice, [this]() { return Stopping || !Tasks.empty(); }))
+                {
+                }
+                if (Tasks.empty())
+                {
+                    return;
+                }
+                task = move(Tasks.front());
+                Tasks.pop();
+            }
+
+            // an escaping exception would end the process; the task is lost,
+            // the worker and wait() go on
+            try
+            {
+                task();
+            }
+            catch (const exception& exception)
+            {
+                cerr << "Task failed: " << exception.what() << endl;
+            }
+
+            {
+                lock_guard<mutex> lock(Mutex);
+                Pending--;
+                if (Pending == 0)
+                {
+                    AllDone.notify_all();
+                }
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void Semaphore::acquire()
+    {
+        unique_lock<mutex> lock(Mutex);
+        while (!Available.wait_for(lock, waitSlice, [this]() { return Count > 0; }))
+        {
+        }
+        Count--;
+    }
+
+// ***************************************************************************
+
+    void Semaphore::release()
+    {
+        {
+            lock_guard<mutex> lock(Mutex);
+            Count++;
+        }
+        Available.notify_one();
+    }
+
+// ***************************************************************************
+
+    void parallelFor(size_t begin, size_t end, unsigned int numThreads,
+                     const function<void(size_t, size_t, unsigned int)>& body)
+    {
+        if (end <= begin)
+        {
+            return;
+        }
+
+        numThreads = min<size_t>(resolveThreads(numThreads), end - begin);
+        if (numThreads == 1)
+        {
+            body(begin, end, 0);
+            return;
+        }
+
+        vector<thread> threads;
+        threads.reserve(numThreads);
+        const size_t count = end - begin;
+        for (unsigned int t = 0; t < numThreads; t++)
+        {
+            size_t first = begin + count * t / numThreads;
+            size_t last = begin + count * (t + 1) / numThreads;
+            threads.emplace_back(body, first, last, t);
+        }
+        for (auto& worker : threads)
+        {
+            worker.join();
+        }
+    }
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+   class ThreadPool
+   {
+       public:
+           explicit ThreadPool(unsigned int numThreads = 0);
+           ~ThreadPool();
+
+           ThreadPool(const ThreadPool&) = delete;
+           ThreadPool& operator=(const ThreadPool&) = delete;
+
+           unsigned int size() const { return Workers.size(); }
+
+           void submit(function<void()> task);
+
+           void wait();
+
+       private:
+           vector<thread> Workers;
+           queue<function<void()>> Tasks;
+           mutex Mutex;
+           condition_variable TaskAvailable;
+           condition_variable AllDone;
+           size_t Pending;
+           bool Stopping;
+
+           void run();
+   };
+
+   class Semaphore
+   {
+       public:
+           explicit Semaphore(size_t count) : Count(count) {}
+
+           void acquire();
+
+           void release();
+
+       private:
+           mutex Mutex;
+           condition_variable Available;
+           size_t Count;
+   };
+
+   unsigned int resolveThreads(unsigned int numThreads);
+
+   void parallelFor(size_t begin, size_t end, unsigned int numThreads,
+                    const function<void(size_t, size_t, unsigned int)>& body);
+
+}
@@ -0,0 +1,572 @@
+#include "TraceCrossings.hpp"
+#include "Predicates.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <set>
+#include <unordered_set>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        // below this many traces every pair is cheaper than the sweep, and
+        // so it is past n^2 / sweepDensity crossings among n traces
+        const size_t sweepThreshold = 32;
+        const size_t sweepDensity = 256;
+
+        double orient(const Vector2d& a, const Vector2d& b, const Vector2d& c)
+        {
+            return (b.x() - a.x()) * (c.y() - a.y()) - (b.y() - a.y()) * (c.x() - a.x());
+        }
+
+        int orientation(const Vector2d& a, const Vector2d& b, const Vector2d& c)
+        {
+            return orient2d(a.x(), a.y(), b.x(), b.y(), c.x(), c.y());
+        }
+
+        int compareLexicographic(const Vector2d& a, const Vector2d& b)
+        {
+            if (a.x() != b.x())
+            {
+                return a.x() < b.x() ? -1 : 1;
+            }
+            if (a.y() != b.y())
+            {
+                return a.y() < b.y() ? -1 : 1;
+            }
+            return 0;
+        }
+
+        struct Segment
+        {
+            Vector2d Left;
+            Vector2d Right;
+            bool Vertical;
+        };
+
+        // an end of segment A (B = 0 left, 1 right) or the crossing of A and B;
+        // crossings are never rounded, every comparison is exact
+        struct SweepPoint
+        {
+            bool Crossing;
+            unsigned int A;
+            unsigned int B;
+        };
+
+        enum EventType
+        {
+            CrossEvent = 0,
+            InsertEvent = 1,
+            VerticalEvent = 2,
+            RemoveEvent = 3
+        };
+
+        struct Event
+        {
+            SweepPoint Point;
+            int Type;
+            unsigned int A;
+            unsigned int B;
+        };
+
+        struct SweepState
+        {
+            const vector<Segment>* Segments;
+            // the segment being inserted, or Segments->size() for a probe
+            // of the point Probe
+            unsigned int Key;
+            Vector2d Probe;
+
+            const Vector2d& end(const SweepPoint& p) const
+            {
+                const Segment& s = (*Segments)[p.A];
+                return p.B == 0 ? s.Left : s.Right;
+            }
+
+            int compare(const SweepPoint& p, const SweepPoint& q) const
+            {
+                if (!p.Crossing && !q.Crossing)
+                {
+                    return compareLexicographic(end(p), end(q));
+                }
+                if (!p.Crossing)
+                {
+                    return -compare(q, p);
+                }
+                const Segment& a = (*Segments)[p.A];
+                const Segment& b = (*Segments)[p.B];
+                if (!q.Crossing)
+                {
+                    return compareCrossing(a.Left, a.Right, b.Left, b.Right, end(q));
+                }
+                if (p.A == q.A && p.B == q.B)
+                {
+                    return 0;
+                }
+                const Segment& c = (*Segments)[q.A];
+                const Segment& d = (*Segments)[q.B];
+                return compareCrossings(a.Left, a.Right, b.Left, b.Right, c.Left, c.Right, d.Left, d.Right);
+            }
+
+            // +1 when p is above the line of the non vertical segment t
+            int side(unsigned int t, const Vector2d& p) const
+            {
+                return orientation((*Segments)[t].Left, (*Segments)[t].Right, p);
+            }
+
+            // where the crossing segments a and b meet: touching ends, as at
+            // a vertex shared by many traces, are kept as the end itself
+            SweepPoint crossing(unsigned int a, unsigned int b) const
+            {
+                const Segment& sa = (*Segments)[a];
+                const Segment& sb = (*Segments)[b];
+                if (side(b, sa.Left) == 0) return {false, a, 0};
+                if (side(b, sa.Right) == 0) return {false, a, 1};
+                if (side(a, sb.Left) == 0) return {false, b, 0};
+                if (side(a, sb.Right) == 0) return {false, b, 1};
+                return {true, min(a, b), max(a, b)};
+            }
+
+            // b is above a right of their crossing; a segment that ends
+            // there is taken as continued straight on
+            bool aboveAfter(unsigned int b, unsigned int a) const
+            {
+                int s = side(a, (*Segments)[b].Right);
+                if (s != 0)
+                {
+                    return s > 0;
+                }
+                s = side(a, (*Segments)[b].Left);
+                if (s != 0)
+                {
+                    return s < 0;
+                }
+                return b > a;
+            }
+
+            // the tree only ever compares the key with the segments it holds:
+            // the key goes by the side of its left end, segments through that
+            // point by direction, collinear ones by index
+            bool keyBelow(unsigned int t) const
+            {
+                if (Key == Segments->size())
+                {
+                    return side(t, Probe) <= 0;
+                }
+                const Segment& key = (*Segments)[Key];
+                int s = side(t, key.Left);
+                if (s != 0)
+                {
+                    return s < 0;
+                }
+                s = side(t, key.Right);
+                if (s != 0)
+                {
+                    return s < 0;
+                }
+                return Key < t;
+            }
+
+            bool below(unsigned int a, unsigned int b) const
+            {
+                if (a == b)
+                {
+                    return false;
+                }
+                return a == Key ? keyBelow(b) : !keyBelow(a);
+            }
+        };
+
+        // segments swap places at crossings without a new comparison, so
+        // the slot keeps its place in the tree while its segment changes
+        struct Slot
+        {
+            mutable unsigned int Segment;
+        };
+
+        struct SlotBelow
+        {
+            const SweepState* State;
+
+            bool operator()(const Slot& a, const Slot& b) const
+            {
+                return State->below(a.Segment, b.Segment);
+            }
+        };
+
+        struct EventLater
+        {
+            const SweepState* State;
+
+            bool operator()(const Event& a, const Event& b) const
+            {
+                int order = State->compare(a.Point, b.Point);
+                if (order != 0) return order > 0;
+                if (a.Type != b.Type) return a.Type > b.Type;
+                if (a.A != b.A) return a.A > b.A;
+                return a.B > b.B;
+            }
+        };
+    }
+
+// ***************************************************************************
+
+    bool segmentsCross(const Vector2d& a0, const Vector2d& a1, const Vector2d& b0, const Vector2d& b1,
+                       Vector2d& point)
+    {
+        int s1 = orientation(b0, b1, a0);
+        int s2 = orientation(b0, b1, a1);
+        int s3 = orientation(a0, a1, b0);
+        int s4 = orientation(a0, a1, b1);
+        if (s1 == 0 && s2 == 0 && s3 == 0 && s4 == 0)
+        {
+            return false;
+        }
+        if (s1 * s2 > 0 || s3 * s4 > 0)
+        {
+            return false;
+        }
+
+        // touching ends are exact, only a proper crossing is rounded
+        if (s1 == 0)
+        {
+            point = a0;
+        }
+        else if (s2 == 0)
+        {
+            point = a1;
+        }
+        else if (s3 == 0)
+        {
+            point = b0;
+        }
+        else if (s4 == 0)
+        {
+            point = b1;
+        }
+        else
+        {
+            double d1 = orient(b0, b1, a0);
+            double d2 = orient(b0, b1, a1);
+            double t = d1 != d2 ? d1 / (d1 - d2) : 0.5;
+            point = a0 + min(max(t, 0.0), 1.0) * (a1 - a0);
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    void traceCrossingsBruteForce(const vector<LocalTrace>& traces, vector<TraceCrossing>& crossings)
+    {
+        crossings.clear();
+        Vector2d point;
+        for (unsigned int i = 0; i < traces.size(); i++)
+        {
+            for (unsigned int j = i + 1; j < traces.size(); j++)
+            {
+                if (segmentsCross(traces[i].P1, traces[i].P2, traces[j].P1, traces[j].P2, point))
+                {
+                    crossings.emplace_back(i, j, point);
+                }
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    bool traceCrossingsSweep(const vector<LocalTrace>& traces, vector<TraceCrossing>& crossings,
+                             size_t maxCrossings)
+    {
+        crossings.clear();
+        const unsigned int n = traces.size();
+
+        vector<Segment> segments(n);
+        for (unsigned int i = 0; i < n; i++)
+        {
+            Segment& s = segments[i];
+            bool ordered = compareLexicographic(traces[i].P1, traces[i].P2) < 0;
+            s.Left = ordered ? traces[i].P1 : traces[i].P2;
+            s.Right = ordered ? traces[i].P2 : traces[i].P1;
+            s.Vertical = s.Left.x() == s.Right.x();
+        }
+
+        SweepState state{&segments, n, Vector2d::Zero()};
+        set<Slot, SlotBelow> status(SlotBelow{&state});
+        vector<set<Slot, SlotBelow>::iterator> where(n, status.end());
+        priority_queue<Event, vector<Event>, EventLater> events(EventLater{&state});
+        for (unsigned int i = 0; i < n; i++)
+        {
+            // points cross nothing; a vertical segment is a single query of
+            // the status and never enters it
+            if (!segments[i].Vertical)
+            {
+                events.push({{false, i, 0}, InsertEvent, i, i});
+                events.push({{false, i, 1}, RemoveEvent, i, i});
+            }
+            else if (segments[i].Left != segments[i].Right)
+            {
+                events.push({{false, i, 0}, VerticalEvent, i, i});
+            }
+        }
+
+        unordered_set<uint64_t> reported;
+        unordered_set<uint64_t> scheduled;
+        Vector2d point;
+
+        // the same test, argument order included, as the brute force, so
+        // that the points are the same
+        auto crosses = [&](unsigned int a, unsigned int b)
+        {
+            const LocalTrace& first = traces[min(a, b)];
+            const LocalTrace& second = traces[max(a, b)];
+            return segmentsCross(first.P1, first.P2, second.P1, second.P2, point);
+        };
+
+        auto report = [&](unsigned int a, unsigned int b)
+        {
+            uint64_t pair = uint64_t(min(a, b)) * n + max(a, b);
+            if (!reported.count(pair) && crosses(a, b))
+            {
+                reported.insert(pair);
+                crossings.emplace_back(min(a, b), max(a, b), point);
+            }
+        };
+
+        // lower and upper are neighbours; a crossing is reported once, and a
+        // swap is scheduled at it, or now when the pair is already past it
+        // and still in the order from before
+        SweepPoint now = {false, 0, 0};
+        auto check = [&](set<Slot, SlotBelow>::iterator lower, set<Slot, SlotBelow>::iterator upper)
+        {
+            if (lower == status.end() || upper == status.end())
+            {
+                return;
+            }
+            unsigned int a = lower->Segment;
+            unsigned int b = upper->Segment;
+            if (!crosses(a, b))
+            {
+                return;
+            }
+            report(a, b);
+            SweepPoint crossing = state.crossing(a, b);
+            if (state.compare(now, crossing) < 0)
+            {
+                // neighbours again before their crossing keep the one event
+                if (scheduled.insert(uint64_t(min(a, b)) * n + max(a, b)).second)
+                {
+                    events.push({crossing, CrossEvent, a, b});
+                }
+            }
+            else if (!state.aboveAfter(b, a))
+            {
+                events.push({now, CrossEvent, a, b});
+            }
+        };
+
+        // every segment through the end p of the anchor; they are neighbours
+        // in the status, and crossings among more than two of them at one
+        // point are not all found through adjacency
+        vector<unsigned int> through;
+        auto gather = [&](unsigned int anchor, const Vector2d& p)
+        {
+            auto contains = [&](set<Slot, SlotBelow>::iterator it)
+            {
+                return state.side(it->Segment, p) == 0;
+            };
+            auto it = where[anchor];
+            while (it != status.begin() && contains(prev(it)))
+            {
+                --it;
+            }
+            through.clear();
+            for (; it != status.end() && contains(it); ++it)
+            {
+                through.push_back(it->Segment);
+            }
+            for (size_t i = 0; i < through.size(); i++)
+            {
+                for (size_t j = i + 1; j < through.size(); j++)
+                {
+                    report(through[i], through[j]);
+                }
+            }
+        };
+
+        // vertical segments on the abscissa of the sweep whose query is done;
+        // segments that start higher up on them are tested as they enter
+        vector<unsigned int> verticals;
+        double verticalX = numeric_limits<double>::quiet_NaN();
+
+        // once per end point: at its first removal, else after its last event
+        bool gathered = false;
+        unsigned int anchor = n;
+        bool started = false;
+        while (!events.empty())
+        {
+            if (crossings.size() > maxCrossings)
+            {
+                crossings.clear();
+                return false;
+            }
+            Event event = events.top();
+            events.pop();
+            if (!started || state.compare(event.Point, now) != 0)
+            {
+                gathered = false;
+                anchor = n;
+                started = true;
+            }
+            now = event.Point;
+
+            if (event.Type == InsertEvent)
+            {
+                state.Key = event.A;
+                auto it = status.insert(Slot{event.A}).first;
+                where[event.A] = it;
+                anchor = event.A;
+                if (it != status.begin())
+                {
+                    check(prev(it), it);
+                }
+                check(it, next(it));
+
+                const Vector2d& p = segments[event.A].Left;
+                if (p.x() == verticalX)
+                {
+                    verticals.erase(remove_if(verticals.begin(), verticals.end(), [&](unsigned int v)
+                                              {
+                                                  return segments[v].Right.y() < p.y();
+                                              }), verticals.end());
+                    for (unsigned int v : verticals)
+                    {
+                        report(v, event.A);
+                    }
+                }
+            }
+            else if (event.Type == VerticalEvent)
+            {
+                // along the vertical line the status is in order: the
+                // segments from its lower end up to its upper one cross it
+                const Segment& vertical = segments[event.A];
+                state.Key = n;
+                state.Probe = vertical.Left;
+                for (auto it = status.lower_bound(Slot{n});
+                     it != status.end() && state.side(it->Segment, vertical.Right) >= 0; ++it)
+                {
+                    report(event.A, it->Segment);
+                }
+                if (vertical.Left.x() != verticalX)
+                {
+                    verticals.clear();
+                    verticalX = vertical.Left.x();
+                }
+                verticals.push_back(event.A);
+            }
+            else if (event.Type == RemoveEvent)
+            {
+                if (!gathered)
+                {
+                    gather(event.A, segments[event.A].Right);
+                    gathered = true;
+                }
+                auto it = where[event.A];
+                auto above = next(it);
+                bool hasBelow = it != status.begin();
+                auto below = hasBelow ? prev(it) : status.end();
+                status.erase(it);
+                where[event.A] = status.end();
+                if (hasBelow)
+                {
+                    check(below, above);
+                }
+            }
+            else
+            {
+                scheduled.erase(uint64_t(min(event.A, event.B)) * n + max(event.A, event.B));
+                auto lower = where[event.A];
+                auto upper = where[event.B];
+                if (lower != status.end() && upper != status.end() && next(upper) == lower)
+                {
+                    swap(lower, upper);
+                }
+                // only neighbours still in the order before the crossing swap
+                if (lower != status.end() && upper != status.end() && next(lower) == upper &&
+                    !state.aboveAfter(upper->Segment, lower->Segment))
+                {
+                    swap(lower->Segment, upper->Segment);
+                    where[lower->Segment] = lower;
+                    where[upper->Segment] = upper;
+                    if (lower != status.begin())
+                    {
+                        check(prev(lower), lower);
+                    }
+                    check(upper, next(upper));
+                }
+            }
+
+            bool lastAtPoint = events.empty() || state.compare(events.top().Point, now) != 0;
+            if (!gathered && lastAtPoint && anchor != n && where[anchor] != status.end())
+            {
+                gather(anchor, segments[anchor].Left);
+                gathered = true;
+            }
+        }
+
+        sort(crossings.begin(), crossings.end(), [](const TraceCrossing& a, const TraceCrossing& b)
+             {
+                 return a.First < b.First || (a.First == b.First && a.Second < b.Second);
+             });
+        return true;
+    }
+
+// ***************************************************************************
+
+    void computeTraceCrossings(const vector<LocalFracture>& local, TraceCrossings& crossings,
+                               unsigned int numThreads)
+    {
+        vector<vector<TraceCrossing>> perFracture(local.size());
+        parallelFor(0, local.size(), numThreads, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t k = begin; k < end; k++)
+            {
+                const size_t numTraces = local[k].Traces.size();
+                if (numTraces < sweepThreshold ||
+                    !traceCrossingsSweep(local[k].Traces, perFracture[k], numTraces * numTraces / sweepDensity))
+                {
+                    traceCrossingsBruteForce(local[k].Traces, perFracture[k]);
+                }
+            }
+        });
+
+        crossings.Offsets.assign(local.size() + 1, 0);
+        for (size_t k = 0; k < local.size(); k++)
+        {
+            crossings.Offsets[k + 1] = crossings.Offsets[k] + perFracture[k].size();
+        }
+        const size_t total = crossings.Offsets.back();
+        crossings.TraceId1.resize(total);
+        crossings.TraceId2.resize(total);
+        crossings.Points.resize(2, total);
+
+        parallelFor(0, local.size(), numThreads, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t k = begin; k < end; k++)
+            {
+                size_t c = crossings.Offsets[k];
+                for (const TraceCrossing& crossing : perFracture[k])
+                {
+                    crossings.TraceId1[c] = local[k].Traces[crossing.First].TraceId;
+                    crossings.TraceId2[c] = local[k].Traces[crossing.Second].TraceId;
+                    crossings.Points.col(c) = crossing.Point;
+                    c++;
+                }
+            }
+        });
+    }
+
+}
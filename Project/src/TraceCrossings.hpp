@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "Fractures.hpp"
+#include "LocalTraces.hpp"
+
+namespace FractureLibrary
+{
+
+   struct TraceCrossing
+   {
+       // positions in the trace list of the fracture, First < Second
+       unsigned int First;
+       unsigned int Second;
+       Vector2d Point;
+
+       TraceCrossing() : First(0), Second(0), Point(Vector2d::Zero()) {}
+       TraceCrossing(unsigned int first, unsigned int second, const Vector2d& point)
+           : First(first), Second(second), Point(point) {}
+   };
+
+   // Segments cross when they share exactly one point, touching ends
+   // included; collinear segments never cross. The test is exact, only the
+   // point of a proper crossing is rounded.
+   bool segmentsCross(const Vector2d& a0, const Vector2d& a1, const Vector2d& b0, const Vector2d& b1,
+                      Vector2d& point);
+
+   // every pair, the reference for the sweep
+   void traceCrossingsBruteForce(const vector<LocalTrace>& traces, vector<TraceCrossing>& crossings);
+
+   // Bentley-Ottmann sweep: the traces cut by the sweep line are kept in
+   // order and only neighbours are tested, so the cost follows the number
+   // of crossings rather than the number of pairs. Events and the order of
+   // the status are decided by exact predicates, so the result is that of
+   // the brute force. Sorted by (First, Second). Past maxCrossings it gives
+   // up, leaves crossings empty and returns false.
+   bool traceCrossingsSweep(const vector<LocalTrace>& traces, vector<TraceCrossing>& crossings,
+                            size_t maxCrossings = numeric_limits<size_t>::max());
+
+   // Crossings of every fracture in CSR form: those of fracture k, in the
+   // order of the local fractures, are [Offsets[k], Offsets[k + 1]).
+   struct TraceCrossings
+   {
+       vector<uint64_t> Offsets;
+       vector<int> TraceId1;
+       vector<int> TraceId2;
+       Matrix2Xd Points;
+
+       size_t size() const { return TraceId1.size(); }
+
+       size_t numberCrossings(size_t fracture) const { return Offsets[fracture + 1] - Offsets[fracture]; }
+   };
+
+   void computeTraceCrossings(const vector<LocalFracture>& local, TraceCrossings& crossings,
+                              unsigned int numThreads = 0);
+
+}
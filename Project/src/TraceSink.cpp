@@ -0,0 +1,270 @@
+#include "TraceSink.hpp"
+#include "BinaryIO.hpp"
+#include "Prefilter.hpp"
+#include "Utils.hpp"
+#include <cstdio>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    void CollectingSink::consume(const vector<Trace>& block)
+    {
+        DFN.Traces.insert(DFN.Traces.end(), block.begin(), block.end());
+    }
+
+// ***************************************************************************
+
+    void CollectingSink::intersecting(int fractureId1, int fractureId2)
+    {
+        Intersections[fractureId1].push_back(fractureId2);
+        Intersections[fractureId2].push_back(fractureId1);
+    }
+
+// ***************************************************************************
+
+    TextTraceWriter::TextTraceWriter(const string& filename)
+        : Filename(filename), BodyFilename(filename + ".body"), Body(BodyFilename), Count(0)
+    {
+    }
+
+// ***************************************************************************
+
+    void TextTraceWriter::consume(const vector<Trace>& block)
+    {
+        for (const Trace& trace : block)
+        {
+            writeTraceLine(Body, trace);
+        }
+        Count += block.size();
+    }
+
+// ***************************************************************************
+
+    bool TextTraceWriter::finish()
+    {
+        Body.close();
+        bool written = false;
+        {
+            ofstream outFile(Filename);
+            if (!outFile)
+            {
+                cerr << "Failed to open file for writing: " << Filename << endl;
+            }
+            else
+            {
+                outFile << "# Number of Traces" << endl;
+                outFile << Count << endl;
+                outFile << "# TraceId; FractureId1; FractureId2; X1; Y1; Z1; X2; Y2; Z2" << endl;
+                ifstream body(BodyFilename);
+                if (Count > 0)
+                {
+                    outFile << body.rdbuf();
+                }
+                written = bool(outFile);
+            }
+        }
+        remove(BodyFilename.c_str());
+        return written;
+    }
+
+// ***************************************************************************
+
+    BinaryTraceWriter::BinaryTraceWriter(const string& filename)
+        : Filename(filename), Out(filename, ios::binary), Count(0)
+    {
+        writeBinary<uint64_t>(Out, 0);
+    }
+
+// ***************************************************************************
+
+    void BinaryTraceWriter::consume(const vector<Trace>& block)
+    {
+        for (const Trace& trace : block)
+        {
+            writeTraceBinary(Out, trace);
+        }
+        Count += block.size();
+    }
+
+// ***************************************************************************
+
+    bool BinaryTraceWriter::finish()
+    {
+        Out.seekp(0);
+        writeBinary<uint64_t>(Out, Count);
+        Out.close();
+        if (Out.fail())
+        {
+            cerr << "Failed to write " << Filename << endl;
+            return false;
+        }
+        return true;
+    }
+
+// ***************************************************************************
+
+    StatisticsSink::StatisticsSink(const Fractures& fractures)
+    {
+        measureNetwork(fractures, Statistics);
+
+        for (size_t i = 0; i < fractures.FracturesId.size(); i++)
+        {
+            Position[fractures.FracturesId[i]] = i;
+        }
+    }
+
+// ***************************************************************************
+
+    void StatisticsSink::consume(const vector<Trace>& block)
+    {
+        for (const Trace& trace : block)
+        {
+            Statistics.add(trace, Position[trace.fractureId1], Position[trace.fractureId2]);
+        }
+    }
+
+// ***************************************************************************
+
+    unordered_set<int> repeatedFractureIds(const Fractures& fractures)
+    {
+        unordered_set<int> seen, repeated;
+        for (unsigned int id : fractures.FracturesId)
+        {
+            if (!seen.insert(id).second)
+            {
+                repeated.insert(id);
+            }
+        }
+        return repeated;
+    }
+
+// ***************************************************************************
+
+    bool runPairKernel(const Fractures& fractures, TraceSink& sink, const PairKernel& kernel,
+                       PairKernelState& state)
+    {
+        const vector<unsigned int>& ids = fractures.FracturesId;
+        const vector<Matrix3Xd>& vertices = fractures.FracturesVertices;
+        const size_t blockSize = max<size_t>(kernel.BlockSize, 1);
+
+        // with unique ids no pair comes up twice and nothing is remembered
+        unordered_set<int> repeatedIds = repeatedFractureIds(fractures);
+        vector<char> repeated(repeatedIds.empty() ? 0 : ids.size(), 0);
+        for (size_t k = 0; k < repeated.size(); k++)
+        {
+            repeated[k] = repeatedIds.count(ids[k]) > 0;
+        }
+
+        vector<Trace> block;
+        block.reserve(min<size_t>(blockSize, 1024));
+
+        while (state.NextRow < ids.size())
+        {
+            const size_t i = state.NextRow;
+            for (size_t j = i + 1; j < ids.size(); j++)
+            {
+                int id1 = ids[i];
+                int id2 = ids[j];
+
+                if (id1 == id2)
+                {
+                    continue;
+                }
+
+                const bool remembered = !repeated.empty() && (repeated[i] || repeated[j]);
+                FracturePair pair(id1, id2, fractures.NumberFractures);
+
+                if (remembered && state.PairFound.find(pair) != state.PairFound.end())
+                {
+                    continue;
+                }
+
+                if (kernel.MayIntersect && !kernel.MayIntersect(i, j))
+                {
+                    continue;
+                }
+
+                const Matrix3Xd& P = vertices[i];
+                const Matrix3Xd& Q = vertices[j];
+
+                if (kernel.Intersect ? !kernel.Intersect(P, Q) : !fracturesIntersect(P, Q))
+                {
+                    continue;
+                }
+
+                sink.intersecting(id1, id2);
+                if (remembered)
+                {
+                    state.PairFound.insert(pair);
+                }
+
+                try
+                {
+                    block.push_back(calculateTrace(P, Q, id1, id2, state.TraceId));
+                }
+                catch (const exception& e)
+                {
+                    cerr << "Error calculating trace between fractures "
+                         << id1 << " and " << id2 << ": " << e.what() << endl;
+                }
+
+                if (block.size() == blockSize)
+                {
+                    sink.consume(block);
+                    block.clear();
+                }
+            }
+            state.NextRow++;
+
+            if (kernel.RowDone)
+            {
+                if (!block.empty())
+                {
+                    sink.consume(block);
+                    block.clear();
+                }
+                if (!kernel.RowDone(i))
+                {
+                    break;
+                }
+            }
+        }
+
+        if (!block.empty())
+        {
+            sink.consume(block);
+        }
+        return state.NextRow == ids.size();
+    }
+
+// ***************************************************************************
+
+    bool streamTraces(const Fractures& fractures, TraceSink& sink, size_t blockSize)
+    {
+        // the box stage keeps exactly the pairs fracturesIntersect accepts
+        PrefilterParameters filter;
+        filter.UsePlanes = false;
+        ConservativePrefilter prefilter(fractures, filter);
+        vector<char> survivors;
+        size_t row = fractures.FracturesId.size();
+
+        PairKernel kernel;
+        kernel.BlockSize = blockSize;
+        kernel.MayIntersect = [&](size_t i, size_t j)
+        {
+            if (i != row)
+            {
+                prefilter.candidates(i, survivors);
+                row = i;
+            }
+            return survivors[j] != 0;
+        };
+
+        PairKernelState state;
+        runPairKernel(fractures, sink, kernel, state);
+        return sink.finish();
+    }
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "Fractures.hpp"
+#include "Statistics.hpp"
+#include "Utils.hpp"
+
+namespace FractureLibrary
+{
+
+   // receives traces in blocks as the intersection kernel produces them
+   class TraceSink
+   {
+       public:
+           virtual ~TraceSink() = default;
+
+           virtual void consume(const vector<Trace>& block) = 0;
+
+           // every accepted pair, also when its trace cannot be built
+           virtual void intersecting(int /*fractureId1*/, int /*fractureId2*/) {}
+
+           virtual bool finish() { return true; }
+   };
+
+   // the behaviour of checkIntersections: fill fractures.Traces and the map
+   class CollectingSink : public TraceSink
+   {
+       public:
+           CollectingSink(Fractures& fractures, map<int, vector<int>>& intersections)
+               : DFN(fractures), Intersections(intersections) {}
+
+           void consume(const vector<Trace>& block) override;
+
+           void intersecting(int fractureId1, int fractureId2) override;
+
+       private:
+           Fractures& DFN;
+           map<int, vector<int>>& Intersections;
+   };
+
+   // same file as writeTraces; the body is spooled until the count is known
+   class TextTraceWriter : public TraceSink
+   {
+       public:
+           explicit TextTraceWriter(const string& filename);
+
+           void consume(const vector<Trace>& block) override;
+
+           bool finish() override;
+
+       private:
+           string Filename;
+           string BodyFilename;
+           ofstream Body;
+           unsigned long long Count;
+   };
+
+   // same layout as writeTracesBinary; the count is patched in at the end
+   class BinaryTraceWriter : public TraceSink
+   {
+       public:
+           explicit BinaryTraceWriter(const string& filename);
+
+           void consume(const vector<Trace>& block) override;
+
+           bool finish() override;
+
+       private:
+           string Filename;
+           ofstream Out;
+           unsigned long long Count;
+   };
+
+   class StatisticsSink : public TraceSink
+   {
+       public:
+           explicit StatisticsSink(const Fractures& fractures);
+
+           void consume(const vector<Trace>& block) override;
+
+           const TraceStatistics& statistics() const { return Statistics; }
+
+       private:
+           TraceStatistics Statistics;
+           map<int, size_t> Position;
+   };
+
+   class CallbackSink : public TraceSink
+   {
+       public:
+           explicit CallbackSink(function<void(const vector<Trace>&)> callback)
+               : Callback(move(callback)) {}
+
+           void consume(const vector<Trace>& block) override { Callback(block); }
+
+       private:
+           function<void(const vector<Trace>&)> Callback;
+   };
+
+   // the replaceable parts of the pair loop
+   struct PairKernel
+   {
+       // pairs (i, j) it rejects never reach the narrow phase
+       function<bool(size_t, size_t)> MayIntersect;
+       // the narrow phase, fracturesIntersect when empty
+       function<bool(const Matrix3Xd&, const Matrix3Xd&)> Intersect;
+       // runs once row i is done and its traces consumed; false stops the loop
+       function<bool(size_t)> RowDone;
+       size_t BlockSize;
+
+       PairKernel() : BlockSize(1024) {}
+   };
+
+   // where the pair loop stands; a pair of repeated ids is taken once, so
+   // only the accepted pairs with a repeated id are kept
+   struct PairKernelState
+   {
+       size_t NextRow;
+       int TraceId;
+       set<FracturePair> PairFound;
+
+       PairKernelState() : NextRow(0), TraceId(0) {}
+   };
+
+   // The pair loop of checkIntersections from state.NextRow on: accepted
+   // pairs go to sink.intersecting, their traces to sink.consume in blocks
+   // of kernel.BlockSize. Returns true once every row is done; finishing the
+   // sink is left to the caller.
+   bool runPairKernel(const Fractures& fractures, TraceSink& sink, const PairKernel& kernel,
+                      PairKernelState& state);
+
+   // the ids carried by more than one fracture, usually none
+   unordered_set<int> repeatedFractureIds(const Fractures& fractures);
+
+   // checkIntersections with every trace handed to sink in blocks of
+   // blockSize; memory stays bounded by the block
+   bool streamTraces(const Fractures& fractures, TraceSink& sink, size_t blockSize = 1024);
+
+}
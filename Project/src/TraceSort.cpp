@@ -0,0 +1,156 @@
+#include "TraceSort.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+
+namespace FractureLibrary
+{
+
+    namespace
+    {
+        const size_t radixThreshold = 256;
+
+        bool longerFirst(const Trace& a, const Trace& b)
+        {
+            return a.length > b.length || (a.length == b.length && a.traceId < b.traceId);
+        }
+
+        // ascending in the key is descending in the length
+        uint64_t lengthKey(double length)
+        {
+            uint64_t bits;
+            memcpy(&bits, &length, sizeof(bits));
+            bits = (bits >> 63) ? ~bits : bits | (uint64_t(1) << 63);
+            return ~bits;
+        }
+
+        // stable passes over the bytes of the keys, skipping the bytes that
+        // every key shares
+        void radixPasses(vector<uint64_t>& keys, vector<uint32_t>& order, int numberBytes,
+                         vector<uint64_t>& keysBuffer, vector<uint32_t>& orderBuffer)
+        {
+            const size_t n = keys.size();
+            vector<size_t> counts(numberBytes * 256, 0);
+            for (uint64_t key : keys)
+            {
+                for (int b = 0; b < numberBytes; b++)
+                {
+                    counts[b * 256 + ((key >> (8 * b)) & 0xff)]++;
+                }
+            }
+
+            keysBuffer.resize(n);
+            orderBuffer.resize(n);
+            for (int b = 0; b < numberBytes; b++)
+            {
+                size_t* count = &counts[b * 256];
+                if (*max_element(count, count + 256) == n)
+                {
+                    continue;
+                }
+
+                size_t offset = 0;
+                for (int d = 0; d < 256; d++)
+                {
+                    size_t c = count[d];
+                    count[d] = offset;
+                    offset += c;
+                }
+                for (size_t k = 0; k < n; k++)
+                {
+                    size_t slot = count[(keys[k] >> (8 * b)) & 0xff]++;
+                    keysBuffer[slot] = keys[k];
+                    orderBuffer[slot] = order[k];
+                }
+                keys.swap(keysBuffer);
+                order.swap(orderBuffer);
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void radixOrderByLength(const vector<Trace>& traces, vector<uint32_t>& order)
+    {
+        const size_t n = traces.size();
+        order.resize(n);
+        iota(order.begin(), order.end(), 0);
+        if (n < radixThreshold)
+        {
+            sort(order.begin(), order.end(), [&traces](uint32_t a, uint32_t b)
+                 {
+                     return longerFirst(traces[a], traces[b]);
+                 });
+            return;
+        }
+
+        vector<uint64_t> keys(n);
+        vector<uint64_t> keysBuffer;
+        vector<uint32_t> orderBuffer;
+
+        // traces usually come in id order, which the length passes keep
+        bool byId = is_sorted(traces.begin(), traces.end(), [](const Trace& a, const Trace& b)
+                              {
+                                  return a.traceId < b.traceId;
+                              });
+        if (!byId)
+        {
+            for (size_t k = 0; k < n; k++)
+            {
+                keys[k] = uint32_t(traces[k].traceId) ^ 0x80000000u;
+            }
+            radixPasses(keys, order, 4, keysBuffer, orderBuffer);
+        }
+
+        for (size_t k = 0; k < n; k++)
+        {
+            keys[k] = lengthKey(traces[order[k]].length);
+        }
+        radixPasses(keys, order, 8, keysBuffer, orderBuffer);
+    }
+
+// ***************************************************************************
+
+    void radixSortByLength(vector<Trace>& traces)
+    {
+        if (traces.size() < radixThreshold)
+        {
+            sort(traces.begin(), traces.end(), longerFirst);
+            return;
+        }
+
+        vector<uint32_t> order;
+        radixOrderByLength(traces, order);
+        vector<Trace> sorted;
+        sorted.reserve(traces.size());
+        for (uint32_t k : order)
+        {
+            sorted.push_back(traces[k]);
+        }
+        traces.swap(sorted);
+    }
+
+// ***************************************************************************
+
+    void sortTraceSegments(const vector<vector<Trace>*>& segments, unsigned int numThreads)
+    {
+        vector<size_t> bySize(segments.size());
+        iota(bySize.begin(), bySize.end(), 0);
+        sort(bySize.begin(), bySize.end(), [&segments](size_t a, size_t b)
+             {
+                 return segments[a]->size() > segments[b]->size();
+             });
+
+        atomic<size_t> next(0);
+        parallelFor(0, min<size_t>(resolveThreads(numThreads), segments.size()), numThreads, [&](size_t, size_t, unsigned int)
+        {
+            for (size_t s = next++; s < bySize.size(); s = next++)
+            {
+                radixSortByLength(*segments[bySize[s]]);
+            }
+        });
+    }
+
+}
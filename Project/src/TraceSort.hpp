@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Fractures.hpp"
+
+namespace FractureLibrary
+{
+
+   // Order of sortTracesByLength: longest first, equal lengths by traceId.
+   // order[k] is the index in traces of the k-th trace; an LSD radix sort on
+   // the IEEE bits of the lengths, std::sort below a few hundred traces.
+   void radixOrderByLength(const vector<Trace>& traces, vector<uint32_t>& order);
+
+   void radixSortByLength(vector<Trace>& traces);
+
+   // sorts every segment on its own, the largest ones first, across threads
+   void sortTraceSegments(const vector<vector<Trace>*>& segments, unsigned int numThreads = 0);
+
+}
@@ -0,0 +1,221 @@
+#include "TraceStore.hpp"
+#include "Utils.hpp"
+#include <stdexcept>
+
+namespace FractureLibrary
+{
+
+// ***************************************************************************
+
+    TraceStore::TraceStore(TracePrecision precision, bool storeLength, const Fractures* fractures)
+        : Precision(precision), StoreLength(storeLength), DFN(fractures)
+    {
+        if (Precision == TracePrecision::LineParameter)
+        {
+            if (DFN == nullptr)
+            {
+                throw invalid_argument("Line parameter traces need the fractures");
+            }
+            for (size_t i = 0; i < DFN->FracturesId.size(); i++)
+            {
+                Position[DFN->FracturesId[i]] = i;
+            }
+        }
+    }
+
+// ***************************************************************************
+
+    void TraceStore::reserve(size_t count)
+    {
+        Ids.reserve(count);
+        Fracture1.reserve(count);
+        Fracture2.reserve(count);
+        TipBits.reserve((count + 31) / 32);
+        int columns = Precision == TracePrecision::LineParameter ? 2 : 6;
+        for (int c = 0; c < columns; c++)
+        {
+            if (Precision == TracePrecision::Double)
+            {
+                EndpointsDouble[c].reserve(count);
+            }
+            else
+            {
+                EndpointsFloat[c].reserve(count);
+            }
+        }
+        if (StoreLength)
+        {
+            Lengths.reserve(count);
+        }
+    }
+
+// ***************************************************************************
+
+    void TraceStore::clear()
+    {
+        Ids.clear();
+        Fracture1.clear();
+        Fracture2.clear();
+        TipBits.clear();
+        for (int c = 0; c < 6; c++)
+        {
+            EndpointsDouble[c].clear();
+            EndpointsFloat[c].clear();
+        }
+        Lengths.clear();
+    }
+
+// ***************************************************************************
+
+    bool TraceStore::line(uint32_t fractureId1, uint32_t fractureId2, Vector3d& base1, Vector3d& base2,
+                          Vector3d& direction) const
+    {
+        auto first = Position.find(fractureId1);
+        auto second = Position.find(fractureId2);
+        if (first == Position.end() || second == Position.end())
+        {
+            return false;
+        }
+
+        // calculateTrace puts the endpoints at the points intersectPlanes
+        // gives, so the offsets of its traces are zero
+        const Matrix3Xd& P = DFN->FracturesVertices[first->second];
+        const Matrix3Xd& Q = DFN->FracturesVertices[second->second];
+        if (!intersectPlanes(P, Q, base1, base2))
+        {
+            return false;
+        }
+        Vector3d normal1 = Hyperplane<double, 3>::Through(P.col(0), P.col(1), P.col(2)).normal();
+        Vector3d normal2 = Hyperplane<double, 3>::Through(Q.col(0), Q.col(1), Q.col(2)).normal();
+        direction = normal1.cross(normal2).normalized();
+        return true;
+    }
+
+// ***************************************************************************
+
+    void TraceStore::push_back(const Trace& trace)
+    {
+        size_t k = Ids.size();
+        Ids.push_back(trace.traceId);
+        Fracture1.push_back(trace.fractureId1);
+        Fracture2.push_back(trace.fractureId2);
+        if (k % 32 == 0)
+        {
+            TipBits.push_back(0);
+        }
+        TipBits.back() |= uint64_t(trace.Tips1) << (2 * (k % 32));
+        TipBits.back() |= uint64_t(trace.Tips2) << (2 * (k % 32) + 1);
+
+        const double values[6] = {trace.p1.x, trace.p1.y, trace.p1.z, trace.p2.x, trace.p2.y, trace.p2.z};
+        if (Precision == TracePrecision::Double)
+        {
+            for (int c = 0; c < 6; c++)
+            {
+                EndpointsDouble[c].push_back(values[c]);
+            }
+        }
+        else if (Precision == TracePrecision::Float)
+        {
+            for (int c = 0; c < 6; c++)
+            {
+                EndpointsFloat[c].push_back(values[c]);
+            }
+        }
+        else
+        {
+            Vector3d base1;
+            Vector3d base2;
+            Vector3d direction;
+            if (!line(trace.fractureId1, trace.fractureId2, base1, base2, direction))
+            {
+                throw invalid_argument("Trace between fractures without an intersection line");
+            }
+            EndpointsFloat[0].push_back((Vector3d(values[0], values[1], values[2]) - base1).dot(direction));
+            EndpointsFloat[1].push_back((Vector3d(values[3], values[4], values[5]) - base2).dot(direction));
+        }
+
+        if (StoreLength)
+        {
+            Lengths.push_back(trace.length);
+        }
+    }
+
+// ***************************************************************************
+
+    void TraceStore::consume(const vector<Trace>& block)
+    {
+        for (const Trace& trace : block)
+        {
+            push_back(trace);
+        }
+    }
+
+// ***************************************************************************
+
+    void TraceStore::endpoints(size_t k, Vector3d& p1, Vector3d& p2) const
+    {
+        if (Precision == TracePrecision::Double)
+        {
+            p1 << EndpointsDouble[0][k], EndpointsDouble[1][k], EndpointsDouble[2][k];
+            p2 << EndpointsDouble[3][k], EndpointsDouble[4][k], EndpointsDouble[5][k];
+        }
+        else if (Precision == TracePrecision::Float)
+        {
+            p1 << EndpointsFloat[0][k], EndpointsFloat[1][k], EndpointsFloat[2][k];
+            p2 << EndpointsFloat[3][k], EndpointsFloat[4][k], EndpointsFloat[5][k];
+        }
+        else
+        {
+            Vector3d base1;
+            Vector3d base2;
+            Vector3d direction;
+            line(Fracture1[k], Fracture2[k], base1, base2, direction);
+            p1 = base1 + double(EndpointsFloat[0][k]) * direction;
+            p2 = base2 + double(EndpointsFloat[1][k]) * direction;
+        }
+    }
+
+// ***************************************************************************
+
+    double TraceStore::length(size_t k) const
+    {
+        if (StoreLength)
+        {
+            return Lengths[k];
+        }
+        Vector3d p1;
+        Vector3d p2;
+        endpoints(k, p1, p2);
+        return (p2 - p1).norm();
+    }
+
+// ***************************************************************************
+
+    Trace TraceStore::operator[](size_t k) const
+    {
+        Vector3d p1;
+        Vector3d p2;
+        endpoints(k, p1, p2);
+        Trace trace(Ids[k], Fracture1[k], Fracture2[k], Point(p1.x(), p1.y(), p1.z()),
+                    Point(p2.x(), p2.y(), p2.z()), tips1(k), tips2(k));
+        if (StoreLength)
+        {
+            trace.length = Lengths[k];
+        }
+        return trace;
+    }
+
+// ***************************************************************************
+
+    size_t TraceStore::memoryBytes() const
+    {
+        size_t bytes = (Ids.capacity() + Fracture1.capacity() + Fracture2.capacity()) * sizeof(uint32_t)
+                       + TipBits.capacity() * sizeof(uint64_t) + Lengths.capacity() * sizeof(float);
+        for (int c = 0; c < 6; c++)
+        {
+            bytes += EndpointsDouble[c].capacity() * sizeof(double) + EndpointsFloat[c].capacity() * sizeof(float);
+        }
+        return bytes;
+    }
+
+}
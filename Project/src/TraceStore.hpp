@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Fractures.hpp"
+#include "TraceSink.hpp"
+
+namespace FractureLibrary
+{
+
+   enum class TracePrecision
+   {
+       Double,
+       Float,
+       // two float offsets along the intersection line of the two fracture
+       // planes, from the points intersectPlanes gives; rebuilt on access
+       LineParameter
+   };
+
+   // Column store of traces: 32-bit ids, two tip bits per trace, endpoints
+   // at the chosen precision. operator[] gives the Trace view.
+   class TraceStore : public TraceSink
+   {
+       public:
+           explicit TraceStore(TracePrecision precision = TracePrecision::Double,
+                               bool storeLength = false,
+                               const Fractures* fractures = nullptr);
+
+           size_t size() const { return Ids.size(); }
+
+           TracePrecision precision() const { return Precision; }
+
+           void reserve(size_t count);
+
+           void clear();
+
+           void push_back(const Trace& trace);
+
+           void consume(const vector<Trace>& block) override;
+
+           Trace operator[](size_t k) const;
+
+           uint32_t traceId(size_t k) const { return Ids[k]; }
+
+           uint32_t fractureId1(size_t k) const { return Fracture1[k]; }
+
+           uint32_t fractureId2(size_t k) const { return Fracture2[k]; }
+
+           bool tips1(size_t k) const { return (TipBits[k / 32] >> (2 * (k % 32))) & 1; }
+
+           bool tips2(size_t k) const { return (TipBits[k / 32] >> (2 * (k % 32) + 1)) & 1; }
+
+           double length(size_t k) const;
+
+           size_t memoryBytes() const;
+
+       private:
+           TracePrecision Precision;
+           bool StoreLength;
+           const Fractures* DFN;
+           unordered_map<uint32_t, uint32_t> Position;
+
+           vector<uint32_t> Ids;
+           vector<uint32_t> Fracture1;
+           vector<uint32_t> Fracture2;
+           vector<uint64_t> TipBits;
+           vector<double> EndpointsDouble[6];
+           vector<float> EndpointsFloat[6];
+           vector<float> Lengths;
+
+           bool line(uint32_t fractureId1, uint32_t fractureId2, Vector3d& base1, Vector3d& base2,
+                     Vector3d& direction) const;
+
+           void endpoints(size_t k, Vector3d& p1, Vector3d& p2) const;
+   };
+
+}
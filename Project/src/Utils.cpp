@@ -1,19 +1,28 @@
 #include "Utils.hpp"
+#include "TraceSort.hpp"
+#include "Allocations.hpp"
+#include "TraceSink.hpp"
+#include "Predicates.hpp"
 #include <ostream>
 #include <list>
 #include <cmath>
 #include <algorithm>
+#include <iomanip>
 
 namespace FractureLibrary
 {
 
     const double epsilon = 1e-6;
 
+    // below this many traces writeResults sorts on the calling thread
+    static const size_t parallelSortTraces = 1 << 14;
+
 // ***************************************************************************
 
     bool ImportFractures(const string& filename,
                      Fractures& fractures)
     {
+        AllocationPhase phase("import");
         ifstream file;
         file.open(filename);
 
@@ -108,6 +117,42 @@ namespace FractureLibrary
         return true;
     }
 
+// ***************************************************************************
+
+    bool writeFractures(const Fractures& fractures, const string& filename)
+    {
+        ofstream outFile(filename);
+        if (!outFile)
+        {
+            cerr << "Failed to open file for writing: " << filename << endl;
+            return false;
+        }
+
+        outFile << scientific << setprecision(16);
+        outFile << "# Number of Fractures" << endl;
+        outFile << fractures.FracturesId.size() << endl;
+
+        for (size_t i = 0; i < fractures.FracturesId.size(); i++)
+        {
+            const Matrix3Xd& vertices = fractures.FracturesVertices[i];
+
+            outFile << "# FractureId; NumVertices" << endl;
+            outFile << fractures.FracturesId[i] << "; " << vertices.cols() << endl;
+            outFile << "# Vertices" << endl;
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < vertices.cols(); c++)
+                {
+                    outFile << (c == 0 ? "" : "; ") << vertices(r, c);
+                }
+                outFile << endl;
+            }
+        }
+
+        outFile.close();
+        return true;
+    }
+
 // ***************************************************************************
 
     bool intersection2D(const vector<pair<double, double>>& P,
@@ -255,6 +300,16 @@ namespace FractureLibrary
         return false;
     }
 
+// ***************************************************************************
+
+    bool fracturesIntersect(const Matrix3Xd& P, const Matrix3Xd& Q)
+    {
+        return intersection2D(projectsOnPlane(P, "XY"), projectsOnPlane(Q, "XY")) &&
+               intersection2D(projectsOnPlane(P, "YZ"), projectsOnPlane(Q, "YZ")) &&
+               intersection2D(projectsOnPlane(P, "ZX"), projectsOnPlane(Q, "ZX")) &&
+               !checkSeparation(P, Q);
+    }
+
 // ***************************************************************************
 
     bool intersectPlanes(const Matrix3Xd& vertices1, const Matrix3Xd& vertices2,
@@ -299,6 +354,20 @@ namespace FractureLibrary
             Vector3d p1 = points.col(i);
             Vector3d p2 = points.col((i + 1) % points.cols());
 
+            // exactly on the edge: collinear in all three coordinate planes
+            // and inside its box, whatever the scale of the coordinates
+            bool collinear = true;
+            for (int u = 0; u < 3 && collinear; u++)
+            {
+                int v = (u + 1) % 3;
+                collinear = orient2d(p1(u), p1(v), p2(u), p2(v), pt(u), pt(v)) == 0;
+            }
+            if (collinear && (pt.array() >= p1.cwiseMin(p2).array()).all() &&
+                (pt.array() <= p1.cwiseMax(p2).array()).all())
+            {
+                return true;
+            }
+
             Vector3d edge = p2 - p1;
             Vector3d ptToP1 = pt - p1;
 
@@ -342,68 +411,20 @@ namespace FractureLibrary
 
     void checkIntersections(Fractures& fractures, map<int, vector<int>>& intersections)
     {
-        const vector<unsigned int>& ids = fractures.FracturesId;
-        const vector<Matrix3Xd>& vertices = fractures.FracturesVertices;
-        set<FracturePair> pairFound;
-        int traceId = 0;
-
-        for (size_t i = 0; i < ids.size(); i++)
-        {
-            for (size_t j = i + 1; j < ids.size(); j++)
-            {
-                int id1 = ids[i];
-                int id2 = ids[j];
-
-                if (id1 == id2)
-                {
-                    continue;
-                }
-
-                FracturePair pair(id1, id2, fractures.NumberFractures);
-
-                if (pairFound.find(pair) != pairFound.end())
-                {
-                    continue;
-                }
-
-                const Matrix3Xd& P = vertices[i];
-                const Matrix3Xd& Q = vertices[j];
+        checkIntersections(fractures, intersections, nullptr);
+    }
 
-                bool intersectionXY = intersection2D(projectsOnPlane(P, "XY"),
-                                                     projectsOnPlane(Q, "XY"));
-                bool intersectionYZ = intersection2D(projectsOnPlane(P, "YZ"),
-                                                     projectsOnPlane(Q, "YZ"));
-                bool intersectionZX = intersection2D(projectsOnPlane(P, "ZX"),
-                                                     projectsOnPlane(Q, "ZX"));
+// ***************************************************************************
 
-                if (intersectionXY && intersectionYZ && intersectionZX)
-                {
-                    if (!checkSeparation(P, Q))
-                    {
-                        {
-                            intersections[id1].push_back(id2);
-                            intersections[id2].push_back(id1);
-                            pairFound.insert(pair);
-                        }
-
-                        try
-                        {
-                            Trace trace = calculateTrace(P, Q, id1, id2, traceId);
-
-                            fractures.Traces.push_back(trace);
-                        }
-
-                        catch (const exception& e)
-                        {
-                            {
-                                cerr <<"Error calculating trace between fractures "
-                                     << id1 << " and " << id2 << ": " << e.what() << endl;
-                            }
-                        }
-                    }
-                }
-            }
-        }
+    void checkIntersections(Fractures& fractures, map<int, vector<int>>& intersections,
+                            const function<bool(size_t, size_t)>& mayIntersect)
+    {
+        AllocationPhase phase("intersect");
+        CollectingSink sink(fractures, intersections);
+        PairKernel kernel;
+        kernel.MayIntersect = mayIntersect;
+        PairKernelState state;
+        runPairKernel(fractures, sink, kernel, state);
     }
 
 // ***************************************************************************
@@ -412,14 +433,31 @@ namespace FractureLibrary
     {
         sort(traces.begin(), traces.end(), [](const Trace& a, const Trace& b)
              {
-                 return a.length > b.length;
+                 return a.length > b.length || (a.length == b.length && a.traceId < b.traceId);
              });
     }
 
+// ***************************************************************************
+
+    void writeTraceLine(ostream& out, const Trace& trace)
+    {
+        out << trace.traceId << "; "
+            << trace.fractureId1 << "; "
+            << trace.fractureId2 << "; "
+            << trace.p1.x << "; "
+            << trace.p1.y << "; "
+            << trace.p1.z << "; "
+            << trace.p2.x << "; "
+            << trace.p2.y << "; "
+            << trace.p2.z << endl;
+    }
+
 // ***************************************************************************
 
     void writeTraces(const Fractures& fractures, const string& filename)
     {
+        AllocationPhase phase("write");
+
         ofstream outFile(filename);
         if (!outFile)
         {
@@ -432,15 +470,7 @@ namespace FractureLibrary
         outFile << "# TraceId; FractureId1; FractureId2; X1; Y1; Z1; X2; Y2; Z2" << endl;
         for (const auto& trace : fractures.Traces)
         {
-            outFile << trace.traceId << "; "
-                    << trace.fractureId1 << "; "
-                    << trace.fractureId2 << "; "
-                    << trace.p1.x << "; "
-                    << trace.p1.y << "; "
-                    << trace.p1.z << "; "
-                    << trace.p2.x << "; "
-                    << trace.p2.y << "; "
-                    << trace.p2.z << endl;
+            writeTraceLine(outFile, trace);
         }
 
         outFile.close();
@@ -453,35 +483,43 @@ namespace FractureLibrary
         map<int, vector<Trace>> passing;
         map<int, vector<Trace>> non_passing;
 
-        for (const auto& trace : fractures.Traces)
         {
-            if (trace.Tips1)
-            {
-                non_passing[trace.fractureId1].push_back(trace);
-            }
-            else
-            {
-                passing[trace.fractureId1].push_back(trace);
-            }
+            AllocationPhase phase("sort");
 
-            if (trace.Tips2)
+            for (const auto& trace : fractures.Traces)
             {
-                non_passing[trace.fractureId2].push_back(trace);
+                if (trace.Tips1)
+                {
+                    non_passing[trace.fractureId1].push_back(trace);
+                }
+                else
+                {
+                    passing[trace.fractureId1].push_back(trace);
+                }
+
+                if (trace.Tips2)
+                {
+                    non_passing[trace.fractureId2].push_back(trace);
+                }
+                else
+                {
+                    passing[trace.fractureId2].push_back(trace);
+                }
             }
-            else
+
+            // same order as sortTracesByLength, fractures spread over threads on large networks
+            vector<vector<Trace>*> segments;
+            for (auto* lists : {&passing, &non_passing})
             {
-                passing[trace.fractureId2].push_back(trace);
+                for (auto& entry : *lists)
+                {
+                    segments.push_back(&entry.second);
+                }
             }
+            sortTraceSegments(segments, fractures.Traces.size() < parallelSortTraces ? 1 : 0);
         }
 
-        for (auto& entry : passing)
-        {
-            sortTracesByLength(entry.second);
-        }
-        for (auto& entry : non_passing)
-        {
-            sortTracesByLength(entry.second);
-        }
+        AllocationPhase phase("write");
 
         ofstream outFile(filename);
         if (!outFile)
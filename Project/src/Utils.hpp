@@ -8,6 +8,7 @@
 #include <list>
 #include <set>
 #include <tuple>
+#include <functional>
 #include "Fractures.hpp"
 
 namespace FractureLibrary
@@ -22,6 +23,9 @@ namespace FractureLibrary
    bool ImportFractures(const string& filename,
                         Fractures& fractures);
 
+   bool writeFractures(const Fractures& fractures,
+                       const string& filename);
+
    bool intersection2D(const vector<pair<double, double>>& P,
                        const vector<pair<double, double>>& Q);
 
@@ -30,6 +34,8 @@ namespace FractureLibrary
 
    bool checkSeparation(const Matrix3Xd& P, const Matrix3Xd& Q);
 
+   bool fracturesIntersect(const Matrix3Xd& P, const Matrix3Xd& Q);
+
    bool intersectPlanes(const Matrix3Xd& vertices1, const Matrix3Xd& vertices2,
                         Vector3d& pt1, Vector3d& pt2);
 
@@ -41,8 +47,14 @@ namespace FractureLibrary
    void checkIntersections(Fractures& fractures, map<int,
                            vector<int>>& intersections);
 
+   // only pairs (i, j) accepted by mayIntersect reach the narrow phase
+   void checkIntersections(Fractures& fractures, map<int, vector<int>>& intersections,
+                           const function<bool(size_t, size_t)>& mayIntersect);
+
    void sortTracesByLength(vector<Trace>& traces);
 
+   void writeTraceLine(ostream& out, const Trace& trace);
+
    void writeTraces(const Fractures& fractures,
                     const string& filename);
 
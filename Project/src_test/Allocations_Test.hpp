@@ -0,0 +1,88 @@
+#ifndef __TESTALLOCATIONS_H
+#define __TESTALLOCATIONS_H
+
+#include <gtest/gtest.h>
+#include <memory>
+#include "Allocations.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    const PhaseReport* findPhase(const vector<PhaseReport>& reports, const string& name)
+    {
+        for (const PhaseReport& report : reports)
+        {
+            if (report.Name == name)
+            {
+                return &report;
+            }
+        }
+        return nullptr;
+    }
+
+
+    TEST(ALLOCATIONSTEST, TestPhaseCounters)
+    {
+        resetPhaseReports();
+        AllocationCounters before = allocationCounters();
+        {
+            AllocationPhase phase("test_phase");
+            vector<unique_ptr<double>> blocks;
+            for (int k = 0; k < 100; k++)
+            {
+                blocks.emplace_back(new double(k));
+            }
+        }
+        AllocationCounters after = allocationCounters();
+        vector<PhaseReport> reports = phaseReports();
+
+        if (!allocationTrackingEnabled())
+        {
+            EXPECT_EQ(after.Allocations, 0u);
+            EXPECT_TRUE(reports.empty());
+            return;
+        }
+
+        EXPECT_GE(after.Allocations - before.Allocations, 100u);
+        EXPECT_GE(after.Deallocations - before.Deallocations, 100u);
+        ASSERT_EQ(reports.size(), 1u);
+        EXPECT_EQ(reports[0].Runs, 1u);
+        EXPECT_GE(reports[0].Allocations, 100u);
+        EXPECT_GE(reports[0].Bytes, 100 * sizeof(double));
+        EXPECT_GE(reports[0].PeakLiveBytes, 100 * sizeof(double));
+        EXPECT_GT(reports[0].PeakResidentBytes, 0u);
+    }
+
+
+    TEST(ALLOCATIONSTEST, TestPipelinePhases)
+    {
+        resetPhaseReports();
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        writeResults(fractures, "allocations_results.txt");
+        vector<PhaseReport> reports = phaseReports();
+
+        if (!allocationTrackingEnabled())
+        {
+            EXPECT_TRUE(reports.empty());
+            return;
+        }
+
+        for (const char* name : {"import", "intersect", "sort", "write"})
+        {
+            const PhaseReport* report = findPhase(reports, name);
+            ASSERT_NE(report, nullptr) << name;
+            EXPECT_EQ(report->Runs, 1u);
+            EXPECT_GT(report->Allocations, 0u) << name;
+        }
+        EXPECT_EQ(reports[0].Name, "import");
+    }
+
+}
+
+#endif
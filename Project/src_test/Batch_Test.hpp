@@ -0,0 +1,103 @@
+#ifndef __TESTBATCH_H
+#define __TESTBATCH_H
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "Batch.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(BATCHTEST, TestMatchWildcard)
+    {
+        EXPECT_TRUE(matchWildcard("FR*_data.txt", "FR362_data.txt"));
+        EXPECT_TRUE(matchWildcard("FR?_data.txt", "FR3_data.txt"));
+        EXPECT_FALSE(matchWildcard("FR?_data.txt", "FR10_data.txt"));
+        EXPECT_TRUE(matchWildcard("*", "anything"));
+        EXPECT_FALSE(matchWildcard("*.png", "FR3_data.txt"));
+    }
+
+
+    TEST(BATCHTEST, TestParallelFor)
+    {
+        vector<int> values(1000, 0);
+        parallelFor(0, values.size(), 4, [&values](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                values[i] += int(i);
+            }
+        });
+
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            ASSERT_EQ(values[i], int(i));
+        }
+    }
+
+
+    TEST(BATCHTEST, TestBatchMatchesSerialOutput)
+    {
+        vector<string> files = expandInputs({"DFN/FR*_data.txt"});
+        ASSERT_EQ(files.size(), 6);
+        EXPECT_EQ(expandInputs({"DFN"}).size(), 6);
+
+        string folder = "test_batch/";
+        filesystem::create_directories(folder);
+
+        BatchParameters parameters;
+        parameters.NumberThreads = 3;
+        parameters.MaxFilesInFlight = 2;
+        parameters.OutputFolder = folder;
+        BatchStatistics statistics;
+        ASSERT_TRUE(runBatch(files, parameters, statistics));
+        EXPECT_EQ(statistics.NumberFiles, 6);
+        EXPECT_EQ(statistics.FailedFiles, 0);
+
+        for (const auto& file : {"FR10_data.txt", "FR50_data.txt"})
+        {
+            Fractures fractures;
+            ASSERT_TRUE(ImportFractures(string("DFN/") + file, fractures));
+            map<int, vector<int>> intersections;
+            checkIntersections(fractures, intersections);
+            writeTraces(fractures, "test_serial_traces.txt");
+            writeResults(fractures, "test_serial_results.txt");
+
+            ifstream serialTraces("test_serial_traces.txt"), batchTraces(folder + file + "_traces.txt");
+            ifstream serialResults("test_serial_results.txt"), batchResults(folder + file + "_results.txt");
+            stringstream expected, actual;
+            expected << serialTraces.rdbuf() << serialResults.rdbuf();
+            actual << batchTraces.rdbuf() << batchResults.rdbuf();
+            EXPECT_EQ(actual.str(), expected.str());
+        }
+
+        vector<string> missing = {"DFN/does_not_exist.txt"};
+        EXPECT_FALSE(runBatch(missing, parameters, statistics));
+        EXPECT_EQ(statistics.FailedFiles, 1);
+
+        // a malformed file and a second input of the same name fail alone;
+        // the output folder needs no trailing separator
+        filesystem::create_directories("test_batch_inputs");
+        ofstream("test_batch_inputs/malformed.txt") << "# Number of Fractures\nnot a number\n";
+        filesystem::copy_file("DFN/FR3_data.txt", "test_batch_inputs/FR3_data.txt",
+                              filesystem::copy_options::overwrite_existing);
+        vector<string> mixed = {"test_batch_inputs/malformed.txt", "DFN/FR3_data.txt",
+                                "test_batch_inputs/FR3_data.txt", "DFN/FR10_data.txt"};
+        parameters.OutputFolder = "test_batch";
+        EXPECT_FALSE(runBatch(mixed, parameters, statistics));
+        EXPECT_EQ(statistics.FailedFiles, 2);
+        EXPECT_EQ(statistics.NumberFiles, 2);
+        EXPECT_TRUE(filesystem::exists("test_batch/FR3_data.txt_traces.txt"));
+        EXPECT_FALSE(filesystem::exists("test_batch_traces.txt"));
+        filesystem::remove_all("test_batch_inputs");
+
+        remove("test_serial_traces.txt");
+        remove("test_serial_results.txt");
+        filesystem::remove_all(folder);
+    }
+}
+#endif
@@ -0,0 +1,134 @@
+#ifndef __TESTCACHE_H
+#define __TESTCACHE_H
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "BinaryIO.hpp"
+#include "Cache.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(CACHETEST, TestTracesBinaryRoundTrip)
+    {
+        vector<Trace> traces;
+        traces.emplace_back(0, 0, 1, Point(0, 0, 0), Point(1.6, 0, 0), false, true);
+        traces.emplace_back(1, 0, 2, Point(0.1, 0.2, 0.3), Point(0, 1, 0), true, false);
+
+        map<int, vector<int>> intersections = {{0, {1, 2}}, {1, {0}}, {2, {0}}};
+
+        stringstream buffer;
+        writeTracesBinary(buffer, traces);
+        writeIntersectionsBinary(buffer, intersections);
+
+        vector<Trace> readTraces;
+        map<int, vector<int>> readIntersections;
+        ASSERT_TRUE(readTracesBinary(buffer, readTraces));
+        ASSERT_TRUE(readIntersectionsBinary(buffer, readIntersections));
+
+        ASSERT_EQ(readTraces.size(), 2);
+        EXPECT_EQ(readTraces[1].traceId, 1);
+        EXPECT_EQ(readTraces[1].p1.z, 0.3);
+        EXPECT_EQ(readTraces[1].length, traces[1].length);
+        EXPECT_TRUE(readTraces[1].Tips1);
+        EXPECT_FALSE(readTraces[1].Tips2);
+        EXPECT_EQ(readIntersections, intersections);
+    }
+
+
+    TEST(CACHETEST, TestCorruptCountsAreRejected)
+    {
+        stringstream traces;
+        writeBinary<uint64_t>(traces, uint64_t(1) << 60);
+        vector<Trace> readTraces;
+        EXPECT_FALSE(readTracesBinary(traces, readTraces));
+
+        stringstream intersections;
+        writeBinary<uint64_t>(intersections, 1);
+        writeBinary<int32_t>(intersections, 0);
+        writeBinary<uint64_t>(intersections, uint64_t(1) << 60);
+        map<int, vector<int>> readIntersections;
+        EXPECT_FALSE(readIntersectionsBinary(intersections, readIntersections));
+
+        // a stored entry whose trace count is corrupt is a miss
+        string directory = "test_cache_corrupt";
+        IntersectionCache cache(directory);
+        cache.invalidate();
+        Fractures first, second;
+        ASSERT_TRUE(ImportFractures("DFN/FR10_data.txt", first));
+        ASSERT_TRUE(ImportFractures("DFN/FR10_data.txt", second));
+        map<int, vector<int>> firstIntersections, secondIntersections;
+        EXPECT_FALSE(cache.checkIntersections(first, firstIntersections));
+
+        for (const auto& entry : filesystem::directory_iterator(directory))
+        {
+            fstream file(entry.path(), ios::in | ios::out | ios::binary);
+            uint32_t versionSize = 0;
+            file.seekg(4);
+            ASSERT_TRUE(readBinary(file, versionSize));
+            file.seekp(4 + sizeof(uint32_t) + versionSize + 2 * sizeof(uint64_t));
+            writeBinary<uint64_t>(file, uint64_t(1) << 60);
+        }
+        EXPECT_FALSE(cache.checkIntersections(second, secondIntersections));
+        EXPECT_EQ(secondIntersections, firstIntersections);
+        EXPECT_EQ(second.Traces.size(), first.Traces.size());
+        filesystem::remove_all(directory);
+    }
+
+
+    TEST(CACHETEST, TestHashDependsOnGeometry)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR3_data.txt", fractures));
+        unsigned long long key = hashFractures(fractures);
+        EXPECT_EQ(key, hashFractures(fractures));
+
+        fractures.FracturesVertices[1](2, 3) += 1e-12;
+        EXPECT_NE(key, hashFractures(fractures));
+    }
+
+
+    TEST(CACHETEST, TestCacheHitReturnsSameResults)
+    {
+        string directory = "test_cache";
+        IntersectionCache cache(directory);
+        cache.invalidate();
+
+        Fractures reference;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", reference));
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        Fractures first, second;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", first));
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", second));
+        map<int, vector<int>> firstIntersections, secondIntersections;
+
+        EXPECT_FALSE(cache.checkIntersections(first, firstIntersections));
+        EXPECT_TRUE(cache.checkIntersections(second, secondIntersections));
+
+        EXPECT_EQ(cache.statistics().Hits, 1);
+        EXPECT_EQ(cache.statistics().Misses, 1);
+        EXPECT_EQ(cache.statistics().Stores, 1);
+        EXPECT_EQ(cache.usage().Entries, 1);
+
+        EXPECT_EQ(secondIntersections, referenceIntersections);
+        ASSERT_EQ(second.Traces.size(), reference.Traces.size());
+        for (size_t t = 0; t < reference.Traces.size(); t++)
+        {
+            EXPECT_EQ(second.Traces[t].traceId, reference.Traces[t].traceId);
+            EXPECT_EQ(second.Traces[t].p2.y, reference.Traces[t].p2.y);
+            EXPECT_EQ(second.Traces[t].length, reference.Traces[t].length);
+        }
+
+        EXPECT_EQ(cache.invalidate(), 1);
+        EXPECT_EQ(cache.usage().Entries, 0);
+        filesystem::remove_all(directory);
+    }
+}
+#endif
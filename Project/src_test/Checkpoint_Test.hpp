@@ -0,0 +1,143 @@
+#ifndef __TESTCHECKPOINT_H
+#define __TESTCHECKPOINT_H
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "Checkpoint.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(CHECKPOINTTEST, TestResumeGivesIdenticalResults)
+    {
+        Fractures reference;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", reference));
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        CheckpointParameters parameters;
+        parameters.Path = "checkpoint_test.dfnckpt";
+        parameters.IntervalSeconds = 0.0;
+        parameters.StopAfterRows = 60;
+        filesystem::remove(parameters.Path);
+
+        // three interrupted runs and a last one that finishes
+        Fractures fractures;
+        map<int, vector<int>> intersections;
+        CheckpointStatistics statistics;
+        size_t resumedRow = 0;
+        bool done = false;
+        for (int run = 0; run < 4; run++)
+        {
+            fractures.clear();
+            intersections.clear();
+            ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", fractures));
+            done = checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics);
+            EXPECT_EQ(statistics.ResumedRow, resumedRow);
+            EXPECT_GT(statistics.Checkpoints, 0u);
+            resumedRow = statistics.NextRow;
+            if (done)
+            {
+                break;
+            }
+        }
+
+        ASSERT_TRUE(done);
+        EXPECT_EQ(statistics.NextRow, 200u);
+        EXPECT_FALSE(filesystem::exists(parameters.Path));
+        EXPECT_EQ(intersections, referenceIntersections);
+        expectSameTraces(fractures.Traces, reference.Traces);
+    }
+
+
+    TEST(CHECKPOINTTEST, TestResumeWithRepeatedIds)
+    {
+        // repeated ids are the only pairs the loop remembers across a resume
+        Fractures network;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", network));
+        for (size_t k = 0; k < network.FracturesId.size(); k += 3)
+        {
+            network.FracturesId[k] = network.FracturesId[k] % 10;
+        }
+        Fractures reference = network;
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        CheckpointParameters parameters;
+        parameters.Path = "checkpoint_repeated.dfnckpt";
+        parameters.IntervalSeconds = 0.0;
+        parameters.StopAfterRows = 7;
+        filesystem::remove(parameters.Path);
+
+        Fractures fractures;
+        map<int, vector<int>> intersections;
+        CheckpointStatistics statistics;
+        bool done = false;
+        for (int run = 0; run < 10 && !done; run++)
+        {
+            fractures = network;
+            intersections.clear();
+            done = checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics);
+        }
+
+        ASSERT_TRUE(done);
+        EXPECT_EQ(intersections, referenceIntersections);
+        expectSameTraces(fractures.Traces, reference.Traces);
+    }
+
+
+    TEST(CHECKPOINTTEST, TestTornAndForeignCheckpoints)
+    {
+        Fractures reference;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", reference));
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        CheckpointParameters parameters;
+        parameters.Path = "checkpoint_torn.dfnckpt";
+        parameters.IntervalSeconds = 0.0;
+        parameters.StopAfterRows = 30;
+        filesystem::remove(parameters.Path);
+
+        Fractures fractures;
+        map<int, vector<int>> intersections;
+        CheckpointStatistics statistics;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        EXPECT_FALSE(checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics));
+
+        // a write cut short by the interruption loses only its own segment
+        filesystem::resize_file(parameters.Path, filesystem::file_size(parameters.Path) - 5);
+        fractures.clear();
+        intersections.clear();
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        parameters.StopAfterRows = 0;
+        ASSERT_TRUE(checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics));
+        EXPECT_GT(statistics.ResumedRow, 0u);
+        EXPECT_LT(statistics.ResumedRow, 30u);
+        EXPECT_EQ(intersections, referenceIntersections);
+        expectSameTraces(fractures.Traces, reference.Traces);
+
+        // the checkpoint of another network is ignored
+        Fractures other;
+        map<int, vector<int>> otherIntersections;
+        ASSERT_TRUE(ImportFractures("DFN/FR82_data.txt", other));
+        parameters.StopAfterRows = 30;
+        EXPECT_FALSE(checkIntersectionsCheckpointed(other, otherIntersections, parameters, statistics));
+        ASSERT_TRUE(filesystem::exists(parameters.Path));
+
+        fractures.clear();
+        intersections.clear();
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        parameters.StopAfterRows = 0;
+        ASSERT_TRUE(checkIntersectionsCheckpointed(fractures, intersections, parameters, statistics));
+        EXPECT_EQ(statistics.ResumedRow, 0u);
+        EXPECT_EQ(intersections, referenceIntersections);
+        expectSameTraces(fractures.Traces, reference.Traces);
+    }
+
+}
+
+#endif
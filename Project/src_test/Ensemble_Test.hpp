@@ -0,0 +1,176 @@
+#ifndef __TESTENSEMBLE_H
+#define __TESTENSEMBLE_H
+
+#include <gtest/gtest.h>
+#include "Ensemble.hpp"
+#include "Generator.hpp"
+#include "Statistics.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(ENSEMBLETEST, TestRunningMomentsMerge)
+    {
+        RunningMoments all, left, right;
+        vector<double> values = {1.0, 4.0, 2.5, 7.0, 3.0, 0.5};
+
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            all.add(values[i]);
+            (i < 2 ? left : right).add(values[i]);
+        }
+        left.merge(right);
+
+        EXPECT_EQ(left.Count, all.Count);
+        EXPECT_NEAR(left.Mean, all.Mean, 1e-12);
+        EXPECT_NEAR(left.variance(), all.variance(), 1e-12);
+        EXPECT_EQ(left.Min, 0.5);
+        EXPECT_EQ(left.Max, 7.0);
+    }
+
+
+    TEST(ENSEMBLETEST, TestGenerateFractures)
+    {
+        NetworkParameters parameters;
+        parameters.NumberFractures = 20;
+        parameters.NumberVertices = 5;
+
+        Fractures first, second;
+        mt19937_64 generator1(7), generator2(7);
+        generateFractures(first, parameters, generator1);
+        generateFractures(second, parameters, generator2);
+
+        ASSERT_EQ(first.NumberFractures, 20);
+        ASSERT_EQ(first.FracturesVertices.size(), 20);
+        for (size_t i = 0; i < first.FracturesVertices.size(); i++)
+        {
+            const Matrix3Xd& vertices = first.FracturesVertices[i];
+            ASSERT_EQ(vertices.cols(), 5);
+            EXPECT_TRUE(vertices.isApprox(second.FracturesVertices[i]));
+
+            Vector3d normal = (vertices.col(1) - vertices.col(0)).cross(vertices.col(2) - vertices.col(0));
+            for (int k = 3; k < vertices.cols(); k++)
+            {
+                EXPECT_NEAR(normal.normalized().dot(vertices.col(k) - vertices.col(0)), 0.0, 1e-12);
+            }
+        }
+    }
+
+
+    TEST(ENSEMBLETEST, TestWriteFracturesRoundTrip)
+    {
+        Fractures fractures, imported;
+        NetworkParameters parameters;
+        parameters.NumberFractures = 10;
+        mt19937_64 generator(3);
+        generateFractures(fractures, parameters, generator);
+
+        string filename = "test_fractures_output.txt";
+        ASSERT_TRUE(writeFractures(fractures, filename));
+        ASSERT_TRUE(ImportFractures(filename, imported));
+
+        ASSERT_EQ(imported.NumberFractures, fractures.NumberFractures);
+        EXPECT_EQ(imported.FracturesId, fractures.FracturesId);
+        for (size_t i = 0; i < fractures.FracturesVertices.size(); i++)
+        {
+            EXPECT_EQ(imported.FracturesVertices[i], fractures.FracturesVertices[i]);
+        }
+
+        remove(filename.c_str());
+    }
+
+
+    TEST(ENSEMBLETEST, TestEnsembleIndependentOfThreads)
+    {
+        EnsembleParameters parameters;
+        parameters.NumberRealizations = 12;
+        parameters.Network.NumberFractures = 30;
+        parameters.Seed = 11;
+
+        EnsembleStatistics serial, parallel;
+        parameters.NumberThreads = 1;
+        ASSERT_TRUE(runEnsemble(parameters, serial));
+        parameters.NumberThreads = 3;
+        ASSERT_TRUE(runEnsemble(parameters, parallel));
+
+        EXPECT_EQ(serial.NumberRealizations, 12);
+        EXPECT_EQ(parallel.NumberRealizations, 12);
+        EXPECT_EQ(serial.TraceLength.Count, parallel.TraceLength.Count);
+        EXPECT_EQ(serial.PassingEnds, parallel.PassingEnds);
+        EXPECT_EQ(serial.TraceLengthHistogram.Bins, parallel.TraceLengthHistogram.Bins);
+        EXPECT_NEAR(serial.LargestClusterFraction.Mean, parallel.LargestClusterFraction.Mean, 1e-12);
+        EXPECT_GT(serial.TracesPerRealization.Mean, 0.0);
+    }
+
+
+    TEST(ENSEMBLETEST, TestEnsembleFromFiles)
+    {
+        EnsembleParameters parameters;
+        parameters.NumberRealizations = 4;
+        parameters.NumberThreads = 2;
+        parameters.InputFiles = {"DFN/FR3_data.txt"};
+
+        EnsembleStatistics statistics;
+        ASSERT_TRUE(runEnsemble(parameters, statistics));
+
+        EXPECT_EQ(statistics.NumberRealizations, 4);
+        EXPECT_EQ(statistics.TraceLength.Count, 8);
+        EXPECT_EQ(statistics.TracesPerRealization.Min, 2);
+        EXPECT_EQ(statistics.TracesPerRealization.Max, 2);
+        EXPECT_NEAR(statistics.LargestClusterFraction.Mean, 1.0, 1e-12);
+    }
+
+
+    TEST(ENSEMBLETEST, TestLogHistogram)
+    {
+        LogHistogram histogram(1e-3, 1e3, 5);
+        ASSERT_EQ(histogram.Bins.size(), 30);
+        histogram.add(1e-4);
+        histogram.add(1e-3);
+        histogram.add(1.0);
+        histogram.add(5e3);
+
+        LogHistogram other(1e-3, 1e3, 5);
+        other.add(1.0);
+        histogram.merge(other);
+
+        EXPECT_EQ(histogram.Underflow, 1);
+        EXPECT_EQ(histogram.Overflow, 1);
+        EXPECT_EQ(histogram.Bins[0], 1);
+        EXPECT_EQ(histogram.Bins[15], 2);
+        EXPECT_NEAR(histogram.binLower(15), 1.0, 1e-12);
+    }
+
+
+    TEST(ENSEMBLETEST, TestStreamingTraceStatistics)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", fractures));
+
+        TraceStatistics serial;
+        TraceStatistics parallel;
+        collectTraceStatistics(fractures, serial, 1);
+        collectTraceStatistics(fractures, parallel, 3);
+        EXPECT_TRUE(fractures.Traces.empty());
+
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        TraceStatistics stored;
+        summarizeTraces(fractures, stored);
+
+        for (const TraceStatistics* streamed : {&serial, &parallel})
+        {
+            EXPECT_EQ(streamed->NumberTraces, fractures.Traces.size());
+            EXPECT_EQ(streamed->PassingEnds, stored.PassingEnds);
+            EXPECT_EQ(streamed->TracesPerFracture, stored.TracesPerFracture);
+            EXPECT_EQ(streamed->LengthHistogram.Bins, stored.LengthHistogram.Bins);
+            EXPECT_NEAR(streamed->Length.Mean, stored.Length.Mean, 1e-9 * stored.Length.Mean);
+            EXPECT_NEAR(streamed->p21(), stored.p21(), 1e-9 * stored.p21());
+        }
+        EXPECT_GT(stored.p32(), 0.0);
+    }
+}
+#endif
@@ -0,0 +1,108 @@
+#ifndef __TESTFILTERCASCADE_H
+#define __TESTFILTERCASCADE_H
+
+#include <gtest/gtest.h>
+#include <random>
+#include "FilterCascade.hpp"
+#include "Generator.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    // fractures squashed along one axis around their centroids, so that
+    // their planes are almost normal to it
+    Fractures orientedNetwork(unsigned int numberFractures, int axis, unsigned long long seed)
+    {
+        NetworkParameters parameters;
+        parameters.NumberFractures = numberFractures;
+        parameters.MinRadius = 0.02;
+        parameters.MaxRadius = 0.2;
+        Fractures fractures;
+        mt19937_64 generator(seed);
+        generateFractures(fractures, parameters, generator);
+        for (Matrix3Xd& vertices : fractures.FracturesVertices)
+        {
+            double centroid = vertices.row(axis).mean();
+            vertices.row(axis) = (vertices.row(axis).array() - centroid) * 0.02 + centroid;
+        }
+        return fractures;
+    }
+
+
+    TEST(FILTERCASCADETEST, TestSameTracesAsReference)
+    {
+        vector<Fractures> networks(3);
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", networks[0]));
+        networks[1] = orientedNetwork(300, 2, 5);
+        networks[2] = orientedNetwork(300, 0, 6);
+
+        for (const Fractures& network : networks)
+        {
+            Fractures reference = network;
+            map<int, vector<int>> referenceIntersections;
+            checkIntersections(reference, referenceIntersections);
+
+            for (bool adaptive : {false, true})
+            {
+                CascadeParameters parameters;
+                parameters.Adaptive = adaptive;
+                parameters.SamplePairs = 500;
+                Fractures fractures = network;
+                map<int, vector<int>> intersections;
+                CascadeStatistics statistics;
+                checkIntersectionsCascade(fractures, intersections, parameters, statistics);
+
+                expectSameTraces(fractures.Traces, reference.Traces);
+                EXPECT_EQ(intersections, referenceIntersections);
+                const double n = network.FracturesId.size();
+                EXPECT_EQ(statistics.Pairs, (unsigned long long)(n * (n - 1) / 2));
+            }
+        }
+    }
+
+
+    TEST(FILTERCASCADETEST, TestOrderFollowsOrientation)
+    {
+        // horizontal fractures overlap in XY far more often than in YZ or ZX
+        Fractures network = orientedNetwork(400, 2, 7);
+        const vector<Matrix3Xd>& vertices = network.FracturesVertices;
+
+        CascadeParameters parameters;
+        parameters.SamplePairs = 2000;
+        FilterCascade cascade(parameters);
+        CascadeParameters reference;
+        reference.Adaptive = false;
+        FilterCascade shortCircuit(reference);
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            for (size_t j = i + 1; j < vertices.size(); j++)
+            {
+                bool expected = fracturesIntersect(vertices[i], vertices[j]);
+                ASSERT_EQ(cascade.intersects(vertices[i], vertices[j]), expected);
+                ASSERT_EQ(shortCircuit.intersects(vertices[i], vertices[j]), expected);
+            }
+        }
+
+        const CascadeStatistics& statistics = cascade.statistics();
+        ASSERT_FALSE(cascade.order().empty());
+        EXPECT_NE(cascade.order().front(), CascadeFilter::ProjectionXY);
+        const CascadeFilterStatistics& xy = statistics.Filters[size_t(CascadeFilter::ProjectionXY)];
+        const CascadeFilterStatistics& yz = statistics.Filters[size_t(CascadeFilter::ProjectionYZ)];
+        EXPECT_EQ(xy.SampledPairs, parameters.SamplePairs);
+        EXPECT_LT(xy.SampledRejections, yz.SampledRejections);
+        ASSERT_EQ(cascade.order().size(), statistics.Filters.size());
+        const CascadeFilterStatistics& last = statistics.Filters[size_t(cascade.order().back())];
+        EXPECT_LT(last.Evaluated, statistics.Pairs);
+        EXPECT_EQ(statistics.Rejected, shortCircuit.statistics().Rejected);
+
+        vector<CascadeFilter> referenceOrder = {CascadeFilter::ProjectionXY, CascadeFilter::ProjectionYZ,
+                                                CascadeFilter::ProjectionZX, CascadeFilter::Separation};
+        EXPECT_EQ(shortCircuit.order(), referenceOrder);
+    }
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef __TESTFLOW_H
+#define __TESTFLOW_H
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include "Flow.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(FLOWTEST, TestChainOfFractures)
+    {
+        // four overlapping rectangles along x, plus one isolated fracture
+        Fractures fractures;
+        for (unsigned int k = 0; k < 5; k++)
+        {
+            Matrix3Xd rectangle(3, 4);
+            rectangle << k, k + 1.2, k + 1.2, k,
+                         0, 0, 0, 0,
+                         0, 0, 1, 1;
+            if (k == 4)
+            {
+                rectangle << 1.5, 2, 2, 1.5,
+                             0, 0, 0, 0,
+                             5, 5, 6, 6;
+            }
+            fractures.FracturesId.push_back(10 + k);
+            fractures.FracturesVertices.push_back(rectangle);
+        }
+        fractures.NumberFractures = 5;
+        for (int k = 0; k < 3; k++)
+        {
+            fractures.Traces.push_back(Trace(k, 10 + k, 11 + k, Point(k + 1.1, 0, 0),
+                                             Point(k + 1.1, 0, 1), false, false));
+        }
+
+        FlowParameters parameters;
+        parameters.NumberThreads = 2;
+        FlowSolution solution;
+        ASSERT_TRUE(solveFlow(fractures, parameters, solution));
+        EXPECT_EQ(solution.NumberUnknowns, 4);
+        EXPECT_EQ(solution.NumberPipes, 3);
+        EXPECT_TRUE(isnan(solution.Pressure[4]));
+
+        for (int k = 0; k < 3; k++)
+        {
+            EXPECT_GT(solution.Pressure[k], solution.Pressure[k + 1]);
+        }
+        EXPECT_LT(solution.Pressure[0], parameters.InletPressure);
+        EXPECT_GT(solution.Pressure[3], parameters.OutletPressure);
+        EXPECT_GT(solution.Inflow, 0.0);
+        EXPECT_NEAR(solution.Inflow, solution.Outflow, 1e-8 * solution.Inflow);
+        EXPECT_NEAR(solution.Pressure[1] + solution.Pressure[2], 1.0, 1e-8);
+    }
+
+
+    TEST(FLOWTEST, TestThreadsGiveSameSolution)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+
+        FlowParameters parameters;
+        parameters.NumberThreads = 1;
+        FlowSolution serial;
+        ASSERT_TRUE(solveFlow(fractures, parameters, serial));
+        EXPECT_GT(serial.NumberUnknowns, 0);
+
+        parameters.NumberThreads = 4;
+        FlowSolution parallel;
+        ASSERT_TRUE(solveFlow(fractures, parameters, parallel));
+        ASSERT_EQ(parallel.NumberUnknowns, serial.NumberUnknowns);
+        for (size_t i = 0; i < serial.Pressure.size(); i++)
+        {
+            if (isnan(serial.Pressure[i]))
+            {
+                EXPECT_TRUE(isnan(parallel.Pressure[i]));
+                continue;
+            }
+            EXPECT_NEAR(parallel.Pressure[i], serial.Pressure[i], 1e-8);
+        }
+        EXPECT_NEAR(serial.Inflow, serial.Outflow, 1e-6 * serial.Inflow);
+    }
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef __TESTFUZZ_H
+#define __TESTFUZZ_H
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include "Fuzz.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(FUZZTEST, TestPathsAgreeOnAdversarialPairs)
+    {
+        FuzzParameters parameters;
+        parameters.Seed = 2024;
+        parameters.NumberCases = 1500;
+        FuzzStatistics statistics;
+        bool agreed = runFuzz(parameters, defaultFuzzPaths(), statistics);
+
+        EXPECT_TRUE(agreed);
+        EXPECT_EQ(statistics.Cases, 1500u);
+        EXPECT_EQ(statistics.Disagreements, 0u);
+        EXPECT_GT(statistics.ReferenceIntersections, 0u);
+        EXPECT_LT(statistics.ReferenceIntersections, statistics.Cases);
+        for (unsigned long long cases : statistics.CasesOf)
+        {
+            EXPECT_EQ(cases, 300u);
+        }
+    }
+
+
+    TEST(FUZZTEST, TestReproducersOfAFaultyPath)
+    {
+        // a path that loses every intersection
+        FuzzPath faulty = {"faulty", [](const Matrix3Xd&, const Matrix3Xd&, const vector<Trace>& reference)
+        {
+            return reference.empty();
+        }};
+
+        FuzzParameters parameters;
+        parameters.NumberCases = 40;
+        parameters.Cases = {FuzzCase::Random};
+        parameters.MaxReproducers = 3;
+        parameters.OutputFolder = "fuzz_reproducers";
+        filesystem::remove_all(parameters.OutputFolder);
+        FuzzStatistics statistics;
+        EXPECT_FALSE(runFuzz(parameters, {faulty}, statistics));
+        EXPECT_EQ(statistics.Disagreements, statistics.ReferenceIntersections);
+        ASSERT_EQ(statistics.Reproducers.size(), 3u);
+
+        for (const FuzzDisagreement& found : statistics.Reproducers)
+        {
+            EXPECT_EQ(found.Path, "faulty");
+            EXPECT_LE(found.P.cols() + found.Q.cols(), found.OriginalVertices);
+
+            // the written pair reproduces the disagreement on its own
+            Fractures reproducer;
+            string file = parameters.OutputFolder + "/fuzz_faulty_" + to_string(found.CaseIndex) + ".txt";
+            ASSERT_TRUE(ImportFractures(file, reproducer));
+            ASSERT_EQ(reproducer.FracturesVertices.size(), 2u);
+            EXPECT_EQ(reproducer.FracturesVertices[0], found.P);
+            const Matrix3Xd& P = reproducer.FracturesVertices[0];
+            const Matrix3Xd& Q = reproducer.FracturesVertices[1];
+            EXPECT_FALSE(faulty.Agrees(P, Q, referencePairTraces(P, Q)));
+        }
+    }
+
+}
+
+#endif
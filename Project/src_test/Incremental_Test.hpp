@@ -0,0 +1,127 @@
+#ifndef __TESTINCREMENTAL_H
+#define __TESTINCREMENTAL_H
+
+#include <gtest/gtest.h>
+#include "Incremental.hpp"
+#include "SpatialIndex.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    void expectSameTraces(const vector<Trace>& actual, const vector<Trace>& expected)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t t = 0; t < actual.size(); t++)
+        {
+            EXPECT_EQ(actual[t].traceId, expected[t].traceId);
+            EXPECT_EQ(actual[t].fractureId1, expected[t].fractureId1);
+            EXPECT_EQ(actual[t].fractureId2, expected[t].fractureId2);
+            EXPECT_EQ(actual[t].p1.x, expected[t].p1.x);
+            EXPECT_EQ(actual[t].p2.z, expected[t].p2.z);
+            EXPECT_EQ(actual[t].Tips1, expected[t].Tips1);
+            EXPECT_EQ(actual[t].Tips2, expected[t].Tips2);
+        }
+    }
+
+
+    TEST(INCREMENTALTEST, TestSpatialGridQuery)
+    {
+        SpatialGrid grid(0.5);
+        BoundingBox a(Vector3d(0, 0, 0), Vector3d(0.2, 0.2, 0.2));
+        BoundingBox b(Vector3d(0.9, 0.9, 0.9), Vector3d(1.4, 1.1, 1.0));
+        grid.insert(1, a);
+        grid.insert(2, b);
+
+        vector<unsigned int> items;
+        grid.query(BoundingBox(Vector3d(1.2, 1.0, 0.95), Vector3d(1.3, 1.05, 0.99)), items);
+        ASSERT_EQ(items.size(), 1);
+        EXPECT_EQ(items[0], 2);
+
+        grid.remove(2, b);
+        grid.query(BoundingBox(Vector3d(-1, -1, -1), Vector3d(2, 2, 2)), items);
+        ASSERT_EQ(items.size(), 1);
+        EXPECT_EQ(items[0], 1);
+    }
+
+
+    TEST(INCREMENTALTEST, TestAddMatchesFullRecomputation)
+    {
+        Fractures full;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", full));
+        map<int, vector<int>> fullIntersections;
+        checkIntersections(full, fullIntersections);
+
+        const size_t added = 6;
+        Fractures fractures;
+        fractures.FracturesId.assign(full.FracturesId.begin(), full.FracturesId.end() - added);
+        fractures.FracturesVertices.assign(full.FracturesVertices.begin(), full.FracturesVertices.end() - added);
+        fractures.NumberFractures = fractures.FracturesId.size();
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+
+        IncrementalDFN dfn(fractures, intersections);
+        int firstNewId = dfn.nextTraceId();
+        vector<int> newTraces;
+        for (size_t k = full.FracturesId.size() - added; k < full.FracturesId.size(); k++)
+        {
+            ASSERT_TRUE(dfn.addFracture(full.FracturesId[k], full.FracturesVertices[k], newTraces));
+            for (int traceId : newTraces)
+            {
+                EXPECT_GE(traceId, firstNewId);
+            }
+        }
+        EXPECT_FALSE(dfn.addFracture(full.FracturesId[0], full.FracturesVertices[0], newTraces));
+        EXPECT_LT(dfn.testedPairs(), added * full.FracturesId.size());
+
+        EXPECT_EQ(intersections, fullIntersections);
+        dfn.compactTraceIds();
+        expectSameTraces(fractures.Traces, full.Traces);
+    }
+
+
+    TEST(INCREMENTALTEST, TestRemoveKeepsIdsStable)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR10_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+
+        const int removed = 3;
+        Fractures reference;
+        for (size_t i = 0; i < fractures.FracturesId.size(); i++)
+        {
+            if (int(fractures.FracturesId[i]) != removed)
+            {
+                reference.FracturesId.push_back(fractures.FracturesId[i]);
+                reference.FracturesVertices.push_back(fractures.FracturesVertices[i]);
+            }
+        }
+        reference.NumberFractures = reference.FracturesId.size();
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        vector<Trace> kept;
+        for (const auto& trace : fractures.Traces)
+        {
+            if (trace.fractureId1 != removed && trace.fractureId2 != removed)
+            {
+                kept.push_back(trace);
+            }
+        }
+
+        IncrementalDFN dfn(fractures, intersections);
+        ASSERT_TRUE(dfn.removeFracture(removed));
+        EXPECT_FALSE(dfn.removeFracture(removed));
+
+        expectSameTraces(fractures.Traces, kept);
+        EXPECT_EQ(intersections, referenceIntersections);
+
+        map<int, int> renumbering = dfn.compactTraceIds();
+        EXPECT_EQ(renumbering.size(), kept.size());
+        expectSameTraces(fractures.Traces, reference.Traces);
+    }
+}
+#endif
@@ -0,0 +1,92 @@
+#ifndef __TESTLAZYTRACES_H
+#define __TESTLAZYTRACES_H
+
+#include <gtest/gtest.h>
+#include "LazyTraces.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(LAZYTRACESTEST, TestMatchesCheckIntersections)
+    {
+        Fractures reference;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", reference));
+        LazyTraceNetwork network(reference);
+
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        map<int, vector<int>> intersections;
+        network.adjacency(intersections);
+        EXPECT_EQ(intersections, referenceIntersections);
+        EXPECT_EQ(network.evaluatedTraces(), 0);
+
+        const Trace& last = reference.Traces.back();
+        const Trace* lazy = network.trace(last.fractureId2, last.fractureId1);
+        ASSERT_NE(lazy, nullptr);
+        EXPECT_EQ(lazy->p1.x, last.p1.x);
+        EXPECT_EQ(lazy->length, last.length);
+        EXPECT_EQ(network.evaluatedTraces(), 1);
+        EXPECT_EQ(network.trace(last.fractureId1, last.fractureId2), lazy);
+        EXPECT_EQ(network.evaluatedTraces(), 1);
+
+        vector<Trace> traces;
+        network.materialize(traces);
+        expectSameTraces(traces, reference.Traces);
+        EXPECT_EQ(network.evaluatedTraces(), network.numberPairs());
+    }
+
+
+    TEST(LAZYTRACESTEST, TestRegionOfInterest)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", fractures));
+        map<int, vector<int>> referenceIntersections;
+        Fractures reference = fractures;
+        checkIntersections(reference, referenceIntersections);
+
+        BoundingBox domain;
+        for (const Matrix3Xd& vertices : fractures.FracturesVertices)
+        {
+            domain.expand(computeBoundingBox(vertices));
+        }
+
+        LazyParameters parameters;
+        parameters.UseRegion = true;
+        parameters.Region = BoundingBox(domain.Min, 0.5 * (domain.Min + domain.Max));
+        LazyTraceNetwork network(fractures, parameters);
+        EXPECT_LT(network.numberSelected(), fractures.FracturesVertices.size());
+
+        // exactly the reference pairs whose fractures both touch the region
+        BoundingBox region = parameters.Region;
+        region.inflate(epsilon);
+        map<int, bool> inside;
+        for (size_t i = 0; i < fractures.FracturesId.size(); i++)
+        {
+            inside[fractures.FracturesId[i]] = computeBoundingBox(fractures.FracturesVertices[i]).overlaps(region);
+        }
+        size_t expectedPairs = 0;
+        for (const Trace& trace : reference.Traces)
+        {
+            expectedPairs += inside[trace.fractureId1] && inside[trace.fractureId2];
+        }
+
+        map<int, vector<int>> intersections;
+        network.adjacency(intersections);
+        size_t pairs = 0;
+        for (const auto& entry : intersections)
+        {
+            ASSERT_TRUE(inside[entry.first]);
+            pairs += entry.second.size();
+        }
+        EXPECT_EQ(pairs / 2, network.numberPairs());
+        EXPECT_EQ(network.numberPairs(), expectedPairs);
+        EXPECT_GT(network.numberPairs(), 0);
+    }
+
+}
+
+#endif
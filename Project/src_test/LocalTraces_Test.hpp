@@ -0,0 +1,125 @@
+#ifndef __TESTLOCALTRACES_H
+#define __TESTLOCALTRACES_H
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include "LocalTraces.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(LOCALTRACESTEST, TestFrameRoundTrip)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        ASSERT_FALSE(fractures.Traces.empty());
+
+        vector<LocalFracture> local;
+        computeLocalTraces(fractures, local, 4);
+        ASSERT_EQ(local.size(), fractures.FracturesId.size());
+
+        size_t numberTraces = 0;
+        for (size_t i = 0; i < local.size(); i++)
+        {
+            const LocalFracture& fracture = local[i];
+            const LocalFrame& frame = fracture.Frame;
+            EXPECT_EQ(fracture.Id, fractures.FracturesId[i]);
+            EXPECT_NEAR(frame.U.norm(), 1.0, 1e-12);
+            EXPECT_NEAR(frame.V.norm(), 1.0, 1e-12);
+            EXPECT_NEAR(frame.U.dot(frame.V), 0.0, 1e-12);
+            EXPECT_NEAR(frame.U.dot(frame.Normal), 0.0, 1e-12);
+
+            const Matrix3Xd& vertices = fractures.FracturesVertices[i];
+            for (Index c = 0; c < vertices.cols(); c++)
+            {
+                EXPECT_LT((frame.toGlobal(fracture.Vertices.col(c)) - vertices.col(c)).norm(), 1e-9);
+            }
+
+            // endpoints come back up to their distance from the plane
+            for (const LocalTrace& projected : fracture.Traces)
+            {
+                const Trace& trace = fractures.Traces[projected.TraceId];
+                ASSERT_EQ(trace.traceId, projected.TraceId);
+                bool first = trace.fractureId1 == int(fracture.Id);
+                for (const auto& endpoint : {make_pair(trace.p1, projected.P1), make_pair(trace.p2, projected.P2)})
+                {
+                    Vector3d p(endpoint.first.x, endpoint.first.y, endpoint.first.z);
+                    Vector3d height = frame.Normal * frame.Normal.dot(p - frame.Origin);
+                    EXPECT_LT((frame.toGlobal(endpoint.second) + height - p).norm(), 1e-9);
+                }
+                EXPECT_EQ(projected.Tips, first ? trace.Tips1 : trace.Tips2);
+            }
+            numberTraces += fracture.Traces.size();
+        }
+        EXPECT_EQ(numberTraces, 2 * fractures.Traces.size());
+    }
+
+
+    TEST(LOCALTRACESTEST, TestParallelAndBinaryMatchSerialText)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+
+        vector<LocalFracture> serial, parallel;
+        computeLocalTraces(fractures, serial, 1);
+        computeLocalTraces(fractures, parallel, 4);
+
+        ostringstream serialText, parallelText;
+        writeLocalTraces(serialText, serial);
+        writeLocalTraces(parallelText, parallel);
+        EXPECT_EQ(serialText.str(), parallelText.str());
+
+        stringstream binary(ios::in | ios::out | ios::binary);
+        writeLocalTracesBinary(binary, parallel);
+        vector<LocalFracture> read;
+        ASSERT_TRUE(readLocalTracesBinary(binary, read));
+        ostringstream readText;
+        writeLocalTraces(readText, read);
+        EXPECT_EQ(readText.str(), serialText.str());
+
+        istringstream truncated(binary.str().substr(0, binary.str().size() / 2), ios::binary);
+        EXPECT_FALSE(readLocalTracesBinary(truncated, read));
+
+        // counts far beyond the stream are refused before allocating
+        ostringstream corrupt(ios::binary);
+        corrupt.write("DFNL", 4);
+        const uint64_t numberFractures = 1;
+        corrupt.write(reinterpret_cast<const char*>(&numberFractures), sizeof(numberFractures));
+        for (uint32_t value : {uint32_t(7), uint32_t(0xffffffff), uint32_t(0xffffffff)})
+        {
+            corrupt.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        const double frame[9] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+        corrupt.write(reinterpret_cast<const char*>(frame), sizeof(frame));
+        istringstream huge(corrupt.str(), ios::binary);
+        EXPECT_FALSE(readLocalTracesBinary(huge, read));
+    }
+
+
+    TEST(LOCALTRACESTEST, TestFrameOfCollinearFirstVertices)
+    {
+        // a tilted rectangle with its second vertex on the first edge
+        Matrix3Xd vertices(3, 5);
+        vertices << 0, 1, 2, 2, 0,
+                    0, 0, 0, 1, 1,
+                    0, 1, 2, 2, 0;
+        LocalFrame frame = fractureFrame(vertices);
+        Vector3d normal = Vector3d(1, 0, -1).normalized();
+        EXPECT_NEAR(abs(frame.Normal.dot(normal)), 1.0, 1e-12);
+        for (Index c = 0; c < vertices.cols(); c++)
+        {
+            Vector2d local = frame.toLocal(vertices.col(c));
+            EXPECT_LT((frame.toGlobal(local) - vertices.col(c)).norm(), 1e-12);
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef __TESTMULTIPROCESS_H
+#define __TESTMULTIPROCESS_H
+
+#include <gtest/gtest.h>
+#include "Multiprocess.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    void expectSameNetworkResults(const string& filename, unsigned int workers, size_t maxRecords)
+    {
+        Fractures reference, fractures;
+        ASSERT_TRUE(ImportFractures(filename, reference));
+        ASSERT_TRUE(ImportFractures(filename, fractures));
+        map<int, vector<int>> referenceIntersections, intersections;
+        checkIntersections(reference, referenceIntersections);
+
+        DecompositionParameters parameters;
+        parameters.NumberWorkers = workers;
+        parameters.MaxRecordsPerWorker = maxRecords;
+        DecompositionStatistics statistics;
+        ASSERT_TRUE(checkIntersectionsMultiprocess(fractures, intersections, parameters, statistics));
+
+        EXPECT_EQ(statistics.NumberWorkers, workers);
+        EXPECT_EQ(intersections, referenceIntersections);
+        ASSERT_EQ(fractures.Traces.size(), reference.Traces.size());
+        for (size_t t = 0; t < reference.Traces.size(); t++)
+        {
+            EXPECT_EQ(fractures.Traces[t].traceId, reference.Traces[t].traceId);
+            EXPECT_EQ(fractures.Traces[t].fractureId1, reference.Traces[t].fractureId1);
+            EXPECT_EQ(fractures.Traces[t].fractureId2, reference.Traces[t].fractureId2);
+            EXPECT_EQ(fractures.Traces[t].p1.y, reference.Traces[t].p1.y);
+            EXPECT_EQ(fractures.Traces[t].length, reference.Traces[t].length);
+            EXPECT_EQ(fractures.Traces[t].Tips2, reference.Traces[t].Tips2);
+        }
+    }
+
+
+    TEST(MULTIPROCESSTEST, TestWorkersMatchSerial)
+    {
+        expectSameNetworkResults("DFN/FR50_data.txt", 3, 0);
+        expectSameNetworkResults("DFN/FR200_data.txt", 4, 0);
+    }
+
+
+    TEST(MULTIPROCESSTEST, TestOverflowFallsBackInProcess)
+    {
+        expectSameNetworkResults("DFN/FR50_data.txt", 2, 5);
+    }
+}
+#endif
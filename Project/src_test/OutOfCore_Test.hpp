@@ -0,0 +1,136 @@
+#ifndef __TESTOUTOFCORE_H
+#define __TESTOUTOFCORE_H
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "Generator.hpp"
+#include "OutOfCore.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    vector<string> readLines(const string& filename)
+    {
+        vector<string> lines;
+        ifstream file(filename);
+        string line;
+        while (getline(file, line))
+        {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+
+
+    TEST(OUTOFCORETEST, TestFractureReader)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR10_data.txt", fractures));
+
+        FractureReader reader("DFN/FR10_data.txt");
+        ASSERT_TRUE(reader.good());
+        EXPECT_EQ(reader.declaredFractures(), 10);
+
+        unsigned int id;
+        Matrix3Xd vertices;
+        size_t count = 0;
+        while (reader.next(id, vertices))
+        {
+            EXPECT_EQ(id, fractures.FracturesId[count]);
+            EXPECT_EQ(vertices, fractures.FracturesVertices[count]);
+            count++;
+        }
+        EXPECT_TRUE(reader.good());
+        EXPECT_EQ(count, 10);
+    }
+
+
+    TEST(OUTOFCORETEST, TestTiledOutputMatchesInMemory)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        writeTraces(fractures, "test_memory_traces.txt");
+        writeResults(fractures, "test_memory_results.txt");
+
+        TilingParameters parameters;
+        parameters.TilesPerAxis = 4;
+        TilingStatistics statistics;
+        ASSERT_TRUE(processOutOfCore("DFN/FR50_data.txt", "test_tiled_traces.txt",
+                                     "test_tiled_results.txt", parameters, statistics));
+
+        EXPECT_EQ(statistics.NumberFractures, 50);
+        EXPECT_EQ(statistics.NumberTraces, fractures.Traces.size());
+        EXPECT_GT(statistics.DuplicatedFractures, 0);
+        EXPECT_LT(statistics.MaxTileFractures, 50);
+
+        EXPECT_EQ(readLines("test_tiled_traces.txt"), readLines("test_memory_traces.txt"));
+
+        // traces of equal length may be listed in a different order
+        vector<string> tiled = readLines("test_tiled_results.txt");
+        vector<string> memory = readLines("test_memory_results.txt");
+        sort(tiled.begin(), tiled.end());
+        sort(memory.begin(), memory.end());
+        EXPECT_EQ(tiled, memory);
+
+        remove("test_memory_traces.txt");
+        remove("test_memory_results.txt");
+        remove("test_tiled_traces.txt");
+        remove("test_tiled_results.txt");
+    }
+
+
+    TEST(OUTOFCORETEST, TestSkewedDensityStaysInBudget)
+    {
+        // most fractures in one small cluster, so that one tile holds them all
+        mt19937_64 generator(3);
+        Fractures cluster, spread;
+        NetworkParameters parameters;
+        parameters.NumberFractures = 360;
+        parameters.DomainSize = 0.05;
+        parameters.MinRadius = 0.005;
+        parameters.MaxRadius = 0.02;
+        generateFractures(cluster, parameters, generator);
+        parameters = NetworkParameters();
+        parameters.NumberFractures = 40;
+        generateFractures(spread, parameters, generator);
+
+        Fractures fractures = cluster;
+        fractures.FracturesVertices.insert(fractures.FracturesVertices.end(), spread.FracturesVertices.begin(),
+                                           spread.FracturesVertices.end());
+        fractures.NumberFractures = fractures.FracturesVertices.size();
+        fractures.FracturesId.clear();
+        for (unsigned int i = 0; i < fractures.NumberFractures; i++)
+        {
+            fractures.FracturesId.push_back(i);
+        }
+        ASSERT_TRUE(writeFractures(fractures, "test_skewed_data.txt"));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        writeTraces(fractures, "test_skewed_memory_traces.txt");
+
+        TilingParameters tiling;
+        tiling.MemoryBudget = size_t(64) << 10;
+        TilingStatistics statistics;
+        ASSERT_TRUE(processOutOfCore("test_skewed_data.txt", "test_skewed_traces.txt",
+                                     "test_skewed_results.txt", tiling, statistics));
+
+        EXPECT_GT(statistics.SplitTiles, 0);
+        EXPECT_GE(statistics.MaxTileFractures, 360);
+        EXPECT_LT(statistics.MaxResidentFractures, statistics.MaxTileFractures / 2);
+        EXPECT_EQ(statistics.NumberTraces, fractures.Traces.size());
+        EXPECT_GT(statistics.NumberTraces, 0);
+        EXPECT_EQ(readLines("test_skewed_traces.txt"), readLines("test_skewed_memory_traces.txt"));
+
+        remove("test_skewed_data.txt");
+        remove("test_skewed_memory_traces.txt");
+        remove("test_skewed_traces.txt");
+        remove("test_skewed_results.txt");
+    }
+}
+#endif
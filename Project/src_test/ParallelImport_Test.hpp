@@ -0,0 +1,113 @@
+#ifndef __TESTPARALLELIMPORT_H
+#define __TESTPARALLELIMPORT_H
+
+#include <gtest/gtest.h>
+#include <random>
+#include "Generator.hpp"
+#include "ParallelImport.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    void expectSameFractures(const Fractures& expected, const Fractures& actual)
+    {
+        ASSERT_EQ(actual.NumberFractures, expected.NumberFractures);
+        ASSERT_EQ(actual.FracturesId, expected.FracturesId);
+        ASSERT_EQ(actual.FracturesVertices.size(), expected.FracturesVertices.size());
+        for (size_t i = 0; i < expected.FracturesVertices.size(); i++)
+        {
+            ASSERT_EQ(actual.FracturesVertices[i].cols(), expected.FracturesVertices[i].cols());
+            EXPECT_TRUE(actual.FracturesVertices[i] == expected.FracturesVertices[i]);
+        }
+    }
+
+
+    TEST(PARALLELIMPORTTEST, TestBundledFilesMatchSerial)
+    {
+        vector<string> files = {"DFN/FR3_data.txt", "DFN/FR10_data.txt", "DFN/FR50_data.txt",
+                                "DFN/FR82_data.txt", "DFN/FR200_data.txt", "DFN/FR362_data.txt"};
+
+        for (const string& file : files)
+        {
+            Fractures serial;
+            ASSERT_TRUE(ImportFractures(file, serial));
+
+            for (unsigned int threads : {1u, 3u, 8u})
+            {
+                Fractures parallel;
+                ASSERT_TRUE(ImportFracturesParallel(file, parallel, threads));
+                expectSameFractures(serial, parallel);
+            }
+        }
+    }
+
+
+    TEST(PARALLELIMPORTTEST, TestGeneratedFileMatchesSerial)
+    {
+        Fractures generated;
+        NetworkParameters parameters;
+        parameters.NumberFractures = 2000;
+        parameters.NumberVertices = 7;
+        mt19937_64 generator(5);
+        generateFractures(generated, parameters, generator);
+        ASSERT_TRUE(writeFractures(generated, "test_parallel_import.txt"));
+
+        Fractures serial;
+        Fractures parallel;
+        ASSERT_TRUE(ImportFractures("test_parallel_import.txt", serial));
+        ASSERT_TRUE(ImportFracturesParallel("test_parallel_import.txt", parallel, 4));
+        expectSameFractures(serial, parallel);
+        EXPECT_EQ(parallel.FracturesVertices.size(), 2000);
+    }
+
+
+    TEST(PARALLELIMPORTTEST, TestMissingMarker)
+    {
+        // the marker comment of one fracture, and with it the chunk count, is gone
+        ifstream original("DFN/FR50_data.txt");
+        ostringstream content;
+        content << original.rdbuf();
+        string text = content.str();
+        size_t marker = text.find("# FractureId", text.size() / 2);
+        ASSERT_NE(marker, string::npos);
+        size_t markerLength = text.find('\n', marker) + 1 - marker;
+        string missing = text;
+        missing.erase(marker, markerLength);
+
+        // the same count of markers, one of them doubled up elsewhere
+        string moved = missing;
+        size_t other = moved.find("# FractureId", moved.size() / 4);
+        moved.insert(other, text.substr(marker, markerLength));
+
+        for (const string& variant : {missing, moved})
+        {
+            {
+                ofstream unmarked("test_missing_marker.txt");
+                unmarked << variant;
+            }
+
+            Fractures serial;
+            ASSERT_TRUE(ImportFractures("test_missing_marker.txt", serial));
+            EXPECT_EQ(serial.FracturesId.size(), 50u);
+            for (unsigned int threads : {1u, 3u, 8u})
+            {
+                Fractures parallel;
+                ASSERT_TRUE(ImportFracturesParallel("test_missing_marker.txt", parallel, threads));
+                expectSameFractures(serial, parallel);
+            }
+        }
+    }
+
+
+    TEST(PARALLELIMPORTTEST, TestMissingFile)
+    {
+        Fractures fractures;
+        EXPECT_FALSE(ImportFracturesParallel("DFN/missing_data.txt", fractures, 2));
+    }
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef __TESTPARAVIEWEXPORT_H
+#define __TESTPARAVIEWEXPORT_H
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "ParaviewExport.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    string readFile(const string& filename)
+    {
+        ifstream file(filename, ios::binary);
+        return string(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    }
+
+    size_t countOf(const string& text, const string& pattern)
+    {
+        size_t count = 0;
+        for (size_t at = text.find(pattern); at != string::npos; at = text.find(pattern, at + 1))
+        {
+            count++;
+        }
+        return count;
+    }
+
+    // values of an ascii data array of a .vtu file
+    vector<double> asciiArray(const string& text, const string& name)
+    {
+        size_t begin = text.find('>', text.find("Name=\"" + name + "\"")) + 1;
+        istringstream values(text.substr(begin, text.find("</DataArray>", begin) - begin));
+        return vector<double>(istream_iterator<double>(values), istream_iterator<double>());
+    }
+
+
+    TEST(PARAVIEWEXPORTTEST, TestShardsCoverNetwork)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+
+        ShardParameters parameters;
+        parameters.Folder = "test_paraview";
+        parameters.Name = "fr50";
+        parameters.NumberShards = 4;
+        parameters.Encoding = VtkEncoding::Ascii;
+        ShardStatistics statistics;
+        ASSERT_TRUE(exportNetworkParaview(fractures, intersections, parameters, statistics));
+        EXPECT_EQ(statistics.Shards, 8u);
+        EXPECT_EQ(statistics.Cells, fractures.FracturesId.size() + fractures.Traces.size());
+
+        string collection = readFile("test_paraview/fr50.pvd");
+        EXPECT_EQ(countOf(collection, "<DataSet "), 2u);
+        EXPECT_EQ(countOf(readFile("test_paraview/fr50_fractures.pvtu"), "<Piece "), 4u);
+        EXPECT_EQ(countOf(readFile("test_paraview/fr50_traces.pvtu"), "<Piece "), 4u);
+
+        vector<double> ids;
+        size_t numberTraces = 0;
+        for (int s = 0; s < 4; s++)
+        {
+            string fracturesShard = readFile("test_paraview/fr50_fractures_" + to_string(s) + ".vtu");
+            vector<double> shardIds = asciiArray(fracturesShard, "FractureId");
+            ids.insert(ids.end(), shardIds.begin(), shardIds.end());
+            EXPECT_EQ(asciiArray(fracturesShard, "ClusterId").size(), shardIds.size());
+
+            string tracesShard = readFile("test_paraview/fr50_traces_" + to_string(s) + ".vtu");
+            numberTraces += asciiArray(tracesShard, "TraceId").size();
+            EXPECT_EQ(asciiArray(tracesShard, "Tips").size(), 2 * asciiArray(tracesShard, "TraceId").size());
+        }
+        sort(ids.begin(), ids.end());
+        vector<double> expected(fractures.FracturesId.begin(), fractures.FracturesId.end());
+        sort(expected.begin(), expected.end());
+        EXPECT_EQ(ids, expected);
+        EXPECT_EQ(numberTraces, fractures.Traces.size());
+
+        filesystem::remove_all(parameters.Folder);
+    }
+
+
+    TEST(PARAVIEWEXPORTTEST, TestShardsAreSpatiallyCoherent)
+    {
+        // a 16 x 16 grid of unit squares, four shards are its four quadrants
+        const unsigned int n = 16;
+        MatrixXd points(3, 4 * n * n);
+        vector<vector<unsigned int>> cells;
+        vector<double> index;
+        for (unsigned int i = 0; i < n; i++)
+        {
+            for (unsigned int j = 0; j < n; j++)
+            {
+                unsigned int c = cells.size();
+                points.middleCols(4 * c, 4) << i, i + 1, i + 1, i,
+                                                j, j, j + 1, j + 1,
+                                                0, 0, 0, 0;
+                cells.push_back({4 * c, 4 * c + 1, 4 * c + 2, 4 * c + 3});
+                index.push_back(c);
+            }
+        }
+        vector<Gedim::UCDProperty<double>> properties = {{"Index", "-", (unsigned int)cells.size(), 1, index.data()}};
+
+        ShardParameters parameters;
+        parameters.Folder = "test_paraview";
+        parameters.Name = "grid";
+        parameters.NumberShards = 4;
+        parameters.Encoding = VtkEncoding::Ascii;
+        ShardStatistics ascii;
+        ASSERT_TRUE(exportShardedCells(points, cells, properties, parameters, ascii));
+        for (int s = 0; s < 4; s++)
+        {
+            vector<double> coordinates = asciiArray(readFile("test_paraview/grid_" + to_string(s) + ".vtu"), "Points");
+            ASSERT_EQ(coordinates.size(), 3u * 4 * n * n / 4);
+            Map<Matrix3Xd> shard(coordinates.data(), 3, coordinates.size() / 3);
+            EXPECT_LE(shard.row(0).maxCoeff() - shard.row(0).minCoeff(), n / 2.0);
+            EXPECT_LE(shard.row(1).maxCoeff() - shard.row(1).minCoeff(), n / 2.0);
+        }
+
+        filesystem::copy_file("test_paraview/grid_0.vtu", "test_paraview/grid_0.vtu.ascii");
+        parameters.Encoding = VtkEncoding::Raw;
+        ShardStatistics raw;
+        ASSERT_TRUE(exportShardedCells(points, cells, properties, parameters, raw));
+        EXPECT_EQ(raw.Cells, ascii.Cells);
+        EXPECT_EQ(raw.Points, ascii.Points);
+        string shard = readFile("test_paraview/grid_0.vtu");
+        size_t data = shard.find('_', shard.find("<AppendedData")) + 1;
+        uint64_t bytes = 0;
+        memcpy(&bytes, shard.data() + data, sizeof(uint64_t));
+        ASSERT_EQ(bytes, raw.Points / 4 * 3 * sizeof(double));
+        vector<double> coordinates(bytes / sizeof(double));
+        memcpy(coordinates.data(), shard.data() + data + sizeof(uint64_t), bytes);
+        EXPECT_EQ(coordinates, asciiArray(readFile("test_paraview/grid_0.vtu.ascii"), "Points"));
+
+        properties[0].Size = cells.size() - 1;
+        EXPECT_FALSE(exportShardedCells(points, cells, properties, parameters, raw));
+
+        filesystem::remove_all(parameters.Folder);
+    }
+
+}
+
+#endif
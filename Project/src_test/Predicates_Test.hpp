@@ -0,0 +1,126 @@
+#ifndef __TESTPREDICATES_H
+#define __TESTPREDICATES_H
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include "Predicates.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(PREDICATESTEST, TestOrient2dNearDegenerate)
+    {
+        // points perturbed by ulps around the line y = x through (12, 12) and (24, 24)
+        const double ulp = ldexp(1.0, -53);
+        resetPredicateStatistics();
+        for (int i = 0; i < 16; i++)
+        {
+            for (int j = 0; j < 16; j++)
+            {
+                double px = 0.5 + i * ulp;
+                double py = 0.5 + j * ulp;
+                int expected = (j > i) - (j < i);
+                ASSERT_EQ(orient2d(px, py, 12.0, 12.0, 24.0, 24.0), expected);
+            }
+        }
+        PredicateStatistics statistics = predicateStatistics();
+        EXPECT_EQ(statistics.Orient2dCalls, 256);
+        EXPECT_GT(statistics.Orient2dFallbacks, 0);
+        EXPECT_EQ(orient2d(0.0, 0.0, 1.0, 0.0, 0.0, 1.0), 1);
+        EXPECT_EQ(orient2d(0.0, 0.0, 0.0, 1.0, 1.0, 0.0), -1);
+    }
+
+
+    TEST(PREDICATESTEST, TestOrient3dNearDegenerate)
+    {
+        // points perturbed by ulps around the plane z = x
+        const double ulp = ldexp(1.0, -53);
+        Vector3d a(12.0, 0.0, 12.0);
+        Vector3d b(24.0, 0.0, 24.0);
+        Vector3d c(0.0, 1.0, 0.0);
+        int above = orient3d(a, b, c, Vector3d(0.0, 0.0, 1.0));
+        ASSERT_NE(above, 0);
+
+        for (int i = 0; i < 16; i++)
+        {
+            for (int j = 0; j < 16; j++)
+            {
+                Vector3d d(0.5 + i * ulp, 0.3, 0.5 + j * ulp);
+                int expected = above * ((j > i) - (j < i));
+                ASSERT_EQ(orient3d(a, b, c, d), expected);
+            }
+        }
+    }
+
+
+    TEST(PREDICATESTEST, TestFracturesIntersectExact)
+    {
+        Matrix3Xd square(3, 4);
+        square << 0, 1, 1, 0,
+                  0, 0, 1, 1,
+                  0, 0, 0, 0;
+
+        Matrix3Xd crossing(3, 4);
+        crossing << 0.5, 0.5, 0.5, 0.5,
+                    -0.5, 1.5, 1.5, -0.5,
+                    -0.5, -0.5, 0.5, 0.5;
+
+        Matrix3Xd above = crossing;
+        above.row(2).array() += 0.5 + 1e-12;
+
+        Matrix3Xd touching = crossing;
+        touching.row(2).array() += 0.5;
+
+        EXPECT_TRUE(fracturesIntersectExact(square, crossing));
+        EXPECT_FALSE(fracturesIntersectExact(square, above));
+        EXPECT_TRUE(fracturesIntersectExact(square, touching));
+
+        // the same configuration at kilometre scale, far from the origin
+        Matrix3Xd shiftedSquare = square * 1000.0;
+        Matrix3Xd shiftedAbove = above * 1000.0;
+        shiftedSquare.colwise() += Vector3d(5e5, 5e5, 2e3);
+        shiftedAbove.colwise() += Vector3d(5e5, 5e5, 2e3);
+        EXPECT_FALSE(fracturesIntersectExact(shiftedSquare, shiftedAbove));
+
+        Matrix3Xd coplanar = square;
+        coplanar.row(0).array() += 0.5;
+        EXPECT_TRUE(fracturesIntersectExact(square, coplanar));
+        coplanar.row(0).array() += 1.0;
+        EXPECT_FALSE(fracturesIntersectExact(square, coplanar));
+    }
+
+
+    TEST(PREDICATESTEST, TestExactPipeline)
+    {
+        // the tolerant projections and the exact test disagree near contact,
+        // so the exact pipeline is checked against the exact test pair by pair
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersectionsExact(fractures, intersections);
+        for (size_t i = 0; i < fractures.FracturesId.size(); i++)
+        {
+            for (size_t j = i + 1; j < fractures.FracturesId.size(); j++)
+            {
+                const vector<int>& found = intersections[int(fractures.FracturesId[i])];
+                bool listed = find(found.begin(), found.end(), int(fractures.FracturesId[j])) != found.end();
+                EXPECT_EQ(listed, fracturesIntersectExact(fractures.FracturesVertices[i], fractures.FracturesVertices[j]));
+            }
+        }
+
+        // a point exactly on an edge, where the distance test rounds above epsilon
+        Matrix3Xd triangle(3, 3);
+        triangle << 27100000, 27232432, 27100000,
+                    49700000, 49755180, 49700000,
+                    69800000, 69981560, 69900000;
+        EXPECT_TRUE(isPointOnEdges(triangle, Vector3d(27201556, 49742315, 69939230)));
+        EXPECT_FALSE(isPointOnEdges(triangle, Vector3d(27201556, 49742315, 69939231)));
+    }
+
+}
+
+#endif
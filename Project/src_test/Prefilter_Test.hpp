@@ -0,0 +1,98 @@
+#ifndef __TESTPREFILTER_H
+#define __TESTPREFILTER_H
+
+#include <gtest/gtest.h>
+#include <random>
+#include "Generator.hpp"
+#include "Predicates.hpp"
+#include "Prefilter.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    // every pair rejected by the prefilter must be disjoint for the exact test
+    void expectConservative(const Fractures& fractures, const PrefilterParameters& parameters)
+    {
+        ConservativePrefilter prefilter(fractures, parameters);
+        const vector<Matrix3Xd>& vertices = fractures.FracturesVertices;
+        vector<char> survivors;
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            prefilter.candidates(i, survivors);
+            for (size_t j = i + 1; j < vertices.size(); j++)
+            {
+                ASSERT_EQ(survivors[j] != 0, prefilter.mayIntersect(i, j));
+                if (!survivors[j])
+                {
+                    ASSERT_FALSE(fracturesIntersectExact(vertices[i], vertices[j])) << i << " " << j;
+                    ASSERT_FALSE(!parameters.UsePlanes && fracturesIntersect(vertices[i], vertices[j]));
+                }
+            }
+        }
+        EXPECT_GT(prefilter.statistics().rejectionRate(), 0.0);
+    }
+
+
+    TEST(PREFILTERTEST, TestNeverRejectsIntersectingPairs)
+    {
+        vector<Fractures> networks(4);
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", networks[0]));
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", networks[1]));
+
+        NetworkParameters parameters;
+        parameters.NumberFractures = 300;
+        mt19937_64 generator(11);
+        generateFractures(networks[2], parameters, generator);
+
+        // kilometre scale network far from the origin
+        generateFractures(networks[3], parameters, generator);
+        for (Matrix3Xd& vertices : networks[3].FracturesVertices)
+        {
+            vertices = (vertices * 2000.0).colwise() + Vector3d(4e5, -7e5, 1e3);
+        }
+
+        for (const Fractures& network : networks)
+        {
+            for (PrefilterPrecision precision : {PrefilterPrecision::Float, PrefilterPrecision::Quantized16})
+            {
+                for (bool planes : {false, true})
+                {
+                    PrefilterParameters filter;
+                    filter.Precision = precision;
+                    filter.UsePlanes = planes;
+                    expectConservative(network, filter);
+                }
+            }
+        }
+    }
+
+
+    TEST(PREFILTERTEST, TestBoxStageKeepsReferenceOutput)
+    {
+        Fractures reference;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", reference));
+        Fractures filtered = reference;
+
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        PrefilterParameters parameters;
+        parameters.Precision = PrefilterPrecision::Quantized16;
+        parameters.UsePlanes = false;
+        PrefilterStatistics statistics;
+        map<int, vector<int>> filteredIntersections;
+        checkIntersectionsPrefiltered(filtered, filteredIntersections, parameters, statistics);
+
+        EXPECT_EQ(filteredIntersections, referenceIntersections);
+        expectSameTraces(filtered.Traces, reference.Traces);
+        EXPECT_EQ(statistics.TestedPairs, 200 * 199 / 2);
+        EXPECT_GT(statistics.RejectedByBox, 0);
+        EXPECT_EQ(statistics.RejectedByPlane, 0);
+    }
+
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef __TESTRAYQUERIES_H
+#define __TESTRAYQUERIES_H
+
+#include <gtest/gtest.h>
+#include <random>
+#include "Generator.hpp"
+#include "RayQueries.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    vector<Ray> randomRays(size_t count, mt19937_64& generator)
+    {
+        uniform_real_distribution<double> position(-0.2, 1.2);
+        normal_distribution<double> direction(0.0, 1.0);
+        vector<Ray> rays;
+        for (size_t r = 0; r < count; r++)
+        {
+            Vector3d origin(position(generator), position(generator), position(generator));
+            Vector3d towards(direction(generator), direction(generator), direction(generator));
+            rays.push_back(Ray(origin, towards, r % 3 == 0 ? 0.5 : numeric_limits<double>::infinity()));
+        }
+        return rays;
+    }
+
+
+    TEST(RAYQUERIESTEST, TestMatchesLinearScan)
+    {
+        Fractures fractures;
+        NetworkParameters parameters;
+        parameters.NumberFractures = 400;
+        parameters.MaxRadius = 0.15;
+        mt19937_64 generator(21);
+        generateFractures(fractures, parameters, generator);
+
+        FractureBVH bvh(fractures);
+        FractureBVH linear(fractures, fractures.FracturesVertices.size());
+        EXPECT_GT(bvh.numberNodes(), 100);
+        EXPECT_EQ(linear.numberNodes(), 1);
+
+        vector<Ray> rays = randomRays(300, generator);
+        size_t hitting = 0;
+        for (const Ray& ray : rays)
+        {
+            RayHit expected;
+            RayHit actual;
+            bool found = linear.firstHit(ray, expected);
+            ASSERT_EQ(bvh.firstHit(ray, actual), found);
+            hitting += found;
+            if (found)
+            {
+                EXPECT_EQ(actual.FractureId, expected.FractureId);
+                EXPECT_EQ(actual.Distance, expected.Distance);
+                EXPECT_LE(actual.Distance, ray.MaxDistance);
+            }
+
+            vector<RayHit> expectedAll;
+            vector<RayHit> actualAll;
+            linear.allHits(ray, expectedAll);
+            bvh.allHits(ray, actualAll);
+            ASSERT_EQ(actualAll.size(), expectedAll.size());
+            for (size_t h = 0; h < actualAll.size(); h++)
+            {
+                EXPECT_EQ(actualAll[h].FractureId, expectedAll[h].FractureId);
+            }
+            if (found)
+            {
+                EXPECT_EQ(actualAll.front().FractureId, actual.FractureId);
+            }
+
+            Vector3d end = ray.Origin + 0.3 * ray.Direction;
+            EXPECT_EQ(bvh.occluded(ray.Origin, end), linear.occluded(ray.Origin, end));
+        }
+        EXPECT_GT(hitting, 50);
+    }
+
+
+    TEST(RAYQUERIESTEST, TestPacketsAndThreadsMatchSingleRays)
+    {
+        Fractures fractures;
+        NetworkParameters parameters;
+        parameters.NumberFractures = 300;
+        mt19937_64 generator(22);
+        generateFractures(fractures, parameters, generator);
+        FractureBVH bvh(fractures);
+
+        vector<Ray> rays = randomRays(203, generator);
+        vector<RayHit> hits;
+        castRays(bvh, rays, hits, 3);
+        ASSERT_EQ(hits.size(), rays.size());
+
+        for (size_t r = 0; r < rays.size(); r++)
+        {
+            RayHit single;
+            ASSERT_EQ(bvh.firstHit(rays[r], single), hits[r].hit());
+            EXPECT_EQ(hits[r].FractureId, single.FractureId);
+            EXPECT_EQ(hits[r].Distance, single.Distance);
+        }
+    }
+
+
+    TEST(RAYQUERIESTEST, TestSimpleGeometry)
+    {
+        Fractures fractures;
+        fractures.NumberFractures = 2;
+        fractures.FracturesId = {7, 9};
+        Matrix3Xd square(3, 4);
+        square << 0, 1, 1, 0,
+                  0, 0, 1, 1,
+                  0, 0, 0, 0;
+        fractures.FracturesVertices = {square, square};
+        fractures.FracturesVertices[1].row(2).array() += 1.0;
+
+        FractureBVH bvh(fractures);
+        RayHit hit;
+        ASSERT_TRUE(bvh.firstHit(Ray(Vector3d(0.5, 0.5, 2.0), Vector3d(0, 0, -1)), hit));
+        EXPECT_EQ(hit.FractureId, 9);
+        EXPECT_DOUBLE_EQ(hit.Distance, 1.0);
+        EXPECT_TRUE(hit.Point.isApprox(Vector3d(0.5, 0.5, 1.0)));
+
+        vector<RayHit> hits;
+        bvh.allHits(Ray(Vector3d(0.5, 0.5, 2.0), Vector3d(0, 0, -1)), hits);
+        ASSERT_EQ(hits.size(), 2);
+        EXPECT_EQ(hits[1].FractureId, 7);
+
+        EXPECT_FALSE(bvh.firstHit(Ray(Vector3d(1.5, 0.5, 2.0), Vector3d(0, 0, -1)), hit));
+        EXPECT_TRUE(bvh.occluded(Vector3d(0.5, 0.5, -0.5), Vector3d(0.5, 0.5, 0.5)));
+        EXPECT_FALSE(bvh.occluded(Vector3d(0.5, 0.5, 0.2), Vector3d(0.5, 0.5, 0.8)));
+    }
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef __TESTREGRESSION_H
+#define __TESTREGRESSION_H
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "Regression.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    RegressionMeasurement measurement(const string& workload, double pairs, double traces, double megabytes)
+    {
+        RegressionMeasurement result;
+        result.Workload = workload;
+        result.PairsPerSecond = pairs;
+        result.TracesPerSecond = traces;
+        result.PeakMegabytes = megabytes;
+        return result;
+    }
+
+
+    TEST(REGRESSIONTEST, TestBaselineRoundTrip)
+    {
+        RegressionBaseline baseline;
+        baseline.Tolerance = 0.25;
+        baseline.BuildType = "Release";
+        baseline.Host = "node-7";
+        baseline.Workloads = {measurement("FR82", 1.5e6, 2.5e4, 12.0),
+                              measurement("synthetic_1000", 3.25e6, 125.0, 40.5)};
+        ASSERT_TRUE(writeRegressionBaseline("test_baseline.json", baseline));
+
+        RegressionBaseline read;
+        ASSERT_TRUE(readRegressionBaseline("test_baseline.json", read));
+        EXPECT_DOUBLE_EQ(read.Tolerance, 0.25);
+        EXPECT_EQ(read.BuildType, "Release");
+        EXPECT_EQ(read.Host, "node-7");
+        ASSERT_EQ(read.Workloads.size(), 2u);
+        EXPECT_EQ(read.Workloads[1].Workload, "synthetic_1000");
+        EXPECT_DOUBLE_EQ(read.Workloads[1].PairsPerSecond, 3.25e6);
+        EXPECT_DOUBLE_EQ(read.Workloads[0].PeakMegabytes, 12.0);
+
+        ofstream("test_baseline.json") << "{\"tolerance\": 0.1, \"workloads\": [{\"pairs_per_second\": 1}]}";
+        EXPECT_FALSE(readRegressionBaseline("test_baseline.json", read));
+        ofstream("test_baseline.json") << "{\"workloads\": [";
+        EXPECT_FALSE(readRegressionBaseline("test_baseline.json", read));
+        remove("test_baseline.json");
+    }
+
+
+    TEST(REGRESSIONTEST, TestComparisonFlagsRegressions)
+    {
+        RegressionBaseline baseline;
+        baseline.Workloads = {measurement("FR82", 1000.0, 100.0, 10.0)};
+
+        ostringstream diff;
+        EXPECT_TRUE(compareToBaseline(baseline, {measurement("FR82", 800.0, 120.0, 11.0),
+                                                 measurement("new", 1.0, 1.0, 1.0)}, 0.25, diff));
+        EXPECT_NE(diff.str().find("new; -; -; -; -; not in baseline"), string::npos);
+
+        ostringstream slower;
+        EXPECT_FALSE(compareToBaseline(baseline, {measurement("FR82", 700.0, 100.0, 10.0)}, 0.25, slower));
+        EXPECT_NE(slower.str().find("FR82; pairs/s; 1000; 700; -30.0%; REGRESSION"), string::npos);
+
+        ostringstream larger;
+        EXPECT_FALSE(compareToBaseline(baseline, {measurement("FR82", 1000.0, 100.0, 13.0)}, 0.25, larger));
+        EXPECT_NE(larger.str().find("FR82; peak MB; 10; 13; +30.0%; REGRESSION"), string::npos);
+
+        ostringstream missing;
+        EXPECT_FALSE(compareToBaseline(baseline, {measurement("new", 1.0, 1.0, 1.0)}, 0.25, missing));
+        EXPECT_NE(missing.str().find("FR82; -; -; -; -; NOT MEASURED"), string::npos);
+    }
+
+
+    TEST(REGRESSIONTEST, TestEnvironmentMismatch)
+    {
+        RegressionBaseline baseline;
+        baseline.BuildType = "Debug";
+        baseline.Host = "node-7";
+
+        ostringstream same;
+        EXPECT_TRUE(sameEnvironment(baseline, "Debug", "node-7", same));
+        EXPECT_TRUE(same.str().empty());
+
+        ostringstream release;
+        EXPECT_FALSE(sameEnvironment(baseline, "Release", "node-7", release));
+        EXPECT_NE(release.str().find("build type \"Debug\" differs from \"Release\""), string::npos);
+
+        ostringstream host;
+        EXPECT_FALSE(sameEnvironment(baseline, "Debug", "laptop", host));
+        EXPECT_NE(host.str().find("host \"node-7\" differs from \"laptop\""), string::npos);
+
+        // a baseline written before the fields existed never matches
+        ostringstream old;
+        EXPECT_FALSE(sameEnvironment(RegressionBaseline(), "Debug", "node-7", old));
+    }
+
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef __TESTSERVER_H
+#define __TESTSERVER_H
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "Server.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(SERVERTEST, TestQueriesMatchNetwork)
+    {
+        Fractures reference, fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", reference));
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(reference, intersections);
+
+        ServerParameters parameters;
+        parameters.SocketPath = "server_test.sock";
+        QueryServer server(fractures, parameters);
+        ASSERT_TRUE(server.start());
+
+        QueryClient client;
+        ASSERT_TRUE(client.connect(parameters.SocketPath));
+
+        vector<unsigned int> ids = reference.FracturesId;
+        ids.push_back(100000);
+        vector<vector<unsigned int>> neighbors;
+        ASSERT_TRUE(client.neighbors(ids, neighbors));
+        ASSERT_EQ(neighbors.size(), ids.size());
+        for (size_t k = 0; k < ids.size(); k++)
+        {
+            vector<int> expected = intersections[ids[k]];
+            sort(expected.begin(), expected.end());
+            EXPECT_EQ(vector<int>(neighbors[k].begin(), neighbors[k].end()), expected);
+        }
+
+        vector<vector<Trace>> traces;
+        ASSERT_TRUE(client.traces(ids, traces));
+        for (size_t k = 0; k < ids.size(); k++)
+        {
+            vector<Trace> expected;
+            for (const Trace& trace : reference.Traces)
+            {
+                if (trace.fractureId1 == int(ids[k]) || trace.fractureId2 == int(ids[k]))
+                {
+                    expected.push_back(trace);
+                }
+            }
+            expectSameTraces(traces[k], expected);
+        }
+
+        // the fractures themselves as proposed polygons, against a full scan
+        vector<vector<unsigned int>> found;
+        ASSERT_TRUE(client.wouldIntersect(reference.FracturesVertices, found));
+        for (size_t k = 0; k < reference.FracturesVertices.size(); k++)
+        {
+            vector<unsigned int> expected;
+            for (size_t i = 0; i < reference.FracturesVertices.size(); i++)
+            {
+                if (fracturesIntersect(reference.FracturesVertices[i], reference.FracturesVertices[k]))
+                {
+                    expected.push_back(reference.FracturesId[i]);
+                }
+            }
+            sort(expected.begin(), expected.end());
+            EXPECT_EQ(found[k], expected);
+        }
+
+        // a degenerate polygon is refused and the connection dropped
+        vector<vector<unsigned int>> refused;
+        EXPECT_FALSE(client.wouldIntersect({Matrix3Xd::Zero(3, 2)}, refused));
+
+        ServerStatistics statistics = server.statistics();
+        EXPECT_EQ(statistics.Requests, 4u);
+        EXPECT_EQ(statistics.Errors, 1u);
+        EXPECT_EQ(statistics.Queries, 2 * ids.size() + reference.FracturesVertices.size());
+        server.stop();
+        EXPECT_FALSE(server.running());
+    }
+
+
+    TEST(SERVERTEST, TestConcurrentClients)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR82_data.txt", fractures));
+        ServerParameters parameters;
+        parameters.SocketPath = "server_concurrent.sock";
+        QueryServer server(fractures, parameters);
+        ASSERT_TRUE(server.start());
+
+        const unsigned int numberClients = 4;
+        const unsigned int requests = 25;
+        vector<int> failures(numberClients, 0);
+        vector<thread> clients;
+        for (unsigned int c = 0; c < numberClients; c++)
+        {
+            clients.emplace_back([&, c]()
+            {
+                QueryClient client;
+                if (!client.connect(parameters.SocketPath))
+                {
+                    failures[c] = -1;
+                    return;
+                }
+                for (unsigned int r = 0; r < requests; r++)
+                {
+                    vector<unsigned int> ids = {(c * requests + r) % 82};
+                    vector<vector<unsigned int>> expected(1), answer;
+                    server.neighbors(ids[0], expected[0]);
+                    if (!client.neighbors(ids, answer) || answer != expected)
+                    {
+                        failures[c]++;
+                    }
+                }
+            });
+        }
+        for (thread& client : clients)
+        {
+            client.join();
+        }
+        EXPECT_EQ(failures, vector<int>(numberClients, 0));
+
+        QueryClient client;
+        ASSERT_TRUE(client.connect(parameters.SocketPath));
+        ServerStatistics statistics;
+        ASSERT_TRUE(client.statistics(statistics));
+        EXPECT_EQ(statistics.Clients, numberClients + 1);
+        EXPECT_EQ(statistics.Requests, numberClients * requests);
+        EXPECT_LE(statistics.Latency50, statistics.Latency99);
+        EXPECT_LE(statistics.Latency99, statistics.LatencyMax);
+
+        // a client can stop the server
+        EXPECT_TRUE(client.shutdown());
+        server.wait();
+        EXPECT_FALSE(server.running());
+    }
+
+
+    TEST(SERVERTEST, TestMisbehavingClients)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+        ServerParameters parameters;
+        parameters.SocketPath = "server_misbehaving.sock";
+        QueryServer server(fractures, parameters);
+        ASSERT_TRUE(server.start());
+
+        auto connectRaw = [&]()
+        {
+            sockaddr_un address;
+            memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            strcpy(address.sun_path, parameters.SocketPath.c_str());
+            int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+            EXPECT_EQ(::connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+            return connection;
+        };
+
+        // a request far larger than its queries can be is refused unread
+        int oversized = connectRaw();
+        uint32_t header[4] = {uint32_t(QueryOpcode::Neighbors), 1, 1u << 30, 0};
+        ASSERT_EQ(write(oversized, header, sizeof(header)), ssize_t(sizeof(header)));
+        uint32_t answer[4] = {};
+        ASSERT_EQ(read(oversized, answer, sizeof(answer)), ssize_t(sizeof(answer)));
+        EXPECT_EQ(answer[0], uint32_t(QueryStatus::BadRequest));
+        close(oversized);
+
+        // half a header does not keep the server from stopping
+        int stalled = connectRaw();
+        ASSERT_EQ(write(stalled, header, 8), 8);
+        this_thread::sleep_for(chrono::milliseconds(100));
+        auto begin = chrono::steady_clock::now();
+        server.stop();
+        EXPECT_LT(chrono::duration<double>(chrono::steady_clock::now() - begin).count(), 1.0);
+        EXPECT_FALSE(server.running());
+        close(stalled);
+    }
+
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef __TESTTRACECROSSINGS_H
+#define __TESTTRACECROSSINGS_H
+
+#include <gtest/gtest.h>
+#include <random>
+#include "TraceCrossings.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    LocalTrace localSegment(double x1, double y1, double x2, double y2)
+    {
+        LocalTrace trace;
+        trace.TraceId = 0;
+        trace.P1 = Vector2d(x1, y1);
+        trace.P2 = Vector2d(x2, y2);
+        return trace;
+    }
+
+    void expectSameCrossings(const vector<LocalTrace>& traces)
+    {
+        vector<TraceCrossing> reference, sweep;
+        traceCrossingsBruteForce(traces, reference);
+        traceCrossingsSweep(traces, sweep);
+        ASSERT_EQ(sweep.size(), reference.size());
+        for (size_t c = 0; c < reference.size(); c++)
+        {
+            EXPECT_EQ(sweep[c].First, reference[c].First);
+            EXPECT_EQ(sweep[c].Second, reference[c].Second);
+            EXPECT_LT((sweep[c].Point - reference[c].Point).norm(), 1e-12);
+        }
+    }
+
+
+    TEST(TRACECROSSINGSTEST, TestSweepMatchesBruteForce)
+    {
+        mt19937_64 generator(11);
+        uniform_real_distribution<double> coordinate(0.0, 1.0);
+        for (double length : {2.0, 0.1})
+        {
+            vector<LocalTrace> traces;
+            for (unsigned int i = 0; i < 300; i++)
+            {
+                Vector2d p(coordinate(generator), coordinate(generator));
+                Vector2d q(coordinate(generator), coordinate(generator));
+                q = p + length * (q - p);
+                traces.push_back(localSegment(p.x(), p.y(), q.x(), q.y()));
+            }
+            expectSameCrossings(traces);
+        }
+    }
+
+
+    TEST(TRACECROSSINGSTEST, TestDegenerateConfigurations)
+    {
+        // grid: vertical segments, shared endpoints and touching ends
+        vector<LocalTrace> grid;
+        for (int k = 0; k <= 6; k++)
+        {
+            grid.push_back(localSegment(k, 0, k, 6));
+            grid.push_back(localSegment(0, k, 6, k));
+        }
+        grid.push_back(localSegment(0, 0, 6, 6));
+        grid.push_back(localSegment(6, 0, 0, 6));
+        grid.push_back(localSegment(3, 3, 3, 9));
+        expectSameCrossings(grid);
+
+        vector<TraceCrossing> crossings;
+        traceCrossingsSweep(grid, crossings);
+        EXPECT_EQ(count_if(crossings.begin(), crossings.end(), [](const TraceCrossing& c)
+                           {
+                               return c.First == 0 && c.Second == 1;
+                           }), 1);
+
+        // star through a common point and a family of parallel segments
+        vector<LocalTrace> star;
+        for (int k = 0; k < 12; k++)
+        {
+            double angle = M_PI * k / 12;
+            star.push_back(localSegment(cos(angle), sin(angle), -cos(angle), -sin(angle)));
+        }
+        for (int k = -3; k <= 3; k++)
+        {
+            star.push_back(localSegment(-2, 0.25 * k - 1, 2, 0.25 * k + 1));
+        }
+        expectSameCrossings(star);
+
+        // inexact coordinates: the crossing on the vertical segment is at
+        // x = 0.10000000000000003 when rounded, after its end
+        vector<LocalTrace> rounded = {localSegment(3 * 0.1, 0, 0, 0.1), localSegment(0.1, 0.2, 0.1, 0),
+                                      localSegment(0.1, 0.2, 3 * 0.1, 3 * 0.1 + 0.05)};
+        expectSameCrossings(rounded);
+        traceCrossingsSweep(rounded, crossings);
+        EXPECT_EQ(crossings.size(), 2u);
+
+        mt19937_64 generator(5);
+        for (int trial = 0; trial < 200; trial++)
+        {
+            uniform_int_distribution<int> coordinate(0, 3 + trial % 10);
+            vector<LocalTrace> scaled(33 + trial % 60);
+            for (LocalTrace& trace : scaled)
+            {
+                trace = localSegment(coordinate(generator) * 0.1, coordinate(generator) * 0.1,
+                                     coordinate(generator) * 0.1, coordinate(generator) * 0.1 + 0.05 * (trial % 2));
+            }
+            expectSameCrossings(scaled);
+        }
+
+        // collinear overlaps and points cross nothing
+        vector<LocalTrace> collinear = {localSegment(0, 0, 2, 2), localSegment(1, 1, 3, 3),
+                                        localSegment(1, 1, 1, 1)};
+        traceCrossingsSweep(collinear, crossings);
+        EXPECT_TRUE(crossings.empty());
+    }
+
+
+    TEST(TRACECROSSINGSTEST, TestNetworkCrossingsInCsr)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+        vector<LocalFracture> local;
+        computeLocalTraces(fractures, local);
+
+        TraceCrossings serial, parallel;
+        computeTraceCrossings(local, serial, 1);
+        computeTraceCrossings(local, parallel, 4);
+        ASSERT_EQ(serial.Offsets.size(), local.size() + 1);
+        EXPECT_EQ(serial.Offsets, parallel.Offsets);
+        EXPECT_EQ(serial.TraceId1, parallel.TraceId1);
+        EXPECT_EQ(serial.TraceId2, parallel.TraceId2);
+        EXPECT_TRUE(serial.Points == parallel.Points);
+        EXPECT_GT(serial.size(), 0u);
+
+        for (size_t k = 0; k < local.size(); k++)
+        {
+            vector<TraceCrossing> reference;
+            traceCrossingsBruteForce(local[k].Traces, reference);
+            ASSERT_EQ(serial.numberCrossings(k), reference.size());
+            for (size_t c = 0; c < reference.size(); c++)
+            {
+                size_t position = serial.Offsets[k] + c;
+                EXPECT_EQ(serial.TraceId1[position], local[k].Traces[reference[c].First].TraceId);
+                EXPECT_EQ(serial.TraceId2[position], local[k].Traces[reference[c].Second].TraceId);
+                EXPECT_LT((serial.Points.col(position) - reference[c].Point).norm(), 1e-12);
+            }
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef __TESTTRACESINK_H
+#define __TESTTRACESINK_H
+
+#include <gtest/gtest.h>
+#include "BinaryIO.hpp"
+#include "TraceSink.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(TRACESINKTEST, TestCollectingSinkMatchesCheckIntersections)
+    {
+        Fractures reference;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", reference));
+        Fractures streamed = reference;
+
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+
+        map<int, vector<int>> intersections;
+        CollectingSink sink(streamed, intersections);
+        size_t blocks = 0;
+        CallbackSink counter([&blocks](const vector<Trace>& block)
+        {
+            EXPECT_LE(block.size(), 64);
+            blocks++;
+        });
+        ASSERT_TRUE(streamTraces(streamed, sink, 64));
+        ASSERT_TRUE(streamTraces(streamed, counter, 64));
+
+        EXPECT_EQ(intersections, referenceIntersections);
+        expectSameTraces(streamed.Traces, reference.Traces);
+        EXPECT_EQ(blocks, (reference.Traces.size() + 63) / 64);
+    }
+
+
+    TEST(TRACESINKTEST, TestWriterAndStatisticsSinks)
+    {
+        Fractures reference;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", reference));
+        map<int, vector<int>> referenceIntersections;
+        checkIntersections(reference, referenceIntersections);
+        writeTraces(reference, "test_sink_reference.txt");
+
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+
+        TextTraceWriter text("test_sink_traces.txt");
+        ASSERT_TRUE(streamTraces(fractures, text, 7));
+        EXPECT_EQ(readLines("test_sink_traces.txt"), readLines("test_sink_reference.txt"));
+
+        BinaryTraceWriter binary("test_sink_traces.bin");
+        ASSERT_TRUE(streamTraces(fractures, binary, 7));
+        ifstream in("test_sink_traces.bin", ios::binary);
+        vector<Trace> traces;
+        ASSERT_TRUE(readTracesBinary(in, traces));
+        expectSameTraces(traces, reference.Traces);
+
+        StatisticsSink statistics(fractures);
+        ASSERT_TRUE(streamTraces(fractures, statistics));
+        TraceStatistics expected;
+        summarizeTraces(reference, expected);
+        EXPECT_EQ(statistics.statistics().NumberTraces, expected.NumberTraces);
+        EXPECT_EQ(statistics.statistics().TracesPerFracture, expected.TracesPerFracture);
+        EXPECT_DOUBLE_EQ(statistics.statistics().p21(), expected.p21());
+        EXPECT_TRUE(fractures.Traces.empty());
+    }
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef __TESTTRACESORT_H
+#define __TESTTRACESORT_H
+
+#include <gtest/gtest.h>
+#include <random>
+#include "TraceSort.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    // traces with few distinct lengths, so that ties are common, in shuffled id order
+    vector<Trace> tiedTraces(size_t n, unsigned long long seed)
+    {
+        mt19937_64 generator(seed);
+        uniform_int_distribution<int> length(0, 40);
+        vector<Trace> traces;
+        for (size_t k = 0; k < n; k++)
+        {
+            double l = length(generator) * 0.125;
+            traces.emplace_back(k, 0, 1, Point(0, 0, 0), Point(l, 0, 0), k % 2, k % 3 == 0);
+        }
+        shuffle(traces.begin(), traces.end(), generator);
+        return traces;
+    }
+
+
+    TEST(TRACESORTTEST, TestRadixMatchesComparatorOrder)
+    {
+        for (size_t n : {0, 1, 7, 255, 256, 5000})
+        {
+            vector<Trace> traces = tiedTraces(n, n + 1);
+            vector<Trace> expected = traces;
+            stable_sort(expected.begin(), expected.end(), [](const Trace& a, const Trace& b)
+                        {
+                            return a.length > b.length || (a.length == b.length && a.traceId < b.traceId);
+                        });
+
+            vector<Trace> comparator = traces;
+            sortTracesByLength(comparator);
+            expectSameTraces(comparator, expected);
+
+            vector<uint32_t> order;
+            radixOrderByLength(traces, order);
+            ASSERT_EQ(order.size(), n);
+            for (size_t k = 0; k < n; k++)
+            {
+                EXPECT_EQ(traces[order[k]].traceId, expected[k].traceId);
+            }
+
+            radixSortByLength(traces);
+            expectSameTraces(traces, expected);
+        }
+    }
+
+
+    TEST(TRACESORTTEST, TestParallelSegments)
+    {
+        vector<vector<Trace>> lists;
+        for (size_t s = 0; s < 40; s++)
+        {
+            lists.push_back(tiedTraces(s * s * 3, s));
+        }
+        vector<vector<Trace>> expected = lists;
+        vector<vector<Trace>*> segments;
+        for (size_t s = 0; s < lists.size(); s++)
+        {
+            sortTracesByLength(expected[s]);
+            segments.push_back(&lists[s]);
+        }
+
+        sortTraceSegments(segments, 4);
+        for (size_t s = 0; s < lists.size(); s++)
+        {
+            expectSameTraces(lists[s], expected[s]);
+        }
+    }
+
+}
+
+#endif
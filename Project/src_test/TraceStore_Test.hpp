@@ -0,0 +1,77 @@
+#ifndef __TESTTRACESTORE_H
+#define __TESTTRACESTORE_H
+
+#include <gtest/gtest.h>
+#include "TraceStore.hpp"
+#include "Utils.hpp"
+
+using namespace std;
+
+namespace FractureLibrary
+{
+
+    TEST(TRACESTORETEST, TestDoubleStoreIsExact)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR200_data.txt", fractures));
+        map<int, vector<int>> intersections;
+        checkIntersections(fractures, intersections);
+
+        TraceStore store;
+        store.reserve(fractures.Traces.size());
+        store.consume(fractures.Traces);
+        ASSERT_EQ(store.size(), fractures.Traces.size());
+
+        vector<Trace> views;
+        for (size_t k = 0; k < store.size(); k++)
+        {
+            views.push_back(store[k]);
+            EXPECT_EQ(views.back().length, fractures.Traces[k].length);
+            EXPECT_EQ(store.tips1(k), fractures.Traces[k].Tips1);
+            EXPECT_EQ(store.tips2(k), fractures.Traces[k].Tips2);
+        }
+        expectSameTraces(views, fractures.Traces);
+        EXPECT_LT(store.memoryBytes(), fractures.Traces.size() * sizeof(Trace));
+    }
+
+
+    TEST(TRACESTORETEST, TestReducedPrecision)
+    {
+        Fractures fractures;
+        ASSERT_TRUE(ImportFractures("DFN/FR50_data.txt", fractures));
+
+        // filled straight from the intersection stream
+        TraceStore exact;
+        TraceStore single(TracePrecision::Float, true);
+        TraceStore parametric(TracePrecision::LineParameter, false, &fractures);
+        ASSERT_TRUE(streamTraces(fractures, exact));
+        ASSERT_TRUE(streamTraces(fractures, single));
+        ASSERT_TRUE(streamTraces(fractures, parametric));
+        ASSERT_EQ(single.size(), exact.size());
+        ASSERT_EQ(parametric.size(), exact.size());
+        EXPECT_LT(single.memoryBytes(), exact.memoryBytes());
+        EXPECT_LT(parametric.memoryBytes(), single.memoryBytes());
+
+        for (size_t k = 0; k < exact.size(); k++)
+        {
+            Trace reference = exact[k];
+            Vector3d p1(reference.p1.x, reference.p1.y, reference.p1.z);
+            Vector3d p2(reference.p2.x, reference.p2.y, reference.p2.z);
+            double scale = max({1.0, p1.norm(), p2.norm()});
+
+            for (const TraceStore* store : {&single, &parametric})
+            {
+                Trace view = (*store)[k];
+                EXPECT_EQ(view.traceId, reference.traceId);
+                EXPECT_EQ(view.fractureId2, reference.fractureId2);
+                EXPECT_EQ(view.Tips1, reference.Tips1);
+                EXPECT_NEAR(view.p1.x, reference.p1.x, 1e-6 * scale);
+                EXPECT_NEAR(view.p2.z, reference.p2.z, 1e-6 * scale);
+                EXPECT_NEAR(store->length(k), reference.length, 1e-6 * scale);
+            }
+        }
+    }
+
+}
+
+#endif